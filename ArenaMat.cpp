@@ -0,0 +1,226 @@
+// ArenaMat.cpp
+#include "ArenaMat.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace {
+
+// Alineación de cada reserva (la de cv::fastMalloc: sirve para AVX-512)
+constexpr size_t kAlineacion = 64;
+
+size_t Alinear(size_t n) { return (n + kAlineacion - 1) & ~(kAlineacion - 1); }
+
+// Arena activa en este hilo (nullptr = heap)
+thread_local ArenaMat* arenaActiva = nullptr;
+
+} // namespace
+
+struct ArenaMat::Bloque
+{
+    unsigned char* datos = nullptr;
+    size_t capacidad = 0;
+    size_t usado = 0;                           // sólo lo toca el hilo dueño de la arena
+
+    // Mat vivos en el bloque + 1 mientras la arena lo tiene en su lista.
+    // Quien lo deja en 0 (la arena o el último Mat, desde cualquier hilo) lo libera.
+    std::atomic<long> referencias{ 1 };
+};
+
+static ArenaMat::Bloque* NuevoBloque(size_t capacidad)
+{
+    auto* bloque = new ArenaMat::Bloque;
+    bloque->datos = static_cast<unsigned char*>(cv::fastMalloc(capacidad));
+    bloque->capacidad = capacidad;
+    SumarMemoria(CategoriaMemoria::Slices, static_cast<long long>(capacidad));
+    return bloque;
+}
+
+static void SoltarBloque(ArenaMat::Bloque* bloque)
+{
+    if (bloque->referencias.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        SumarMemoria(CategoriaMemoria::Slices, -static_cast<long long>(bloque->capacidad));
+        cv::fastFree(bloque->datos);
+        delete bloque;
+    }
+}
+
+// Delante de cada Mat del heap: categoría y bytes, para descontarlos al liberarlo
+struct CabeceraHeap
+{
+    CategoriaMemoria categoria;
+    long long bytes;
+};
+static_assert(sizeof(CabeceraHeap) <= kAlineacion, "CabeceraHeap no cabe en su hueco");
+
+/**
+ * Asignador por defecto de cv::Mat (ver InstalarAsignadorMat): si el hilo tiene
+ * arena, el Mat (cabecera UMatData + datos) sale de ella; si no, de un bloque
+ * propio del heap que se cuenta en la categoría de memoria activa del hilo.
+ * Los Mat con datos de usuario se delegan en el asignador estándar de OpenCV.
+ */
+class AsignadorArenas : public cv::MatAllocator
+{
+public:
+    explicit AsignadorArenas(bool usarArenas) : usarArenas(usarArenas) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+    {
+        ArenaMat* arena = usarArenas ? arenaActiva : nullptr;
+        if (data0)
+        {
+            // Los datos no son nuestros: no hay memoria que contar
+            if (arena) ++arena->contadores.fueraDeArena;
+            return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+        }
+
+        // Pasos continuos (como el asignador estándar sin datos de usuario)
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; --i)
+        {
+            if (step) step[i] = total;
+            total *= static_cast<size_t>(sizes[i]);
+        }
+
+        const size_t cabecera = Alinear(sizeof(cv::UMatData));
+        unsigned char* p = nullptr;
+        ArenaMat::Bloque* bloque = nullptr;
+        if (arena) {
+            p = static_cast<unsigned char*>(arena->Reservar(cabecera + Alinear(total), bloque));
+        } else {
+            const size_t bytes = kAlineacion + cabecera + Alinear(total);
+            auto* base = static_cast<unsigned char*>(cv::fastMalloc(bytes));
+            const CategoriaMemoria categoria = CategoriaMemoriaActiva();
+            new (base) CabeceraHeap{ categoria, static_cast<long long>(bytes) };
+            SumarMemoria(categoria, static_cast<long long>(bytes));
+            p = base + kAlineacion;
+        }
+
+        cv::UMatData* u = new (p) cv::UMatData(this);
+        u->data = u->origdata = p + cabecera;
+        u->size = total;
+        u->userdata = bloque;                   // nullptr = bloque propio del heap
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override
+    {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override
+    {
+        if (!u) return;
+        auto* bloque = static_cast<ArenaMat::Bloque*>(u->userdata);
+        u->~UMatData();                         // la memoria es del bloque: no hay delete
+        if (bloque) {
+            SoltarBloque(bloque);
+        } else {
+            auto* base = reinterpret_cast<unsigned char*>(u) - kAlineacion;
+            const CabeceraHeap cab = *reinterpret_cast<CabeceraHeap*>(base);
+            SumarMemoria(cab.categoria, -cab.bytes);
+            cv::fastFree(base);
+        }
+    }
+
+private:
+    bool usarArenas;                            // false = siempre del heap (CopiarFueraDeArena)
+};
+
+// Se crean una sola vez y no se destruyen nunca: puede haber Mat vivos hasta el final del programa
+static AsignadorArenas* AsignadorPorDefecto()
+{
+    static AsignadorArenas* asignador = new AsignadorArenas(true);
+    return asignador;
+}
+
+static AsignadorArenas* AsignadorSoloHeap()
+{
+    static AsignadorArenas* asignador = new AsignadorArenas(false);
+    return asignador;
+}
+
+void InstalarAsignadorMat()
+{
+    static std::once_flag instalado;
+    std::call_once(instalado, [] { cv::Mat::setDefaultAllocator(AsignadorPorDefecto()); });
+}
+
+ContadoresArena& ContadoresArena::operator+=(const ContadoresArena& otro)
+{
+    asignaciones     += otro.asignaciones;
+    bytes            += otro.bytes;
+    reservasHeap     += otro.reservasHeap;
+    bloquesRetenidos += otro.bloquesRetenidos;
+    fueraDeArena     += otro.fueraDeArena;
+    return *this;
+}
+
+ArenaMat::ArenaMat(size_t tamBloque)
+    : tamBloque(Alinear(std::max<size_t>(tamBloque, kAlineacion)))
+{
+    InstalarAsignadorMat();
+
+    anterior = arenaActiva;
+    arenaActiva = this;
+}
+
+ArenaMat::~ArenaMat()
+{
+    arenaActiva = anterior;
+    for (Bloque* bloque : bloques) SoltarBloque(bloque);
+}
+
+void* ArenaMat::Reservar(size_t bytes, Bloque*& bloque)
+{
+    for (; actual < bloques.size(); ++actual)
+    {
+        Bloque* b = bloques[actual];
+        if (b->capacidad - b->usado >= bytes) break;
+    }
+    if (actual == bloques.size())
+    {
+        // Ningún bloque tiene sitio: uno nuevo, al menos del tamaño pedido
+        bloques.push_back(NuevoBloque(std::max(tamBloque, bytes)));
+        ++contadores.reservasHeap;
+    }
+
+    bloque = bloques[actual];
+    void* p = bloque->datos + bloque->usado;
+    bloque->usado += bytes;
+    bloque->referencias.fetch_add(1, std::memory_order_relaxed);
+
+    ++contadores.asignaciones;
+    contadores.bytes += static_cast<long long>(bytes);
+    return p;
+}
+
+void ArenaMat::Reiniciar()
+{
+    // Sólo este hilo reserva en sus bloques: si no quedan Mat vivos (referencias == 1),
+    // nadie puede volver a tomarlo entre la comprobación y la reutilización.
+    size_t libres = 0;
+    for (Bloque* bloque : bloques)
+    {
+        if (bloque->referencias.load(std::memory_order_acquire) == 1) {
+            bloque->usado = 0;
+            bloques[libres++] = bloque;
+        } else {
+            ++contadores.bloquesRetenidos;
+            SoltarBloque(bloque);               // lo liberará el último Mat que lo use
+        }
+    }
+    bloques.resize(libres);
+    actual = 0;
+}
+
+cv::Mat CopiarFueraDeArena(const cv::Mat& m, CategoriaMemoria categoria)
+{
+    CategoriaMemoriaEnHilo enCategoria(categoria);
+    cv::Mat copia;
+    copia.allocator = AsignadorSoloHeap();
+    m.copyTo(copia);
+    return copia;
+}
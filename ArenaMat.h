@@ -0,0 +1,82 @@
+// ArenaMat.h
+#ifndef ARENAMAT_H
+#define ARENAMAT_H
+
+#include <cstddef>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "Memoria.h"              // para CategoriaMemoria
+
+/**
+ * Contadores de una arena (o de la suma de las arenas de una ejecución).
+ */
+struct ContadoresArena
+{
+    long long asignaciones     = 0;   // cv::Mat servidos desde la arena
+    long long bytes            = 0;   // bytes servidos (datos + cabecera)
+    long long reservasHeap     = 0;   // bloques pedidos al heap (0 en régimen estable)
+    long long bloquesRetenidos = 0;   // bloques que un Mat vivo impidió reutilizar al reiniciar
+    long long fueraDeArena     = 0;   // Mat con datos de usuario (se delegan al asignador estándar)
+
+    ContadoresArena& operator+=(const ContadoresArena& otro);
+};
+
+/**
+ * Arena de memoria para los cv::Mat temporales de un hilo de trabajo.
+ *
+ * Mientras existe, todos los cv::Mat que se crean en su hilo (los del filtro,
+ * el overlay, los de dentro de las funciones de OpenCV que corren en ese hilo)
+ * se sirven por avance de puntero desde bloques propios, cabecera UMatData
+ * incluida. Reiniciar() al terminar cada slice deja los bloques listos para el
+ * siguiente, así que tras el primer slice no se pide nada al heap.
+ *
+ * Un Mat que deba sobrevivir al slice (p. ej. un frame que se guarda) debe
+ * copiarse con CopiarFueraDeArena. Si aun así sigue vivo al reiniciar, su bloque
+ * no se reutiliza: se libera cuando muere el último Mat que lo usa (desde
+ * cualquier hilo) y se cuenta en bloquesRetenidos.
+ *
+ * Los hilos sin arena (interfaz, pool interno de OpenCV...) reservan del heap
+ * como el asignador estándar de OpenCV, pero cada Mat se cuenta en Memoria.h.
+ */
+class ArenaMat
+{
+public:
+    explicit ArenaMat(size_t tamBloque = size_t(8) << 20);
+    ~ArenaMat();
+
+    ArenaMat(const ArenaMat&) = delete;
+    ArenaMat& operator=(const ArenaMat&) = delete;
+
+    /**
+     * Fin de un slice: los bloques sin Mat vivos vuelven a estar libres.
+     */
+    void Reiniciar();
+
+    const ContadoresArena& Contadores() const { return contadores; }
+
+    struct Bloque;                    // definido en ArenaMat.cpp
+
+private:
+    friend class AsignadorArenas;
+    void* Reservar(size_t bytes, Bloque*& bloque);
+
+    size_t tamBloque;
+    std::vector<Bloque*> bloques;     // bloques en uso por esta arena
+    size_t actual = 0;                // bloque donde se sigue reservando
+    ContadoresArena contadores;
+    ArenaMat* anterior = nullptr;     // arena activa antes de ésta en el hilo
+};
+
+/**
+ * Instala como asignador por defecto de cv::Mat el que sirve las arenas y cuenta
+ * la memoria de los Mat del heap por categoría. Idempotente; ArenaMat y
+ * ProcesarTodosSlices lo llaman. Los Mat creados antes conservan su asignador.
+ */
+void InstalarAsignadorMat();
+
+/**
+ * Copia m en el heap, para que sobreviva al Reiniciar de la arena; se cuenta en 'categoria'.
+ */
+cv::Mat CopiarFueraDeArena(const cv::Mat& m, CategoriaMemoria categoria = CategoriaMemoria::Mats);
+
+#endif // ARENAMAT_H
@@ -0,0 +1,102 @@
+// BloquesZ.h
+// Recorrido de volúmenes por bloques de planos en z, compartido por Filtros3D y Segmentacion3D.
+#ifndef BLOQUESZ_H
+#define BLOQUESZ_H
+
+#include <algorithm>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>  // para cv::parallel_for_
+#include "Traza.h"                   // para TramoTraza
+
+// Planos mínimos por bloque: con menos, el halo que se filtra dos veces pesa demasiado
+constexpr int kPlanosMinBloque = 8;
+
+// Bloques por hilo, para repartir la carga cuando unos bloques tardan más que otros
+constexpr int kBloquesPorHilo = 4;
+
+// Bytes de la ventana en z de una franja de filas que deben caber en la L2 de un núcleo:
+// la mitad de una L2 pequeña (512 KB), para dejar sitio a las filas de entrada y salida
+constexpr size_t kBytesVentanaL2 = 256 * 1024;
+
+// Filas mínimas por franja: con menos, las filas vecinas que se releen en cada franja pesan demasiado
+constexpr int kFilasMinFranjaY = 8;
+
+/**
+ * Índice de plano con el borde reflejado sin repetir el extremo (BORDER_REFLECT_101, como
+ * OpenCV). En un mínimo o un máximo sobre la ventana, los planos reflejados ya están en
+ * ella: no cambian nada.
+ */
+inline int Reflejar101(int z, int nz)
+{
+    if (nz == 1) return 0;
+    while (z < 0 || z >= nz) {
+        if (z < 0)   z = -z;
+        if (z >= nz) z = 2 * nz - 2 - z;
+    }
+    return z;
+}
+
+/**
+ * Anillo de 2h+1 planos indexado por z (sin reflejar): el plano que entra por delante
+ * ocupa la ranura del que sale por detrás.
+ */
+template <class T>
+class VentanaZ
+{
+public:
+    explicit VentanaZ(int halo) : ranuras(2 * halo + 1) {}
+
+    T& operator[](int z)
+    {
+        const int n = static_cast<int>(ranuras.size());
+        return ranuras[((z % n) + n) % n];
+    }
+
+private:
+    std::vector<T> ranuras;
+};
+
+/**
+ * Planos por bloque con los que RecorrerBloquesZ reparte [0, nz).
+ */
+inline int PlanosPorBloqueZ(int nz)
+{
+    const int hilos = std::max(1, cv::getNumThreads());
+    return std::max(kPlanosMinBloque, (nz + kBloquesPorHilo * hilos - 1) / (kBloquesPorHilo * hilos));
+}
+
+/**
+ * Filas por franja en y para que la ventana en z de una franja quepa en kBytesVentanaL2,
+ * con 'bytesFilaVentana' los bytes de una fila en todos los planos de la ventana. Los
+ * filtros recorren cada bloque de z franja a franja y terminan cada franja en z antes de
+ * pasar a la siguiente: así la ventana no son 2h+1 planos enteros (varios MB en 512²).
+ */
+inline int FilasPorFranjaY(int ny, size_t bytesFilaVentana)
+{
+    const size_t filas = kBytesVentanaL2 / std::max<size_t>(1, bytesFilaVentana);
+    return std::max(1, std::min(ny, std::max(kFilasMinFranjaY, static_cast<int>(std::min<size_t>(filas, ny)))));
+}
+
+/**
+ * Reparte [0, nz) en bloques de PlanosPorBloqueZ planos consecutivos y llama a
+ * bloque(z0, z1) para cada uno en paralelo (en el orden que quiera el planificador).
+ * Los bloques deben escribir planos de salida distintos.
+ */
+template <class FuncionBloque>
+void RecorrerBloquesZ(int nz, const char* nombreTramo, const FuncionBloque& bloque)
+{
+    if (nz <= 0) return;
+    const int planosBloque = PlanosPorBloqueZ(nz);
+    const int numBloques = (nz + planosBloque - 1) / planosBloque;
+
+    cv::parallel_for_(cv::Range(0, numBloques), [&](const cv::Range& r) {
+        for (int b = r.start; b < r.end; ++b) {
+            TramoTraza tramo(nombreTramo, b);
+            const int z0 = b * planosBloque;
+            bloque(z0, std::min(nz, z0 + planosBloque));
+        }
+    }, numBloques);
+}
+
+#endif // BLOQUESZ_H
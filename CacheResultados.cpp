@@ -0,0 +1,154 @@
+// CacheResultados.cpp
+#include "CacheResultados.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrimo  = 1099511628211ULL;
+
+uint64_t Fnv1a(uint64_t h, const unsigned char* datos, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        h ^= datos[i];
+        h *= kFnvPrimo;
+    }
+    return h;
+}
+
+std::string Hex64(uint64_t v)
+{
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+// Memoria de hashes del proceso: (ruta, tamaño, mtime) -> hash
+std::mutex mtxMemo;
+std::map<std::tuple<std::string, std::string, std::string>, std::string> memoHashes;
+
+} // namespace
+
+bool CalcularHuella(const std::string& ruta, HuellaArchivo& huella, const HuellaArchivo* conocida)
+{
+    std::error_code ec;
+    const auto tam = fs::file_size(ruta, ec);
+    if (ec) return false;
+    const auto mtime = fs::last_write_time(ruta, ec);
+    if (ec) return false;
+
+    HuellaArchivo h;
+    h.tam   = std::to_string(tam);
+    h.mtime = std::to_string(static_cast<long long>(mtime.time_since_epoch().count()));
+
+    // 1) Ya calculada con el mismo tamaño y fecha (en el manifiesto o en este proceso)
+    if (conocida && !conocida->hash.empty() && conocida->tam == h.tam && conocida->mtime == h.mtime) {
+        h.hash = conocida->hash;
+        huella = h;
+        return true;
+    }
+    const auto claveMemo = std::make_tuple(fs::absolute(ruta, ec).string(), h.tam, h.mtime);
+    {
+        std::lock_guard<std::mutex> lock(mtxMemo);
+        auto it = memoHashes.find(claveMemo);
+        if (it != memoHashes.end()) {
+            h.hash = it->second;
+            huella = h;
+            return true;
+        }
+    }
+
+    // 2) Leer el archivo por bloques
+    std::ifstream in(ruta, std::ios::binary);
+    if (!in) return false;
+    std::vector<char> buffer(1 << 20);
+    uint64_t hash = kFnvOffset;
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        hash = Fnv1a(hash, reinterpret_cast<const unsigned char*>(buffer.data()),
+                     static_cast<size_t>(in.gcount()));
+    }
+    if (in.bad()) return false;
+
+    h.hash = Hex64(hash);
+    {
+        std::lock_guard<std::mutex> lock(mtxMemo);
+        memoHashes[claveMemo] = h.hash;
+    }
+    huella = h;
+    return true;
+}
+
+std::string ClaveResultados(
+    const HuellaArchivo& huellaImagen,
+    const HuellaArchivo& huellaMascara,
+    int filterOption,
+    const OpcionesProcesado& opciones
+)
+{
+    // Descripción canónica de todo lo que determina la salida; la clave es su hash
+    std::ostringstream desc;
+    desc << "v" << kVersionPipeline
+         << "|img=" << huellaImagen.hash
+         << "|mask=" << huellaMascara.hash
+         << "|filtro=" << filterOption
+         << "|orient=" << NombreOrientacion(opciones.orientacion)
+         << "|planos=" << opciones.planoInicio << ":" << opciones.planoFin
+         << "|stats=" << (opciones.recolectarEstadisticas ? 1 : 0);
+    if (opciones.modo3D) desc << "|3d=1";
+    if (opciones.radioFiltro > 0 && (filterOption == 11 || filterOption == 12)) desc << "|radio=" << opciones.radioFiltro;
+    if (!opciones.rutaVideo.empty()) {
+        desc << "|video=" << opciones.rutaVideo << "@" << opciones.videoInicio << ":"
+             << opciones.videoFin << "/" << opciones.fpsVideo;
+    }
+
+    const std::string s = desc.str();
+    return Hex64(Fnv1a(kFnvOffset, reinterpret_cast<const unsigned char*>(s.data()), s.size()));
+}
+
+bool ResultadosVigentes(
+    const std::string& rutaNifti,
+    const std::string& rutaMask,
+    const std::string& carpetaSalidaBase,
+    int filterOption,
+    const OpcionesProcesado& opciones,
+    ManifiestoResultados* manifiesto
+)
+{
+    ManifiestoResultados previo;
+    if (!LeerManifiesto(carpetaSalidaBase, previo) || previo.clave.empty() || previo.NumSlices() == 0)
+        return false;
+
+    HuellaArchivo huellaImg, huellaMask;
+    if (!CalcularHuella(rutaNifti, huellaImg, &previo.huellaImagen) ||
+        !CalcularHuella(rutaMask, huellaMask, &previo.huellaMascara))
+        return false;
+
+    if (ClaveResultados(huellaImg, huellaMask, filterOption, opciones) != previo.clave)
+        return false;
+
+    // Todos los archivos que lista el manifiesto deben seguir ahí
+    std::error_code ec;
+    const fs::path base{ carpetaSalidaBase };
+    for (const auto& nombre : previo.archivos)
+    {
+        for (const char* sub : { "original", "mask", "highlighted" })
+            if (!fs::exists(base / sub / nombre, ec)) return false;
+    }
+    if (!previo.rutaVideo.empty() && !fs::exists(previo.rutaVideo, ec)) return false;
+    if (!previo.archivoEstadisticas.empty() && !fs::exists(base / previo.archivoEstadisticas, ec)) return false;
+    if (!previo.archivoComponentes.empty() && !fs::exists(base / previo.archivoComponentes, ec)) return false;
+
+    if (manifiesto) *manifiesto = std::move(previo);
+    return true;
+}
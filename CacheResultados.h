@@ -0,0 +1,51 @@
+// CacheResultados.h
+#ifndef CACHERESULTADOS_H
+#define CACHERESULTADOS_H
+
+#include <string>
+#include "Manifiesto.h"           // para HuellaArchivo y ManifiestoResultados
+#include "Utils.h"                // para OpcionesProcesado
+
+// Cambiarla cuando cambie el pipeline (filtros, formato de salida...) invalida todos los resultados guardados
+constexpr int kVersionPipeline = 5;
+
+/**
+ * Calcula la huella de un archivo (FNV-1a de 64 bits del contenido).
+ * Si 'conocida' tiene el mismo tamaño y fecha de modificación que el archivo
+ * actual, se reutiliza su hash sin leer el archivo. Los hashes calculados se
+ * memorizan también en el proceso (por ruta, tamaño y fecha). Thread-safe.
+ *
+ * @return false si el archivo no existe o no se pudo leer.
+ */
+bool CalcularHuella(const std::string& ruta, HuellaArchivo& huella, const HuellaArchivo* conocida = nullptr);
+
+/**
+ * Clave de unos resultados: huellas de imagen y máscara, filtro y los parámetros
+ * de OpcionesProcesado que cambian lo que se escribe (orientación, rango de planos,
+ * estadísticas, video y, en los filtros 11 y 12, el radio). Los hilos y demás detalles de ejecución no cuentan.
+ */
+std::string ClaveResultados(
+    const HuellaArchivo& huellaImagen,
+    const HuellaArchivo& huellaMascara,
+    int filterOption,
+    const OpcionesProcesado& opciones
+);
+
+/**
+ * Comprueba si carpetaSalidaBase ya tiene los resultados de esta misma entrada,
+ * filtro y parámetros: manifiesto completo con la misma clave y todos sus
+ * archivos presentes (slices, video y estadísticas). En ese caso no hace falta
+ * volver a procesar.
+ *
+ * @param manifiesto Si no es nulo y los resultados están vigentes, recibe el manifiesto.
+ */
+bool ResultadosVigentes(
+    const std::string& rutaNifti,
+    const std::string& rutaMask,
+    const std::string& carpetaSalidaBase,
+    int filterOption,
+    const OpcionesProcesado& opciones,
+    ManifiestoResultados* manifiesto = nullptr
+);
+
+#endif // CACHERESULTADOS_H
@@ -0,0 +1,235 @@
+// Clahe.cpp
+#include "Clahe.h"
+#include <opencv2/core/utility.hpp>  // para cv::parallel_for_
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "BloquesZ.h"             // para RecorrerBloquesZ
+#include "Memoria.h"              // para MemoriaContada
+#include "Traza.h"
+
+// ----------------------------------------------------------
+// Rejilla de teselas
+// ----------------------------------------------------------
+
+// Límites de las teselas y, por columna y por fila, las dos teselas cuyos centros
+// rodean al píxel y el peso de la segunda (0 en los bordes, donde sólo hay una)
+struct RejillaClahe
+{
+    RejillaClahe(int ancho, int alto, const ParametrosClahe& p)
+        : tx(std::max(1, std::min(p.teselasX, ancho))), ty(std::max(1, std::min(p.teselasY, alto)))
+    {
+        Eje(ancho, tx, bordeX, teselaX, izq, der, pesoX);
+        Eje(alto,  ty, bordeY, teselaY, arriba, abajo, pesoY);
+    }
+
+    int NumTeselas() const { return tx * ty; }
+    double Area(int t) const
+    {
+        const int i = t % tx, j = t / tx;
+        return static_cast<double>(bordeX[i + 1] - bordeX[i]) * (bordeY[j + 1] - bordeY[j]);
+    }
+
+    int tx, ty;
+    std::vector<int> bordeX, bordeY;              // tx + 1 y ty + 1 límites
+    std::vector<int> teselaX, teselaY;            // tesela de cada columna y de cada fila
+    std::vector<int> izq, der, arriba, abajo;
+    std::vector<float> pesoX, pesoY;
+
+private:
+    static void Eje(int n, int teselas, std::vector<int>& bordes, std::vector<int>& tesela,
+                    std::vector<int>& primera, std::vector<int>& segunda, std::vector<float>& peso)
+    {
+        bordes.resize(teselas + 1);
+        for (int i = 0; i <= teselas; ++i) bordes[i] = static_cast<int>(static_cast<long long>(i) * n / teselas);
+
+        std::vector<float> centro(teselas);
+        for (int i = 0; i < teselas; ++i) centro[i] = 0.5f * (bordes[i] + bordes[i + 1] - 1);
+
+        tesela.resize(n);
+        primera.resize(n);
+        segunda.resize(n);
+        peso.resize(n);
+        int i = 0, k = 0;
+        for (int x = 0; x < n; ++x)
+        {
+            while (x >= bordes[i + 1]) ++i;
+            tesela[x] = i;
+
+            while (k + 1 < teselas && centro[k + 1] <= x) ++k;
+            if (x <= centro[0] || k + 1 == teselas) {
+                primera[x] = segunda[x] = (x <= centro[0]) ? 0 : teselas - 1;
+                peso[x] = 0.0f;
+            } else {
+                primera[x] = k;
+                segunda[x] = k + 1;
+                peso[x] = (x - centro[k]) / (centro[k + 1] - centro[k]);
+            }
+        }
+    }
+};
+
+// Suma al histograma de cada tesela de la fila de teselas 'j' sus píxeles del plano
+static void HistogramasFilaTeselas(const cv::Mat& plano, const RejillaClahe& rejilla, int j, uint32_t* hist)
+{
+    for (int y = rejilla.bordeY[j]; y < rejilla.bordeY[j + 1]; ++y)
+    {
+        const uchar* fila = plano.ptr<uchar>(y);
+        for (int x = 0; x < plano.cols; ++x)
+            ++hist[(static_cast<size_t>(j) * rejilla.tx + rejilla.teselaX[x]) * 256 + fila[x]];
+    }
+}
+
+// Recorta el histograma de una tesela de 'area' píxeles, reparte el exceso entre los
+// 256 niveles y escribe su LUT (la CDF escalada a 0..255, como cv::createCLAHE)
+static void TablaTesela(float* hist, double area, double limiteRecorte, uchar* lut)
+{
+    const float limite = static_cast<float>(std::max(1.0, limiteRecorte * area / 256.0));
+    float exceso = 0.0f;
+    for (int v = 0; v < 256; ++v) {
+        if (hist[v] > limite) {
+            exceso += hist[v] - limite;
+            hist[v] = limite;
+        }
+    }
+    const float reparto = exceso / 256.0f;
+    const float escala = static_cast<float>(255.0 / area);
+    float acumulado = 0.0f;
+    for (int v = 0; v < 256; ++v) {
+        acumulado += hist[v] + reparto;
+        lut[v] = cv::saturate_cast<uchar>(acumulado * escala);
+    }
+}
+
+// Buffers de una fila: los valores de las cuatro LUT de cada píxel
+struct FilaClahe
+{
+    explicit FilaClahe(int ancho) : a(ancho), b(ancho), c(ancho), d(ancho) {}
+    std::vector<uchar> a, b, c, d;
+};
+
+// Fila y del resultado: mezcla bilineal de las LUT de las cuatro teselas que rodean cada píxel
+static void InterpolarFila(const RejillaClahe& rejilla, const uchar* luts, const uchar* src, uchar* dst,
+                           int y, FilaClahe& fila)
+{
+    const int ancho = static_cast<int>(rejilla.teselaX.size());
+    const uchar* lutArriba = luts + static_cast<size_t>(rejilla.arriba[y]) * rejilla.tx * 256;
+    const uchar* lutAbajo  = luts + static_cast<size_t>(rejilla.abajo[y]) * rejilla.tx * 256;
+    const int* izq = rejilla.izq.data();
+    const int* der = rejilla.der.data();
+    for (int x = 0; x < ancho; ++x) {
+        const int i = izq[x] * 256 + src[x], d = der[x] * 256 + src[x];
+        fila.a[x] = lutArriba[i];
+        fila.b[x] = lutArriba[d];
+        fila.c[x] = lutAbajo[i];
+        fila.d[x] = lutAbajo[d];
+    }
+
+    const float wy = rejilla.pesoY[y];
+    const float* wx = rejilla.pesoX.data();
+    const uchar *a = fila.a.data(), *b = fila.b.data(), *c = fila.c.data(), *d = fila.d.data();
+    for (int x = 0; x < ancho; ++x) {
+        const float sup = a[x] + wx[x] * (static_cast<float>(b[x]) - a[x]);
+        const float inf = c[x] + wx[x] * (static_cast<float>(d[x]) - c[x]);
+        dst[x] = static_cast<uchar>(sup + wy * (inf - sup) + 0.5f);
+    }
+}
+
+// ----------------------------------------------------------
+// CLAHE de un plano y de un volumen
+// ----------------------------------------------------------
+
+cv::Mat AplicarClahe(const cv::Mat& src, const ParametrosClahe& parametros)
+{
+    CV_Assert(src.type() == CV_8UC1 && parametros.limiteRecorte > 0);
+    if (src.empty()) return src.clone();
+
+    const RejillaClahe rejilla(src.cols, src.rows, parametros);
+    const size_t porPlano = static_cast<size_t>(rejilla.NumTeselas()) * 256;
+    std::vector<uint32_t> hist(porPlano, 0);
+    std::vector<uchar> luts(porPlano);
+
+    cv::parallel_for_(cv::Range(0, rejilla.ty), [&](const cv::Range& r) {
+        std::vector<float> h(256);
+        for (int j = r.start; j < r.end; ++j) {
+            HistogramasFilaTeselas(src, rejilla, j, hist.data());
+            for (int t = j * rejilla.tx; t < (j + 1) * rejilla.tx; ++t) {
+                std::copy(hist.begin() + t * 256, hist.begin() + (t + 1) * 256, h.begin());
+                TablaTesela(h.data(), rejilla.Area(t), parametros.limiteRecorte, luts.data() + t * 256);
+            }
+        }
+    }, rejilla.ty);
+
+    cv::Mat dst(src.size(), CV_8U);
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& r) {
+        FilaClahe fila(src.cols);
+        for (int y = r.start; y < r.end; ++y)
+            InterpolarFila(rejilla, luts.data(), src.ptr<uchar>(y), dst.ptr<uchar>(y), y, fila);
+    });
+    return dst;
+}
+
+Volumen8u ClaheVolumen(const Volumen8u& vol, int radioZ, const ParametrosClahe& parametros)
+{
+    CV_Assert(radioZ >= 0 && parametros.limiteRecorte > 0);
+    const int nx = vol.Nx(), ny = vol.Ny(), nz = vol.Nz();
+    Volumen8u dst(nx, ny, nz, vol.Espaciado());
+    if (vol.Vacio()) return dst;
+
+    TramoTraza tramo("claheVolumen");
+    const RejillaClahe rejilla(nx, ny, parametros);
+    const int numTeselas = rejilla.NumTeselas();
+    const size_t porPlano = static_cast<size_t>(numTeselas) * 256;
+
+    // 1) Histogramas de las teselas de cada plano (se sueltan en cuanto salen las LUT)
+    std::vector<uint32_t> hist(porPlano * nz, 0);
+    MemoriaContada memoriaHist{ CategoriaMemoria::Filtros };
+    memoriaHist.Fijar(static_cast<long long>(hist.size() * sizeof(uint32_t)));
+    RecorrerBloquesZ(nz, "histogramasClahe", [&](int z0, int z1) {
+        for (int z = z0; z < z1; ++z) {
+            const cv::Mat plano = vol.PlanoAxial(z);
+            for (int j = 0; j < rejilla.ty; ++j) HistogramasFilaTeselas(plano, rejilla, j, hist.data() + z * porPlano);
+        }
+    });
+
+    // 2) Media de cada tesela con la misma tesela de los planos vecinos (los que caen
+    //    fuera del volumen no cuentan), recorte y LUT
+    std::vector<uchar> luts(porPlano * nz);
+    MemoriaContada memoriaLuts{ CategoriaMemoria::Filtros };
+    memoriaLuts.Fijar(static_cast<long long>(luts.size()));
+    RecorrerBloquesZ(nz, "tablasClahe", [&](int z0, int z1) {
+        std::vector<float> h(256);
+        for (int z = z0; z < z1; ++z)
+            for (int t = 0; t < numTeselas; ++t)
+            {
+                std::fill(h.begin(), h.end(), 0.0f);
+                float pesoTotal = 0.0f;
+                for (int k = -radioZ; k <= radioZ; ++k) {
+                    const int zz = z + k;
+                    if (zz < 0 || zz >= nz) continue;
+                    const float w = static_cast<float>(radioZ + 1 - std::abs(k));
+                    const uint32_t* hk = hist.data() + zz * porPlano + t * 256;
+                    for (int v = 0; v < 256; ++v) h[v] += w * hk[v];
+                    pesoTotal += w;
+                }
+                for (int v = 0; v < 256; ++v) h[v] /= pesoTotal;
+                TablaTesela(h.data(), rejilla.Area(t), parametros.limiteRecorte, luts.data() + z * porPlano + t * 256);
+            }
+    });
+
+    std::vector<uint32_t>().swap(hist);
+    memoriaHist.Fijar(0);
+
+    // 3) Interpolación de cada plano con sus LUT
+    RecorrerBloquesZ(nz, "interpolarClahe", [&](int z0, int z1) {
+        FilaClahe fila(nx);
+        for (int z = z0; z < z1; ++z)
+            for (int y = 0; y < ny; ++y) {
+                const size_t desplazamiento = static_cast<size_t>(y) * nx;
+                InterpolarFila(rejilla, luts.data() + z * porPlano, vol.Plano(z) + desplazamiento,
+                               dst.Plano(z) + desplazamiento, y, fila);
+            }
+    });
+    return dst;
+}
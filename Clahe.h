@@ -0,0 +1,36 @@
+// Clahe.h
+#ifndef CLAHE_H
+#define CLAHE_H
+
+#include <opencv2/core.hpp>
+#include "Filtros3D.h"            // para Volumen8u
+
+/**
+ * Parámetros del CLAHE, con los valores por defecto de cv::createCLAHE.
+ */
+struct ParametrosClahe
+{
+    int teselasX = 8;               // rejilla de teselas (se reduce si el plano es más pequeño)
+    int teselasY = 8;
+    double limiteRecorte = 2.0;     // en múltiplos de la altura del histograma uniforme
+};
+
+/**
+ * Ecualización adaptativa de histograma con contraste limitado (CLAHE) de un plano
+ * CV_8UC1. Los histogramas de las teselas se cuentan en paralelo (una fila de teselas
+ * por tarea); cada uno se recorta, reparte el exceso entre todos los niveles y se pasa
+ * a LUT. Cada píxel mezcla con pesos bilineales las LUT de las cuatro teselas cuyos
+ * centros lo rodean: primero se leen las cuatro LUT de la fila y después se mezclan en
+ * un bucle sin saltos que el compilador vectoriza.
+ */
+cv::Mat AplicarClahe(const cv::Mat& src, const ParametrosClahe& parametros = ParametrosClahe());
+
+/**
+ * CLAHE de todos los planos axiales de un volumen. El histograma de cada tesela se
+ * promedia con los de la misma tesela en los 'radioZ' planos de cada lado (pesos
+ * triangulares) antes de recortarlo, así que las LUT, y con ellas el contraste, cambian
+ * de forma continua de un slice al siguiente. Con radioZ = 0 es AplicarClahe plano a plano.
+ */
+Volumen8u ClaheVolumen(const Volumen8u& vol, int radioZ, const ParametrosClahe& parametros = ParametrosClahe());
+
+#endif // CLAHE_H
@@ -0,0 +1,448 @@
+// ColaTrabajo.cpp
+#include "ColaTrabajo.h"
+#include <opencv2/core.hpp>       // para cv::FileStorage (JSON)
+#include <unistd.h>               // para gethostname y getpid
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char* kPendientes = "pendientes";
+constexpr const char* kEnCurso    = "en_curso";
+constexpr const char* kHechos     = "hechos";
+constexpr const char* kFallidos   = "fallidos";
+constexpr const char* kExtTarea   = ".json";
+constexpr const char* kExtLease   = ".lease";
+
+// Una tarea de la cola: el caso y con qué opciones procesarlo
+struct Tarea
+{
+    CasoLote     caso;
+    std::string  salida;          // carpeta de salida del caso (con '/' final)
+    OpcionesLote opciones;
+    int          intentos = 0;    // veces que se ha reclamado
+};
+
+// "host:pid", para saber quién tiene cada lease
+std::string IdTrabajador()
+{
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) != 0) host[0] = '\0';
+    return std::string(host[0] ? host : "localhost") + ":" + std::to_string(getpid());
+}
+
+fs::path RutaTarea(const fs::path& dir, const std::string& nombre) { return dir / (nombre + kExtTarea); }
+fs::path RutaLease(const fs::path& dir, const std::string& nombre) { return dir / (nombre + kExtLease); }
+
+// Segundos desde la última modificación; negativo si el archivo no existe
+double Antiguedad(const fs::path& ruta)
+{
+    std::error_code ec;
+    const auto t = fs::last_write_time(ruta, ec);
+    if (ec) return -1.0;
+    return std::chrono::duration<double>(fs::file_time_type::clock::now() - t).count();
+}
+
+bool Tocar(const fs::path& ruta)
+{
+    std::error_code ec;
+    fs::last_write_time(ruta, fs::file_time_type::clock::now(), ec);
+    return !ec;
+}
+
+// Nombres (sin extensión) de las tareas de un directorio, ordenados.
+// Los temporales empiezan por '.' y se ignoran.
+std::vector<std::string> ListarTareas(const fs::path& dir)
+{
+    std::vector<std::string> nombres;
+    std::error_code ec;
+    for (const auto& entrada : fs::directory_iterator(dir, ec))
+    {
+        const fs::path& p = entrada.path();
+        const std::string archivo = p.filename().string();
+        if (archivo.empty() || archivo[0] == '.' || p.extension() != kExtTarea) continue;
+        nombres.push_back(p.stem().string());
+    }
+    std::sort(nombres.begin(), nombres.end());
+    return nombres;
+}
+
+// Escribe un archivo de forma atómica (temporal oculto en el mismo directorio + rename)
+template <typename Escritor>
+bool EscribirAtomico(const fs::path& ruta, Escritor escribir)
+{
+    const fs::path tmp = ruta.parent_path() / ("." + ruta.filename().string() + ".tmp");
+    try
+    {
+        cv::FileStorage out(tmp.string(), cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+        if (!out.isOpened()) return false;
+        escribir(out);
+        out.release();
+        fs::rename(tmp, ruta);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[ERROR] Escribiendo '" << ruta.string() << "': " << e.what() << "\n";
+        std::error_code ec;
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+void EscribirCamposTarea(cv::FileStorage& out, const Tarea& t)
+{
+    out << "nombre"       << t.caso.nombre;
+    out << "imagen"       << t.caso.rutaImagen;
+    out << "mascara"      << t.caso.rutaMascara;
+    out << "salida"       << t.salida;
+    out << "filtro"       << t.opciones.filtro;
+    out << "orientacion"  << std::string(NombreOrientacion(t.opciones.orientacion));
+    out << "video"        << static_cast<int>(t.opciones.video);
+    out << "estadisticas" << static_cast<int>(t.opciones.estadisticas);
+    out << "modo3D"       << static_cast<int>(t.opciones.modo3D);
+    out << "radioFiltro"  << t.opciones.radioFiltro;
+    out << "reanudar"     << static_cast<int>(t.opciones.reanudar);
+    out << "intentos"     << t.intentos;
+}
+
+bool EscribirTarea(const fs::path& ruta, const Tarea& t)
+{
+    return EscribirAtomico(ruta, [&](cv::FileStorage& out) { EscribirCamposTarea(out, t); });
+}
+
+bool LeerTarea(const fs::path& ruta, Tarea& t)
+{
+    try
+    {
+        cv::FileStorage in(ruta.string(), cv::FileStorage::READ | cv::FileStorage::FORMAT_JSON);
+        if (!in.isOpened()) return false;
+
+        std::string orientacion;
+        int video = 0, estadisticas = 1, modo3D = 0, reanudar = 1;
+        in["nombre"]       >> t.caso.nombre;
+        in["imagen"]       >> t.caso.rutaImagen;
+        in["mascara"]      >> t.caso.rutaMascara;
+        in["salida"]       >> t.salida;
+        in["filtro"]       >> t.opciones.filtro;
+        in["orientacion"]  >> orientacion;
+        in["video"]        >> video;
+        in["estadisticas"] >> estadisticas;
+        in["modo3D"]       >> modo3D;
+        in["radioFiltro"]  >> t.opciones.radioFiltro;
+        in["reanudar"]     >> reanudar;
+        in["intentos"]     >> t.intentos;
+
+        t.opciones.orientacion  = OrientacionDesdeNombre(orientacion);
+        t.opciones.video        = video != 0;
+        t.opciones.estadisticas = estadisticas != 0;
+        t.opciones.modo3D       = modo3D != 0;
+        t.opciones.reanudar     = reanudar != 0;
+    }
+    catch (const cv::Exception& e)
+    {
+        std::cerr << "[ERROR] Leyendo tarea '" << ruta.string() << "': " << e.what() << "\n";
+        return false;
+    }
+    return !t.caso.nombre.empty() && !t.salida.empty();
+}
+
+std::string LeerIdLease(const fs::path& ruta)
+{
+    std::ifstream in(ruta);
+    std::string id;
+    std::getline(in, id);
+    return id;
+}
+
+bool EscribirLease(const fs::path& ruta, const std::string& id)
+{
+    const fs::path tmp = ruta.parent_path() / ("." + ruta.filename().string() + ".tmp");
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) return false;
+        out << id << "\n";
+        if (!out) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, ruta, ec);
+    return !ec;
+}
+
+/**
+ * Devuelve a pendientes/ las tareas en curso cuyo lease no se ha renovado en
+ * 'segundosLease'. El lease vencido se aparta primero con un rename a un nombre
+ * propio del trabajador: si dos trabajadores ven el mismo lease vencido, sólo uno
+ * consigue apartarlo y es ése quien mueve la tarea.
+ */
+int ReclamarVencidas(const fs::path& cola, const std::string& id, int segundosLease)
+{
+    const fs::path dirEnCurso    = cola / kEnCurso;
+    const fs::path dirPendientes = cola / kPendientes;
+    int reclamadas = 0;
+
+    for (const auto& nombre : ListarTareas(dirEnCurso))
+    {
+        const fs::path tarea = RutaTarea(dirEnCurso, nombre);
+        const fs::path lease = RutaLease(dirEnCurso, nombre);
+        std::error_code ec;
+
+        const double edadLease = Antiguedad(lease);
+        if (edadLease >= 0.0)
+        {
+            if (edadLease < segundosLease) continue;
+
+            const fs::path apartado = dirEnCurso / ("." + nombre + ".vencido." + id);
+            fs::rename(lease, apartado, ec);
+            if (ec) continue;                          // otro trabajador se adelantó
+            fs::rename(tarea, RutaTarea(dirPendientes, nombre), ec);
+            std::error_code ecBorrar;
+            fs::remove(apartado, ecBorrar);
+            if (ec) continue;                          // ya la había cerrado o devuelto otro
+        }
+        else
+        {
+            // Sin lease: el trabajador cayó justo después de reclamarla. Al reclamar
+            // se actualiza la fecha de la tarea, así que ésta hace de lease.
+            const double edadTarea = Antiguedad(tarea);
+            if (edadTarea < segundosLease) continue;
+            fs::rename(tarea, RutaTarea(dirPendientes, nombre), ec);
+            if (ec) continue;
+        }
+
+        ++reclamadas;
+        std::cout << "[INFO] Lease vencido de '" << nombre << "': vuelve a pendientes.\n";
+    }
+    return reclamadas;
+}
+
+// Mueve una tarea ya reclamada a fallidos/ con el motivo
+void MarcarFallida(const fs::path& cola, const std::string& nombre, const Tarea& t, const std::string& motivo)
+{
+    const fs::path enCurso = RutaTarea(cola / kEnCurso, nombre);
+    EscribirAtomico(enCurso, [&](cv::FileStorage& out) {
+        EscribirCamposTarea(out, t);
+        out << "error" << motivo;
+    });
+    std::error_code ec;
+    fs::rename(enCurso, RutaTarea(cola / kFallidos, nombre), ec);
+    fs::remove(RutaLease(cola / kEnCurso, nombre), ec);
+}
+
+/**
+ * Reclama la primera tarea pendiente que se pueda. Antes del rename se actualiza
+ * su fecha, para que ReclamarVencidas no la tome por abandonada en el instante
+ * entre el rename y la creación del lease.
+ * @return true si se reclamó una tarea (en 'nombre' y 't').
+ */
+bool ReclamarTarea(const fs::path& cola, const std::string& id, int maxIntentos,
+                   std::string& nombre, Tarea& t, int& fallidas)
+{
+    const fs::path dirPendientes = cola / kPendientes;
+    const fs::path dirEnCurso    = cola / kEnCurso;
+
+    for (const auto& candidato : ListarTareas(dirPendientes))
+    {
+        const fs::path origen = RutaTarea(dirPendientes, candidato);
+        if (!Tocar(origen)) continue;                  // ya la reclamó otro
+
+        std::error_code ec;
+        fs::rename(origen, RutaTarea(dirEnCurso, candidato), ec);
+        if (ec) continue;
+
+        EscribirLease(RutaLease(dirEnCurso, candidato), id);
+
+        Tarea leida;
+        if (!LeerTarea(RutaTarea(dirEnCurso, candidato), leida)) {
+            MarcarFallida(cola, candidato, leida, "archivo de tarea ilegible");
+            ++fallidas;
+            continue;
+        }
+        ++leida.intentos;
+        if (leida.intentos > maxIntentos) {
+            std::cerr << "[ERROR] '" << candidato << "' agotó sus " << maxIntentos << " intentos.\n";
+            MarcarFallida(cola, candidato, leida, "agotados los intentos");
+            ++fallidas;
+            continue;
+        }
+        EscribirTarea(RutaTarea(dirEnCurso, candidato), leida);
+
+        nombre = candidato;
+        t = leida;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Cierra una tarea: escribe el resultado y la mueve a hechos/ o fallidos/.
+ * Si entretanto el lease pasó a otro trabajador (este se quedó sin latir), no
+ * toca nada y devuelve false.
+ */
+bool TerminarTarea(const fs::path& cola, const std::string& id, const std::string& nombre,
+                   const Tarea& t, const ResultadoCaso& res)
+{
+    const fs::path dirEnCurso = cola / kEnCurso;
+    const fs::path enCurso    = RutaTarea(dirEnCurso, nombre);
+    const fs::path lease      = RutaLease(dirEnCurso, nombre);
+
+    if (LeerIdLease(lease) != id) {
+        std::cerr << "[WARNING] '" << nombre << "' ya no es de este trabajador (lease vencido); se descarta el resultado.\n";
+        return false;
+    }
+
+    EscribirAtomico(enCurso, [&](cv::FileStorage& out) {
+        EscribirCamposTarea(out, t);
+        out << "trabajador"  << id;
+        out << "ok"          << static_cast<int>(res.ok);
+        out << "reutilizado" << static_cast<int>(res.reutilizado);
+        out << "numSlices"   << res.numSlices;
+        out << "msTotal"     << res.msTotal;
+    });
+
+    std::error_code ec;
+    fs::rename(enCurso, RutaTarea(cola / (res.ok ? kHechos : kFallidos), nombre), ec);
+    if (ec) {
+        std::cerr << "[WARNING] No se pudo cerrar '" << nombre << "': " << ec.message() << "\n";
+        return false;
+    }
+    fs::remove(lease, ec);
+    return true;
+}
+
+} // namespace
+
+bool PrepararCola(const std::string& dirCola)
+{
+    std::error_code ec;
+    for (const char* sub : { kPendientes, kEnCurso, kHechos, kFallidos })
+    {
+        fs::create_directories(fs::path(dirCola) / sub, ec);
+        if (ec) {
+            std::cerr << "[ERROR] No se pudo crear la cola en '" << dirCola << "': " << ec.message() << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int EncolarCasos(
+    const std::vector<CasoLote>& casos,
+    const std::string& carpetaSalida,
+    const OpcionesLote& opciones,
+    const std::string& dirCola
+)
+{
+    if (!PrepararCola(dirCola)) return -1;
+    const fs::path cola{ dirCola };
+
+    int nuevas = 0;
+    for (const auto& caso : casos)
+    {
+        std::error_code ec;
+        bool yaEsta = false;
+        for (const char* sub : { kPendientes, kEnCurso, kHechos, kFallidos })
+            yaEsta = yaEsta || fs::exists(RutaTarea(cola / sub, caso.nombre), ec);
+        if (yaEsta) continue;
+
+        Tarea t;
+        t.caso     = caso;
+        t.caso.rutaImagen  = fs::absolute(caso.rutaImagen, ec).string();
+        t.caso.rutaMascara = fs::absolute(caso.rutaMascara, ec).string();
+        t.salida   = (fs::absolute(carpetaSalida, ec) / caso.nombre).string() + "/";
+        t.opciones = opciones;
+
+        if (!EscribirTarea(RutaTarea(cola / kPendientes, caso.nombre), t)) return -1;
+        ++nuevas;
+    }
+    return nuevas;
+}
+
+ResumenTrabajador EjecutarTrabajador(const std::string& dirCola, const OpcionesTrabajador& opciones)
+{
+    using Reloj = std::chrono::steady_clock;
+    const auto t0 = Reloj::now();
+
+    ResumenTrabajador resumen;
+    if (!PrepararCola(dirCola)) return resumen;
+
+    const fs::path cola{ dirCola };
+    const std::string id = IdTrabajador();
+    const int segundosLease = std::max(3, opciones.segundosLease);
+    const auto periodoLatido = std::chrono::seconds(std::max(1, segundosLease / 3));
+
+    std::cout << "[INFO] Trabajador " << id << " sobre la cola '" << dirCola << "'.\n";
+
+    while (true)
+    {
+        resumen.reclamados += ReclamarVencidas(cola, id, segundosLease);
+
+        std::string nombre;
+        Tarea t;
+        if (ReclamarTarea(cola, id, opciones.maxIntentos, nombre, t, resumen.fallidos))
+        {
+            std::cout << "[INFO] Procesando '" << nombre << "' (intento " << t.intentos << ").\n";
+
+            // Latido: renueva la fecha del lease mientras se procesa el caso
+            std::mutex mtx;
+            std::condition_variable cv;
+            bool terminado = false;
+            std::thread latido([&]() {
+                const fs::path lease = RutaLease(cola / kEnCurso, nombre);
+                std::unique_lock<std::mutex> lock(mtx);
+                while (!cv.wait_for(lock, periodoLatido, [&] { return terminado; }))
+                    Tocar(lease);
+            });
+
+            ResultadoCaso res;
+            try {
+                res = ProcesarCaso(t.caso, t.salida, t.opciones, opciones.numHilos);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "[ERROR] Procesando '" << nombre << "': " << e.what() << "\n";
+                res.nombre = nombre;
+                res.ok = false;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                terminado = true;
+            }
+            cv.notify_one();
+            latido.join();
+
+            if (TerminarTarea(cola, id, nombre, t, res)) {
+                if (!res.ok)               ++resumen.fallidos;
+                else if (res.reutilizado)  ++resumen.reutilizados;
+                else {
+                    ++resumen.procesados;
+                    resumen.slices += res.numSlices;
+                }
+            }
+            std::cout << "[INFO] '" << nombre << "'"
+                      << (res.reutilizado ? " ya hecho" : res.ok ? " ok" : " ERROR");
+            if (res.ok) std::cout << " (" << res.numSlices << " slices, " << res.msTotal << " ms)";
+            std::cout << "\n";
+            continue;
+        }
+
+        // Sin tareas libres: terminar si tampoco queda ninguna en curso
+        // (o si no hay que esperar a las de otros trabajadores)
+        if (ListarTareas(cola / kPendientes).empty() &&
+            (!opciones.esperarEnCurso || ListarTareas(cola / kEnCurso).empty()))
+            break;
+
+        std::this_thread::sleep_for(std::chrono::seconds(std::max(1, opciones.segundosEspera)));
+    }
+
+    resumen.segundos = std::chrono::duration<double>(Reloj::now() - t0).count();
+    return resumen;
+}
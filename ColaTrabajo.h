@@ -0,0 +1,77 @@
+// ColaTrabajo.h
+#ifndef COLATRABAJO_H
+#define COLATRABAJO_H
+
+#include <string>
+#include <vector>
+#include "Lote.h"                 // para CasoLote, OpcionesLote y ProcesarCaso
+
+/**
+ * Cola de casos en un directorio compartido, para repartir un lote entre varios
+ * procesos (en una o varias máquinas con el mismo sistema de archivos) sin
+ * ningún servicio de planificación:
+ *
+ *   <cola>/pendientes/<caso>.json   tarea por hacer
+ *   <cola>/en_curso/<caso>.json     tarea reclamada por un trabajador
+ *   <cola>/en_curso/<caso>.lease    quién la tiene; su fecha es el latido (heartbeat)
+ *   <cola>/hechos/<caso>.json       terminada (con su resultado)
+ *   <cola>/fallidos/<caso>.json     falló o agotó los intentos
+ *
+ * Reclamar una tarea es un rename de pendientes/ a en_curso/: es atómico, así que
+ * sólo un trabajador lo consigue. Mientras procesa, el trabajador renueva la fecha
+ * del .lease; si un lease no se renueva en 'segundosLease' (proceso o nodo caído),
+ * cualquier trabajador devuelve la tarea a pendientes/.
+ * Los relojes de las máquinas deben diferir bastante menos que 'segundosLease'.
+ */
+
+/**
+ * Crea los subdirectorios de la cola si no existen.
+ */
+bool PrepararCola(const std::string& dirCola);
+
+/**
+ * Añade un archivo de tarea por caso a pendientes/. Cada caso se procesará en
+ * carpetaSalida/<caso>/ con las opciones dadas. Los casos que ya estén en la
+ * cola (en cualquier estado) no se duplican.
+ * @return Número de tareas añadidas, o -1 si hubo error.
+ */
+int EncolarCasos(
+    const std::vector<CasoLote>& casos,
+    const std::string& carpetaSalida,
+    const OpcionesLote& opciones,
+    const std::string& dirCola
+);
+
+/**
+ * Opciones de un trabajador.
+ */
+struct OpcionesTrabajador
+{
+    int  numHilos        = 0;     // hilos para cada caso (0 = todos los núcleos)
+    int  segundosLease   = 300;   // sin latido durante este tiempo, la tarea se reclama
+    int  segundosEspera  = 5;     // espera entre intentos cuando no hay tareas libres
+    int  maxIntentos     = 3;     // reclamaciones de una tarea antes de darla por fallida
+    bool esperarEnCurso  = true;  // si no hay pendientes, esperar a las en curso (por si caen)
+};
+
+/**
+ * Qué hizo un trabajador.
+ */
+struct ResumenTrabajador
+{
+    int procesados   = 0;
+    int reutilizados = 0;
+    int fallidos     = 0;
+    int reclamados   = 0;         // leases vencidos devueltos a pendientes/
+    long long slices = 0;
+    double segundos  = 0.0;
+};
+
+/**
+ * Toma tareas de la cola y las procesa con el mismo pipeline que ProcesarLote
+ * (ProcesarCaso -> ProcesarTodosSlices) hasta que no quedan pendientes ni en curso.
+ * Pueden ejecutarse tantos trabajadores como se quiera sobre la misma cola.
+ */
+ResumenTrabajador EjecutarTrabajador(const std::string& dirCola, const OpcionesTrabajador& opciones);
+
+#endif // COLATRABAJO_H
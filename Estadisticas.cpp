@@ -0,0 +1,571 @@
+// Estadisticas.cpp
+#include "Estadisticas.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <type_traits>
+
+std::vector<uint64_t> Histograma8u(const cv::Mat& gray8u)
+{
+    std::vector<uint64_t> hist(256, 0);
+    if (gray8u.empty()) return hist;
+    CV_Assert(gray8u.type() == CV_8UC1);
+
+    // Contadores de 32 bits por sub-histograma. Cada fila suma como mucho 'cols' a un
+    // contador, así que se vuelcan a 64 bits cada ⌊(2^32 − 1)/cols⌋ filas (en la práctica,
+    // una sola vez al final) y no tras cada fila
+    uint32_t sub[4][256] = {};
+    auto volcar = [&]() {
+        for (int v = 0; v < 256; ++v) {
+            hist[v] += static_cast<uint64_t>(sub[0][v]) + sub[1][v] + sub[2][v] + sub[3][v];
+            sub[0][v] = sub[1][v] = sub[2][v] = sub[3][v] = 0;
+        }
+    };
+    const uint64_t filas = UINT32_MAX / static_cast<uint64_t>(gray8u.cols);
+    const int filasPorVolcado = static_cast<int>(std::min<uint64_t>(INT_MAX, std::max<uint64_t>(1, filas)));
+
+    for (int y = 0; y < gray8u.rows; ++y)
+    {
+        const uchar* p = gray8u.ptr<uchar>(y);
+        int x = 0;
+        for (; x + 4 <= gray8u.cols; x += 4)
+        {
+            ++sub[0][p[x]];
+            ++sub[1][p[x + 1]];
+            ++sub[2][p[x + 2]];
+            ++sub[3][p[x + 3]];
+        }
+        for (; x < gray8u.cols; ++x)
+            ++sub[0][p[x]];
+
+        if ((y + 1) % filasPorVolcado == 0) volcar();
+    }
+    volcar();
+    return hist;
+}
+
+namespace {
+
+// Valor (índice de bin) que ocupa la posición 'rango' (base 0) en los datos ordenados.
+size_t BinEnRango(const std::vector<uint64_t>& hist, uint64_t rango)
+{
+    uint64_t acumulado = 0;
+    for (size_t i = 0; i < hist.size(); ++i) {
+        acumulado += hist[i];
+        if (acumulado > rango) return i;
+    }
+    return hist.size() - 1;
+}
+
+// Percentil con interpolación lineal entre rangos vecinos (por defecto de numpy).
+double Percentil(const std::vector<uint64_t>& hist, uint64_t n, double q)
+{
+    double pos = q * static_cast<double>(n - 1);
+    uint64_t lo = static_cast<uint64_t>(std::floor(pos));
+    uint64_t hi = static_cast<uint64_t>(std::ceil(pos));
+    double vLo = static_cast<double>(BinEnRango(hist, lo));
+    double vHi = (hi == lo) ? vLo : static_cast<double>(BinEnRango(hist, hi));
+    return vLo + (vHi - vLo) * (pos - static_cast<double>(lo));
+}
+
+} // namespace
+
+EstadisticasIntensidad EstadisticasDesdeHistograma(
+    const std::vector<uint64_t>& hist,
+    double origen,
+    double anchoBin)
+{
+    EstadisticasIntensidad e;
+    auto valor = [&](double bin) { return origen + bin * anchoBin; };
+
+    size_t primero = hist.size(), ultimo = 0, binModa = 0;
+    double suma = 0.0, sumaCuad = 0.0;
+    for (size_t i = 0; i < hist.size(); ++i)
+    {
+        if (hist[i] == 0) continue;
+        if (primero == hist.size()) primero = i;
+        ultimo = i;
+        if (hist[i] > hist[binModa] || hist[binModa] == 0) binModa = i;
+
+        double v = valor(static_cast<double>(i));
+        double c = static_cast<double>(hist[i]);
+        e.n      += hist[i];
+        suma     += c * v;
+        sumaCuad += c * v * v;
+    }
+    if (e.n == 0) return e;
+
+    double n = static_cast<double>(e.n);
+    e.media      = suma / n;
+    e.varianza   = std::max(0.0, sumaCuad / n - e.media * e.media);
+    e.desviacion = std::sqrt(e.varianza);
+    e.moda       = valor(static_cast<double>(binModa));
+    e.minimo     = valor(static_cast<double>(primero));
+    e.maximo     = valor(static_cast<double>(ultimo));
+
+    // Percentiles en unidades de bin y luego a valor
+    e.mediana = valor(Percentil(hist, e.n, 0.50));
+    e.q1      = valor(Percentil(hist, e.n, 0.25));
+    e.q3      = valor(Percentil(hist, e.n, 0.75));
+
+    // Bigotes como matplotlib: el dato más extremo dentro de 1.5 * IQR
+    double iqr = e.q3 - e.q1;
+    double limInf = e.q1 - 1.5 * iqr;
+    double limSup = e.q3 + 1.5 * iqr;
+    e.bigoteInferior = e.q1;
+    e.bigoteSuperior = e.q3;
+    bool hayInf = false;
+    for (size_t i = primero; i <= ultimo; ++i)
+    {
+        if (hist[i] == 0) continue;
+        double v = valor(static_cast<double>(i));
+        if (v < limInf || v > limSup) {
+            e.atipicos.push_back(v);
+            continue;
+        }
+        if (!hayInf) { e.bigoteInferior = std::min(v, e.q1); hayInf = true; }
+        e.bigoteSuperior = std::max(v, e.q3);
+    }
+    return e;
+}
+
+EstadisticasIntensidad CalcularEstadisticas8u(const cv::Mat& img)
+{
+    if (img.empty()) return {};
+
+    cv::Mat gray;
+    if (img.channels() == 3)      cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+    else if (img.channels() == 4) cv::cvtColor(img, gray, cv::COLOR_BGRA2GRAY);
+    else                          gray = img;
+
+    if (gray.depth() != CV_8U)
+        gray.convertTo(gray, CV_8U);
+
+    return EstadisticasDesdeHistograma(Histograma8u(gray));
+}
+
+namespace {
+
+// Bins del histograma de un tipo nativo: el bin i representa 'origen + i * ancho'.
+// En los enteros hay un bin por valor; en float32 el valor se lleva al bin más cercano
+// entre el mínimo y el máximo (NaN cae en el bin 0)
+template <class T>
+struct BinsNativos
+{
+    int    num    = kBinsNativos;
+    double origen = 0.0;
+    double ancho  = 1.0;
+    float  escala = 1.0f;    // sólo float32: 1 / ancho
+
+    int Bin(T v) const
+    {
+        if constexpr (std::is_same_v<T, short>) return v + 32768;
+        else if constexpr (std::is_floating_point_v<T>)
+            return static_cast<int>(std::min(static_cast<float>(num - 1),
+                                             std::max(0.0f, (v - static_cast<float>(origen)) * escala + 0.5f)));
+        else return v;
+    }
+};
+
+template <class T>
+BinsNativos<T> BinsPara(double minimo, double maximo)
+{
+    BinsNativos<T> b;
+    if constexpr (std::is_same_v<T, uchar>) b.num = 256;
+    else if constexpr (std::is_same_v<T, short>) b.origen = -32768.0;
+    else if constexpr (std::is_floating_point_v<T>) {
+        b.origen = minimo;
+        if (maximo > minimo) b.ancho = (maximo - minimo) / (b.num - 1);
+        b.escala = static_cast<float>(1.0 / b.ancho);
+    }
+    return b;
+}
+
+// Sumas de un slice (o plano) para su perfil; los totales del volumen salen de los histogramas.
+// En double: exactas para enteros de 16 bits en slices de hasta 2^21 vóxeles
+template <class T>
+struct AcumuladoSlice
+{
+    uint64_t n = 0, nDentro = 0;
+    double   suma = 0.0, sumaDentro = 0.0;
+    double   sumaCuad = 0.0, sumaCuadDentro = 0.0;
+    T        minimo = std::numeric_limits<T>::max();
+    T        maximo = std::numeric_limits<T>::lowest();
+};
+
+// Una fila: cada vóxel va al histograma dentro/fuera según su máscara 0/255 (sin ramas)
+template <class T>
+void AcumularFila(const T* img, const uchar* mascara, int n, const BinsNativos<T>& bins,
+                  uint64_t* histDentro, uint64_t* histFuera, AcumuladoSlice<T>& a)
+{
+    uint64_t* hist[2] = { histFuera, histDentro };
+    for (int i = 0; i < n; ++i)
+    {
+        const T v = img[i];
+        const int dentro = (mascara && mascara[i]) ? 1 : 0;
+        ++hist[dentro][bins.Bin(v)];
+
+        const double vd = static_cast<double>(v);
+        a.suma     += vd;
+        a.sumaCuad += vd * vd;
+        a.minimo = std::min(a.minimo, v);
+        a.maximo = std::max(a.maximo, v);
+        a.nDentro        += dentro;
+        a.sumaDentro     += dentro * vd;
+        a.sumaCuadDentro += dentro * vd * vd;
+    }
+    a.n += static_cast<uint64_t>(n);
+}
+
+void MediaYDesviacion(double suma, double sumaCuad, uint64_t n, double& media, double& desviacion)
+{
+    if (n == 0) { media = desviacion = 0.0; return; }
+    const double dn = static_cast<double>(n);
+    media = suma / dn;
+    desviacion = std::sqrt(std::max(0.0, sumaCuad / dn - media * media));
+}
+
+template <class T>
+EstadisticasRoi RoiDesdeHistogramas(const std::vector<uint64_t>& histDentro,
+                                    const std::vector<uint64_t>& histFuera,
+                                    const BinsNativos<T>& bins)
+{
+    std::vector<uint64_t> histTotal(bins.num);
+    for (int b = 0; b < bins.num; ++b) histTotal[b] = histDentro[b] + histFuera[b];
+
+    EstadisticasRoi r;
+    r.total  = EstadisticasDesdeHistograma(histTotal,  bins.origen, bins.ancho);
+    r.dentro = EstadisticasDesdeHistograma(histDentro, bins.origen, bins.ancho);
+    r.fuera  = EstadisticasDesdeHistograma(histFuera,  bins.origen, bins.ancho);
+    return r;
+}
+
+// Mínimo y máximo de un plano (sólo hace falta para los bins de float32)
+void RangoPlano(const cv::Mat& plano, double& minimo, double& maximo)
+{
+    minimo = maximo = 0.0;
+    if (plano.depth() == CV_32F) cv::minMaxIdx(plano, &minimo, &maximo);
+}
+
+template <class T>
+EstadisticasRoi EstadisticasRoiComo(const cv::Mat& plano, const cv::Mat& m8)
+{
+    double minimo, maximo;
+    RangoPlano(plano, minimo, maximo);
+    const BinsNativos<T> bins = BinsPara<T>(minimo, maximo);
+
+    std::vector<uint64_t> histDentro(bins.num, 0), histFuera(bins.num, 0);
+    AcumuladoSlice<T> a;
+    for (int y = 0; y < plano.rows; ++y)
+    {
+        const uchar* filaMascara = m8.empty() ? nullptr : m8.ptr<uchar>(y);
+        AcumularFila(plano.ptr<T>(y), filaMascara, plano.cols, bins,
+                     histDentro.data(), histFuera.data(), a);
+    }
+    return RoiDesdeHistogramas(histDentro, histFuera, bins);
+}
+
+template <class T>
+void EstadisticasVolumenComo(const T* imagen, const void* mascara, int tipoCvMascara,
+                             int nx, int ny, int nz, int numHilos, double areaPixelMm2,
+                             EstadisticasVolumen& e)
+{
+    const size_t voxelesPorSlice = static_cast<size_t>(nx) * ny;
+    const size_t bytesMascara = mascara ? CV_ELEM_SIZE1(tipoCvMascara) : 0;
+    auto sliceImagen = [&](int z) {
+        return cv::Mat(ny, nx, cv::DataType<T>::type,
+                       const_cast<T*>(imagen + static_cast<size_t>(z) * voxelesPorSlice));
+    };
+
+    // float32: los bins van del mínimo al máximo del volumen
+    double minimo = 0.0, maximo = 0.0;
+    if constexpr (std::is_floating_point_v<T>) {
+        std::vector<double> minimos(nz), maximos(nz);
+        cv::parallel_for_(cv::Range(0, nz), [&](const cv::Range& r) {
+            for (int z = r.start; z < r.end; ++z)
+                cv::minMaxIdx(sliceImagen(z), &minimos[z], &maximos[z]);
+        });
+        minimo = *std::min_element(minimos.begin(), minimos.end());
+        maximo = *std::max_element(maximos.begin(), maximos.end());
+    }
+    const BinsNativos<T> bins = BinsPara<T>(minimo, maximo);
+
+    // Histogramas por hilo (sin contención); se suman al final
+    std::vector<std::vector<uint64_t>> histDentro(numHilos), histFuera(numHilos);
+    std::atomic<int> siguiente{ 0 };
+
+    auto trabajador = [&](int h) {
+        histDentro[h].assign(bins.num, 0);
+        histFuera[h].assign(bins.num, 0);
+        cv::Mat m8;   // máscara del slice a 0/255, se reutiliza entre slices
+        for (int z = siguiente++; z < nz; z = siguiente++)
+        {
+            if (mascara) {
+                cv::Mat sliceMascara(ny, nx, CV_MAKETYPE(tipoCvMascara, 1),
+                                     const_cast<uchar*>(static_cast<const uchar*>(mascara))
+                                         + static_cast<size_t>(z) * voxelesPorSlice * bytesMascara);
+                cv::compare(sliceMascara, 0, m8, cv::CMP_GT);
+            }
+
+            const T* slice = imagen + static_cast<size_t>(z) * voxelesPorSlice;
+            AcumuladoSlice<T> a;
+            for (int y = 0; y < ny; ++y)
+            {
+                AcumularFila(slice + static_cast<size_t>(y) * nx, mascara ? m8.ptr<uchar>(y) : nullptr, nx,
+                             bins, histDentro[h].data(), histFuera[h].data(), a);
+            }
+
+            PerfilSliceZ& p = e.perfilZ[z];
+            p.z = z;
+            p.minimo = static_cast<double>(a.minimo);
+            p.maximo = static_cast<double>(a.maximo);
+            p.voxelesMascara = a.nDentro;
+            p.areaMascaraMm2 = static_cast<double>(a.nDentro) * areaPixelMm2;
+            MediaYDesviacion(a.suma, a.sumaCuad, a.n, p.media, p.desviacion);
+            MediaYDesviacion(a.sumaDentro, a.sumaCuadDentro, a.nDentro, p.mediaDentro, p.desviacionDentro);
+        }
+    };
+
+    std::vector<std::thread> hilos;
+    for (int h = 1; h < numHilos; ++h) hilos.emplace_back(trabajador, h);
+    trabajador(0);
+    for (auto& hilo : hilos) hilo.join();
+
+    for (int h = 1; h < numHilos; ++h)
+    {
+        for (int b = 0; b < bins.num; ++b) {
+            histDentro[0][b] += histDentro[h][b];
+            histFuera[0][b]  += histFuera[h][b];
+        }
+    }
+    e.roi = RoiDesdeHistogramas(histDentro[0], histFuera[0], bins);
+}
+
+} // namespace
+
+EstadisticasRoi CalcularEstadisticasRoi(const cv::Mat& plano, const cv::Mat& mascara)
+{
+    if (plano.empty()) return {};
+    CV_Assert(plano.channels() == 1);
+    CV_Assert(plano.depth() == CV_8U || plano.depth() == CV_16S ||
+              plano.depth() == CV_16U || plano.depth() == CV_32F);
+
+    cv::Mat m8;
+    if (!mascara.empty()) {
+        CV_Assert(mascara.size() == plano.size());
+        cv::compare(mascara, 0, m8, cv::CMP_GT);
+    }
+
+    switch (plano.depth()) {
+        case CV_8U:  return EstadisticasRoiComo<uchar>(plano, m8);
+        case CV_16S: return EstadisticasRoiComo<short>(plano, m8);
+        case CV_16U: return EstadisticasRoiComo<ushort>(plano, m8);
+        case CV_32F:
+        default:     return EstadisticasRoiComo<float>(plano, m8);
+    }
+}
+
+EstadisticasVolumen CalcularEstadisticasVolumen(
+    const void* imagen,
+    int tipoCv,
+    const void* mascara,
+    int tipoCvMascara,
+    int nx, int ny, int nz,
+    const double spacing[3],
+    int numHilos)
+{
+    auto t0 = std::chrono::steady_clock::now();
+
+    EstadisticasVolumen e;
+    e.nx = nx; e.ny = ny; e.nz = nz;
+    for (int d = 0; d < 3; ++d) e.spacing[d] = spacing[d];
+    e.volumenVoxelMm3 = spacing[0] * spacing[1] * spacing[2];
+    const double areaPixelMm2 = spacing[0] * spacing[1];
+    if (!imagen || nx <= 0 || ny <= 0 || nz <= 0) return e;
+
+    const int profundidad = CV_MAT_DEPTH(tipoCv);
+    CV_Assert(profundidad == CV_8U || profundidad == CV_16S || profundidad == CV_16U || profundidad == CV_32F);
+
+    e.perfilZ.resize(nz);
+    if (numHilos <= 0) numHilos = static_cast<int>(std::thread::hardware_concurrency());
+    numHilos = std::max(1, std::min(numHilos, nz));
+
+    switch (profundidad) {
+        case CV_8U:
+            EstadisticasVolumenComo(static_cast<const uchar*>(imagen), mascara, tipoCvMascara,
+                                    nx, ny, nz, numHilos, areaPixelMm2, e);
+            break;
+        case CV_16S:
+            EstadisticasVolumenComo(static_cast<const short*>(imagen), mascara, tipoCvMascara,
+                                    nx, ny, nz, numHilos, areaPixelMm2, e);
+            break;
+        case CV_16U:
+            EstadisticasVolumenComo(static_cast<const ushort*>(imagen), mascara, tipoCvMascara,
+                                    nx, ny, nz, numHilos, areaPixelMm2, e);
+            break;
+        case CV_32F:
+        default:
+            EstadisticasVolumenComo(static_cast<const float*>(imagen), mascara, tipoCvMascara,
+                                    nx, ny, nz, numHilos, areaPixelMm2, e);
+            break;
+    }
+
+    e.volumenMascaraMm3 = static_cast<double>(e.roi.dentro.n) * e.volumenVoxelMm3;
+    e.msCalculo = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return e;
+}
+
+namespace {
+
+// Histograma de 8 bits plegado a kBinsResumen bins; devuelve también la media
+double HistogramaResumen(const cv::Mat& img, std::array<uint32_t, kBinsResumen>& hist32)
+{
+    hist32.fill(0);
+    if (img.empty()) return 0.0;
+
+    cv::Mat gray = img;
+    if (img.channels() == 3) cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+    if (gray.depth() != CV_8U) gray.convertTo(gray, CV_8U);
+
+    std::vector<uint64_t> hist = Histograma8u(gray);
+    uint64_t n = 0;
+    double suma = 0.0;
+    for (int v = 0; v < 256; ++v) {
+        hist32[v * kBinsResumen / 256] += static_cast<uint32_t>(hist[v]);
+        n    += hist[v];
+        suma += static_cast<double>(hist[v]) * v;
+    }
+    return n ? suma / static_cast<double>(n) : 0.0;
+}
+
+} // namespace
+
+// Suma y suma de cuadrados de la ROI: sólo se leen los píxeles cuyo bit está a 1,
+// saltando de uno al siguiente con ctz (acumuladores en double: exactos para enteros
+// de 16 bits en planos de hasta 2^22 píxeles)
+template <class TImg>
+static void AcumularRoi(const cv::Mat& plano, const PlanoMascaraBits& mascara, double& suma, double& sumaCuad)
+{
+    for (int y = 0; y < plano.rows; ++y)
+    {
+        const TImg* img = plano.ptr<TImg>(y);
+        const uint64_t* fila = mascara.Fila(y);
+        for (int w = 0; w < mascara.PalabrasPorFila(); ++w)
+        {
+            for (uint64_t palabra = fila[w]; palabra != 0; palabra &= palabra - 1)
+            {
+                const double v = static_cast<double>(img[w * 64 + __builtin_ctzll(palabra)]);
+                suma     += v;
+                sumaCuad += v * v;
+            }
+        }
+    }
+}
+
+static bool ProfundidadVolumen(int profundidad)
+{
+    return profundidad == CV_8U || profundidad == CV_16S || profundidad == CV_16U || profundidad == CV_32F;
+}
+
+ResumenSlice ResumirSlice(
+    int indice,
+    const cv::Mat& plano,
+    const PlanoMascaraBits& mascara,
+    const cv::Mat& original8u,
+    const cv::Mat& procesado,
+    double areaPixelMm2)
+{
+    ResumenSlice r;
+    r.indice = indice;
+
+    // ROI en intensidades originales, en el tipo nativo del volumen
+    if (!plano.empty() && mascara.Filas() > 0)
+    {
+        CV_Assert(plano.channels() == 1 && ProfundidadVolumen(plano.depth()));
+        CV_Assert(plano.rows == mascara.Filas() && plano.cols == mascara.Columnas());
+
+        const uint64_t n = mascara.Area();
+        double suma = 0.0, sumaCuad = 0.0;
+        switch (plano.depth()) {
+            case CV_8U:  AcumularRoi<uchar>(plano, mascara, suma, sumaCuad);  break;
+            case CV_16S: AcumularRoi<short>(plano, mascara, suma, sumaCuad);  break;
+            case CV_16U: AcumularRoi<ushort>(plano, mascara, suma, sumaCuad); break;
+            case CV_32F:
+            default:     AcumularRoi<float>(plano, mascara, suma, sumaCuad);  break;
+        }
+        r.pixelesMascara = n;
+        r.areaMascaraMm2 = static_cast<double>(n) * areaPixelMm2;
+        r.cajaMascara    = mascara.CajaEnvolvente();
+        if (n > 0) {
+            r.mediaRoi = suma / static_cast<double>(n);
+            r.desviacionRoi = std::sqrt(std::max(0.0,
+                sumaCuad / static_cast<double>(n) - r.mediaRoi * r.mediaRoi));
+        }
+    }
+
+    r.mediaOriginal  = HistogramaResumen(original8u, r.histOriginal);
+    r.mediaProcesado = HistogramaResumen(procesado,  r.histProcesado);
+    return r;
+}
+
+bool GuardarResumenSlicesCsv(const std::vector<ResumenSlice>& resumenes, const std::string& ruta)
+{
+    namespace fs = std::filesystem;
+    const fs::path rutaFinal{ ruta };
+    const fs::path rutaTmp = rutaFinal.string() + ".tmp";
+
+    {
+        std::ofstream out(rutaTmp);
+        if (!out) {
+            std::cerr << "[ERROR] No se pudo escribir '" << rutaTmp.string() << "'.\n";
+            return false;
+        }
+
+        out << "indice,pixeles_mascara,area_mascara_mm2,caja_x,caja_y,caja_ancho,caja_alto,"
+               "media_roi,desv_roi,media_original,media_procesado";
+        for (int b = 0; b < kBinsResumen; ++b) out << ",h_orig_" << b;
+        for (int b = 0; b < kBinsResumen; ++b) out << ",h_proc_" << b;
+        out << ",areas_etiquetas_mm2\n";
+
+        char buf[192];
+        for (const auto& r : resumenes)
+        {
+            std::snprintf(buf, sizeof(buf), "%d,%llu,%.3f,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f",
+                          r.indice, static_cast<unsigned long long>(r.pixelesMascara), r.areaMascaraMm2,
+                          r.cajaMascara.x, r.cajaMascara.y, r.cajaMascara.width, r.cajaMascara.height,
+                          r.mediaRoi, r.desviacionRoi,
+                          r.mediaOriginal, r.mediaProcesado);
+            out << buf;
+            for (uint32_t c : r.histOriginal)  out << ',' << c;
+            for (uint32_t c : r.histProcesado) out << ',' << c;
+            out << ',';
+            for (size_t k = 0; k < r.areasEtiquetasMm2.size(); ++k) {
+                std::snprintf(buf, sizeof(buf), "%s%d:%.3f", k ? ";" : "",
+                              r.areasEtiquetasMm2[k].first, r.areasEtiquetasMm2[k].second);
+                out << buf;
+            }
+            out << '\n';
+        }
+        if (!out) {
+            std::cerr << "[ERROR] Falló la escritura de '" << rutaTmp.string() << "'.\n";
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(rutaTmp, rutaFinal, ec);
+    if (ec) {
+        std::cerr << "[ERROR] No se pudo renombrar '" << rutaTmp.string() << "': " << ec.message() << "\n";
+        return false;
+    }
+    return true;
+}
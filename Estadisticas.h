@@ -0,0 +1,177 @@
+// Estadisticas.h
+#ifndef ESTADISTICAS_H
+#define ESTADISTICAS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "MascaraCompacta.h"      // para PlanoMascaraBits
+
+/**
+ * Estadísticas de intensidad calculadas a partir de un histograma.
+ * Mediana y cuartiles siguen la interpolación lineal de numpy (np.median / np.percentile).
+ */
+struct EstadisticasIntensidad
+{
+    uint64_t n = 0;           // número de píxeles
+    double media      = 0.0;
+    double mediana    = 0.0;
+    double moda       = 0.0;  // valor más frecuente (el menor si hay empate)
+    double varianza   = 0.0;  // poblacional, como np.var
+    double desviacion = 0.0;
+    double minimo     = 0.0;
+    double maximo     = 0.0;
+
+    // Para el boxplot
+    double q1 = 0.0, q3 = 0.0;
+    double bigoteInferior = 0.0, bigoteSuperior = 0.0;   // 1.5 * IQR, ajustados a datos reales
+    std::vector<double> atipicos;                        // valores distintos fuera de los bigotes
+};
+
+/**
+ * Histograma de 256 bins de una imagen de 8 bits (1 canal).
+ * Se recorre una sola vez, fila a fila, con 4 sub-histogramas intercalados
+ * para que píxeles iguales consecutivos no serialicen los incrementos.
+ */
+std::vector<uint64_t> Histograma8u(const cv::Mat& gray8u);
+
+/**
+ * Calcula todas las estadísticas en O(bins) a partir de un histograma.
+ * El bin i representa el valor 'origen + i * anchoBin'.
+ */
+EstadisticasIntensidad EstadisticasDesdeHistograma(
+    const std::vector<uint64_t>& hist,
+    double origen = 0.0,
+    double anchoBin = 1.0
+);
+
+/**
+ * Estadísticas de una imagen de 8 bits. Si es BGR se pasa antes a gris
+ * (igual que cv::imread(..., IMREAD_GRAYSCALE)).
+ */
+EstadisticasIntensidad CalcularEstadisticas8u(const cv::Mat& img);
+
+// ---------------------------------------------------------------------------
+// Datos originales en su tipo nativo (CV_8U, CV_16S, CV_16U o CV_32F). Los enteros
+// usan un bin por valor (256 en uint8, 65536 en int16/uint16); float32 reparte
+// kBinsNativos bins entre el mínimo y el máximo de los datos, así que sus
+// estadísticas (salvo mínimo y máximo) tienen una resolución de medio bin.
+// Los histogramas se suman entre hilos, así mediana y moda siguen siendo O(n).
+// ---------------------------------------------------------------------------
+constexpr int kBinsNativos = 65536;
+
+/**
+ * Estadísticas de todos los vóxeles y separadas dentro/fuera de la máscara (> 0).
+ */
+struct EstadisticasRoi
+{
+    EstadisticasIntensidad total;
+    EstadisticasIntensidad dentro;   // máscara > 0
+    EstadisticasIntensidad fuera;
+};
+
+/**
+ * Resumen de un slice axial (z = cte) para los perfiles a lo largo de Z.
+ */
+struct PerfilSliceZ
+{
+    int      z = 0;
+    double   media = 0.0, desviacion = 0.0;
+    double   minimo = 0.0, maximo = 0.0;
+    uint64_t voxelesMascara = 0;
+    double   areaMascaraMm2 = 0.0;
+    double   mediaDentro = 0.0, desviacionDentro = 0.0;   // 0 si el slice no tiene máscara
+};
+
+/**
+ * Estadísticas de un volumen completo con su máscara.
+ */
+struct EstadisticasVolumen
+{
+    int nx = 0, ny = 0, nz = 0;
+    double spacing[3] = { 1.0, 1.0, 1.0 };   // mm
+
+    EstadisticasRoi roi;
+    double volumenVoxelMm3   = 0.0;
+    double volumenMascaraMm3 = 0.0;
+
+    std::vector<PerfilSliceZ> perfilZ;       // uno por z, en orden
+
+    double msCalculo = 0.0;
+};
+
+/**
+ * Estadísticas de un plano de un canal (CV_8U, CV_16S, CV_16U o CV_32F) en su tipo;
+ * 'mascara' (de cualquier profundidad, mismo tamaño) puede estar vacía.
+ */
+EstadisticasRoi CalcularEstadisticasRoi(const cv::Mat& plano, const cv::Mat& mascara);
+
+/**
+ * Recorre el volumen (buffer contiguo, x más rápido) una sola vez, repartiendo
+ * los slices z entre 'numHilos' hilos (0 = todos los núcleos). Cada hilo
+ * acumula sus propios histogramas dentro/fuera y el perfil de sus slices;
+ * al final se suman los histogramas. En float32 hay antes una pasada de
+ * mínimo/máximo para fijar los bins.
+ *
+ * @param tipoCv Profundidad de la imagen (CV_8U, CV_16S, CV_16U o CV_32F).
+ * @param mascara Puede ser nullptr (todo cuenta como fuera de la máscara).
+ * @param tipoCvMascara Profundidad de la máscara (cualquiera de las anteriores).
+ * @param spacing Espaciado en mm (x, y, z) del NIfTI.
+ */
+EstadisticasVolumen CalcularEstadisticasVolumen(
+    const void* imagen,
+    int tipoCv,
+    const void* mascara,
+    int tipoCvMascara,
+    int nx, int ny, int nz,
+    const double spacing[3],
+    int numHilos = 0
+);
+
+// ---------------------------------------------------------------------------
+// Resumen por slice recogido durante el procesamiento (sidecar CSV)
+// ---------------------------------------------------------------------------
+constexpr int kBinsResumen = 32;                       // 8 niveles de gris por bin
+constexpr const char* kNombreEstadisticasSlices = "slice_stats.csv";
+
+struct ResumenSlice
+{
+    int      indice = 0;                 // plano en el volumen
+    uint64_t pixelesMascara = 0;         // en el plano original (antes de reescalar)
+    double   areaMascaraMm2 = 0.0;
+    cv::Rect cajaMascara;                // caja envolvente de la ROI en el plano original (0x0 si vacía)
+    double   mediaRoi = 0.0, desviacionRoi = 0.0;       // intensidad original (tipo nativo) en la máscara
+    double   mediaOriginal = 0.0, mediaProcesado = 0.0; // 8 bits
+    std::array<uint32_t, kBinsResumen> histOriginal{};  // slice normalizado a 8 bits
+    std::array<uint32_t, kBinsResumen> histProcesado{};  // resultado del filtro (gris)
+    std::vector<std::pair<int, double>> areasEtiquetasMm2; // (etiqueta, mm²) en la máscara refinada
+};
+
+/**
+ * Resume un slice con los datos que el procesamiento ya tiene a mano:
+ * el plano original (un canal; CV_8U, CV_16S, CV_16U o CV_32F) y su máscara
+ * empaquetada del mismo tamaño, el slice de 8 bits que entra al filtro y el
+ * resultado del filtro (gris o BGR). Área y caja salen de las palabras de la
+ * máscara (popcount, ctz/clz) y la ROI se recorre saltando de bit a 1 en bit a 1.
+ * @param areaPixelMm2 Área de un píxel del plano original en mm².
+ */
+ResumenSlice ResumirSlice(
+    int indice,
+    const cv::Mat& plano,
+    const PlanoMascaraBits& mascara,
+    const cv::Mat& original8u,
+    const cv::Mat& procesado,
+    double areaPixelMm2
+);
+
+/**
+ * Escribe los resúmenes como CSV (una fila por slice, en orden) de forma atómica
+ * (archivo temporal + rename). La última columna lista las áreas por etiqueta
+ * como "etiqueta:mm2" separadas por ';'.
+ * @return true si se escribió correctamente.
+ */
+bool GuardarResumenSlicesCsv(const std::vector<ResumenSlice>& resumenes, const std::string& ruta);
+
+#endif // ESTADISTICAS_H
@@ -2,9 +2,15 @@
 #include "Filtros.h"
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>  // para cv::imencode
 #include <itkImageRegionConstIterator.h>
 #include <iostream>
+#include <fstream>
 #include <cstdio>
+#include <algorithm>
+#include "Perfil.h"                // para MedirEtapa y TramoTraza
+#include "Suavizado.h"             // para los filtros 11 y 12
+#include "Clahe.h"                 // para el filtro 13
 
 // ----------------------------------------------------------
 // Funciones Auxiliares: cada una aplica el filtro correspondiente
@@ -13,6 +19,7 @@
 // 1) Thresholding truncado
 cv::Mat aplicarThresholding(const cv::Mat& src)
 {
+    TramoTraza tramo("aplicarThresholding");
     cv::Mat gray, dst;
     if (src.channels() == 3) {
         cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
@@ -27,6 +34,7 @@ cv::Mat aplicarThresholding(const cv::Mat& src)
 // 2) Contrast Stretching (estiramiento lineal de contrastes)
 cv::Mat aplicarContrastStretching(const cv::Mat& src)
 {
+    TramoTraza tramo("aplicarContrastStretching");
     cv::Mat gray, dst;
     if (src.channels() == 3) {
         cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
@@ -46,6 +54,7 @@ cv::Mat aplicarContrastStretching(const cv::Mat& src)
 // 3) Binarización por umbral de color o, si es imagen de 1 canal, umbral de intensidad
 cv::Mat aplicarBinarizacionColor(const cv::Mat& src)
 {
+    TramoTraza tramo("aplicarBinarizacionColor");
     // Si la imagen viene en escala de grises (1 canal), aplicamos threshold de intensidad
     if (src.channels() == 1)
     {
@@ -78,6 +87,7 @@ cv::Mat aplicarBinarizacionColor(const cv::Mat& src)
 //    Si es NOT, ignoramos mask y solo invertimos src. Para los demás, src & mask, etc.
 cv::Mat aplicarOperacionLogica(const cv::Mat& src, const cv::Mat& mask, int tipoOp)
 {
+    TramoTraza tramo("aplicarOperacionLogica");
     cv::Mat graySrc;
     if (src.channels() == 3) {
         cv::cvtColor(src, graySrc, cv::COLOR_BGR2GRAY);
@@ -107,6 +117,7 @@ cv::Mat aplicarOperacionLogica(const cv::Mat& src, const cv::Mat& mask, int tipo
 // 5) Detección de bordes (Canny)
 cv::Mat aplicarDeteccionBordes(const cv::Mat& src)
 {
+    TramoTraza tramo("aplicarDeteccionBordes");
     cv::Mat gray, edges;
     if (src.channels() == 3) {
         cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
@@ -121,6 +132,7 @@ cv::Mat aplicarDeteccionBordes(const cv::Mat& src)
 // 6) Manipulación de píxeles: ImagenOriginal + (TopHat – BlackHat)
 cv::Mat aplicarManipulacionPixeles(const cv::Mat& src)
 {
+    TramoTraza tramo("aplicarManipulacionPixeles");
     // 1) Convertir a escala de grises
     cv::Mat gray;
     if (src.channels() == 3) {
@@ -166,6 +178,7 @@ cv::Mat aplicarManipulacionPixeles(const cv::Mat& src)
 // 7) Filtros de suavizado (GaussianBlur)
 cv::Mat aplicarFiltroSuavizado(const cv::Mat& src)
 {
+    TramoTraza tramo("aplicarFiltroSuavizado");
     cv::Mat gray, dst;
     if (src.channels() == 3) {
         cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
@@ -179,6 +192,7 @@ cv::Mat aplicarFiltroSuavizado(const cv::Mat& src)
 // 8) Operaciones morfológicas (apertura + cierre)
 cv::Mat aplicarOperacionesMorfo(const cv::Mat& src)
 {
+    TramoTraza tramo("aplicarOperacionesMorfo");
     cv::Mat gray, dst;
     if (src.channels() == 3) {
         cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
@@ -191,9 +205,54 @@ cv::Mat aplicarOperacionesMorfo(const cv::Mat& src)
     return dst;
 }
 
+// 11) Mediana con histogramas: el coste no crece con el radio (por defecto 11x11)
+cv::Mat aplicarMedianaRapida(const cv::Mat& src, int radio)
+{
+    TramoTraza tramo("aplicarMedianaRapida");
+    cv::Mat gray;
+    if (src.channels() == 3) {
+        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = src;
+    }
+    return MedianaHistograma(gray, radio);
+}
+
+// 12) Suavizado que conserva los bordes (filtro guiado rápido, por defecto ventana de 17x17)
+static constexpr double kEpsGuiado = 0.01;      // (0.1)²: se conservan saltos de más de ~25 niveles
+static constexpr int kSubmuestreoGuiado = 4;
+
+cv::Mat aplicarSuavizadoBordes(const cv::Mat& src, int radio)
+{
+    TramoTraza tramo("aplicarSuavizadoBordes");
+    cv::Mat gray;
+    if (src.channels() == 3) {
+        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = src;
+    }
+    // Con radios pequeños se submuestrea menos, para que la ventana reducida no baje de 2
+    const int submuestreo = std::max(1, std::min(kSubmuestreoGuiado, radio / 2));
+    return FiltroGuiadoRapido(gray, radio, kEpsGuiado, submuestreo);
+}
+
+// 13) CLAHE: ecualización adaptativa por teselas de 8x8, con el recorte de cv::createCLAHE
+cv::Mat aplicarClahe(const cv::Mat& src)
+{
+    TramoTraza tramo("aplicarClahe");
+    cv::Mat gray;
+    if (src.channels() == 3) {
+        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = src;
+    }
+    return AplicarClahe(gray);
+}
+
 // 9) Otra técnica: Segmentación Watershed
 cv::Mat aplicarOtraTecnica(const cv::Mat& src)
 {
+    TramoTraza tramo("aplicarOtraTecnica");
     // --- 1) Convertir a escala de grises ---
     cv::Mat gray;
     if (src.channels() == 3) {
@@ -302,20 +361,7 @@ cv::Mat ITKImage2DtoCVMat(const ImageType2D::Pointer& image2D)
         mat16s.at<short>(static_cast<int>(idx[1]), static_cast<int>(idx[0])) = val;
     }
 
-    double minVal, maxVal;
-    cv::minMaxLoc(mat16s, &minVal, &maxVal);
-    cv::Mat mat8u;
-    if (maxVal > minVal) {
-        mat16s.convertTo(
-            mat8u,
-            CV_8U,
-            255.0 / (maxVal - minVal),
-            -minVal * 255.0 / (maxVal - minVal)
-        );
-    } else {
-        mat8u = cv::Mat::zeros(mat16s.size(), CV_8U);
-    }
-    return mat8u;
+    return Normalizar16a8(mat16s);
 }
 
 // ----------------------------------------------------------
@@ -342,141 +388,359 @@ cv::Mat ITKMask2BinCVMat(const ImageType2D::Pointer& mask2D)
     return matBin;
 }
 
+// ----------------------------------------------------------
+// Conversión de planos en el tipo nativo del volumen (extraídos en cualquier orientación)
+// ----------------------------------------------------------
+cv::Mat Normalizar16a8(const cv::Mat& plano)
+{
+    double minVal, maxVal;
+    cv::minMaxLoc(plano, &minVal, &maxVal);
+    cv::Mat mat8u;
+    if (maxVal > minVal) {
+        plano.convertTo(
+            mat8u,
+            CV_8U,
+            255.0 / (maxVal - minVal),
+            -minVal * 255.0 / (maxVal - minVal)
+        );
+    } else {
+        mat8u = cv::Mat::zeros(plano.size(), CV_8U);
+    }
+    return mat8u;
+}
+
+cv::Mat BinarizarMascara(const cv::Mat& plano)
+{
+    cv::Mat matBin;
+    cv::compare(plano, 0, matBin, cv::CMP_GT);  // 255 donde val > 0
+    return matBin;
+}
+
+std::string NombreArchivoSlice(unsigned int indice)
+{
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "slice_%03u.png", indice);
+    return buffer;
+}
+
+// ----------------------------------------------------------
+// Overlay por etiquetas
+// ----------------------------------------------------------
+
+// El resultado del filtro queda siempre al 90% (como en la mezcla 0.6 + 0.3 de siempre) y
+// la etiqueta le quita 'alfa' para poner su color: dentro de la ROI, 0.6·filtro + 0.3·color.
+static constexpr double kPesoFiltro = 0.9;
+static constexpr double kAlfaEtiqueta = 0.3;
+static constexpr double kPesoBordes = 0.2;
+
+PaletaEtiquetas::PaletaEtiquetas()
+    : tabla(static_cast<size_t>(256) * 3 * 256)
+{
+    static const cv::Vec3b kColores[] = {
+        cv::Vec3b(0, 0, 255),     // rojo
+        cv::Vec3b(255, 0, 0),     // azul
+        cv::Vec3b(0, 255, 255),   // amarillo
+        cv::Vec3b(255, 0, 255),   // magenta
+        cv::Vec3b(255, 255, 0),   // cian
+        cv::Vec3b(0, 128, 255),   // naranja
+        cv::Vec3b(255, 0, 128),   // violeta
+    };
+    constexpr int kNumColores = static_cast<int>(sizeof(kColores) / sizeof(kColores[0]));
+
+    Fijar(0, cv::Vec3b(0, 0, 0), 0.0);
+    for (int e = 1; e < 256; ++e) Fijar(e, kColores[(e - 1) % kNumColores], kAlfaEtiqueta);
+    Fijar(255, kColores[0], kAlfaEtiqueta);     // máscaras binarias guardadas como 0/255
+}
+
+void PaletaEtiquetas::Fijar(int etiqueta, const cv::Vec3b& colorBgr, double alfa)
+{
+    CV_Assert(etiqueta >= 0 && etiqueta < 256);
+    uchar* t = tabla.data() + static_cast<size_t>(etiqueta) * 3 * 256;
+    for (int c = 0; c < 3; ++c)
+        for (int v = 0; v < 256; ++v)
+            t[c * 256 + v] = cv::saturate_cast<uchar>((kPesoFiltro - alfa) * v + alfa * colorBgr[c]);
+}
+
+const PaletaEtiquetas& PaletaEtiquetas::PorDefecto()
+{
+    static const PaletaEtiquetas paleta;
+    return paleta;
+}
+
+// Segunda mezcla, con los bordes: [borde][canal][valor] -> 0.8·valor + 0.2·verde
+static const uchar* TablaBordes()
+{
+    static const std::vector<uchar> tabla = [] {
+        const cv::Vec3b verde(0, 255, 0);
+        std::vector<uchar> t(2 * 3 * 256);
+        for (int borde = 0; borde < 2; ++borde)
+            for (int c = 0; c < 3; ++c)
+                for (int v = 0; v < 256; ++v)
+                    t[(borde * 3 + c) * 256 + v] = cv::saturate_cast<uchar>(
+                        (1.0 - kPesoBordes) * v + (borde ? kPesoBordes * verde[c] : 0.0));
+        return t;
+    }();
+    return tabla.data();
+}
+
+cv::Mat ComponerOverlay(
+    const cv::Mat& processed,
+    const cv::Mat& etiquetas,
+    const cv::Mat& bordes,
+    const PaletaEtiquetas& paleta,
+    AreasEtiquetas* areas
+)
+{
+    CV_Assert(processed.depth() == CV_8U && (processed.channels() == 1 || processed.channels() == 3));
+    CV_Assert(etiquetas.type() == CV_8UC1 && bordes.type() == CV_8UC1);
+    CV_Assert(etiquetas.size() == processed.size() && bordes.size() == processed.size());
+
+    const uchar* tablaBordes = TablaBordes();
+    const bool gris = processed.channels() == 1;
+    std::array<uint32_t, 256> cuentas{};
+
+    cv::Mat dst(processed.size(), CV_8UC3);
+    for (int y = 0; y < processed.rows; ++y)
+    {
+        const uchar* p = processed.ptr<uchar>(y);
+        const uchar* e = etiquetas.ptr<uchar>(y);
+        const uchar* b = bordes.ptr<uchar>(y);
+        uchar* d = dst.ptr<uchar>(y);
+        for (int x = 0; x < processed.cols; ++x)
+        {
+            const uchar etiqueta = e[x];
+            ++cuentas[etiqueta];
+            const uchar* t  = paleta.Tabla(etiqueta);
+            const uchar* tb = tablaBordes + (b[x] ? 3 * 256 : 0);
+            for (int c = 0; c < 3; ++c)
+            {
+                const uchar v = gris ? p[x] : p[3 * x + c];
+                d[3 * x + c] = tb[c * 256 + t[c * 256 + v]];
+            }
+        }
+    }
+
+    if (areas) {
+        for (int i = 0; i < 256; ++i) (*areas)[i] = cuentas[i];
+    }
+    return dst;
+}
+
+// Etiquetas de la máscara refinada: sin etiquetas, 1 en toda la ROI (rojo); con ellas, la
+// original en cada píxel y, en los que añadió el cierre, la de un vecino (o 1 si el píxel
+// viene del cierre 3D y no hay ninguno en el plano)
+static cv::Mat EtiquetasRefinadas(const cv::Mat& maskRefined, const cv::Mat* etiquetas, const cv::Mat& elemento)
+{
+    cv::Mat resultado;
+    if (!etiquetas || etiquetas->empty()) {
+        cv::threshold(maskRefined, resultado, 0, 1, cv::THRESH_BINARY);
+        return resultado;
+    }
+
+    CV_Assert(etiquetas->type() == CV_8UC1 && etiquetas->size() == maskRefined.size());
+    cv::Mat vecinas;
+    cv::dilate(*etiquetas, vecinas, elemento);
+    resultado.create(maskRefined.size(), CV_8U);
+    for (int y = 0; y < resultado.rows; ++y)
+    {
+        const uchar* m = maskRefined.ptr<uchar>(y);
+        const uchar* e = etiquetas->ptr<uchar>(y);
+        const uchar* v = vecinas.ptr<uchar>(y);
+        uchar* r = resultado.ptr<uchar>(y);
+        for (int x = 0; x < resultado.cols; ++x)
+            r[x] = m[x] ? (e[x] ? e[x] : (v[x] ? v[x] : 1)) : 0;
+    }
+    return resultado;
+}
+
 // ----------------------------------------------------------
 // 3) Procesamiento de un único slice: preprocesamiento y resaltado
 //    Ahora recibe también 'filterOption' para saber qué función aplicar.
 // ----------------------------------------------------------
-void ProcesarYGuardarSlice(
+cv::Mat ProcesarSlice(
     const cv::Mat& slice8u,
     const cv::Mat& maskBin,
-    const fs::path& dirOrig,
-    const fs::path& dirMask,
-    const fs::path& dirHigh,
-    unsigned int indiceZ,
-    int filterOption
+    int filterOption,
+    cv::Mat* maskRefinadaSalida,
+    cv::Mat* processedSalida,
+    const cv::Mat* etiquetas,
+    AreasEtiquetas* areasEtiquetasSalida,
+    const PlanosFiltrados3D* filtrados3D,
+    int radioFiltro
 )
 {
     cv::Mat processed;         // contendrá la imagen luego de aplicar el filtro elegido
     cv::Mat morphMask;         // para operaciones lógicas/mascara refinada si se necesita
 
-    // ———  Selección del filtro a aplicar  ———
-    switch (filterOption)
+    // ———  Selección del filtro a aplicar (salvo que ya venga del volumen 3D)  ———
+    if (filtrados3D && !filtrados3D->processed.empty())
     {
-        case 1:
-            // Thresholding
-            processed = aplicarThresholding(slice8u);
-            break;
-        case 2:
-            // Contrast Stretching
-            processed = aplicarContrastStretching(slice8u);
-            break;
-        case 3:
-            // Binarización por umbral de color
-            processed = aplicarBinarizacionColor(slice8u);
-            break;
-        case 4:
-            // Operaciones lógicas: supongamos que aplicamos AND entre slice y mascara
-            //   - tipoOp = 1 para AND. En NOT, la máscara no se usa.
-            processed = aplicarOperacionLogica(slice8u, maskBin, 0);
-            break;
-        case 5:
-            // Detección de Bordes (Canny)
-            processed = aplicarDeteccionBordes(slice8u);
-            break;
-        case 6:
-            // Manipulación de píxeles (ej. negativo)
-            processed = aplicarManipulacionPixeles(slice8u);
-            break;
-        case 7:
-            // Filtro de suavizado (GaussianBlur)
-            processed = aplicarFiltroSuavizado(slice8u);
-            break;
-        case 8:
-            // Operaciones morfológicas
-            processed = aplicarOperacionesMorfo(slice8u);
-            break;
-        case 9:
-            // Otra técnica (ecualización de histograma)
-            processed = aplicarOtraTecnica(slice8u);
-            break;
-        case 10:
-            // Aplicar todos los filtros EN SECUENCIA sobre el mismo slice
-            {
-                cv::Mat tmp = slice8u.clone();
-                tmp = aplicarThresholding(tmp);
-                tmp = aplicarContrastStretching(tmp);
-                tmp = aplicarBinarizacionColor(tmp);
-                tmp = aplicarOperacionLogica(tmp, maskBin, 0);
-                tmp = aplicarDeteccionBordes(tmp);
-                tmp = aplicarManipulacionPixeles(tmp);
-                tmp = aplicarFiltroSuavizado(tmp);
-                tmp = aplicarOperacionesMorfo(tmp);
-                tmp = aplicarOtraTecnica(tmp);
-                processed = tmp;
-            }
-            break;
-        default:
-            // Opcional: si la opción no coincide, devolvemos simplemente el slice ecualizado
-            processed = slice8u.clone();
-            break;
+        processed = filtrados3D->processed;
+    }
+    else
+    {
+        MedirEtapa medir(Etapa::Filtro);
+        switch (filterOption)
+        {
+            case 1:
+                // Thresholding
+                processed = aplicarThresholding(slice8u);
+                break;
+            case 2:
+                // Contrast Stretching
+                processed = aplicarContrastStretching(slice8u);
+                break;
+            case 3:
+                // Binarización por umbral de color
+                processed = aplicarBinarizacionColor(slice8u);
+                break;
+            case 4:
+                // Operaciones lógicas: supongamos que aplicamos AND entre slice y mascara
+                //   - tipoOp = 1 para AND. En NOT, la máscara no se usa.
+                processed = aplicarOperacionLogica(slice8u, maskBin, 0);
+                break;
+            case 5:
+                // Detección de Bordes (Canny)
+                processed = aplicarDeteccionBordes(slice8u);
+                break;
+            case 6:
+                // Manipulación de píxeles (ej. negativo)
+                processed = aplicarManipulacionPixeles(slice8u);
+                break;
+            case 7:
+                // Filtro de suavizado (GaussianBlur)
+                processed = aplicarFiltroSuavizado(slice8u);
+                break;
+            case 8:
+                // Operaciones morfológicas
+                processed = aplicarOperacionesMorfo(slice8u);
+                break;
+            case 9:
+                // Segmentación Watershed
+                processed = aplicarOtraTecnica(slice8u);
+                break;
+            case 10:
+                // Aplicar todos los filtros EN SECUENCIA sobre el mismo slice
+                {
+                    cv::Mat tmp = slice8u.clone();
+                    tmp = aplicarThresholding(tmp);
+                    tmp = aplicarContrastStretching(tmp);
+                    tmp = aplicarBinarizacionColor(tmp);
+                    tmp = aplicarOperacionLogica(tmp, maskBin, 0);
+                    tmp = aplicarDeteccionBordes(tmp);
+                    tmp = aplicarManipulacionPixeles(tmp);
+                    tmp = aplicarFiltroSuavizado(tmp);
+                    tmp = aplicarOperacionesMorfo(tmp);
+                    tmp = aplicarOtraTecnica(tmp);
+                    processed = tmp;
+                }
+                break;
+            case 11:
+                // Mediana de radio grande (coste constante)
+                processed = aplicarMedianaRapida(slice8u, radioFiltro > 0 ? radioFiltro : kRadioMedianaDefecto);
+                break;
+            case 12:
+                // Suavizado que conserva los bordes (filtro guiado)
+                processed = aplicarSuavizadoBordes(slice8u, radioFiltro > 0 ? radioFiltro : kRadioGuiadoDefecto);
+                break;
+            case 13:
+                // Ecualización adaptativa de histograma (CLAHE)
+                processed = aplicarClahe(slice8u);
+                break;
+            default:
+                // Opcional: si la opción no coincide, devolvemos simplemente el slice ecualizado
+                processed = slice8u.clone();
+                break;
+        }
     }
 
+    MedirEtapa medirComposicion(Etapa::Composicion);
+
     // ———  Refinamiento de la máscara usando operaciones morfológicas  ———
     cv::Mat maskRefined;
     cv::Mat elemento = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3));
-    cv::morphologyEx(maskBin, maskRefined, cv::MORPH_OPEN, elemento); //MORPH_OPEN (erosión seguida de dilatación) 
-    cv::morphologyEx(maskRefined, maskRefined, cv::MORPH_CLOSE, elemento); //MORPH_CLOSE (dilatación seguida de erosión)
-
-    // ——— Construir overlay: combinar processed, máscara coloreada y bordes (del processed) ———
-    // Convertimos processed a color para overlay
-    cv::Mat processedColor;
-    if (processed.channels() == 1)
-        cv::cvtColor(processed, processedColor, cv::COLOR_GRAY2BGR);
+    if (filtrados3D && !filtrados3D->maskRefinada.empty())
+    {
+        maskRefined = filtrados3D->maskRefinada;
+    }
     else
-        processedColor = processed.clone();
+    {
+        TramoTraza tramo("refinarMascara");
+        cv::morphologyEx(maskBin, maskRefined, cv::MORPH_OPEN, elemento); //MORPH_OPEN (erosión seguida de dilatación) 
+        cv::morphologyEx(maskRefined, maskRefined, cv::MORPH_CLOSE, elemento); //MORPH_CLOSE (dilatación seguida de erosión)
+    }
+    cv::Mat etiquetasRef = EtiquetasRefinadas(maskRefined, etiquetas, elemento);
 
     // Mapa de bordes sobre el resultado de "processed" (opción 5 o filtrado)
     cv::Mat edges;
-    cv::Canny(processed, edges, 50, 150);
-    cv::Mat edgeColor;
-    cv::cvtColor(edges, edgeColor, cv::COLOR_GRAY2BGR);
-    for (int y = 0; y < edgeColor.rows; ++y)
     {
-        for (int x = 0; x < edgeColor.cols; ++x)
-        {
-            if (edgeColor.at<cv::Vec3b>(y, x) != cv::Vec3b(0, 0, 0))
-                edgeColor.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 255, 0); // verde
-        }
+        TramoTraza tramo("canny");
+        cv::Canny(processed, edges, 50, 150);
     }
 
-    // Aplicar máscara roja semitransparente (ROI)
-    cv::Mat overlay = processedColor.clone();
-    for (int y = 0; y < overlay.rows; ++y)
+    // ——— Overlay: processed + ROI coloreada por etiqueta + bordes en verde, en una pasada ———
+    cv::Mat highlighted;
     {
-        for (int x = 0; x < overlay.cols; ++x)
-        {
-            if (maskRefined.at<uchar>(y, x) > 0)
-                overlay.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 0, 255);
-        }
+        TramoTraza tramoOverlay("overlay");
+        highlighted = ComponerOverlay(processed, etiquetasRef, edges, PaletaEtiquetas::PorDefecto(),
+                                      areasEtiquetasSalida);
     }
 
-    // Combinar processedColor + overlay + bordes
-    cv::Mat highlighted;
-    cv::addWeighted(processedColor, 0.6, overlay, 0.3, 0, highlighted);
-    cv::addWeighted(highlighted, 0.8, edgeColor, 0.2, 0, highlighted); // Comentar si no se requiere bordes verdes
+    if (maskRefinadaSalida) *maskRefinadaSalida = maskRefined;
+    if (processedSalida)    *processedSalida = processed;
+    return highlighted;
+}
+
+// Como cv::imwrite, pero con la codificación PNG y la escritura a disco medidas por separado
+static bool GuardarPng(const fs::path& ruta, const cv::Mat& imagen)
+{
+    std::vector<uchar> png;
+    {
+        MedirEtapa medir(Etapa::Codificacion);
+        if (!cv::imencode(".png", imagen, png)) return false;
+    }
+
+    MedirEtapa medir(Etapa::Escritura);
+    std::ofstream archivo(ruta, std::ios::binary | std::ios::trunc);
+    archivo.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    if (!archivo) {
+        std::cerr << "[WARNING] No se pudo escribir " << ruta << "\n";
+        return false;
+    }
+    return true;
+}
+
+cv::Mat ProcesarYGuardarSlice(
+    const cv::Mat& slice8u,
+    const cv::Mat& maskBin,
+    const fs::path& dirOrig,
+    const fs::path& dirMask,
+    const fs::path& dirHigh,
+    unsigned int indiceZ,
+    int filterOption,
+    cv::Mat* processedSalida,
+    const cv::Mat* etiquetas,
+    AreasEtiquetas* areasEtiquetasSalida,
+    const PlanosFiltrados3D* filtrados3D,
+    int radioFiltro
+)
+{
+    cv::Mat maskRefined;
+    cv::Mat highlighted = ProcesarSlice(slice8u, maskBin, filterOption, &maskRefined, processedSalida,
+                                        etiquetas, areasEtiquetasSalida, filtrados3D, radioFiltro);
 
     // ——— Preparar nombres de archivos de salida ———
-    char buffer[64];
-    std::snprintf(buffer, sizeof(buffer), "slice_%03u.png", indiceZ);
+    const std::string nombre = NombreArchivoSlice(indiceZ);
 
-    fs::path rutaOrig     = dirOrig / buffer;
-    fs::path rutaMaskImg  = dirMask / buffer;
-    fs::path rutaHigh     = dirHigh / buffer;
+    fs::path rutaOrig     = dirOrig / nombre;
+    fs::path rutaMaskImg  = dirMask / nombre;
+    fs::path rutaHigh     = dirHigh / nombre;
 
     // Guardar cada imagen
-    cv::imwrite(rutaOrig.string(), slice8u);       // processed “original” del filtro
-    cv::imwrite(rutaMaskImg.string(), maskRefined);  // máscara refinada
-    cv::imwrite(rutaHigh.string(), highlighted);     // Highlighted con ROI y bordes
+    GuardarPng(rutaOrig, slice8u);         // processed “original” del filtro
+    GuardarPng(rutaMaskImg, maskRefined);  // máscara refinada
+    GuardarPng(rutaHigh, highlighted);     // Highlighted con ROI y bordes
 
     // std::cout << "Guardado slice " << indiceZ << " -> OriginalFiltro, Mask, Highlighted\n";
+    return highlighted;
 }
@@ -2,7 +2,11 @@
 #ifndef FILTROS_H
 #define FILTROS_H
 
+#include <array>
+#include <cstdint>
 #include <filesystem>
+#include <string>
+#include <vector>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
@@ -27,7 +31,116 @@ cv::Mat ITKImage2DtoCVMat(const ImageType2D::Pointer& image2D);
 cv::Mat ITKMask2BinCVMat(const ImageType2D::Pointer& mask2D);
 
 /**
- * Procesa un único slice:
+ * Escala un plano de un canal (CV_8U, CV_16S, CV_16U o CV_32F, cualquier orientación)
+ * a 8 bits usando su mínimo y máximo. Los float32 conservan su precisión hasta aquí.
+ */
+cv::Mat Normalizar16a8(const cv::Mat& plano);
+
+/**
+ * Convierte un plano de máscara de un canal (cualquier tipo) a binaria 8 bits (0 ó 255, >0 es ROI).
+ */
+cv::Mat BinarizarMascara(const cv::Mat& plano);
+
+/**
+ * Nombre de archivo de un slice guardado: "slice_XXX.png" (XXX = índice con 3 dígitos).
+ */
+std::string NombreArchivoSlice(unsigned int indice);
+
+/**
+ * Píxeles de cada etiqueta de la máscara (índice = etiqueta, 0 = fondo) en un slice compuesto.
+ */
+using AreasEtiquetas = std::array<uint64_t, 256>;
+
+/**
+ * Color (BGR) y opacidad del overlay de cada etiqueta de la máscara (0 = fondo, sin color).
+ * Por defecto: 1 y 255 en rojo (el overlay binario de siempre), 2 azul, 3 amarillo,
+ * 4 magenta, 5 cian, 6 naranja, 7 violeta, y de ahí se repiten; el verde queda para
+ * los bordes. Guarda ya precalculada la tabla de mezcla que usa ComponerOverlay.
+ */
+class PaletaEtiquetas
+{
+public:
+    PaletaEtiquetas();
+
+    void Fijar(int etiqueta, const cv::Vec3b& colorBgr, double alfa);
+
+    // Fila de la tabla de una etiqueta: [canal * 256 + valor del filtro] -> valor mezclado
+    const uchar* Tabla(int etiqueta) const { return tabla.data() + static_cast<size_t>(etiqueta) * 3 * 256; }
+
+    static const PaletaEtiquetas& PorDefecto();
+
+private:
+    std::vector<uchar> tabla;      // 256 etiquetas x 3 canales x 256 valores
+};
+
+/**
+ * Construye la imagen highlighted en una sola pasada por píxel: el resultado del filtro
+ * se mezcla con el color de la etiqueta de cada píxel (una consulta a la tabla de la
+ * paleta por canal) y después con los bordes en verde. Mostrar N clases cuesta lo
+ * mismo que mostrar una.
+ *
+ * @param processed Resultado del filtro (gris o BGR, 8 bits).
+ * @param etiquetas CV_8U del mismo tamaño (0 = fondo).
+ * @param bordes    CV_8U del mismo tamaño (distinto de 0 = borde).
+ * @param areas     Si no es nulo, recibe los píxeles de cada etiqueta, contados en la misma pasada.
+ * @return La imagen highlighted (BGR).
+ */
+cv::Mat ComponerOverlay(
+    const cv::Mat& processed,
+    const cv::Mat& etiquetas,
+    const cv::Mat& bordes,
+    const PaletaEtiquetas& paleta = PaletaEtiquetas::PorDefecto(),
+    AreasEtiquetas* areas = nullptr
+);
+
+// Filtros disponibles: 1..kNumFiltros (ver ProcesarSlice)
+constexpr int kNumFiltros = 13;
+
+// Radio de los filtros 11 y 12 (ventana de 2·radio+1) si no se elige otro, y máximo admitido.
+// Su coste por píxel no depende del radio.
+constexpr int kRadioMedianaDefecto = 5;        // 11x11
+constexpr int kRadioGuiadoDefecto  = 8;        // 17x17
+constexpr int kRadioFiltroMaximo   = 64;
+
+/**
+ * Planos de un slice ya calculados sobre el volumen entero en el modo 3D (ver Filtros3D.h),
+ * al tamaño del slice. Los vacíos se calculan en 2D como siempre.
+ */
+struct PlanosFiltrados3D
+{
+    cv::Mat processed;      // resultado del filtro 3D (CV_8U)
+    cv::Mat maskRefinada;   // máscara refinada en 3D (0/255)
+};
+
+/**
+ * Aplica el filtro elegido (filterOption) a un slice y construye la imagen
+ * highlighted (resultado + ROI coloreada por etiqueta + bordes en verde), sin escribir nada.
+ *
+ * @param maskRefinadaSalida Si no es nulo, recibe la máscara refinada (apertura + cierre).
+ * @param processedSalida    Si no es nulo, recibe el resultado del filtro (antes del overlay).
+ * @param etiquetas          Si no es nulo, etiquetas de la máscara (CV_8U, tamaño de maskBin)
+ *                           para colorear cada clase; si es nulo, la ROI entera va en rojo.
+ * @param areasEtiquetasSalida Si no es nulo, recibe los píxeles de cada etiqueta en la
+ *                           máscara refinada (contados al componer).
+ * @param filtrados3D        Si no es nulo, resultado del filtro y máscara refinada del modo 3D:
+ *                           sustituyen al filtro y al refinado 2D (sólo se compone).
+ * @param radioFiltro        Radio de los filtros 11 y 12 (1–kRadioFiltroMaximo; 0 = el de cada uno).
+ * @return La imagen highlighted (BGR).
+ */
+cv::Mat ProcesarSlice(
+    const cv::Mat& slice8u,
+    const cv::Mat& maskBin,
+    int filterOption,
+    cv::Mat* maskRefinadaSalida = nullptr,
+    cv::Mat* processedSalida = nullptr,
+    const cv::Mat* etiquetas = nullptr,
+    AreasEtiquetas* areasEtiquetasSalida = nullptr,
+    const PlanosFiltrados3D* filtrados3D = nullptr,
+    int radioFiltro = 0
+);
+
+/**
+ * Procesa un único slice (ProcesarSlice) y guarda los resultados:
  *  - Aplica el filtro elegido (filterOption)
  *  - Guarda las imágenes resultantes (original ecualizada, máscara refinada, highlighted)
  *
@@ -37,16 +150,27 @@ cv::Mat ITKMask2BinCVMat(const ImageType2D::Pointer& mask2D);
  * @param dirMask      Carpeta donde se guardará la máscara refinada
  * @param dirHigh      Carpeta donde se guardará la imagen highlight (ROI + bordes)
  * @param indiceZ      Índice del slice para nombrar los archivos (slice_XXX.png)
- * @param filterOption Entero (1–10) que indica qué filtro/técnica aplicar.
+ * @param filterOption Entero (1–kNumFiltros) que indica qué filtro/técnica aplicar.
+ * @param processedSalida Si no es nulo, recibe el resultado del filtro (antes del overlay).
+ * @param etiquetas       Si no es nulo, etiquetas de la máscara (ver ProcesarSlice).
+ * @param areasEtiquetasSalida Si no es nulo, recibe los píxeles de cada etiqueta (ver ProcesarSlice).
+ * @param filtrados3D     Si no es nulo, planos del modo 3D (ver ProcesarSlice).
+ * @param radioFiltro     Radio de los filtros 11 y 12 (ver ProcesarSlice).
+ * @return La imagen highlighted (BGR) que se guardó.
  */
-void ProcesarYGuardarSlice(
+cv::Mat ProcesarYGuardarSlice(
     const cv::Mat& slice8u,
     const cv::Mat& maskBin,
     const fs::path& dirOrig,
     const fs::path& dirMask,
     const fs::path& dirHigh,
     unsigned int indiceZ,
-    int filterOption
+    int filterOption,
+    cv::Mat* processedSalida = nullptr,
+    const cv::Mat* etiquetas = nullptr,
+    AreasEtiquetas* areasEtiquetasSalida = nullptr,
+    const PlanosFiltrados3D* filtrados3D = nullptr,
+    int radioFiltro = 0
 );
 
 // —————— Declaración de funciones para cada técnica ——————
@@ -71,13 +195,22 @@ cv::Mat aplicarDeteccionBordes(const cv::Mat& src);
 // 6) Manipulación de píxeles (ej. negativo, invertir intensidades)
 cv::Mat aplicarManipulacionPixeles(const cv::Mat& src);
 
-// 7) Filtros de suavizado (e.g. GaussianBlur, Mediana, Bilateral)
+// 7) Filtros de suavizado (GaussianBlur 5x5; mediana y suavizado con bordes en 11 y 12)
 cv::Mat aplicarFiltroSuavizado(const cv::Mat& src);
 
 // 8) Operaciones morfológicas (apertura + cierre, dilatación, erosión, etc.)
 cv::Mat aplicarOperacionesMorfo(const cv::Mat& src);
 
-// 9) Otra técnica (por ejemplo: ecualización de histograma)
+// 9) Segmentación Watershed
 cv::Mat aplicarOtraTecnica(const cv::Mat& src);
 
+// 11) Mediana de (2·radio+1)² de coste constante (MedianaHistograma)
+cv::Mat aplicarMedianaRapida(const cv::Mat& src, int radio = kRadioMedianaDefecto);
+
+// 12) Suavizado que conserva los bordes (FiltroGuiadoRapido) con ventana de (2·radio+1)²
+cv::Mat aplicarSuavizadoBordes(const cv::Mat& src, int radio = kRadioGuiadoDefecto);
+
+// 13) Ecualización adaptativa de histograma con contraste limitado (AplicarClahe)
+cv::Mat aplicarClahe(const cv::Mat& src);
+
 #endif // FILTROS_H
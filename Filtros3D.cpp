@@ -0,0 +1,481 @@
+// Filtros3D.cpp
+#include "Filtros3D.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include "BloquesZ.h"             // para RecorrerBloquesZ, VentanaZ y Reflejar101
+#include "Clahe.h"                // para ClaheVolumen (filtro 13)
+#include "Traza.h"
+
+// Sigma del GaussianBlur 5x5 con sigma 0 del filtro 7: 0.3·((5 − 1)·0.5 − 1) + 0.8
+static constexpr double kSigmaSuavizado = 1.1;
+
+// Radio máximo de los núcleos en y y z (vóxeles muy finos respecto a x)
+static constexpr int kRadioMaximo = 8;
+
+// Planos a cada lado con los que se promedian los histogramas del CLAHE 3D: unos 5 mm
+static constexpr double kRadioZClaheMm = 5.0;
+
+// tan(22.5°): una componente del gradiente cuenta en la dirección si pasa de esta fracción de la mayor
+static constexpr float kTan22_5 = 0.41421356f;
+
+Volumen8u::Volumen8u(int nx, int ny, int nz, const double espaciado[3])
+    : nx(nx), ny(ny), nz(nz), datos(static_cast<size_t>(nx) * ny * nz)
+{
+    for (int d = 0; d < 3; ++d) this->espaciado[d] = espaciado[d];
+    memoria.Fijar(static_cast<long long>(datos.size()));
+}
+
+// Vóxeles del eje 'eje' que ocupa un vóxel en x (1 si el espaciado no es válido)
+static double RelacionConX(const Volumen8u& vol, int eje)
+{
+    const double* s = vol.Espaciado();
+    return (s[0] > 0 && s[eje] > 0) ? s[0] / s[eje] : 1.0;
+}
+
+static int RadioAcotado(double radio)
+{
+    return static_cast<int>(std::min<long>(kRadioMaximo, std::max(0L, std::lround(radio))));
+}
+
+// Núcleo columna de 3 coeficientes (para sepFilter2D)
+static cv::Mat Nucleo3(float a, float b, float c)
+{
+    cv::Mat nucleo(3, 1, CV_32F);
+    float* k = nucleo.ptr<float>();
+    k[0] = a; k[1] = b; k[2] = c;
+    return nucleo;
+}
+
+// ----------------------------------------------------------
+// Conversión de volúmenes nativos
+// ----------------------------------------------------------
+
+// Planos axiales de un buffer nativo como cv::Mat (sin copia)
+static cv::Mat PlanoNativo(const void* datos, int tipoCv, int nx, int ny, int z)
+{
+    const size_t bytesPlano = static_cast<size_t>(nx) * ny * CV_ELEM_SIZE(tipoCv);
+    auto base = static_cast<const unsigned char*>(datos);
+    return cv::Mat(ny, nx, tipoCv, const_cast<unsigned char*>(base + z * bytesPlano));
+}
+
+static bool TipoNativoValido(int tipoCv)
+{
+    return tipoCv == CV_8U || tipoCv == CV_16S || tipoCv == CV_16U || tipoCv == CV_32F;
+}
+
+Volumen8u NormalizarVolumenA8(const void* datos, int tipoCv, int nx, int ny, int nz,
+                              const double espaciado[3])
+{
+    CV_Assert(TipoNativoValido(tipoCv));
+
+    std::mutex mtx;
+    double minVal = std::numeric_limits<double>::max();
+    double maxVal = std::numeric_limits<double>::lowest();
+    RecorrerBloquesZ(nz, "minMaxVolumen", [&](int z0, int z1) {
+        double minBloque = std::numeric_limits<double>::max();
+        double maxBloque = std::numeric_limits<double>::lowest();
+        for (int z = z0; z < z1; ++z) {
+            double minPlano, maxPlano;
+            cv::minMaxLoc(PlanoNativo(datos, tipoCv, nx, ny, z), &minPlano, &maxPlano);
+            minBloque = std::min(minBloque, minPlano);
+            maxBloque = std::max(maxBloque, maxPlano);
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        minVal = std::min(minVal, minBloque);
+        maxVal = std::max(maxVal, maxBloque);
+    });
+
+    // Con un volumen constante, escala 0: todo a 0 (como Normalizar16a8)
+    Volumen8u vol(nx, ny, nz, espaciado);
+    const double escala = (maxVal > minVal) ? 255.0 / (maxVal - minVal) : 0.0;
+    RecorrerBloquesZ(nz, "normalizarVolumen", [&](int z0, int z1) {
+        for (int z = z0; z < z1; ++z) {
+            cv::Mat salida = vol.PlanoAxial(z);
+            PlanoNativo(datos, tipoCv, nx, ny, z).convertTo(salida, CV_8U, escala, -minVal * escala);
+        }
+    });
+    return vol;
+}
+
+Volumen8u BinarizarVolumen(const void* datos, int tipoCv, int nx, int ny, int nz,
+                           const double espaciado[3])
+{
+    CV_Assert(TipoNativoValido(tipoCv));
+
+    Volumen8u vol(nx, ny, nz, espaciado);
+    RecorrerBloquesZ(nz, "binarizarVolumen", [&](int z0, int z1) {
+        for (int z = z0; z < z1; ++z) {
+            cv::Mat salida = vol.PlanoAxial(z);
+            cv::compare(PlanoNativo(datos, tipoCv, nx, ny, z), 0, salida, cv::CMP_GT);
+        }
+    });
+    return vol;
+}
+
+Volumen8u ReorientarVolumen(const Volumen8u& vol, Orientacion orientacion)
+{
+    VolumenOrtogonal origen(vol.Datos(), CV_8U, vol.Nx(), vol.Ny(), vol.Nz());
+    origen.PrepararOrientacion(orientacion);
+    const cv::Size tam = origen.TamPlano(orientacion);
+    const int planos = origen.NumPlanos(orientacion);
+
+    // Espaciado (columnas, filas, planos): coronal (x, z, y), sagital (y, z, x)
+    const double* e = vol.Espaciado();
+    double espaciado[3] = { e[0], e[1], e[2] };
+    if (orientacion == Orientacion::Coronal) {
+        espaciado[1] = e[2];
+        espaciado[2] = e[1];
+    } else if (orientacion == Orientacion::Sagital) {
+        espaciado[0] = e[1];
+        espaciado[1] = e[2];
+        espaciado[2] = e[0];
+    }
+
+    Volumen8u dst(tam.width, tam.height, planos, espaciado);
+    RecorrerBloquesZ(planos, "reorientarVolumen", [&](int z0, int z1) {
+        for (int z = z0; z < z1; ++z) {
+            cv::Mat salida = dst.PlanoAxial(z);
+            origen.ExtraerPlano(orientacion, z).copyTo(salida);
+        }
+    });
+    return dst;
+}
+
+// ----------------------------------------------------------
+// Filtros
+// ----------------------------------------------------------
+
+// Radio en planos de la media de histogramas del CLAHE: kRadioZClaheMm, al menos un plano
+static int RadioZClahe(const Volumen8u& vol)
+{
+    const double sz = vol.Espaciado()[2];
+    return std::max(1, RadioAcotado(sz > 0 ? kRadioZClaheMm / sz : 1.0));
+}
+
+bool Filtro3DDisponible(int filterOption)
+{
+    return filterOption == 5 || filterOption == 7 || filterOption == 8 || filterOption == 13;
+}
+
+bool Filtro3DPorOrientacion(int filterOption)
+{
+    return filterOption == 13;
+}
+
+Volumen8u AplicarFiltro3D(const Volumen8u& vol, int filterOption)
+{
+    CV_Assert(Filtro3DDisponible(filterOption));
+    switch (filterOption)
+    {
+        case 5:  return BordesCanny3D(vol);
+        case 7:  return SuavizarGaussiano3D(vol);
+        case 13: return ClaheVolumen(vol, RadioZClahe(vol));
+        case 8:
+        default: return AperturaCierre3D(vol);
+    }
+}
+
+Volumen8u SuavizarGaussiano3D(const Volumen8u& vol)
+{
+    const int nx = vol.Nx(), ny = vol.Ny(), nz = vol.Nz();
+    Volumen8u dst(nx, ny, nz, vol.Espaciado());
+
+    // La misma sigma en mm en los tres ejes; el radio, como el 5x5 en x (2·sigma)
+    cv::Mat nucleo[3];
+    int radio[3];
+    for (int d = 0; d < 3; ++d) {
+        const double sigma = kSigmaSuavizado * RelacionConX(vol, d);
+        radio[d]  = RadioAcotado(2.0 * sigma);
+        nucleo[d] = cv::getGaussianKernel(2 * radio[d] + 1, sigma, CV_32F);
+    }
+    const int h = radio[2];
+    const float* kz = nucleo[2].ptr<float>();
+
+    // Ventana de 2h+1 franjas CV_32F
+    const int filasFranja = FilasPorFranjaY(ny, static_cast<size_t>(2 * h + 1) * nx * sizeof(float));
+
+    RecorrerBloquesZ(nz, "suavizado3D", [&](int z0, int z1) {
+        VentanaZ<cv::Mat> ventana(h);
+        std::vector<float> acumulado(nx);
+        for (int y0 = 0; y0 < ny; y0 += filasFranja)
+        {
+            const int y1 = std::min(ny, y0 + filasFranja);
+            for (int u = z0 - h; u < z1 + h; ++u)
+            {
+                // La franja es una ROI del plano: el filtro en y lee las filas vecinas del plano
+                // y sólo refleja en los bordes de éste, como con el plano entero
+                cv::sepFilter2D(vol.PlanoAxial(Reflejar101(u, nz)).rowRange(y0, y1), ventana[u], CV_32F,
+                                nucleo[0], nucleo[1], cv::Point(-1, -1), 0, cv::BORDER_REFLECT_101);
+
+                // Con el plano u ya están los 2h+1 vecinos de z = u − h
+                const int z = u - h;
+                if (z < z0) continue;
+                cv::Mat salida = dst.PlanoAxial(z);
+                for (int y = y0; y < y1; ++y)
+                {
+                    std::fill(acumulado.begin(), acumulado.end(), 0.0f);
+                    for (int k = 0; k <= 2 * h; ++k) {
+                        const float w = kz[k];
+                        const float* fila = ventana[z - h + k].ptr<float>(y - y0);
+                        for (int x = 0; x < nx; ++x) acumulado[x] += w * fila[x];
+                    }
+                    uchar* out = salida.ptr<uchar>(y);
+                    for (int x = 0; x < nx; ++x) out[x] = cv::saturate_cast<uchar>(acumulado[x]);
+                }
+            }
+        }
+    });
+    return dst;
+}
+
+int RadioEquivalente(const Volumen8u& vol, int eje, double radioX)
+{
+    return RadioAcotado(radioX * RelacionConX(vol, eje));
+}
+
+// En el plano con cv::erode/dilate (separable con MORPH_RECT) y en z, mínimo o máximo de los 2·rz+1 planos
+Volumen8u MorfologiaCaja3D(const Volumen8u& vol, bool erosion, int rx, int ry, int rz)
+{
+    const int ny = vol.Ny(), nz = vol.Nz();
+    Volumen8u dst(vol.Nx(), ny, nz, vol.Espaciado());
+    const cv::Mat caja = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * rx + 1, 2 * ry + 1));
+    const int filasFranja = FilasPorFranjaY(ny, static_cast<size_t>(2 * rz + 1) * vol.Nx());
+
+    RecorrerBloquesZ(nz, erosion ? "erosion3D" : "dilatacion3D", [&](int z0, int z1) {
+        VentanaZ<cv::Mat> ventana(rz);
+        for (int y0 = 0; y0 < ny; y0 += filasFranja)
+        {
+            const int y1 = std::min(ny, y0 + filasFranja);
+            for (int u = z0 - rz; u < z1 + rz; ++u)
+            {
+                // Franja como ROI del plano: la caja ve las filas vecinas, como con el plano entero
+                const cv::Mat franja = vol.PlanoAxial(Reflejar101(u, nz)).rowRange(y0, y1);
+                if (erosion) cv::erode(franja, ventana[u], caja);
+                else         cv::dilate(franja, ventana[u], caja);
+
+                const int z = u - rz;
+                if (z < z0) continue;
+                cv::Mat salida = dst.PlanoAxial(z).rowRange(y0, y1);
+                ventana[z - rz].copyTo(salida);
+                for (int k = 1; k <= 2 * rz; ++k) {
+                    if (erosion) cv::min(salida, ventana[z - rz + k], salida);
+                    else         cv::max(salida, ventana[z - rz + k], salida);
+                }
+            }
+        }
+    });
+    return dst;
+}
+
+Volumen8u AperturaCierre3D(const Volumen8u& vol)
+{
+    const int rx = 1;
+    const int ry = std::max(1, RadioEquivalente(vol, 1, rx));
+    const int rz = RadioEquivalente(vol, 2, rx);
+
+    // Apertura (erosión + dilatación) y cierre (dilatación + erosión). Las dos dilataciones
+    // seguidas con una caja son una sola con la caja de radio doble: tres pasadas en vez de cuatro.
+    Volumen8u r = MorfologiaCaja3D(vol, true, rx, ry, rz);
+    r = MorfologiaCaja3D(r, false, 2 * rx, 2 * ry, 2 * rz);
+    return MorfologiaCaja3D(r, true, rx, ry, rz);
+}
+
+// ----------------------------------------------------------
+// Canny 3D
+// ----------------------------------------------------------
+
+// Sobel separable de un plano: a = dx·sy, b = sx·dy, c = sx·sy (CV_16S, exactos con 8 bits)
+struct SobelPlano
+{
+    cv::Mat a, b, c;
+};
+
+// Magnitud L1 del gradiente (CV_32F) y código del vecino hacia el que apunta (CV_8U, 0..26)
+struct GradientePlano
+{
+    cv::Mat magnitud, direccion;
+};
+
+// Código (dx+1) + 3·(dy+1) + 9·(dz+1) del vecino en la dirección del gradiente. Cada
+// componente cuenta si pasa de tan(22.5°) veces la mayor, como las 8 direcciones del Canny 2D.
+static inline uchar CodigoDireccion(float gx, float gy, float gz, float maximo)
+{
+    const float umbral = kTan22_5 * maximo;
+    auto paso = [umbral](float g) { return g > umbral ? 2 : (g < -umbral ? 0 : 1); };
+    return static_cast<uchar>(paso(gx) + 3 * paso(gy) + 9 * paso(gz));
+}
+
+// Gradiente del plano 'actual' con sus vecinos en z. Sobre el Sobel 2D, gx y gy llevan además
+// el suavizado [1 2 1] en z y gz el [1 2 1]x[1 2 1] en el plano: con el factor 1/4 quedan en
+// las unidades del Canny 2D. gy y gz se pasan a derivadas por vóxel de x (espaciado).
+static void CalcularGradiente(const SobelPlano& anterior, const SobelPlano& actual, const SobelPlano& siguiente,
+                              float escalaY, float escalaZ, GradientePlano& g)
+{
+    const int filas = actual.a.rows, columnas = actual.a.cols;
+    g.magnitud.create(filas, columnas, CV_32F);
+    g.direccion.create(filas, columnas, CV_8U);
+
+    const float kx = 0.25f, ky = 0.25f * escalaY, kz = 0.25f * escalaZ;
+    for (int y = 0; y < filas; ++y)
+    {
+        const short* a0 = anterior.a.ptr<short>(y);
+        const short* a1 = actual.a.ptr<short>(y);
+        const short* a2 = siguiente.a.ptr<short>(y);
+        const short* b0 = anterior.b.ptr<short>(y);
+        const short* b1 = actual.b.ptr<short>(y);
+        const short* b2 = siguiente.b.ptr<short>(y);
+        const short* c0 = anterior.c.ptr<short>(y);
+        const short* c2 = siguiente.c.ptr<short>(y);
+        float* mag = g.magnitud.ptr<float>(y);
+        uchar* dir = g.direccion.ptr<uchar>(y);
+        for (int x = 0; x < columnas; ++x)
+        {
+            const float gx = kx * static_cast<float>(a0[x] + 2 * a1[x] + a2[x]);
+            const float gy = ky * static_cast<float>(b0[x] + 2 * b1[x] + b2[x]);
+            const float gz = kz * static_cast<float>(c2[x] - c0[x]);
+            const float ax = std::abs(gx), ay = std::abs(gy), az = std::abs(gz);
+            mag[x] = ax + ay + az;
+            dir[x] = CodigoDireccion(gx, gy, gz, std::max(ax, std::max(ay, az)));
+        }
+    }
+}
+
+// Supresión de no máximos de las filas [filaIni, filaFin) del plano 'actual' (una franja con
+// una fila de halo en cada lado interior; fuera de sus filas está el borde del plano), que van
+// a las filas 0.. de 'salida': 0 = nada, 1 = débil (> bajo), 2 = fuerte (> alto). Como en
+// OpenCV, el vóxel debe superar al vecino de delante y no quedar por debajo del de detrás.
+static void SuprimirNoMaximos(const GradientePlano& anterior, const GradientePlano& actual,
+                              const GradientePlano& siguiente, float bajo, float alto,
+                              int filaIni, int filaFin, cv::Mat salida)
+{
+    const int filas = actual.magnitud.rows, columnas = actual.magnitud.cols;
+    const GradientePlano* planos[3] = { &anterior, &actual, &siguiente };
+
+    for (int y = filaIni; y < filaFin; ++y)
+    {
+        // Filas y−1, y, y+1 de los tres planos (nulas fuera del plano)
+        const float* filasMag[3][3];
+        for (int dz = 0; dz < 3; ++dz)
+            for (int dy = 0; dy < 3; ++dy) {
+                const int yy = y + dy - 1;
+                filasMag[dz][dy] = (yy >= 0 && yy < filas) ? planos[dz]->magnitud.ptr<float>(yy) : nullptr;
+            }
+        auto magnitudEn = [&](int dx, int dy, int dz, int x) {
+            const float* fila = filasMag[dz + 1][dy + 1];
+            const int xx = x + dx;
+            return (fila && xx >= 0 && xx < columnas) ? fila[xx] : 0.0f;
+        };
+
+        const float* mag = actual.magnitud.ptr<float>(y);
+        const uchar* dir = actual.direccion.ptr<uchar>(y);
+        uchar* out = salida.ptr<uchar>(y - filaIni);
+        for (int x = 0; x < columnas; ++x)
+        {
+            const float m = mag[x];
+            out[x] = 0;
+            if (m <= bajo) continue;
+
+            const int dx = dir[x] % 3 - 1, dy = (dir[x] / 3) % 3 - 1, dz = dir[x] / 9 - 1;
+            if (m > magnitudEn(dx, dy, dz, x) && m >= magnitudEn(-dx, -dy, -dz, x))
+                out[x] = (m > alto) ? 2 : 1;
+        }
+    }
+}
+
+// Histéresis con vecindad 26: los débiles conectados a un fuerte pasan a borde (255) y el
+// resto a 0. La propagación es secuencial (sólo visita candidatos); la limpieza, en paralelo.
+static void Histeresis3D(Volumen8u& clases)
+{
+    const int nx = clases.Nx(), ny = clases.Ny(), nz = clases.Nz();
+    if (nz == 0) return;
+    const size_t voxelesPlano = clases.VoxelesPlano();
+    const size_t total = voxelesPlano * nz;
+    uchar* d = clases.Plano(0);
+
+    TramoTraza tramo("histeresis3D");
+    std::vector<size_t> pila;
+    for (size_t i = 0; i < total; ++i)
+    {
+        if (d[i] != 2) continue;
+        d[i] = 255;
+        pila.push_back(i);
+        while (!pila.empty())
+        {
+            const size_t j = pila.back();
+            pila.pop_back();
+            const int z = static_cast<int>(j / voxelesPlano);
+            const int y = static_cast<int>((j % voxelesPlano) / nx);
+            const int x = static_cast<int>(j % nx);
+            for (int zz = std::max(0, z - 1); zz <= std::min(nz - 1, z + 1); ++zz)
+                for (int yy = std::max(0, y - 1); yy <= std::min(ny - 1, y + 1); ++yy)
+                    for (int xx = std::max(0, x - 1); xx <= std::min(nx - 1, x + 1); ++xx) {
+                        const size_t k = zz * voxelesPlano + static_cast<size_t>(yy) * nx + xx;
+                        if (d[k] == 1 || d[k] == 2) {
+                            d[k] = 255;
+                            pila.push_back(k);
+                        }
+                    }
+        }
+    }
+
+    RecorrerBloquesZ(nz, "limpiarHisteresis3D", [&](int z0, int z1) {
+        for (size_t i = z0 * voxelesPlano; i < z1 * voxelesPlano; ++i)
+            d[i] = (d[i] == 255) ? 255 : 0;
+    });
+}
+
+Volumen8u BordesCanny3D(const Volumen8u& vol, double umbral1, double umbral2)
+{
+    const int ny = vol.Ny(), nz = vol.Nz();
+    Volumen8u dst(vol.Nx(), ny, nz, vol.Espaciado());
+
+    // Como cv::Canny, el menor de los dos umbrales es el bajo
+    const float bajo = static_cast<float>(std::min(umbral1, umbral2));
+    const float alto = static_cast<float>(std::max(umbral1, umbral2));
+    const float escalaY = static_cast<float>(RelacionConX(vol, 1));
+    const float escalaZ = static_cast<float>(RelacionConX(vol, 2));
+    const cv::Mat suave = Nucleo3(1, 2, 1);
+    const cv::Mat deriv = Nucleo3(-1, 0, 1);
+
+    // Ventana de una fila: 5 planos de Sobel (3 x CV_16S) y 3 de gradiente (CV_32F + CV_8U)
+    const int filasFranja = FilasPorFranjaY(ny, static_cast<size_t>(vol.Nx()) * (5 * 3 * sizeof(short) + 3 * 5));
+
+    // Para los no máximos de z hacen falta los gradientes de z−1..z+1 y, para esos, el
+    // Sobel en el plano de z−2..z+2: dos ventanas, que van uno y dos planos por detrás.
+    // Cada franja [y0, y1) calcula Sobel y gradiente con una fila más por cada lado interior,
+    // la que miran los no máximos de sus filas extremas.
+    RecorrerBloquesZ(nz, "canny3D", [&](int z0, int z1) {
+        VentanaZ<SobelPlano> sobel(2);
+        VentanaZ<GradientePlano> gradiente(1);
+        for (int y0 = 0; y0 < ny; y0 += filasFranja)
+        {
+            const int y1 = std::min(ny, y0 + filasFranja);
+            const int g0 = std::max(0, y0 - 1), g1 = std::min(ny, y1 + 1);
+            for (int u = z0 - 2; u < z1 + 2; ++u)
+            {
+                // ROI del plano: el Sobel lee las filas vecinas y replica sólo en el borde del plano
+                const cv::Mat franja = vol.PlanoAxial(Reflejar101(u, nz)).rowRange(g0, g1);
+                SobelPlano& s = sobel[u];
+                cv::sepFilter2D(franja, s.a, CV_16S, deriv, suave, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+                cv::sepFilter2D(franja, s.b, CV_16S, suave, deriv, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+                cv::sepFilter2D(franja, s.c, CV_16S, suave, suave, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+
+                const int m = u - 1;
+                if (m < z0 - 1) continue;
+                CalcularGradiente(sobel[m - 1], sobel[m], sobel[m + 1], escalaY, escalaZ, gradiente[m]);
+
+                const int z = u - 2;
+                if (z < z0) continue;
+                SuprimirNoMaximos(gradiente[z - 1], gradiente[z], gradiente[z + 1], bajo, alto,
+                                  y0 - g0, y1 - g0, dst.PlanoAxial(z).rowRange(y0, y1));
+            }
+        }
+    });
+
+    Histeresis3D(dst);
+    return dst;
+}
@@ -0,0 +1,127 @@
+// Filtros3D.h
+#ifndef FILTROS3D_H
+#define FILTROS3D_H
+
+#include <cstddef>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "Memoria.h"              // para MemoriaContada
+#include "Volumen.h"              // para Orientacion y VolumenOrtogonal
+
+/**
+ * Volumen de 8 bits con el layout de ITK (x más rápido, luego y, luego z) y el
+ * espaciado del vóxel en mm (x, y, z). Cada plano axial es contiguo.
+ */
+class Volumen8u
+{
+public:
+    Volumen8u() = default;
+    Volumen8u(int nx, int ny, int nz, const double espaciado[3]);     // todo a 0
+
+    int Nx() const { return nx; }
+    int Ny() const { return ny; }
+    int Nz() const { return nz; }
+    const double* Espaciado() const { return espaciado; }
+    bool Vacio() const { return datos.empty(); }
+    size_t VoxelesPlano() const { return static_cast<size_t>(nx) * ny; }
+    size_t Bytes() const { return datos.size(); }
+
+    const uchar* Datos() const { return datos.data(); }
+    uchar* Plano(int z) { return datos.data() + z * VoxelesPlano(); }
+    const uchar* Plano(int z) const { return datos.data() + z * VoxelesPlano(); }
+
+    // Plano axial z como cv::Mat CV_8UC1 que comparte memoria con el volumen
+    cv::Mat PlanoAxial(int z) { return cv::Mat(ny, nx, CV_8U, Plano(z)); }
+    cv::Mat PlanoAxial(int z) const { return cv::Mat(ny, nx, CV_8U, const_cast<uchar*>(Plano(z))); }
+
+private:
+    int nx = 0, ny = 0, nz = 0;
+    double espaciado[3] = { 1.0, 1.0, 1.0 };
+    std::vector<uchar> datos;
+    MemoriaContada memoria{ CategoriaMemoria::Volumenes };
+};
+
+/**
+ * Pasa a 8 bits un volumen en su tipo nativo (CV_8U, CV_16S, CV_16U o CV_32F) con el
+ * mínimo y el máximo de todo el volumen. Normalizar16a8 usa los de cada plano, que
+ * cambian de un slice al siguiente y romperían la continuidad en z.
+ */
+Volumen8u NormalizarVolumenA8(const void* datos, int tipoCv, int nx, int ny, int nz,
+                              const double espaciado[3]);
+
+/**
+ * Máscara binaria (0/255) de un volumen de máscara en su tipo nativo: >0 es ROI.
+ */
+Volumen8u BinarizarVolumen(const void* datos, int tipoCv, int nx, int ny, int nz,
+                           const double espaciado[3]);
+
+/**
+ * Copia del volumen cuyos planos axiales son los planos de 'orientacion' (en el orden
+ * y con la forma de VolumenOrtogonal::ExtraerPlano), con el espaciado permutado igual.
+ */
+Volumen8u ReorientarVolumen(const Volumen8u& vol, Orientacion orientacion);
+
+/**
+ * Filtros con versión 3D: 5 (bordes), 7 (suavizado), 8 (operaciones morfológicas) y
+ * 13 (CLAHE, ver ClaheVolumen).
+ */
+bool Filtro3DDisponible(int filterOption);
+
+/**
+ * Filtros 3D que no son isótropos respecto a la orientación de salida: el CLAHE (13)
+ * ecualiza planos, así que debe aplicarse al volumen reorientado (ReorientarVolumen)
+ * para que sus teselas sean las del slice guardado y sus vecinos en z los slices vecinos.
+ */
+bool Filtro3DPorOrientacion(int filterOption);
+
+/**
+ * Versión 3D del filtro 'filterOption' (ver Filtro3DDisponible) sobre el volumen entero.
+ *
+ * Todos son separables: cada plano axial se filtra en x e y con OpenCV y después se
+ * combinan en z los 2h+1 planos vecinos. El volumen se reparte en bloques de planos
+ * consecutivos (en paralelo, un bloque por tarea) y cada bloque avanza en z con una
+ * ventana deslizante de planos ya filtrados: cada plano se filtra en el plano una
+ * sola vez (más el halo de h planos en los extremos del bloque) y los temporales
+ * son esos 2h+1 planos por hilo, no volúmenes enteros. Además, cada bloque se recorre
+ * en franjas de filas (FilasPorFranjaY) que se terminan en z antes de pasar a la
+ * siguiente, de modo que la ventana de 2h+1 franjas cabe en la L2 del núcleo.
+ *
+ * Los radios en z salen del espaciado del NIfTI: el filtro cubre en z la misma
+ * distancia en mm que en x, así que con cortes gruesos se reduce a su versión 2D.
+ * El CLAHE (13) no es separable: cada plano se ecualiza con sus propias teselas, pero
+ * con los histogramas promediados con los de los planos a unos 5 mm de cada lado.
+ */
+Volumen8u AplicarFiltro3D(const Volumen8u& vol, int filterOption);
+
+/**
+ * Suavizado gaussiano 3D con la sigma del GaussianBlur 5x5 del filtro 7 (1.1 píxeles
+ * en x), pasada a mm y de vuelta a vóxeles en cada eje.
+ */
+Volumen8u SuavizarGaussiano3D(const Volumen8u& vol);
+
+/**
+ * Radio en vóxeles del eje 'eje' (0 = x, 1 = y, 2 = z) que cubre en mm lo mismo que
+ * 'radioX' vóxeles en x, acotado a [0, 8].
+ */
+int RadioEquivalente(const Volumen8u& vol, int eje, double radioX);
+
+/**
+ * Erosión (o dilatación) con una caja de radios (rx, ry, rz) en vóxeles, por bloques de z.
+ */
+Volumen8u MorfologiaCaja3D(const Volumen8u& vol, bool erosion, int rx, int ry, int rz);
+
+/**
+ * Apertura seguida de cierre (como el filtro 8 y el refinado de la máscara) con un
+ * elemento estructurante de caja de radio 1 en x e y y el equivalente en mm en z.
+ * La caja, a diferencia de la elipse 3x3 del filtro 2D, es separable.
+ */
+Volumen8u AperturaCierre3D(const Volumen8u& vol);
+
+/**
+ * Canny 3D: gradiente de Sobel 3x3x3 (separable, con las derivadas pasadas a mm),
+ * magnitud L1 en las unidades del Canny 2D, supresión de no máximos a lo largo del
+ * gradiente (26 direcciones) e histéresis con vecindad 26. Resultado 0/255.
+ */
+Volumen8u BordesCanny3D(const Volumen8u& vol, double umbral1 = 50, double umbral2 = 150);
+
+#endif // FILTROS3D_H
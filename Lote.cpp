@@ -0,0 +1,411 @@
+// Lote.cpp
+#include "Lote.h"
+#include "Utils.h"                // para ProcesarTodosSlices y OpcionesProcesado
+#include "Manifiesto.h"
+#include "CacheResultados.h"     // para ResultadosVigentes
+#include <opencv2/core.hpp>       // para cv::FileStorage (JSON)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// Hilos por caso a partir de los cuales conviene abrir otro caso en paralelo:
+// con menos, la parte secuencial (lectura del NIfTI) pesa poco frente a los planos.
+static constexpr int kHilosPorCasoObjetivo = 4;
+
+// Nombre del caso sin ".nii.gz" / ".nii"; vacío si no es un NIfTI
+static std::string NombreCasoNifti(const fs::path& ruta)
+{
+    std::string nombre = ruta.filename().string();
+    if (nombre.empty() || nombre[0] == '.') return "";   // ocultos y "._*" de macOS
+
+    for (const char* ext : { ".nii.gz", ".nii" })
+    {
+        const std::string e{ ext };
+        if (nombre.size() > e.size() && nombre.compare(nombre.size() - e.size(), e.size(), e) == 0)
+            return nombre.substr(0, nombre.size() - e.size());
+    }
+    return "";
+}
+
+// Mapa nombre -> ruta de los NIfTI de un directorio
+static std::map<std::string, std::string> ListarNifti(const std::string& dir)
+{
+    std::map<std::string, std::string> archivos;
+    std::error_code ec;
+    for (const auto& entrada : fs::directory_iterator(dir, ec))
+    {
+        if (!entrada.is_regular_file(ec)) continue;
+        std::string nombre = NombreCasoNifti(entrada.path());
+        if (!nombre.empty()) archivos[nombre] = entrada.path().string();
+    }
+    if (ec) {
+        std::cerr << "[ERROR] No se pudo listar '" << dir << "': " << ec.message() << "\n";
+    }
+    return archivos;
+}
+
+std::vector<CasoLote> EmparejarCasos(const std::string& dirImagenes, const std::string& dirMascaras)
+{
+    std::vector<CasoLote> casos;
+    const auto imagenes = ListarNifti(dirImagenes);
+    const auto mascaras = ListarNifti(dirMascaras);
+
+    for (const auto& [nombre, rutaImagen] : imagenes)
+    {
+        auto it = mascaras.find(nombre);
+        if (it == mascaras.end()) {
+            std::cerr << "[WARNING] Caso '" << nombre << "' sin máscara en '" << dirMascaras << "', se omite.\n";
+            continue;
+        }
+        casos.push_back({ nombre, rutaImagen, it->second });
+    }
+    return casos;   // std::map ya los deja ordenados por nombre
+}
+
+RepartoHilos RepartirHilos(int hilosTotales, int numCasos, int casosEnParalelo)
+{
+    if (hilosTotales <= 0) hilosTotales = static_cast<int>(std::thread::hardware_concurrency());
+    hilosTotales = std::max(1, hilosTotales);
+    numCasos = std::max(1, numCasos);
+
+    RepartoHilos r;
+    if (casosEnParalelo > 0)
+        r.casosEnParalelo = casosEnParalelo;
+    else
+        r.casosEnParalelo = std::max(1, hilosTotales / kHilosPorCasoObjetivo);
+
+    r.casosEnParalelo = std::min(r.casosEnParalelo, numCasos);
+    r.hilosPorCaso    = std::max(1, hilosTotales / r.casosEnParalelo);
+    return r;
+}
+
+// Opciones de ProcesarTodosSlices para un caso del lote
+static OpcionesProcesado OpcionesDeCaso(const std::string& carpetaSalidaCaso, const OpcionesLote& opciones,
+                                        int numHilos)
+{
+    OpcionesProcesado op;
+    op.orientacion = opciones.orientacion;
+    op.numHilos    = numHilos;
+    op.recolectarEstadisticas = opciones.estadisticas;
+    op.modo3D      = opciones.modo3D;
+    op.radioFiltro = opciones.radioFiltro;
+    if (opciones.video) {
+        op.rutaVideo = carpetaSalidaCaso + "video/highlighted_video.avi";
+    }
+    return op;
+}
+
+static std::string CarpetaSalidaCaso(const std::string& carpetaSalida, const CasoLote& caso)
+{
+    return (fs::path(carpetaSalida) / caso.nombre).string() + "/";
+}
+
+namespace {
+
+// Volúmenes de un caso leídos por adelantado (vacíos si no hizo falta o falló la lectura)
+struct VolumenesCaso
+{
+    VolumenNifti imagen;
+    VolumenNifti mascara;
+    double msLectura = 0.0;
+};
+
+/**
+ * Precarga de los casos siguientes de un lote. La lectura y descompresión de un
+ * NIfTI es E/S + inflate en un solo hilo; aquí se lanza con std::async para los
+ * casos que vienen mientras los hilos de los actuales filtran y codifican.
+ *
+ * Se adelantan como mucho 'profundidad' casos (uno por caso en paralelo: doble
+ * búfer) y sólo si sus volúmenes caben en 'presupuestoBytes' junto con los demás
+ * ya leídos y aún no tomados. Los casos con resultados vigentes no se leen.
+ */
+class PrecargaCasos
+{
+public:
+    PrecargaCasos(const std::vector<CasoLote>& casos, const std::string& carpetaSalida,
+                  const OpcionesLote& opciones, size_t profundidad)
+        : casos(casos), carpetaSalida(carpetaSalida), opciones(opciones), profundidad(profundidad),
+          presupuestoBytes(static_cast<long long>(std::max(0, opciones.mbPrecarga)) << 20)
+    {}
+
+    // El caso i pasa a un hilo: devuelve sus volúmenes si se precargaron (esperando
+    // a que termine la lectura si hace falta). Si no, ProcesarTodosSlices los leerá.
+    VolumenesCaso Tomar(size_t i)
+    {
+        std::future<VolumenesCaso> lectura;
+        long long bytes = 0;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            siguiente = std::max(siguiente, i + 1);     // ya no tiene sentido adelantarlo
+            auto it = enVuelo.find(i);
+            if (it == enVuelo.end()) return {};
+            lectura = std::move(it->second.first);
+            bytes   = it->second.second;
+            enVuelo.erase(it);
+        }
+
+        VolumenesCaso vol;
+        try {
+            vol = lectura.get();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[WARNING] Precarga de '" << casos[i].nombre << "': " << e.what() << "\n";
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        bytesEnVuelo -= bytes;
+        return vol;
+    }
+
+    // Lanza la lectura de los casos siguientes que quepan en el presupuesto
+    void Adelantar()
+    {
+        if (presupuestoBytes <= 0) return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        while (enVuelo.size() < profundidad && siguiente < casos.size())
+        {
+            const CasoLote& caso = casos[siguiente];
+            const long long bytes = BytesVolumenNifti(caso.rutaImagen) + BytesVolumenNifti(caso.rutaMascara);
+            if (bytes <= 0 || bytes > presupuestoBytes) {
+                ++siguiente;                            // no se precarga: lo lee su hilo
+                continue;
+            }
+            if (bytesEnVuelo + bytes > presupuestoBytes) break;   // esperar a que se tome alguno
+
+            enVuelo[siguiente] = { std::async(std::launch::async, &PrecargaCasos::Leer, this, siguiente), bytes };
+            bytesEnVuelo += bytes;
+            ++siguiente;
+        }
+    }
+
+private:
+    VolumenesCaso Leer(size_t i) const
+    {
+        using Reloj = std::chrono::steady_clock;
+        const auto t0 = Reloj::now();
+
+        const CasoLote& caso = casos[i];
+        const std::string salidaCaso = CarpetaSalidaCaso(carpetaSalida, caso);
+        const OpcionesProcesado op = OpcionesDeCaso(salidaCaso, opciones, 1);
+
+        VolumenesCaso vol;
+        if (opciones.reanudar &&
+            ResultadosVigentes(caso.rutaImagen, caso.rutaMascara, salidaCaso, opciones.filtro, op))
+            return vol;
+
+        // Huellas (quedan en la memoria de CalcularHuella: ProcesarTodosSlices no
+        // vuelve a recorrer los archivos) y volúmenes
+        ManifiestoResultados anterior;
+        LeerManifiesto(salidaCaso, anterior);
+        HuellaArchivo h;
+        CalcularHuella(caso.rutaImagen, h, &anterior.huellaImagen);
+        CalcularHuella(caso.rutaMascara, h, &anterior.huellaMascara);
+
+        vol.imagen = LeerVolumenNiftiNativo(caso.rutaImagen, "imagen");
+        if (vol.imagen) vol.mascara = LeerVolumenNiftiNativo(caso.rutaMascara, "máscara");
+        if (!vol.mascara) vol.imagen = VolumenNifti();
+        vol.msLectura = std::chrono::duration<double, std::milli>(Reloj::now() - t0).count();
+        return vol;
+    }
+
+    const std::vector<CasoLote>& casos;
+    const std::string& carpetaSalida;
+    const OpcionesLote& opciones;
+    const size_t profundidad;
+    const long long presupuestoBytes;
+
+    std::mutex mtx;
+    size_t siguiente = 0;                       // primer caso ni tomado ni lanzado
+    std::map<size_t, std::pair<std::future<VolumenesCaso>, long long>> enVuelo;
+    long long bytesEnVuelo = 0;
+};
+
+} // namespace
+
+static ResultadoCaso ProcesarCasoConVolumenes(
+    const CasoLote& caso,
+    const std::string& carpetaSalidaCaso,
+    const OpcionesLote& opciones,
+    int numHilos,
+    VolumenesCaso volumenes
+)
+{
+    ResultadoCaso res;
+    res.nombre = caso.nombre;
+
+    OpcionesProcesado op = OpcionesDeCaso(carpetaSalidaCaso, opciones, numHilos);
+    op.imagenPrecargada  = volumenes.imagen;
+    op.mascaraPrecargada = volumenes.mascara;
+    if (volumenes.imagen) res.msPrecarga = volumenes.msLectura;
+
+    // Caso ya terminado en una ejecución anterior con la misma entrada y parámetros
+    ManifiestoResultados m;
+    if (opciones.reanudar &&
+        ResultadosVigentes(caso.rutaImagen, caso.rutaMascara, carpetaSalidaCaso, opciones.filtro, op, &m))
+    {
+        res.ok = res.reutilizado = true;
+    }
+    else
+    {
+        res.ok = ProcesarTodosSlices(caso.rutaImagen, caso.rutaMascara, carpetaSalidaCaso,
+                                     opciones.filtro, op);
+    }
+
+    // Tiempos y número de slices desde el manifiesto del caso
+    if (res.ok && (res.reutilizado || LeerManifiesto(carpetaSalidaCaso, m))) {
+        res.numSlices   = m.NumSlices();
+        res.msLectura   = m.msLectura;
+        res.msProcesado = m.msProcesado;
+        res.msTotal     = m.msTotal;
+    }
+    return res;
+}
+
+ResultadoCaso ProcesarCaso(
+    const CasoLote& caso,
+    const std::string& carpetaSalidaCaso,
+    const OpcionesLote& opciones,
+    int numHilos
+)
+{
+    return ProcesarCasoConVolumenes(caso, carpetaSalidaCaso, opciones, numHilos, {});
+}
+
+ResumenLote ProcesarLote(
+    const std::vector<CasoLote>& casos,
+    const std::string& carpetaSalida,
+    const OpcionesLote& opciones
+)
+{
+    using Reloj = std::chrono::steady_clock;
+    const auto t0 = Reloj::now();
+    ReiniciarPicosMemoria();
+
+    ResumenLote resumen;
+    resumen.reparto = RepartirHilos(opciones.hilosTotales, static_cast<int>(casos.size()),
+                                    opciones.casosEnParalelo);
+    resumen.casos.resize(casos.size());
+
+    std::cout << "[INFO] " << casos.size() << " casos, " << resumen.reparto.casosEnParalelo
+              << " en paralelo con " << resumen.reparto.hilosPorCaso << " hilos cada uno.\n";
+
+    // Cada hilo toma el siguiente caso libre (como los planos en ProcesarTodosSlices)
+    std::atomic<size_t> siguiente{ 0 };
+    std::atomic<int> terminados{ 0 };
+    std::mutex mtxLog;
+    PrecargaCasos precarga(casos, carpetaSalida, opciones,
+                           static_cast<size_t>(resumen.reparto.casosEnParalelo));
+
+    auto trabajador = [&]() {
+        for (size_t i = siguiente++; i < casos.size(); i = siguiente++)
+        {
+            const CasoLote& caso = casos[i];
+            ResultadoCaso& res = resumen.casos[i];
+            VolumenesCaso volumenes = precarga.Tomar(i);
+            precarga.Adelantar();                       // el siguiente se lee mientras éste se procesa
+            res = ProcesarCasoConVolumenes(caso, CarpetaSalidaCaso(carpetaSalida, caso), opciones,
+                                           resumen.reparto.hilosPorCaso, std::move(volumenes));
+
+            std::lock_guard<std::mutex> lock(mtxLog);
+            std::cout << "[" << ++terminados << "/" << casos.size() << "] " << caso.nombre
+                      << (res.reutilizado ? " ya hecho" : res.ok ? " ok" : " ERROR");
+            if (res.ok) std::cout << " (" << res.numSlices << " slices, " << res.msTotal << " ms)";
+            std::cout << "\n";
+        }
+    };
+
+    std::vector<std::thread> hilos;
+    for (int h = 1; h < resumen.reparto.casosEnParalelo; ++h) hilos.emplace_back(trabajador);
+    trabajador();
+    for (auto& hilo : hilos) hilo.join();
+
+    resumen.segundos = std::chrono::duration<double>(Reloj::now() - t0).count();
+    for (const auto& res : resumen.casos)
+    {
+        if (res.ok) {
+            ++resumen.casosOk;
+            if (res.reutilizado) ++resumen.casosReutilizados;
+            else                 resumen.slicesTotales += res.numSlices;
+        } else {
+            ++resumen.casosFallidos;
+        }
+    }
+    if (resumen.segundos > 0.0) {
+        resumen.casosPorSegundo  = (resumen.casosOk - resumen.casosReutilizados) / resumen.segundos;
+        resumen.slicesPorSegundo = static_cast<double>(resumen.slicesTotales) / resumen.segundos;
+    }
+    resumen.memoria = LeerMemoria();
+    return resumen;
+}
+
+bool GuardarResumenLote(const ResumenLote& resumen, const OpcionesLote& opciones, const std::string& ruta)
+{
+    const fs::path rutaFinal{ ruta };
+    const fs::path rutaTmp = rutaFinal.parent_path() / (rutaFinal.stem().string() + ".tmp.json");
+
+    try
+    {
+        if (rutaFinal.has_parent_path()) fs::create_directories(rutaFinal.parent_path());
+
+        cv::FileStorage out(rutaTmp.string(), cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+        if (!out.isOpened()) {
+            std::cerr << "[ERROR] No se pudo escribir el resumen en '" << rutaTmp.string() << "'.\n";
+            return false;
+        }
+
+        out << "filtro"           << opciones.filtro;
+        out << "orientacion"      << std::string(NombreOrientacion(opciones.orientacion));
+        out << "modo3D"           << static_cast<int>(opciones.modo3D);
+        out << "radioFiltro"      << opciones.radioFiltro;
+        out << "casosEnParalelo"  << resumen.reparto.casosEnParalelo;
+        out << "mbPrecarga"       << opciones.mbPrecarga;
+        out << "hilosPorCaso"     << resumen.reparto.hilosPorCaso;
+        out << "numCasos"         << static_cast<int>(resumen.casos.size());
+        out << "casosOk"          << resumen.casosOk;
+        out << "casosReutilizados" << resumen.casosReutilizados;
+        out << "casosFallidos"    << resumen.casosFallidos;
+        out << "slicesTotales"    << static_cast<double>(resumen.slicesTotales);
+        out << "segundos"         << resumen.segundos;
+        out << "casosPorSegundo"  << resumen.casosPorSegundo;
+        out << "slicesPorSegundo" << resumen.slicesPorSegundo;
+        out << "picoMemoria"      << static_cast<double>(resumen.memoria.picoTotal);
+        out << "picosMemoria" << "{";
+        for (int c = 0; c < kNumCategoriasMemoria; ++c)
+            out << NombreCategoriaMemoria(static_cast<CategoriaMemoria>(c)) << static_cast<double>(resumen.memoria.picos[c]);
+        out << "}";
+
+        out << "casos" << "[";
+        for (const auto& res : resumen.casos)
+        {
+            out << "{";
+            out << "nombre"      << res.nombre;
+            out << "ok"          << static_cast<int>(res.ok);
+            out << "reutilizado" << static_cast<int>(res.reutilizado);
+            out << "numSlices"   << res.numSlices;
+            out << "msLectura"   << res.msLectura;
+            out << "msProcesado" << res.msProcesado;
+            out << "msTotal"     << res.msTotal;
+            out << "msPrecarga"  << res.msPrecarga;
+            out << "}";
+        }
+        out << "]";
+
+        out.release();
+        fs::rename(rutaTmp, rutaFinal);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[ERROR] Guardando resumen del lote: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
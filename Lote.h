@@ -0,0 +1,144 @@
+// Lote.h
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <string>
+#include <vector>
+#include "Volumen.h"              // para Orientacion
+#include "Memoria.h"              // para EstadoMemoria
+
+// Nombre del resumen del lote dentro de la carpeta de salida
+constexpr const char* kNombreResumenLote = "resumen_lote.json";
+
+/**
+ * Un caso del dataset: imagen y máscara con el mismo nombre de archivo
+ * (p. ej. imagesTr/lung_001.nii.gz y labelsTr/lung_001.nii.gz).
+ */
+struct CasoLote
+{
+    std::string nombre;          // nombre sin extensión (".nii" / ".nii.gz"), p. ej. "lung_001"
+    std::string rutaImagen;
+    std::string rutaMascara;
+};
+
+/**
+ * Empareja por nombre de archivo los NIfTI de dirImagenes con los de dirMascaras.
+ * Ignora archivos ocultos (los "._*" que deja macOS en los datasets del MSD)
+ * y avisa de las imágenes sin máscara. Devuelve los casos ordenados por nombre.
+ */
+std::vector<CasoLote> EmparejarCasos(const std::string& dirImagenes, const std::string& dirMascaras);
+
+/**
+ * Opciones de ProcesarLote.
+ */
+struct OpcionesLote
+{
+    int filtro = 1;                              // 1–kNumFiltros, como en ProcesarTodosSlices
+    Orientacion orientacion = Orientacion::Axial;
+
+    int hilosTotales    = 0;                     // 0 = todos los núcleos
+    int casosEnParalelo = 0;                     // 0 = lo decide RepartirHilos
+
+    bool video        = false;                   // video MJPG de cada caso en la misma pasada
+    bool estadisticas = true;                    // slice_stats.csv de cada caso
+    bool modo3D       = false;                   // ver OpcionesProcesado::modo3D
+    int  radioFiltro  = 0;                       // ver OpcionesProcesado::radioFiltro
+
+    // Si es true, los casos cuya carpeta ya tiene resultados vigentes (misma clave,
+    // ver ResultadosVigentes) no se vuelven a procesar: un lote interrumpido se retoma.
+    bool reanudar = true;
+
+    // Memoria máxima (MB) para volúmenes leídos por adelantado: mientras se procesa un
+    // caso, se leen y descomprimen los siguientes en segundo plano. No incluye los
+    // volúmenes de los casos que se están procesando. 0 = sin precarga.
+    int mbPrecarga = 1024;
+};
+
+/**
+ * Reparto de hilos entre casos (paralelismo entre casos) y dentro de cada caso
+ * (planos en paralelo en ProcesarTodosSlices).
+ *
+ * La lectura y descompresión del NIfTI de cada caso es secuencial, así que con
+ * muchos hilos en un solo caso gran parte del tiempo los núcleos esperan; por
+ * eso se procesan varios casos a la vez, con unos pocos hilos cada uno.
+ */
+struct RepartoHilos
+{
+    int casosEnParalelo = 1;
+    int hilosPorCaso    = 1;
+};
+
+/**
+ * @param hilosTotales    Núcleos disponibles (0 = hardware_concurrency).
+ * @param numCasos        Casos del lote.
+ * @param casosEnParalelo Si es > 0 se respeta (limitado a numCasos) y sólo se reparten los hilos.
+ */
+RepartoHilos RepartirHilos(int hilosTotales, int numCasos, int casosEnParalelo = 0);
+
+/**
+ * Resultado de un caso del lote.
+ */
+struct ResultadoCaso
+{
+    std::string nombre;
+    bool   ok = false;
+    bool   reutilizado = false;                  // ya estaba hecho (no se procesó en este lote)
+    int    numSlices   = 0;
+    double msLectura   = 0.0;                    // lectura que sí esperó el caso (según el manifiesto)
+    double msProcesado = 0.0;
+    double msTotal     = 0.0;
+    double msPrecarga  = 0.0;                    // lectura hecha en segundo plano (0 si no se precargó)
+};
+
+/**
+ * Resumen del lote (se escribe como JSON con GuardarResumenLote).
+ */
+struct ResumenLote
+{
+    std::vector<ResultadoCaso> casos;            // mismo orden que los casos de entrada
+    RepartoHilos reparto;
+
+    int    casosOk           = 0;                // incluye los reutilizados
+    int    casosReutilizados = 0;
+    int    casosFallidos     = 0;
+    long long slicesTotales  = 0;                // sólo de los casos procesados en este lote
+
+    double segundos         = 0.0;               // tiempo de pared del lote completo
+    double casosPorSegundo  = 0.0;               // casos procesados (no reutilizados) por segundo
+    double slicesPorSegundo = 0.0;
+
+    EstadoMemoria memoria;                       // picos de todo el lote (casos en paralelo y precargas incluidos)
+};
+
+/**
+ * Procesa un caso en carpetaSalidaCaso con 'numHilos' hilos (o lo da por hecho si
+ * opciones.reanudar y sus resultados están vigentes). Lo usan ProcesarLote y los
+ * trabajadores de la cola (ColaTrabajo.h).
+ */
+ResultadoCaso ProcesarCaso(
+    const CasoLote& caso,
+    const std::string& carpetaSalidaCaso,
+    const OpcionesLote& opciones,
+    int numHilos
+);
+
+/**
+ * Procesa todos los casos: cada uno en carpetaSalida/<nombre>/ con su propio
+ * manifiesto (como una ejecución de ProcesarTodosSlices). Varios casos se procesan
+ * a la vez según RepartirHilos; un caso que falla no detiene al resto.
+ * Con opciones.mbPrecarga > 0, los volúmenes de los casos siguientes se leen
+ * mientras se procesan los actuales (uno por caso en paralelo, doble búfer).
+ */
+ResumenLote ProcesarLote(
+    const std::vector<CasoLote>& casos,
+    const std::string& carpetaSalida,
+    const OpcionesLote& opciones
+);
+
+/**
+ * Escribe el resumen del lote en JSON (archivo temporal + rename).
+ * @return true si se escribió correctamente.
+ */
+bool GuardarResumenLote(const ResumenLote& resumen, const OpcionesLote& opciones, const std::string& ruta);
+
+#endif // LOTE_H
@@ -2,6 +2,11 @@
 #include "MainWindow.h"
 #include "VideoDialog.h"
 #include "Utils.h"
+#include "StatsDialog.h"
+#include "Estadisticas.h"
+#include "CacheResultados.h"
+#include "Traza.h"
+#include "Memoria.h"
 #include <QCoreApplication>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -11,13 +16,18 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QComboBox>
+#include <QSpinBox>
 #include <QSlider>
+#include <QCheckBox>
+#include <QGroupBox>
+#include <QTableWidget>
+#include <QHeaderView>
 #include <QPixmap>
 #include <QImage>
 #include <QDesktopServices>
 #include <QUrl>
-#include <QProcess>
-#include <filesystem>
+#include <opencv2/imgproc.hpp>
+#include <chrono>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
@@ -45,8 +55,25 @@ MainWindow::MainWindow(QWidget *parent)
     comboFilter->addItem("8) Operaciones morfológicas");
     comboFilter->addItem("9) Segmentación Watershed");
     comboFilter->addItem("10) Aplicar TODOS los filtros en secuencia");
+    comboFilter->addItem("11) Mediana de radio grande (coste constante)");
+    comboFilter->addItem("12) Suavizado que conserva los bordes (filtro guiado)");
+    comboFilter->addItem("13) Ecualización adaptativa de histograma (CLAHE)");
+
+    // Radio de los filtros 11 y 12; 0 = el de cada filtro (11x11 y 17x17)
+    spinRadio = new QSpinBox();
+    spinRadio->setRange(0, kRadioFiltroMaximo);
+    spinRadio->setSpecialValueText("por defecto");
+    spinRadio->setEnabled(false);
+
+    comboOrientacion = new QComboBox();
+    comboOrientacion->addItem("Axial");
+    comboOrientacion->addItem("Coronal");
+    comboOrientacion->addItem("Sagital");
 
     btnApplyFilter = new QPushButton("Aplicar filtro");
+    chkVideoAlProcesar = new QCheckBox("Generar video mientras se procesa");
+    chkTraza = new QCheckBox("Medir tiempos por etapa");
+    chkTraza->setChecked(false);     // sin traza, los tramos casi no cuestan: sólo se mide si se pide
 
     // Tres QLabel para mostrar original, máscara y filtrada
     lblOriginalView  = new QLabel();
@@ -70,10 +97,40 @@ MainWindow::MainWindow(QWidget *parent)
     btnStats       = new QPushButton("Sacar Estadísticas");
     btnStats->setEnabled(false);      // Desactivado hasta que haya al menos un slice
 
+    // Tabla de tiempos por tramo (se rellena tras cada procesamiento con la traza activa)
+    tablaTiempos = new QTableWidget(0, 7);
+    tablaTiempos->setHorizontalHeaderLabels(
+        {"Tramo", "Llamadas", "Total (ms)", "p50 (ms)", "p90 (ms)", "p99 (ms)", "Máx (ms)"});
+    tablaTiempos->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    tablaTiempos->verticalHeader()->setVisible(false);
+    tablaTiempos->setMaximumHeight(220);
+    lblTraza = new QLabel("Sin tiempos: procesa con \"Medir tiempos por etapa\" marcado.");
+
+    // Nombres de objeto: con ellos los encuentra el benchmark de interfaz (benchmarks/BenchInterfaz.cpp)
+    btnLoadImage->setObjectName("btnLoadImage");
+    btnLoadMask->setObjectName("btnLoadMask");
+    comboFilter->setObjectName("comboFilter");
+    spinRadio->setObjectName("spinRadio");
+    comboOrientacion->setObjectName("comboOrientacion");
+    btnApplyFilter->setObjectName("btnApplyFilter");
+    chkVideoAlProcesar->setObjectName("chkVideoAlProcesar");
+    chkTraza->setObjectName("chkTraza");
+    lblOriginalView->setObjectName("lblOriginalView");
+    lblMaskView->setObjectName("lblMaskView");
+    lblFilteredView->setObjectName("lblFilteredView");
+    sliderSlice->setObjectName("sliderSlice");
+    btnMakeVideo->setObjectName("btnMakeVideo");
+    btnOpenVideo->setObjectName("btnOpenVideo");
+    btnStats->setObjectName("btnStats");
+    tablaTiempos->setObjectName("tablaTiempos");
+
     // ----- 2) Conectar señales y slots -----
     connect(btnLoadImage,   &QPushButton::clicked, this, &MainWindow::onLoadImage);
     connect(btnLoadMask,    &QPushButton::clicked, this, &MainWindow::onLoadMask);
     connect(btnApplyFilter, &QPushButton::clicked, this, &MainWindow::onApplyFilter);
+    connect(comboFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int idx) {
+        spinRadio->setEnabled(idx + 1 == 11 || idx + 1 == 12);     // sólo esos tienen radio
+    });
     connect(sliderSlice,    &QSlider::valueChanged, this, &MainWindow::onSliderValueChanged);
     connect(btnMakeVideo,   &QPushButton::clicked, this, &MainWindow::onMakeVideo);
     connect(btnOpenVideo,   &QPushButton::clicked, this, &MainWindow::onOpenVideo);
@@ -102,9 +159,17 @@ MainWindow::MainWindow(QWidget *parent)
     QLabel *lblFilter = new QLabel("Filtro a aplicar:");
     h3->addWidget(lblFilter);
     h3->addWidget(comboFilter);
+    h3->addWidget(new QLabel("Radio:"));
+    h3->addWidget(spinRadio);
+    h3->addWidget(new QLabel("Orientación:"));
+    h3->addWidget(comboOrientacion);
     mainLayout->addLayout(h3);
 
-    mainLayout->addWidget(btnApplyFilter);
+    QHBoxLayout *hApply = new QHBoxLayout();
+    hApply->addWidget(btnApplyFilter);
+    hApply->addWidget(chkVideoAlProcesar);
+    hApply->addWidget(chkTraza);
+    mainLayout->addLayout(hApply);
     mainLayout->addSpacing(10);
 
     // HBox con las tres vistas (original, máscara, filtrada)
@@ -123,6 +188,13 @@ MainWindow::MainWindow(QWidget *parent)
     hVideo->addWidget(btnStats);
     mainLayout->addLayout(hVideo);
 
+    // Panel de tiempos de la última ejecución
+    QGroupBox *grupoTiempos = new QGroupBox("Tiempos de la última ejecución");
+    QVBoxLayout *vTiempos = new QVBoxLayout(grupoTiempos);
+    vTiempos->addWidget(tablaTiempos);
+    vTiempos->addWidget(lblTraza);
+    mainLayout->addWidget(grupoTiempos);
+
     setCentralWidget(central);
 }
 
@@ -131,6 +203,14 @@ MainWindow::~MainWindow()
     // Destructor vacío
 }
 
+void MainWindow::establecerEntradas(const QString& rutaImagen, const QString& rutaMascara)
+{
+    rutaImagenVolumetrica  = rutaImagen;
+    rutaMascaraVolumetrica = rutaMascara;
+    lblImagePath->setText(rutaImagen);
+    lblMaskPath->setText(rutaMascara);
+}
+
 void MainWindow::onLoadImage()
 {
     QString fileName = QFileDialog::getOpenFileName(
@@ -166,6 +246,49 @@ void MainWindow::onApplyFilter()
         return;
     }
 
+    // Seleccionar filtro (1–kNumFiltros)
+    int idx = comboFilter->currentIndex();
+    int filtroSeleccionado = idx + 1;
+
+    // Orientación del corte (0=Axial, 1=Coronal, 2=Sagital, mismo orden que el combo)
+    OpcionesProcesado opciones;
+    opciones.orientacion = static_cast<Orientacion>(comboOrientacion->currentIndex());
+    opciones.framesHighlighted = &framesHighlighted;
+    opciones.recolectarEstadisticas = true;   // Output/slice_stats.csv, casi gratis en la misma pasada
+    opciones.radioFiltro = spinRadio->value();
+
+    // Video en la misma pasada: el rango elegido puede limitar también lo que se procesa
+    QString carpetaVideo = carpetaSalidaBase + "video/";
+    if (chkVideoAlProcesar->isChecked()) {
+        int N = ContarPlanosNifti(rutaImagenVolumetrica.toStdString(), opciones.orientacion);
+        if (N <= 0) {
+            QMessageBox::critical(this, "Error", "No se pudo leer la cabecera de la imagen.");
+            return;
+        }
+        VideoDialog dlg(N, this, true);
+        if (dlg.exec() != QDialog::Accepted) return;
+
+        opciones.rutaVideo   = (carpetaVideo + "highlighted_video.avi").toStdString();
+        opciones.videoInicio = dlg.getStart() - 1;
+        opciones.videoFin    = dlg.getEnd() - 1;
+        if (dlg.getLimitarProcesado()) {
+            opciones.planoInicio = opciones.videoInicio;
+            opciones.planoFin    = opciones.videoFin;
+        }
+    }
+
+    // Mismas entradas, filtro y parámetros que lo que ya hay en Output/: se carga sin reprocesar
+    if (ResultadosVigentes(rutaImagenVolumetrica.toStdString(), rutaMascaraVolumetrica.toStdString(),
+                           carpetaSalidaBase.toStdString(), filtroSeleccionado, opciones))
+    {
+        framesHighlighted.clear();   // los PNG de Output/ son la referencia
+        updateSliderRange();
+        btnOpenVideo->setEnabled(!manifiesto.rutaVideo.empty());
+        QMessageBox::information(this, "Éxito",
+            "Los resultados de este filtro ya estaban calculados; se cargaron de " + carpetaSalidaBase + ".");
+        return;
+    }
+
     // Limpiar carpetas original, mask y highlighted
     QDir dirOrig(carpetaSalidaBase + "original/");
     if (dirOrig.exists()) {
@@ -189,46 +312,79 @@ void MainWindow::onApplyFilter()
     btnOpenVideo->setEnabled(false);
     btnStats->setEnabled(false);
 
-    // Seleccionar filtro (1–10)
-    int idx = comboFilter->currentIndex();
-    int filtroSeleccionado = idx + 1;
+    // La traza sólo cuesta si está activa: cada tramo va al búfer de su hilo
+    const bool trazar = chkTraza->isChecked();
+    if (trazar) IniciarTraza();
+    ReiniciarPicosMemoria();                // los volúmenes ya cargados cuentan desde el principio
 
     bool success = ProcesarTodosSlices(
         rutaImagenVolumetrica.toStdString(),
         rutaMascaraVolumetrica.toStdString(),
         carpetaSalidaBase.toStdString(),
-        filtroSeleccionado
+        filtroSeleccionado,
+        opciones
     );
 
+    if (trazar) DetenerTraza();
+    mostrarTiempos(trazar);
+
     if (!success) {
         QMessageBox::critical(this, "Error", "Falló el procesamiento de slices.");
         return;
     }
 
-    QMessageBox::information(this, "Éxito", "Procesamiento completado correctamente.");
+    if (!opciones.rutaVideo.empty()) {
+        btnOpenVideo->setEnabled(true);
+        QMessageBox::information(this, "Éxito",
+            "Procesamiento completado correctamente.\nVideo guardado en: " + carpetaVideo + "highlighted_video.avi");
+    } else {
+        QMessageBox::information(this, "Éxito", "Procesamiento completado correctamente.");
+    }
 
     // Actualizar slider y cargar slice 0
     updateSliderRange();
 }
 
-void MainWindow::updateSliderRange()
+void MainWindow::mostrarTiempos(bool hayTraza)
 {
-    namespace fs = std::filesystem;
-    QString dirPath = carpetaSalidaBase + "highlighted/";
-    int countPNG = 0;
-
-    if (fs::exists(dirPath.toStdString()) && fs::is_directory(dirPath.toStdString())) {
-        for (auto const& entry : fs::directory_iterator(dirPath.toStdString())) {
-            if (!entry.is_regular_file()) continue;
-            std::string ext = entry.path().extension().string();
-            for (auto &c: ext) c = static_cast<char>(tolower(c));
-            if (ext == ".png") {
-                ++countPNG;
-            }
-        }
+    // El pico de memoria se mide siempre; los tiempos, sólo con la traza
+    const QString textoMemoria = "Pico de memoria: " + QString::fromStdString(DescribirMemoria(LeerMemoria(), true)) + ".";
+    if (!hayTraza) {
+        lblTraza->setText(textoMemoria + " Sin tiempos: procesa con \"Medir tiempos por etapa\" marcado.");
+        return;
+    }
+
+    const std::vector<ResumenTramo> resumen = ResumirTraza();
+    tablaTiempos->clearContents();
+    tablaTiempos->setRowCount(static_cast<int>(resumen.size()));
+    for (int fila = 0; fila < static_cast<int>(resumen.size()); ++fila)
+    {
+        const ResumenTramo& r = resumen[fila];
+        const double valores[] = { r.msTotal, r.p50, r.p90, r.p99, r.max };
+        tablaTiempos->setItem(fila, 0, new QTableWidgetItem(QString::fromStdString(r.nombre)));
+        tablaTiempos->setItem(fila, 1, new QTableWidgetItem(QString::number(r.llamadas)));
+        for (int c = 0; c < 5; ++c)
+            tablaTiempos->setItem(fila, 2 + c, new QTableWidgetItem(QString::number(valores[c], 'f', c == 0 ? 1 : 3)));
     }
+    tablaTiempos->resizeColumnsToContents();
+
+    // La traza completa, para abrirla en chrome://tracing o ui.perfetto.dev
+    const QString rutaTraza = carpetaSalidaBase + "traza.json";
+    QString texto = textoMemoria + " Totales sumados entre hilos.";
+    if (ExportarTrazaChrome(rutaTraza.toStdString()))
+        texto += " Traza completa en " + rutaTraza + " (chrome://tracing o ui.perfetto.dev).";
+    if (const long long descartados = TramosDescartados())
+        texto += " " + QString::number(descartados) + " tramos descartados (búfer lleno).";
+    lblTraza->setText(texto);
+}
+
+void MainWindow::updateSliderRange()
+{
+    // El número de slices y sus nombres salen del manifiesto de la ejecución
+    manifiesto = ManifiestoResultados();
+    LeerManifiesto(carpetaSalidaBase.toStdString(), manifiesto);
 
-    numSlices = countPNG;
+    numSlices = manifiesto.NumSlices();
     if (numSlices > 0) {
         sliderSlice->setEnabled(true);
         sliderSlice->setMinimum(0);
@@ -250,10 +406,10 @@ void MainWindow::updateSliderRange()
 
 void MainWindow::onSliderValueChanged(int value)
 {
-    if (numSlices <= 0) return;
+    if (numSlices <= 0 || value < 0 || value >= numSlices) return;
 
-    // Construir nombre de archivo slice_XXX.png
-    QString nombreSlice = QString("slice_%1.png").arg(value, 3, 10, QChar('0'));
+    // Nombre del archivo (slice_XXX.png) según el manifiesto
+    QString nombreSlice = QString::fromStdString(manifiesto.archivos[value]);
 
     // 1) Cargar original: Output/original/slice_XXX.png
     QString rutaOrig = carpetaSalidaBase + "original/" + nombreSlice;
@@ -286,6 +442,7 @@ void MainWindow::onSliderValueChanged(int value)
     // 3) Cargar filtrada: Output/highlighted/slice_XXX.png
     QString rutaFilt = carpetaSalidaBase + "highlighted/" + nombreSlice;
     QImage imgFilt(rutaFilt);
+    imgHighlightedActual = imgFilt;
     if (imgFilt.isNull()) {
         lblFilteredView->setText("No se pudo cargar:\n" + rutaFilt);
     } else {
@@ -300,24 +457,11 @@ void MainWindow::onSliderValueChanged(int value)
 
 void MainWindow::onMakeVideo()
 {
-    namespace fs = std::filesystem;
     QString carpetaHigh = carpetaSalidaBase + "highlighted/";
-    if (!fs::exists(carpetaHigh.toStdString()) || !fs::is_directory(carpetaHigh.toStdString())) {
-        QMessageBox::warning(this, "Error", "No existe la carpeta Output/highlighted/");
-        return;
-    }
 
-    int N = 0;
-    for (auto const& entry : fs::directory_iterator(carpetaHigh.toStdString())) {
-        if (!entry.is_regular_file()) continue;
-        std::string ext = entry.path().extension().string();
-        for (auto &c: ext) c = static_cast<char>(tolower(c));
-        if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tif" || ext == ".tiff") {
-            ++N;
-        }
-    }
+    int N = manifiesto.NumSlices();
     if (N == 0) {
-        QMessageBox::warning(this, "Error", "No se encontraron imágenes en Output/highlighted/");
+        QMessageBox::warning(this, "Error", "No hay resultados procesados en Output/ (falta el manifiesto).");
         return;
     }
 
@@ -330,12 +474,18 @@ void MainWindow::onMakeVideo()
     QString carpetaVideo = carpetaSalidaBase + "video/";
     QDir().mkpath(carpetaVideo);
 
-    bool ok = GenerarVideoHighlighted(
-        carpetaHigh.toStdString(),
-        carpetaVideo.toStdString(),
-        inicio,
-        fin
-    );
+    // Si los frames de esta ejecución siguen en memoria se evita leer y decodificar los PNG
+    bool ok;
+    if (static_cast<int>(framesHighlighted.size()) == N) {
+        ok = GenerarVideoDesdeFrames(framesHighlighted, carpetaVideo.toStdString(), inicio, fin);
+    } else {
+        ok = GenerarVideoHighlighted(
+            carpetaHigh.toStdString(),
+            carpetaVideo.toStdString(),
+            inicio,
+            fin
+        );
+    }
     if (!ok) {
         QMessageBox::critical(this, "Error", "Falló la generación del video.");
         return;
@@ -366,6 +516,29 @@ void MainWindow::onOpenVideo()
     QDesktopServices::openUrl(QUrl::fromLocalFile(videoPath));
 }
 
+bool MainWindow::cargarVolumenesManifiesto()
+{
+    if (manifiesto.rutaImagen.empty()) return false;
+
+    // Ya están en memoria los de esta ejecución
+    if (volumenImagen && rutaVolumenCacheado == manifiesto.rutaImagen &&
+        rutaMascaraCacheada == manifiesto.rutaMascara)
+        return true;
+
+    volumenImagen = LeerVolumenNiftiNativo(manifiesto.rutaImagen, "imagen");
+    volumenMascara = manifiesto.rutaMascara.empty()
+                   ? VolumenNifti()
+                   : LeerVolumenNiftiNativo(manifiesto.rutaMascara, "máscara");
+    statsVolumenValidas = false;
+    if (!volumenImagen) {
+        rutaVolumenCacheado.clear();
+        return false;
+    }
+    rutaVolumenCacheado = manifiesto.rutaImagen;
+    rutaMascaraCacheada = manifiesto.rutaMascara;
+    return true;
+}
+
 void MainWindow::onStats()
 {
     // 1) Verificar que haya slices
@@ -374,30 +547,77 @@ void MainWindow::onStats()
         return;
     }
 
-    // 2) Determinar índice actual del slider (0-based) y construir ruta a la imagen “highlighted”
     int idxSlice = sliderSlice->value();
-    QString nombreSlice = QString("slice_%1.png").arg(idxSlice, 3, 10, QChar('0'));
-    QString rutaImagen = carpetaSalidaBase + "highlighted/" + nombreSlice;
+    QString nombreSlice = QString::fromStdString(manifiesto.archivos[idxSlice]);
+    auto t0 = std::chrono::steady_clock::now();
+    auto msDesde = [](std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+    };
+
+    // 2) Datos originales en su tipo nativo: slice actual y volumen completo, con la máscara
+    if (cargarVolumenesManifiesto())
+    {
+        const bool hayMascara = volumenMascara && volumenMascara.MismoTamano(volumenImagen);
+
+        Orientacion orientacion = OrientacionDesdeNombre(manifiesto.orientacion);
+        VolumenOrtogonal volImg(volumenImagen.datos, volumenImagen.TipoCv(),
+                                volumenImagen.nx, volumenImagen.ny, volumenImagen.nz);
+        cv::Mat plano = volImg.ExtraerPlano(orientacion, manifiesto.indices[idxSlice]);
+        cv::Mat planoMascara;
+        if (hayMascara) {
+            VolumenOrtogonal volMask(volumenMascara.datos, volumenMascara.TipoCv(),
+                                     volumenMascara.nx, volumenMascara.ny, volumenMascara.nz);
+            planoMascara = volMask.ExtraerPlano(orientacion, manifiesto.indices[idxSlice]);
+        }
+        EstadisticasRoi statsSlice = CalcularEstadisticasRoi(plano, planoMascara);
+
+        if (!statsVolumenValidas) {
+            statsVolumenValidas = CalcularEstadisticasNifti(
+                volumenImagen,
+                hayMascara ? &volumenMascara : nullptr,
+                statsVolumen
+            );
+        }
 
-    // 3) Verificar que el archivo exista
-    if (!QFile::exists(rutaImagen)) {
-        QMessageBox::warning(this, "Error", "No se encontró la imagen:\n" + rutaImagen);
+        StatsDialog *dlg = new StatsDialog(
+            statsSlice,
+            statsVolumenValidas ? &statsVolumen : nullptr,
+            "Slice: " + nombreSlice + " (" + QString::fromStdString(manifiesto.orientacion)
+                + "), intensidades originales (" + NombreTipoPixelVolumen(volumenImagen.tipo) + ")",
+            msDesde(t0),
+            this
+        );
+        dlg->setAttribute(Qt::WA_DeleteOnClose);
+        dlg->show();
         return;
     }
 
-    // 4) Invocar el script Python que genera las estadísticas
-    //    Supondremos que el script se llama "image_stats.py" y está en el mismo directorio que el ejecutable
-    QString scriptPath = "/home/juanja/Desktop/vision/image_stats.py";
-    if (!QFile::exists(scriptPath)) {
-        QMessageBox::warning(this, "Error", "No se encontró el script de estadísticas:\n" + scriptPath);
+    // 3) Sin el NIfTI original: sólo el slice “highlighted” ya en memoria (compuesto de 8 bits)
+    cv::Mat gray;
+    if (idxSlice < static_cast<int>(framesHighlighted.size()) && !framesHighlighted[idxSlice].empty()) {
+        cv::cvtColor(framesHighlighted[idxSlice], gray, cv::COLOR_BGR2GRAY);
+    } else if (!imgHighlightedActual.isNull()) {
+        QImage rgb = imgHighlightedActual.convertToFormat(QImage::Format_RGB888);
+        cv::Mat envoltorio(rgb.height(), rgb.width(), CV_8UC3,
+                           const_cast<uchar*>(rgb.constBits()),
+                           static_cast<size_t>(rgb.bytesPerLine()));
+        cv::cvtColor(envoltorio, gray, cv::COLOR_RGB2GRAY);
+    } else {
+        QMessageBox::warning(this, "Error", "No se pudo cargar la imagen:\n" +
+                             carpetaSalidaBase + "highlighted/" + nombreSlice);
         return;
     }
 
-    // Llamamos a "python3 image_stats.py <rutaImagen>"
-    QStringList args;
-    args << scriptPath << rutaImagen;
-    bool started = QProcess::startDetached("python3", args);
-    if (!started) {
-        QMessageBox::warning(this, "Error", "No se pudo ejecutar el script de Python.");
-    }
+    EstadisticasRoi statsSlice;
+    statsSlice.total = CalcularEstadisticas8u(gray);
+
+    StatsDialog *dlg = new StatsDialog(
+        statsSlice,
+        nullptr,
+        "Slice: " + nombreSlice + " (imagen resaltada de 8 bits; no se pudo leer el NIfTI original)",
+        msDesde(t0),
+        this
+    );
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    dlg->show();
 }
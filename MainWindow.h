@@ -4,11 +4,20 @@
 
 #include <QMainWindow>
 #include <QString>
+#include <QImage>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "Manifiesto.h"
+#include "Estadisticas.h"
+#include "Utils.h"              // para VolumenNifti
 
 class QPushButton;
 class QLabel;
 class QComboBox;
+class QSpinBox;
 class QSlider;
+class QCheckBox;
+class QTableWidget;
 
 class MainWindow : public QMainWindow
 {
@@ -18,6 +27,9 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Imagen y máscara sin pasar por los diálogos (argumentos de main, benchmark de interfaz)
+    void establecerEntradas(const QString& rutaImagen, const QString& rutaMascara);
+
 private slots:
     void onLoadImage();
     void onLoadMask();
@@ -42,7 +54,11 @@ private:
     QLabel      *lblMaskPath;
 
     QComboBox   *comboFilter;
+    QSpinBox    *spinRadio;             // radio de los filtros 11 y 12
+    QComboBox   *comboOrientacion;
     QPushButton *btnApplyFilter;
+    QCheckBox   *chkVideoAlProcesar;
+    QCheckBox   *chkTraza;
 
     // Tres QLabel para mostrar original, máscara y filtrada
     QLabel      *lblOriginalView;
@@ -55,9 +71,33 @@ private:
     QPushButton *btnOpenVideo;
     QPushButton *btnStats;
 
+    // Percentiles por tramo de la última ejecución trazada (Output/traza.json)
+    QTableWidget *tablaTiempos;
+    QLabel       *lblTraza;
+
     int numSlices;
 
+    // Índice de la última ejecución (lo que hay en Output/)
+    ManifiestoResultados manifiesto;
+
+    // Frames highlighted de la última ejecución, en memoria para hacer el video sin releer PNG
+    std::vector<cv::Mat> framesHighlighted;
+
+    // Slice highlighted que se está mostrando (estadísticas si no se puede leer el volumen)
+    QImage imgHighlightedActual;
+
+    // Volúmenes originales (en su tipo nativo) de la ejecución del manifiesto, cacheados
+    // para las estadísticas, y las estadísticas del volumen completo una vez calculadas
+    std::string rutaVolumenCacheado;
+    std::string rutaMascaraCacheada;
+    VolumenNifti volumenImagen;
+    VolumenNifti volumenMascara;
+    EstadisticasVolumen statsVolumen;
+    bool statsVolumenValidas = false;
+
     void updateSliderRange();
+    void mostrarTiempos(bool hayTraza);
+    bool cargarVolumenesManifiesto();
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,146 @@
+// Manifiesto.cpp
+#include "Manifiesto.h"
+#include <opencv2/core.hpp>   // para cv::FileStorage (JSON)
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+static void EscribirHuella(cv::FileStorage& out, const char* nombre, const HuellaArchivo& h)
+{
+    out << nombre << "{";
+    out << "hash"  << h.hash;
+    out << "tam"   << h.tam;
+    out << "mtime" << h.mtime;
+    out << "}";
+}
+
+static HuellaArchivo LeerHuella(const cv::FileNode& nodo)
+{
+    HuellaArchivo h;
+    if (nodo.empty()) return h;
+    h.hash  = static_cast<std::string>(nodo["hash"]);
+    h.tam   = static_cast<std::string>(nodo["tam"]);
+    h.mtime = static_cast<std::string>(nodo["mtime"]);
+    return h;
+}
+
+bool GuardarManifiesto(const ManifiestoResultados& m, const std::string& carpetaSalidaBase)
+{
+    fs::path base{ carpetaSalidaBase };
+    fs::path rutaFinal = base / kNombreManifiesto;
+    fs::path rutaTmp   = base / "manifest.tmp.json";
+
+    try
+    {
+        cv::FileStorage out(rutaTmp.string(), cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+        if (!out.isOpened()) {
+            std::cerr << "[ERROR] No se pudo escribir el manifiesto en '" << rutaTmp.string() << "'.\n";
+            return false;
+        }
+
+        out << "version"     << m.version;
+        out << "rutaImagen"  << m.rutaImagen;
+        out << "rutaMascara" << m.rutaMascara;
+        out << "filtro"      << m.filtro;
+        out << "orientacion" << m.orientacion;
+        out << "modo3D"      << static_cast<int>(m.modo3D);
+        out << "radioFiltro" << m.radioFiltro;
+        out << "numSlices"   << m.NumSlices();
+        out << "ancho"       << m.ancho;
+        out << "alto"        << m.alto;
+        out << "msLectura"   << m.msLectura;
+        out << "msProcesado" << m.msProcesado;
+        out << "msTotal"     << m.msTotal;
+        out << "asignacionesMat"   << static_cast<double>(m.asignacionesMat);
+        out << "reservasHeapArena" << static_cast<double>(m.reservasHeapArena);
+        out << "picoMemoria"       << static_cast<double>(m.picoMemoria);
+        out << "picosMemoria" << "{";
+        for (int c = 0; c < kNumCategoriasMemoria; ++c)
+            out << NombreCategoriaMemoria(static_cast<CategoriaMemoria>(c)) << static_cast<double>(m.picosMemoria[c]);
+        out << "}";
+        out << "rutaVideo"   << m.rutaVideo;
+        out << "archivoEstadisticas" << m.archivoEstadisticas;
+        out << "archivoComponentes"  << m.archivoComponentes;
+        out << "clave"       << m.clave;
+        EscribirHuella(out, "huellaImagen",  m.huellaImagen);
+        EscribirHuella(out, "huellaMascara", m.huellaMascara);
+
+        out << "indices" << "[";
+        for (int idx : m.indices) out << idx;
+        out << "]";
+
+        out << "archivos" << "[";
+        for (const auto& nombre : m.archivos) out << nombre;
+        out << "]";
+
+        out.release();
+
+        fs::rename(rutaTmp, rutaFinal);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[ERROR] Guardando manifiesto: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool LeerManifiesto(const std::string& carpetaSalidaBase, ManifiestoResultados& m)
+{
+    fs::path ruta = fs::path(carpetaSalidaBase) / kNombreManifiesto;
+    if (!fs::exists(ruta)) return false;
+
+    try
+    {
+        cv::FileStorage in(ruta.string(), cv::FileStorage::READ);
+        if (!in.isOpened()) return false;
+
+        ManifiestoResultados leido;
+        leido.version     = static_cast<int>(in["version"]);
+        leido.rutaImagen  = static_cast<std::string>(in["rutaImagen"]);
+        leido.rutaMascara = static_cast<std::string>(in["rutaMascara"]);
+        leido.filtro      = static_cast<int>(in["filtro"]);
+        leido.orientacion = static_cast<std::string>(in["orientacion"]);
+        leido.modo3D      = static_cast<int>(in["modo3D"]) != 0;
+        leido.radioFiltro = static_cast<int>(in["radioFiltro"]);
+        leido.ancho       = static_cast<int>(in["ancho"]);
+        leido.alto        = static_cast<int>(in["alto"]);
+        leido.msLectura   = static_cast<double>(in["msLectura"]);
+        leido.msProcesado = static_cast<double>(in["msProcesado"]);
+        leido.msTotal     = static_cast<double>(in["msTotal"]);
+        leido.asignacionesMat   = static_cast<long long>(static_cast<double>(in["asignacionesMat"]));
+        leido.reservasHeapArena = static_cast<long long>(static_cast<double>(in["reservasHeapArena"]));
+        leido.picoMemoria       = static_cast<long long>(static_cast<double>(in["picoMemoria"]));
+        for (int c = 0; c < kNumCategoriasMemoria; ++c)
+            leido.picosMemoria[c] = static_cast<long long>(static_cast<double>(
+                in["picosMemoria"][NombreCategoriaMemoria(static_cast<CategoriaMemoria>(c))]));
+        leido.rutaVideo   = static_cast<std::string>(in["rutaVideo"]);
+        leido.archivoEstadisticas = static_cast<std::string>(in["archivoEstadisticas"]);
+        leido.archivoComponentes  = static_cast<std::string>(in["archivoComponentes"]);
+        leido.clave         = static_cast<std::string>(in["clave"]);
+        leido.huellaImagen  = LeerHuella(in["huellaImagen"]);
+        leido.huellaMascara = LeerHuella(in["huellaMascara"]);
+
+        for (const auto& nodo : in["indices"])  leido.indices.push_back(static_cast<int>(nodo));
+        for (const auto& nodo : in["archivos"]) leido.archivos.push_back(static_cast<std::string>(nodo));
+
+        if (leido.indices.size() != leido.archivos.size()) {
+            std::cerr << "[ERROR] Manifiesto inconsistente en '" << ruta.string() << "'.\n";
+            return false;
+        }
+        m = std::move(leido);
+    }
+    catch (const cv::Exception& e)
+    {
+        std::cerr << "[ERROR] Leyendo manifiesto '" << ruta.string() << "': " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+void BorrarManifiesto(const std::string& carpetaSalidaBase)
+{
+    std::error_code ec;
+    fs::remove(fs::path(carpetaSalidaBase) / kNombreManifiesto, ec);
+}
@@ -0,0 +1,89 @@
+// Manifiesto.h
+#ifndef MANIFIESTO_H
+#define MANIFIESTO_H
+
+#include <string>
+#include <vector>
+#include "Memoria.h"              // para kNumCategoriasMemoria
+
+// Nombre del manifiesto dentro de la carpeta base de salida (p. ej. "Output/manifest.json")
+constexpr const char* kNombreManifiesto = "manifest.json";
+
+/**
+ * Huella de un archivo de entrada: hash de su contenido y el tamaño y la fecha de
+ * modificación con que se calculó (si no cambian, no hace falta volver a leerlo).
+ * Se guardan como texto porque cv::FileStorage no tiene enteros de 64 bits.
+ */
+struct HuellaArchivo
+{
+    std::string hash;     // FNV-1a de 64 bits en hexadecimal
+    std::string tam;      // bytes
+    std::string mtime;    // ticks de std::filesystem::file_time_type
+};
+
+/**
+ * Índice de una ejecución de ProcesarTodosSlices.
+ * Lo escribe el procesamiento al terminar y lo leen el slider, el diálogo de
+ * video, GenerarVideoHighlighted y la CLI, en lugar de listar las carpetas.
+ * Los nombres de 'archivos' son los mismos en original/, mask/ y highlighted/.
+ */
+struct ManifiestoResultados
+{
+    int version = 1;
+
+    std::string rutaImagen;
+    std::string rutaMascara;
+    int filtro = 0;
+    std::string orientacion;       // "axial", "coronal" o "sagital"
+    bool modo3D = false;           // filtro y refinado de la máscara sobre el volumen entero
+    int radioFiltro = 0;           // radio de los filtros 11 y 12 (0 = el de cada filtro)
+
+    int ancho = 0;                 // tamaño de cada slice guardado (px)
+    int alto  = 0;
+
+    double msLectura    = 0.0;     // lectura de los NIfTI
+    double msProcesado  = 0.0;     // filtrado + guardado de todos los slices
+    double msTotal      = 0.0;
+
+    long long asignacionesMat   = 0;  // temporales cv::Mat servidos desde las arenas de los hilos
+    long long reservasHeapArena = 0;  // bloques que las arenas pidieron al heap (no crece con los slices)
+
+    // Pico de memoria contada (Memoria.h) desde el último ReiniciarPicosMemoria, en bytes
+    long long picoMemoria = 0;
+    long long picosMemoria[kNumCategoriasMemoria] = {};  // por CategoriaMemoria
+
+    std::string rutaVideo;         // video generado durante el procesamiento (vacío si no hubo)
+    // Clave de los resultados: huellas de las entradas + filtro + parámetros (ver CacheResultados.h).
+    // Como el manifiesto se escribe al final, es también el registro de que la ejecución terminó.
+    std::string   clave;
+    HuellaArchivo huellaImagen;
+    HuellaArchivo huellaMascara;
+
+    std::string archivoEstadisticas;  // CSV con el resumen por slice, relativo a la carpeta base (vacío si no hubo)
+    std::string archivoComponentes;   // CSV con las regiones del watershed 3D (modo 3D con el filtro 9; si no, vacío)
+
+    std::vector<int>         indices;   // índice del plano en el volumen, en orden
+    std::vector<std::string> archivos;  // "slice_XXX.png", mismo orden que 'indices'
+
+    int NumSlices() const { return static_cast<int>(archivos.size()); }
+};
+
+/**
+ * Escribe el manifiesto (JSON) en carpetaSalidaBase de forma atómica
+ * (archivo temporal + rename), para que nunca se lea uno a medias.
+ * @return true si se escribió correctamente.
+ */
+bool GuardarManifiesto(const ManifiestoResultados& manifiesto, const std::string& carpetaSalidaBase);
+
+/**
+ * Lee el manifiesto de carpetaSalidaBase.
+ * @return true si existe y es válido; false si no hay resultados.
+ */
+bool LeerManifiesto(const std::string& carpetaSalidaBase, ManifiestoResultados& manifiesto);
+
+/**
+ * Borra el manifiesto de carpetaSalidaBase (si existe), p. ej. antes de una nueva ejecución.
+ */
+void BorrarManifiesto(const std::string& carpetaSalidaBase);
+
+#endif // MANIFIESTO_H
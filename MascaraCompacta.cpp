@@ -0,0 +1,388 @@
+// MascaraCompacta.cpp
+#include "MascaraCompacta.h"
+#include <opencv2/core/utility.hpp>  // para cv::parallel_for_
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// GCC y Clang (las plataformas del proyecto) bajan estos builtins a popcnt/tzcnt/lzcnt
+static inline int ContarUnos(uint64_t w)    { return __builtin_popcountll(w); }
+static inline int CerosFinales(uint64_t w)  { return __builtin_ctzll(w); }   // w != 0
+static inline int CerosIniciales(uint64_t w) { return __builtin_clzll(w); }  // w != 0
+
+static constexpr uint64_t kTodosUnos = ~uint64_t(0);
+
+// ----------------------------------------------------------
+// PlanoMascaraBits
+// ----------------------------------------------------------
+PlanoMascaraBits::PlanoMascaraBits(int filas, int columnas)
+    : filas(filas), columnas(columnas), palabrasFila((columnas + 63) / 64),
+      palabras(static_cast<size_t>(filas) * ((columnas + 63) / 64), 0)
+{
+}
+
+template <class T>
+static void EmpaquetarFilas(const cv::Mat& mascara, PlanoMascaraBits& bits)
+{
+    for (int y = 0; y < mascara.rows; ++y)
+    {
+        const T* src = mascara.ptr<T>(y);
+        uint64_t* dst = bits.Fila(y);
+        for (int w = 0; w < bits.PalabrasPorFila(); ++w)
+        {
+            const int x0 = w * 64;
+            const int n  = std::min(64, mascara.cols - x0);
+            uint64_t palabra = 0;
+            for (int b = 0; b < n; ++b)
+                palabra |= static_cast<uint64_t>(src[x0 + b] > 0) << b;
+            dst[w] = palabra;
+        }
+    }
+}
+
+PlanoMascaraBits PlanoMascaraBits::Empaquetar(const cv::Mat& mascara)
+{
+    CV_Assert(mascara.channels() == 1);
+    CV_Assert(mascara.depth() == CV_8U || mascara.depth() == CV_16S ||
+              mascara.depth() == CV_16U || mascara.depth() == CV_32F);
+    PlanoMascaraBits bits(mascara.rows, mascara.cols);
+    switch (mascara.depth()) {
+        case CV_8U:  EmpaquetarFilas<uchar>(mascara, bits);  break;
+        case CV_16S: EmpaquetarFilas<short>(mascara, bits);  break;
+        case CV_16U: EmpaquetarFilas<ushort>(mascara, bits); break;
+        case CV_32F:
+        default:     EmpaquetarFilas<float>(mascara, bits);  break;
+    }
+    return bits;
+}
+
+cv::Mat PlanoMascaraBits::Expandir(uchar valor) const
+{
+    cv::Mat dst(filas, columnas, CV_8U);
+    for (int y = 0; y < filas; ++y)
+    {
+        const uint64_t* src = Fila(y);
+        uchar* fila = dst.ptr<uchar>(y);
+        for (int w = 0; w < palabrasFila; ++w)
+        {
+            const int x0 = w * 64;
+            const int n  = std::min(64, columnas - x0);
+            const uint64_t palabra = src[w];
+            if (palabra == 0) {
+                std::memset(fila + x0, 0, n);
+            } else if (n == 64 && palabra == kTodosUnos) {
+                std::memset(fila + x0, valor, 64);
+            } else {
+                for (int b = 0; b < n; ++b)
+                    fila[x0 + b] = ((palabra >> b) & 1) ? valor : 0;
+            }
+        }
+    }
+    return dst;
+}
+
+uint64_t PlanoMascaraBits::Area() const
+{
+    uint64_t area = 0;
+    for (uint64_t palabra : palabras) area += static_cast<uint64_t>(ContarUnos(palabra));
+    return area;
+}
+
+cv::Rect PlanoMascaraBits::CajaEnvolvente() const
+{
+    int yMin = filas, yMax = -1;
+    int xMin = columnas, xMax = -1;
+    for (int y = 0; y < filas; ++y)
+    {
+        const uint64_t* fila = Fila(y);
+        int wPrimera = -1, wUltima = -1;
+        for (int w = 0; w < palabrasFila; ++w) {
+            if (fila[w] != 0) {
+                if (wPrimera < 0) wPrimera = w;
+                wUltima = w;
+            }
+        }
+        if (wPrimera < 0) continue;
+
+        yMin = std::min(yMin, y);
+        yMax = y;
+        xMin = std::min(xMin, wPrimera * 64 + CerosFinales(fila[wPrimera]));
+        xMax = std::max(xMax, wUltima * 64 + 63 - CerosIniciales(fila[wUltima]));
+    }
+    if (yMax < 0) return cv::Rect();
+    return cv::Rect(xMin, yMin, xMax - xMin + 1, yMax - yMin + 1);
+}
+
+cv::Mat EtiquetasMascara(const cv::Mat& plano)
+{
+    if (plano.depth() == CV_8U) return plano;
+    cv::Mat etiquetas, roi;
+    plano.convertTo(etiquetas, CV_8U);      // saturate_cast: negativos -> 0, >255 -> 255
+    // Lo que redondea a 0 pero es > 0 (máscaras de probabilidad) sigue siendo ROI, como en
+    // BinarizarVolumen: al menos la etiqueta 1 (con max y no con OR, que cambiaría las pares)
+    cv::compare(plano, 0, roi, cv::CMP_GT);     // 255 / 0
+    cv::min(roi, 1, roi);
+    cv::max(etiquetas, roi, etiquetas);
+    return etiquetas;
+}
+
+// ----------------------------------------------------------
+// PlanoMascaraCompacto
+// ----------------------------------------------------------
+PlanoMascaraCompacto PlanoMascaraCompacto::Desde(PlanoMascaraBits bits, int etiqueta)
+{
+    PlanoMascaraCompacto p;
+    p.filas        = bits.Filas();
+    p.columnas     = bits.Columnas();
+    p.etiquetaBits = etiqueta;
+
+    // Tramos de cada fila recorriendo los bits a 1 con ctz (sin mirar píxel a píxel)
+    std::vector<int> primerTramo(static_cast<size_t>(p.filas) + 1, 0);
+    std::vector<TramoMascara> tramos;
+    const size_t limiteTramos = bits.Bytes() / sizeof(TramoMascara);   // a partir de aquí, bits ocupa menos
+    for (int y = 0; y < p.filas && tramos.size() <= limiteTramos; ++y)
+    {
+        primerTramo[y] = static_cast<int>(tramos.size());
+        const uint64_t* fila = bits.Fila(y);
+        bool abierto = false;
+        for (int w = 0; w < bits.PalabrasPorFila(); ++w)
+        {
+            // Bits donde empieza o acaba un tramo: cambios respecto al bit anterior
+            uint64_t palabra = fila[w];
+            uint64_t cambios = palabra ^ ((palabra << 1) | (abierto ? 1 : 0));
+            while (cambios != 0) {
+                const int x = w * 64 + CerosFinales(cambios);
+                if (!abierto) tramos.push_back({ x, x, etiqueta });
+                else          tramos.back().fin = x;
+                abierto = !abierto;
+                cambios &= cambios - 1;
+            }
+            abierto = (palabra >> 63) & 1;
+        }
+        if (abierto) tramos.back().fin = p.columnas;   // el relleno está a 0: sólo si llega al final
+    }
+    if (!tramos.empty()) p.etiquetasPresentes.set(etiqueta);
+
+    const size_t bytesTramos = tramos.size() * sizeof(TramoMascara) + primerTramo.size() * sizeof(int);
+    if (tramos.size() <= limiteTramos && bytesTramos < bits.Bytes())
+    {
+        primerTramo[p.filas] = static_cast<int>(tramos.size());
+        p.formato     = Formato::Tramos;
+        p.primerTramo = std::move(primerTramo);
+        p.tramos      = std::move(tramos);
+    }
+    else
+    {
+        p.formato = Formato::Bits;
+        p.bits    = std::move(bits);
+    }
+    return p;
+}
+
+PlanoMascaraCompacto PlanoMascaraCompacto::DesdeEtiquetas(const cv::Mat& etiquetas)
+{
+    CV_Assert(etiquetas.type() == CV_8UC1);
+
+    // Una pasada: etiquetas presentes y tramos de igual etiqueta por fila
+    std::bitset<256> presentes;
+    std::vector<int> primerTramo(static_cast<size_t>(etiquetas.rows) + 1, 0);
+    std::vector<TramoMascara> tramos;
+    for (int y = 0; y < etiquetas.rows; ++y)
+    {
+        primerTramo[y] = static_cast<int>(tramos.size());
+        const uchar* fila = etiquetas.ptr<uchar>(y);
+        int x = 0;
+        while (x < etiquetas.cols)
+        {
+            const uchar e = fila[x];
+            const int inicio = x;
+            while (x < etiquetas.cols && fila[x] == e) ++x;
+            if (e != 0) {
+                tramos.push_back({ inicio, x, e });
+                presentes.set(e);
+            }
+        }
+    }
+
+    // Una sola clase (o ninguna): como el caso binario, bits o tramos
+    if (presentes.count() <= 1)
+    {
+        int etiqueta = 1;
+        for (int e = 1; e < 256; ++e) if (presentes.test(e)) etiqueta = e;
+        return Desde(PlanoMascaraBits::Empaquetar(etiquetas), etiqueta);
+    }
+
+    PlanoMascaraCompacto p;
+    p.filas    = etiquetas.rows;
+    p.columnas = etiquetas.cols;
+    p.etiquetasPresentes = presentes;
+
+    const size_t bytesDenso  = static_cast<size_t>(p.filas) * p.columnas;
+    const size_t bytesTramos = tramos.size() * sizeof(TramoMascara) + primerTramo.size() * sizeof(int);
+    if (bytesTramos < bytesDenso)
+    {
+        primerTramo[p.filas] = static_cast<int>(tramos.size());
+        p.formato     = Formato::Tramos;
+        p.primerTramo = std::move(primerTramo);
+        p.tramos      = std::move(tramos);
+    }
+    else
+    {
+        p.formato = Formato::Etiquetas;
+        p.etiquetas.resize(bytesDenso);
+        for (int y = 0; y < p.filas; ++y)
+            std::memcpy(p.etiquetas.data() + static_cast<size_t>(y) * p.columnas, etiquetas.ptr<uchar>(y), p.columnas);
+    }
+    return p;
+}
+
+PlanoMascaraBits PlanoMascaraCompacto::Bits() const
+{
+    if (formato == Formato::Bits) return bits;
+    if (formato == Formato::Etiquetas) return PlanoMascaraBits::Empaquetar(ExpandirEtiquetas());
+
+    PlanoMascaraBits resultado(filas, columnas);
+    for (int y = 0; y < filas; ++y)
+    {
+        uint64_t* fila = resultado.Fila(y);
+        for (int t = primerTramo[y]; t < primerTramo[y + 1]; ++t)
+        {
+            // Palabras completas a 1 y bordes con máscara
+            const int ini = tramos[t].inicio, fin = tramos[t].fin;
+            int x = ini;
+            while (x < fin) {
+                const int w = x / 64, b = x % 64;
+                const int n = std::min(64 - b, fin - x);
+                const uint64_t bitsTramo = (n == 64) ? kTodosUnos : ((uint64_t(1) << n) - 1) << b;
+                fila[w] |= bitsTramo;
+                x += n;
+            }
+        }
+    }
+    return resultado;
+}
+
+cv::Mat PlanoMascaraCompacto::Expandir() const
+{
+    switch (formato)
+    {
+        case Formato::Bits:
+            return bits.Expandir();
+        case Formato::Etiquetas:
+        {
+            cv::Mat binaria;
+            cv::compare(ExpandirEtiquetas(), 0, binaria, cv::CMP_GT);
+            return binaria;
+        }
+        case Formato::Tramos:
+        default:
+        {
+            cv::Mat dst = cv::Mat::zeros(filas, columnas, CV_8U);
+            for (int y = 0; y < filas; ++y)
+            {
+                uchar* fila = dst.ptr<uchar>(y);
+                for (int t = primerTramo[y]; t < primerTramo[y + 1]; ++t)
+                    std::memset(fila + tramos[t].inicio, 255, tramos[t].fin - tramos[t].inicio);
+            }
+            return dst;
+        }
+    }
+}
+
+cv::Mat PlanoMascaraCompacto::ExpandirEtiquetas() const
+{
+    switch (formato)
+    {
+        case Formato::Bits:
+            return bits.Expandir(static_cast<uchar>(etiquetaBits));
+        case Formato::Etiquetas:
+        {
+            cv::Mat dst(filas, columnas, CV_8U);
+            for (int y = 0; y < filas; ++y)
+                std::memcpy(dst.ptr<uchar>(y), etiquetas.data() + static_cast<size_t>(y) * columnas, columnas);
+            return dst;
+        }
+        case Formato::Tramos:
+        default:
+        {
+            cv::Mat dst = cv::Mat::zeros(filas, columnas, CV_8U);
+            for (int y = 0; y < filas; ++y)
+            {
+                uchar* fila = dst.ptr<uchar>(y);
+                for (int t = primerTramo[y]; t < primerTramo[y + 1]; ++t)
+                    std::memset(fila + tramos[t].inicio, tramos[t].etiqueta, tramos[t].fin - tramos[t].inicio);
+            }
+            return dst;
+        }
+    }
+}
+
+uint64_t PlanoMascaraCompacto::Area() const
+{
+    switch (formato)
+    {
+        case Formato::Bits:
+            return bits.Area();
+        case Formato::Etiquetas:
+            return Bits().Area();
+        case Formato::Tramos:
+        default:
+        {
+            uint64_t area = 0;
+            for (const TramoMascara& t : tramos) area += static_cast<uint64_t>(t.fin - t.inicio);
+            return area;
+        }
+    }
+}
+
+cv::Rect PlanoMascaraCompacto::CajaEnvolvente() const
+{
+    if (formato == Formato::Bits)      return bits.CajaEnvolvente();
+    if (formato == Formato::Etiquetas) return Bits().CajaEnvolvente();
+
+    int yMin = filas, yMax = -1, xMin = columnas, xMax = 0;
+    for (int y = 0; y < filas; ++y)
+    {
+        if (primerTramo[y] == primerTramo[y + 1]) continue;
+        yMin = std::min(yMin, y);
+        yMax = y;
+        // Los tramos de una fila van en orden de columna
+        xMin = std::min(xMin, tramos[primerTramo[y]].inicio);
+        xMax = std::max(xMax, tramos[primerTramo[y + 1] - 1].fin);
+    }
+    if (yMax < 0) return cv::Rect();
+    return cv::Rect(xMin, yMin, xMax - xMin, yMax - yMin + 1);
+}
+
+size_t PlanoMascaraCompacto::Bytes() const
+{
+    switch (formato)
+    {
+        case Formato::Bits:      return bits.Bytes();
+        case Formato::Etiquetas: return etiquetas.size();
+        case Formato::Tramos:
+        default:                 return tramos.size() * sizeof(TramoMascara) + primerTramo.size() * sizeof(int);
+    }
+}
+
+// ----------------------------------------------------------
+// VolumenMascaraCompacta
+// ----------------------------------------------------------
+VolumenMascaraCompacta::VolumenMascaraCompacta(const VolumenOrtogonal& mascara, Orientacion orientacion)
+    : planos(mascara.NumPlanos(orientacion))
+{
+    // Cada plano es independiente; los sagitales se leen con salto (sin transponer el volumen)
+    cv::parallel_for_(cv::Range(0, NumPlanos()), [&](const cv::Range& r) {
+        for (int i = r.start; i < r.end; ++i) {
+            planos[i] = PlanoMascaraCompacto::DesdeEtiquetas(
+                EtiquetasMascara(mascara.ExtraerPlano(orientacion, i)));
+        }
+    });
+
+    for (const PlanoMascaraCompacto& p : planos) {
+        bytes += p.Bytes();
+        etiquetas |= p.EtiquetasPresentes();
+        if (p.EnTramos()) ++planosEnTramos;
+    }
+    memoria.Fijar(static_cast<long long>(bytes));
+}
@@ -0,0 +1,154 @@
+// MascaraCompacta.h
+#ifndef MASCARACOMPACTA_H
+#define MASCARACOMPACTA_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "Volumen.h"              // para Orientacion y VolumenOrtogonal
+#include "Memoria.h"              // para MemoriaContada
+
+/**
+ * Plano de máscara binaria empaquetado a 1 bit por píxel: cada fila ocupa
+ * PalabrasPorFila() palabras de 64 bits (bit b de la palabra w = columna 64*w + b)
+ * y los bits sobrantes de la última palabra están siempre a 0.
+ *
+ * Área y caja envolvente trabajan sobre las palabras (popcount, ctz/clz):
+ * 64 píxeles por instrucción y 16 veces menos memoria que la máscara de
+ * 8 bits (0/255) que usan los filtros.
+ */
+class PlanoMascaraBits
+{
+public:
+    PlanoMascaraBits() = default;
+    PlanoMascaraBits(int filas, int columnas);      // todo a 0
+
+    /**
+     * Empaqueta una máscara de un canal (CV_8U, CV_16S, CV_16U o CV_32F): >0 es ROI.
+     */
+    static PlanoMascaraBits Empaquetar(const cv::Mat& mascara);
+
+    /**
+     * Máscara CV_8U (0 ó 'valor'; con 255, como BinarizarMascara). Las palabras
+     * vacías o llenas se escriben con memset.
+     */
+    cv::Mat Expandir(uchar valor = 255) const;
+
+    int Filas() const { return filas; }
+    int Columnas() const { return columnas; }
+    int PalabrasPorFila() const { return palabrasFila; }
+    const uint64_t* Fila(int y) const { return palabras.data() + static_cast<size_t>(y) * palabrasFila; }
+    uint64_t* Fila(int y) { return palabras.data() + static_cast<size_t>(y) * palabrasFila; }
+
+    uint64_t Area() const;              // píxeles a 1
+    cv::Rect CajaEnvolvente() const;    // vacía (0x0) si no hay ningún píxel a 1
+    size_t Bytes() const { return palabras.size() * sizeof(uint64_t); }
+
+private:
+    int filas = 0, columnas = 0, palabrasFila = 0;
+    std::vector<uint64_t> palabras;
+};
+
+/**
+ * Etiquetas CV_8U de un plano de máscara en su tipo nativo: los valores se redondean y
+ * se saturan a 0..255 (los negativos y el 0 son fondo), y todo valor > 0 queda al menos
+ * en la etiqueta 1 (0.3 en una máscara de probabilidad es ROI, como en BinarizarVolumen
+ * y BinarizarMascara). Sin copia si ya es CV_8U.
+ */
+cv::Mat EtiquetasMascara(const cv::Mat& plano);
+
+/**
+ * Tramo [inicio, fin) de píxeles con la misma etiqueta dentro de una fila.
+ */
+struct TramoMascara
+{
+    int inicio   = 0;
+    int fin      = 0;
+    int etiqueta = 1;
+};
+
+/**
+ * Plano de máscara que conserva las etiquetas (0 = fondo, 1..255 = clases), guardado
+ * de la forma que ocupe menos:
+ *  - Bits: una sola etiqueta en el plano (el caso binario), 1 bit por píxel.
+ *  - Tramos: tramos por fila (RLE) con su etiqueta; en los planos vacíos o casi
+ *    vacíos (la mayoría fuera del órgano) se quedan en unos pocos bytes.
+ *  - Etiquetas: un byte por píxel, para planos con varias clases muy fragmentadas.
+ */
+class PlanoMascaraCompacto
+{
+public:
+    enum class Formato { Bits, Tramos, Etiquetas };
+
+    PlanoMascaraCompacto() = default;
+
+    /**
+     * Plano binario empaquetado; sus píxeles a 1 llevan 'etiqueta'.
+     */
+    static PlanoMascaraCompacto Desde(PlanoMascaraBits bits, int etiqueta = 1);
+
+    /**
+     * Plano de etiquetas CV_8U (0 = fondo).
+     */
+    static PlanoMascaraCompacto DesdeEtiquetas(const cv::Mat& etiquetas);
+
+    Formato FormatoPlano() const { return formato; }
+    bool EnTramos() const { return formato == Formato::Tramos; }
+    int Filas() const { return filas; }
+    int Columnas() const { return columnas; }
+
+    // Etiquetas distintas de 0 presentes en el plano (bit e = etiqueta e)
+    const std::bitset<256>& EtiquetasPresentes() const { return etiquetasPresentes; }
+
+    // Plano empaquetado de la ROI (cualquier etiqueta); si no está en bits, se reconstruye
+    PlanoMascaraBits Bits() const;
+    cv::Mat Expandir() const;               // CV_8U binaria (0 ó 255)
+    cv::Mat ExpandirEtiquetas() const;      // CV_8U con la etiqueta de cada píxel
+
+    uint64_t Area() const;
+    cv::Rect CajaEnvolvente() const;
+    size_t Bytes() const;
+
+private:
+    int filas = 0, columnas = 0;
+    Formato formato = Formato::Bits;
+    std::bitset<256> etiquetasPresentes;
+    PlanoMascaraBits bits;                      // Bits: todos los píxeles a 1 con etiquetaBits
+    int etiquetaBits = 1;
+    std::vector<int> primerTramo;               // Tramos: los de la fila y en [primerTramo[y], primerTramo[y+1])
+    std::vector<TramoMascara> tramos;
+    std::vector<uint8_t> etiquetas;             // Etiquetas: filas x columnas
+};
+
+/**
+ * Máscara de un volumen en una orientación, empaquetada plano a plano una sola vez
+ * al cargar (en paralelo) y conservando las etiquetas (ver EtiquetasMascara).
+ * Sustituye a extraer y binarizar cada plano de la máscara nativa: por slice sólo
+ * se leen sus bits, tramos o etiquetas. Su tamaño se cuenta en CategoriaMemoria::Volumenes.
+ */
+class VolumenMascaraCompacta
+{
+public:
+    VolumenMascaraCompacta(const VolumenOrtogonal& mascara, Orientacion orientacion);
+
+    int NumPlanos() const { return static_cast<int>(planos.size()); }
+    const PlanoMascaraCompacto& Plano(int indice) const { return planos[indice]; }
+
+    // Etiquetas distintas de 0 en todo el volumen; con más de una, la máscara es multiclase
+    const std::bitset<256>& Etiquetas() const { return etiquetas; }
+    bool MultiEtiqueta() const { return etiquetas.count() > 1; }
+
+    size_t Bytes() const { return bytes; }
+    int PlanosEnTramos() const { return planosEnTramos; }
+
+private:
+    std::vector<PlanoMascaraCompacto> planos;
+    std::bitset<256> etiquetas;
+    size_t bytes = 0;
+    int planosEnTramos = 0;
+    MemoriaContada memoria{ CategoriaMemoria::Volumenes };
+};
+
+#endif // MASCARACOMPACTA_H
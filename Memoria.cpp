@@ -0,0 +1,139 @@
+// Memoria.cpp
+#include "Memoria.h"
+#include "Traza.h"
+#include <atomic>
+#include <cstdio>
+
+namespace {
+
+std::atomic<long long> vivos[kNumCategoriasMemoria] = {};
+std::atomic<long long> picos[kNumCategoriasMemoria] = {};
+std::atomic<long long> vivosTotal{ 0 };
+std::atomic<long long> picoTotal{ 0 };
+
+// Nombres de los contadores en la traza (literales: la traza guarda el puntero)
+const char* const kContadoresTraza[kNumCategoriasMemoria] = {
+    "memoria.volumenes", "memoria.slices", "memoria.mats", "memoria.frames", "memoria.colaVideo",
+    "memoria.filtros"
+};
+
+thread_local CategoriaMemoria categoriaActiva = CategoriaMemoria::Mats;
+
+void ActualizarPico(std::atomic<long long>& pico, long long valor)
+{
+    long long actual = pico.load(std::memory_order_relaxed);
+    while (valor > actual && !pico.compare_exchange_weak(actual, valor, std::memory_order_relaxed)) {}
+}
+
+} // namespace
+
+const char* NombreCategoriaMemoria(CategoriaMemoria categoria)
+{
+    switch (categoria) {
+        case CategoriaMemoria::Volumenes: return "volumenes";
+        case CategoriaMemoria::Slices:    return "slices";
+        case CategoriaMemoria::Mats:      return "mats";
+        case CategoriaMemoria::Frames:    return "frames";
+        case CategoriaMemoria::ColaVideo: return "colaVideo";
+        case CategoriaMemoria::Filtros:   return "filtros";
+    }
+    return "?";
+}
+
+void SumarMemoria(CategoriaMemoria categoria, long long bytes)
+{
+    if (bytes == 0) return;
+    const int c = static_cast<int>(categoria);
+    const long long enCategoria = vivos[c].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    const long long total = vivosTotal.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (bytes > 0) {
+        ActualizarPico(picos[c], enCategoria);
+        ActualizarPico(picoTotal, total);
+    }
+}
+
+EstadoMemoria LeerMemoria()
+{
+    EstadoMemoria estado;
+    for (int c = 0; c < kNumCategoriasMemoria; ++c) {
+        estado.vivos[c] = vivos[c].load(std::memory_order_relaxed);
+        estado.picos[c] = picos[c].load(std::memory_order_relaxed);
+    }
+    estado.vivosTotal = vivosTotal.load(std::memory_order_relaxed);
+    estado.picoTotal  = picoTotal.load(std::memory_order_relaxed);
+    return estado;
+}
+
+void ReiniciarPicosMemoria()
+{
+    for (int c = 0; c < kNumCategoriasMemoria; ++c)
+        picos[c].store(vivos[c].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    picoTotal.store(vivosTotal.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+std::string DescribirMemoria(const EstadoMemoria& estado, bool picos)
+{
+    const long long* valores = picos ? estado.picos : estado.vivos;
+    const double mb = 1024.0 * 1024.0;
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.1f MB (", (picos ? estado.picoTotal : estado.vivosTotal) / mb);
+    std::string texto = buffer;
+    for (int c = 0; c < kNumCategoriasMemoria; ++c)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s%s %.1f", c ? ", " : "",
+                      NombreCategoriaMemoria(static_cast<CategoriaMemoria>(c)), valores[c] / mb);
+        texto += buffer;
+    }
+    return texto + ")";
+}
+
+void MuestrearMemoriaEnTraza()
+{
+    if (!TrazaActiva()) return;
+    for (int c = 0; c < kNumCategoriasMemoria; ++c)
+        RegistrarContadorTraza(kContadoresTraza[c], vivos[c].load(std::memory_order_relaxed));
+    RegistrarContadorTraza("memoria.total", vivosTotal.load(std::memory_order_relaxed));
+}
+
+CategoriaMemoriaEnHilo::CategoriaMemoriaEnHilo(CategoriaMemoria categoria)
+    : anterior(categoriaActiva)
+{
+    categoriaActiva = categoria;
+}
+
+CategoriaMemoriaEnHilo::~CategoriaMemoriaEnHilo()
+{
+    categoriaActiva = anterior;
+}
+
+CategoriaMemoria CategoriaMemoriaActiva()
+{
+    return categoriaActiva;
+}
+
+MemoriaContada& MemoriaContada::operator=(const MemoriaContada& otra)
+{
+    if (this != &otra) {
+        Fijar(0);
+        categoria = otra.categoria;
+        Fijar(otra.bytes);
+    }
+    return *this;
+}
+
+MemoriaContada& MemoriaContada::operator=(MemoriaContada&& otra) noexcept
+{
+    if (this != &otra) {
+        Fijar(0);
+        categoria = otra.categoria;
+        bytes = otra.bytes;
+        otra.bytes = 0;
+    }
+    return *this;
+}
+
+void MemoriaContada::Fijar(long long nuevos)
+{
+    SumarMemoria(categoria, nuevos - bytes);
+    bytes = nuevos;
+}
@@ -0,0 +1,102 @@
+// Memoria.h
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+#include <string>
+
+/**
+ * Categorías en que se reparte la memoria del pipeline.
+ */
+enum class CategoriaMemoria : int
+{
+    Volumenes = 0,  // volúmenes ITK leídos y la copia transpuesta para cortes sagitales
+    Slices,         // bloques de las arenas de los hilos (temporales cv::Mat de cada slice)
+    Mats,           // resto de cv::Mat del heap (fuera de arenas)
+    Frames,         // frames highlighted guardados en memoria (video sin releer PNG, interfaz)
+    ColaVideo,      // JPEG codificados a la espera de escribirse en el AVI
+    Filtros         // búferes de trabajo de los filtros de volumen (histogramas por tesela de CLAHE 3D...)
+};
+constexpr int kNumCategoriasMemoria = 6;
+
+const char* NombreCategoriaMemoria(CategoriaMemoria categoria);
+
+/**
+ * Suma (o resta, si es negativo) 'bytes' a la categoría y actualiza los picos.
+ * Thread-safe y sin locks.
+ */
+void SumarMemoria(CategoriaMemoria categoria, long long bytes);
+
+/**
+ * Bytes vivos y picos de todas las categorías. El pico total es el máximo de la
+ * suma, no la suma de los máximos de cada categoría.
+ */
+struct EstadoMemoria
+{
+    long long vivos[kNumCategoriasMemoria] = {};
+    long long picos[kNumCategoriasMemoria] = {};
+    long long vivosTotal = 0;
+    long long picoTotal  = 0;
+};
+
+EstadoMemoria LeerMemoria();
+
+/**
+ * Empieza una nueva medida de picos (cada pico pasa a ser lo que hay vivo ahora).
+ * Los picos son del proceso: con varios casos a la vez, incluyen a todos.
+ */
+void ReiniciarPicosMemoria();
+
+/**
+ * Texto para logs e interfaz: "1234.5 MB (volumenes 800.0, slices 64.0, ...)".
+ * @param picos true = picos; false = bytes vivos.
+ */
+std::string DescribirMemoria(const EstadoMemoria& estado, bool picos);
+
+/**
+ * Si la traza está activa, registra los bytes vivos de cada categoría (y el total)
+ * como contadores, que Chrome/Perfetto dibuja como series a lo largo del tiempo.
+ */
+void MuestrearMemoriaEnTraza();
+
+/**
+ * Mientras existe, los cv::Mat que se crean en este hilo fuera de una arena se
+ * cuentan en 'categoria' (por defecto, en Mats).
+ */
+class CategoriaMemoriaEnHilo
+{
+public:
+    explicit CategoriaMemoriaEnHilo(CategoriaMemoria categoria);
+    ~CategoriaMemoriaEnHilo();
+
+    CategoriaMemoriaEnHilo(const CategoriaMemoriaEnHilo&) = delete;
+    CategoriaMemoriaEnHilo& operator=(const CategoriaMemoriaEnHilo&) = delete;
+
+private:
+    CategoriaMemoria anterior;
+};
+
+CategoriaMemoria CategoriaMemoriaActiva();
+
+/**
+ * Bytes de un contenedor que se cuentan en una categoría mientras su dueño vive
+ * (como miembro junto al contenedor: las copias cuentan y los movimientos no duplican).
+ */
+class MemoriaContada
+{
+public:
+    explicit MemoriaContada(CategoriaMemoria categoria) : categoria(categoria) {}
+    MemoriaContada(const MemoriaContada& otra) : categoria(otra.categoria) { Fijar(otra.bytes); }
+    MemoriaContada(MemoriaContada&& otra) noexcept : categoria(otra.categoria), bytes(otra.bytes) { otra.bytes = 0; }
+    MemoriaContada& operator=(const MemoriaContada& otra);
+    MemoriaContada& operator=(MemoriaContada&& otra) noexcept;
+    ~MemoriaContada() { Fijar(0); }
+
+    // Los bytes que ocupa ahora el contenedor
+    void Fijar(long long nuevos);
+
+private:
+    CategoriaMemoria categoria;
+    long long bytes = 0;
+};
+
+#endif // MEMORIA_H
@@ -0,0 +1,54 @@
+// Perfil.cpp
+#include "Perfil.h"
+
+namespace {
+
+// Perfil activo en este hilo (nullptr = no se mide)
+thread_local PerfilEtapas* perfilActivo = nullptr;
+
+} // namespace
+
+const char* NombreEtapa(Etapa etapa)
+{
+    switch (etapa) {
+        case Etapa::Lectura:      return "lectura";
+        case Etapa::Extraccion:   return "extraccion";
+        case Etapa::Conversion:   return "conversion";
+        case Etapa::Filtro:       return "filtro";
+        case Etapa::Composicion:  return "composicion";
+        case Etapa::Codificacion: return "codificacion";
+        case Etapa::Escritura:    return "escritura";
+    }
+    return "?";
+}
+
+double PerfilEtapas::MsTotal() const
+{
+    double total = 0.0;
+    for (int e = 0; e < kNumEtapas; ++e) total += Ms(static_cast<Etapa>(e));
+    return total;
+}
+
+void PerfilEtapas::Reiniciar()
+{
+    for (int e = 0; e < kNumEtapas; ++e) {
+        ns_[e] = 0;
+        llamadas_[e] = 0;
+    }
+}
+
+PerfilEtapas* PerfilActivo()
+{
+    return perfilActivo;
+}
+
+PerfilEnHilo::PerfilEnHilo(PerfilEtapas* perfil)
+    : anterior(perfilActivo)
+{
+    perfilActivo = perfil;
+}
+
+PerfilEnHilo::~PerfilEnHilo()
+{
+    perfilActivo = anterior;
+}
@@ -0,0 +1,105 @@
+// Perfil.h
+#ifndef PERFIL_H
+#define PERFIL_H
+
+#include <atomic>
+#include "Traza.h"               // para TrazaActiva y el registro de tramos
+
+/**
+ * Etapas del pipeline en las que se reparte el tiempo de una ejecución.
+ */
+enum class Etapa : int
+{
+    Lectura = 0,    // leer NIfTI (y huellas) o PNG de disco, descompresión incluida
+    Extraccion,     // sacar el plano del volumen en la orientación pedida
+    Conversion,     // 16 → 8 bits, binarizar la máscara y reescalar
+    Filtro,         // el filtro elegido (1–kNumFiltros)
+    Composicion,    // refinado de la máscara, bordes y overlay
+    Codificacion,   // PNG de los slices y JPEG de los frames del video
+    Escritura       // escribir PNG y frames del AVI a disco
+};
+constexpr int kNumEtapas = 7;
+
+const char* NombreEtapa(Etapa etapa);
+
+/**
+ * Tiempo acumulado por etapa, sumado entre todos los hilos que lo comparten
+ * (con N hilos, la suma puede superar el tiempo de reloj de la ejecución).
+ */
+class PerfilEtapas
+{
+public:
+    void Sumar(Etapa etapa, long long ns)
+    {
+        ns_[static_cast<int>(etapa)].fetch_add(ns, std::memory_order_relaxed);
+        llamadas_[static_cast<int>(etapa)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    double    Ms(Etapa etapa) const       { return ns_[static_cast<int>(etapa)].load() / 1e6; }
+    long long Llamadas(Etapa etapa) const { return llamadas_[static_cast<int>(etapa)].load(); }
+    double    MsTotal() const;
+
+    void Reiniciar();
+
+private:
+    std::atomic<long long> ns_[kNumEtapas]       = {};
+    std::atomic<long long> llamadas_[kNumEtapas] = {};
+};
+
+/**
+ * Perfil en el que se acumulan las etapas medidas en este hilo (nullptr = no se mide).
+ * ProcesarTodosSlices y CodificarVideoMJPG lo pasan a sus hilos de trabajo, así que
+ * basta con activarlo en el hilo que las llama.
+ */
+PerfilEtapas* PerfilActivo();
+
+/**
+ * Activa un perfil en el hilo actual mientras existe (y restaura el anterior al destruirse).
+ */
+class PerfilEnHilo
+{
+public:
+    explicit PerfilEnHilo(PerfilEtapas* perfil);
+    ~PerfilEnHilo();
+
+    PerfilEnHilo(const PerfilEnHilo&) = delete;
+    PerfilEnHilo& operator=(const PerfilEnHilo&) = delete;
+
+private:
+    PerfilEtapas* anterior;
+};
+
+/**
+ * Mide su ámbito: lo suma a la etapa en el perfil activo del hilo y, si la traza
+ * está activa (Traza.h), lo registra como un tramo con el nombre de la etapa.
+ * Sin perfil ni traza no lee el reloj.
+ */
+class MedirEtapa
+{
+public:
+    explicit MedirEtapa(Etapa etapa, int arg = -1)
+        : etapa(etapa), perfil(PerfilActivo()), trazar(TrazaActiva()), arg(arg)
+    {
+        if (perfil || trazar) inicioNs = detalle::AhoraNs();
+    }
+
+    ~MedirEtapa()
+    {
+        if (!perfil && !trazar) return;
+        const long long finNs = detalle::AhoraNs();
+        if (perfil) perfil->Sumar(etapa, finNs - inicioNs);
+        if (trazar) detalle::RegistrarTramo(NombreEtapa(etapa), inicioNs, finNs, arg);
+    }
+
+    MedirEtapa(const MedirEtapa&) = delete;
+    MedirEtapa& operator=(const MedirEtapa&) = delete;
+
+private:
+    Etapa etapa;
+    PerfilEtapas* perfil;
+    bool trazar;
+    int arg;
+    long long inicioNs = 0;
+};
+
+#endif // PERFIL_H
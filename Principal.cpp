@@ -1,117 +1,440 @@
 // Principal.cpp
+// Versión de consola (sin interfaz gráfica): procesa un caso, un dataset completo
+// (imagesTr/labelsTr) o genera el video de una ejecución anterior.
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <string>
-#include <filesystem>     // Para std::filesystem
 #include "Utils.h"
+#include "Lote.h"
+#include "CacheResultados.h"
+#include "ColaTrabajo.h"
+#include "ServidorLocal.h"
+#include "Traza.h"
 
-// Prototipo del menú
-int mostrarMenu();
+namespace {
 
-int main()
+void mostrarUso()
 {
     using namespace std;
-    namespace fs = std::filesystem;
+    cout << "Uso:\n"
+         << "  RMProcessorCli lote <imagesTr> <labelsTr> <carpetaSalida> --filtro N [opciones]\n"
+         << "  RMProcessorCli caso <imagen.nii.gz> <mascara.nii.gz> <carpetaSalida> --filtro N [opciones]\n"
+         << "  RMProcessorCli video <carpetaSalida> <inicio> <fin>\n"
+         << "  RMProcessorCli encolar <imagesTr> <labelsTr> <carpetaSalida> <cola> --filtro N [opciones]\n"
+         << "  RMProcessorCli trabajador <cola> [--hilos N] [--lease-seg S] [--sin-esperar]\n"
+         << "  RMProcessorCli servidor [--socket ruta] [--mb-volumenes N] [--mb-frames N] [--hilos N]\n"
+         << "  RMProcessorCli consulta [--socket ruta] <PROCESAR|SLICE|STATS|SALIR> [argumentos]\n"
+         << "\n"
+         << "Filtros (--filtro N):\n"
+         << "   1) Thresholding\n"
+         << "   2) Contrast Stretching\n"
+         << "   3) Binarización por umbral de color\n"
+         << "   4) Operaciones lógicas (NOT, AND, OR, XOR)\n"
+         << "   5) Detección de Bordes\n"
+         << "   6) Manipulación de píxeles\n"
+         << "   7) Filtros de suavizado\n"
+         << "   8) Operaciones morfológicas\n"
+         << "   9) Segmentación Watershed\n"
+         << "  10) Aplicar TODOS los filtros en secuencia\n"
+         << "  11) Mediana de radio grande (11x11 por defecto; coste constante con el radio)\n"
+         << "  12) Suavizado que conserva los bordes (filtro guiado)\n"
+         << "  13) Ecualización adaptativa de histograma (CLAHE)\n"
+         << "\n"
+         << "Opciones:\n"
+         << "  --orientacion axial|coronal|sagital   (por defecto axial)\n"
+         << "  --hilos N             Hilos en total (0 = todos los núcleos)\n"
+         << "  --casos N             Casos en paralelo en 'lote' (0 = automático)\n"
+         << "  --precarga-mb N       Memoria para leer los casos siguientes mientras se procesan\n"
+         << "                        los actuales en 'lote' (por defecto 1024; 0 = sin precarga)\n"
+         << "  --video               Generar el video de cada caso en la misma pasada\n"
+         << "  --sin-estadisticas    No escribir slice_stats.csv\n"
+         << "  --radio N             Radio de los filtros 11 y 12 (1–" << kRadioFiltroMaximo
+         << "; por defecto " << kRadioMedianaDefecto << " y " << kRadioGuiadoDefecto << ")\n"
+         << "  --3d                  Refinar la máscara en 3D y aplicar los filtros 5, 7, 8, 9 y 13 al volumen\n"
+         << "                        entero (separables, con el espaciado del NIfTI) en vez de por slice\n"
+         << "  --forzar              Reprocesar aunque ya haya resultados vigentes\n"
+         << "  --resumen ruta.json   Resumen del lote (por defecto <carpetaSalida>/"
+         << kNombreResumenLote << ")\n"
+         << "  --traza ruta.json     (cualquier comando) Traza de la ejecución en formato Chrome/Perfetto\n"
+         << "                        y percentiles por tramo al terminar\n"
+         << "\n"
+         << "Cola compartida ('encolar' una vez, 'trabajador' en cada proceso o nodo):\n"
+         << "  --lease-seg S         Sin latido durante S segundos, la tarea se reclama (por defecto 300)\n"
+         << "  --sin-esperar         Terminar en cuanto no haya pendientes, aunque otros sigan en curso\n"
+         << "\n"
+         << "Servidor local (socket Unix, por defecto " << kRutaSocketServidor << "):\n"
+         << "  --mb-volumenes N      Caché de volúmenes leídos (por defecto 4096)\n"
+         << "  --mb-frames N         Caché de slices highlighted en memoria compartida (por defecto 1024)\n"
+         << "  Peticiones: PROCESAR <imagen> <mascara> <carpetaSalida> <filtro> [orientacion]\n"
+         << "              SLICE <imagen> <mascara> <filtro> <orientacion> <indice 0-based>\n"
+         << "              STATS | SALIR\n";
+}
+
+// Lee un entero de argv[i]; false si no es un número válido
+bool leerEntero(const char* texto, int& valor)
+{
+    try {
+        size_t usados = 0;
+        valor = std::stoi(texto, &usados);
+        return usados == std::string(texto).size();
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Opciones comunes a 'lote' y 'caso' (argv a partir de 'desde')
+bool leerOpciones(int argc, char* argv[], int desde, OpcionesLote& op, std::string& rutaResumen)
+{
+    op.filtro = 0;
+    for (int i = desde; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hayValor = i + 1 < argc;
+
+        if (arg == "--filtro" && hayValor) {
+            if (!leerEntero(argv[++i], op.filtro)) return false;
+        } else if (arg == "--orientacion" && hayValor) {
+            const std::string nombre = argv[++i];
+            op.orientacion = OrientacionDesdeNombre(nombre);
+            if (nombre != NombreOrientacion(op.orientacion)) {
+                std::cerr << "[ERROR] Orientación desconocida: " << nombre << "\n";
+                return false;
+            }
+        } else if (arg == "--hilos" && hayValor) {
+            if (!leerEntero(argv[++i], op.hilosTotales)) return false;
+        } else if (arg == "--casos" && hayValor) {
+            if (!leerEntero(argv[++i], op.casosEnParalelo)) return false;
+        } else if (arg == "--precarga-mb" && hayValor) {
+            if (!leerEntero(argv[++i], op.mbPrecarga) || op.mbPrecarga < 0) return false;
+        } else if (arg == "--video") {
+            op.video = true;
+        } else if (arg == "--sin-estadisticas") {
+            op.estadisticas = false;
+        } else if (arg == "--3d") {
+            op.modo3D = true;
+        } else if (arg == "--radio" && hayValor) {
+            if (!leerEntero(argv[++i], op.radioFiltro)) return false;
+            if (op.radioFiltro < 1 || op.radioFiltro > kRadioFiltroMaximo) {
+                std::cerr << "[ERROR] --radio debe estar entre 1 y " << kRadioFiltroMaximo << ".\n";
+                return false;
+            }
+        } else if (arg == "--forzar") {
+            op.reanudar = false;
+        } else if (arg == "--resumen" && hayValor) {
+            rutaResumen = argv[++i];
+        } else {
+            std::cerr << "[ERROR] Opción desconocida o sin valor: " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (op.filtro < 1 || op.filtro > kNumFiltros) {
+        std::cerr << "[ERROR] Falta --filtro N (1–" << kNumFiltros << ").\n";
+        return false;
+    }
+    return true;
+}
+
+int ejecutarLote(int argc, char* argv[])
+{
+    using namespace std;
+    if (argc < 5) { mostrarUso(); return EXIT_FAILURE; }
+
+    const string dirImagenes   = argv[2];
+    const string dirMascaras   = argv[3];
+    const string carpetaSalida = argv[4];
+
+    OpcionesLote op;
+    string rutaResumen = carpetaSalida + "/" + kNombreResumenLote;
+    if (!leerOpciones(argc, argv, 5, op, rutaResumen)) { mostrarUso(); return EXIT_FAILURE; }
+
+    vector<CasoLote> casos = EmparejarCasos(dirImagenes, dirMascaras);
+    if (casos.empty()) {
+        cerr << "[ERROR] No se encontraron casos (imagen + máscara) en '" << dirImagenes
+             << "' y '" << dirMascaras << "'.\n";
+        return EXIT_FAILURE;
+    }
+
+    ResumenLote resumen = ProcesarLote(casos, carpetaSalida, op);
+    bool resumenOk = GuardarResumenLote(resumen, op, rutaResumen);
+
+    cout << "Lote terminado: " << resumen.casosOk << "/" << resumen.casos.size() << " casos ("
+         << resumen.casosReutilizados << " ya hechos), "
+         << resumen.slicesTotales << " slices en " << resumen.segundos << " s ("
+         << resumen.casosPorSegundo << " casos/s, " << resumen.slicesPorSegundo << " slices/s).\n";
+    cout << "Pico de memoria: " << DescribirMemoria(resumen.memoria, true) << ".\n";
+    if (resumenOk) cout << "Resumen en '" << rutaResumen << "'.\n";
+
+    return (resumen.casosFallidos == 0 && resumenOk) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int ejecutarCaso(int argc, char* argv[])
+{
+    using namespace std;
+    if (argc < 5) { mostrarUso(); return EXIT_FAILURE; }
+
+    const string rutaNifti         = argv[2];
+    const string rutaMask          = argv[3];
+    const string carpetaSalidaBase = string(argv[4]) + "/";
+
+    OpcionesLote op;
+    string rutaResumen;   // no se usa en un caso suelto
+    if (!leerOpciones(argc, argv, 5, op, rutaResumen)) { mostrarUso(); return EXIT_FAILURE; }
+
+    OpcionesProcesado opciones;
+    opciones.orientacion = op.orientacion;
+    opciones.numHilos    = op.hilosTotales;
+    opciones.recolectarEstadisticas = op.estadisticas;
+    opciones.modo3D      = op.modo3D;
+    opciones.radioFiltro = op.radioFiltro;
+    if (op.video) opciones.rutaVideo = carpetaSalidaBase + "video/highlighted_video.avi";
+
+    if (op.reanudar &&
+        ResultadosVigentes(rutaNifti, rutaMask, carpetaSalidaBase, op.filtro, opciones)) {
+        cout << "Los resultados de '" << carpetaSalidaBase << "' ya están al día (usa --forzar para reprocesar).\n";
+        return EXIT_SUCCESS;
+    }
+
+    cout << "Leyendo volúmenes y procesando todos los slices...\n";
+    if (!ProcesarTodosSlices(rutaNifti, rutaMask, carpetaSalidaBase, op.filtro, opciones)) {
+        cerr << "[ERROR] Falló el procesamiento de slices.\n";
+        return EXIT_FAILURE;
+    }
+
+    cout << "Proceso completado correctamente.\n";
+    return EXIT_SUCCESS;
+}
+
+int ejecutarVideo(int argc, char* argv[])
+{
+    using namespace std;
+    if (argc != 5) { mostrarUso(); return EXIT_FAILURE; }
+
+    const string carpetaSalidaBase  = string(argv[2]) + "/";
+    const string carpetaHighlighted = carpetaSalidaBase + "highlighted/";
+    const string carpetaVideo       = carpetaSalidaBase + "video/";
+
+    // ——— Número de slices según el manifiesto de la última ejecución ———
+    ManifiestoResultados manifiesto;
+    int N = 0;
+    if (LeerManifiesto(carpetaSalidaBase, manifiesto)) {
+        N = manifiesto.NumSlices();
+    }
+    if (N == 0) {
+        cerr << "[ERROR] No hay resultados procesados en '" << carpetaSalidaBase
+             << "' (falta " << kNombreManifiesto << ").\n";
+        return EXIT_FAILURE;
+    }
+
+    // ——— Índices de inicio y fin (1-based) ———
+    int inicio = 0, fin = 0;
+    if (!leerEntero(argv[3], inicio) || inicio < 1 || inicio > N) {
+        cerr << "[ERROR] Índice inicial inválido. Debe estar entre 1 y " << N << ".\n";
+        return EXIT_FAILURE;
+    }
+    if (!leerEntero(argv[4], fin) || fin < inicio || fin > N) {
+        cerr << "[ERROR] Índice final inválido. Debe estar entre " << inicio << " y " << N << ".\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!GenerarVideoHighlighted(carpetaHighlighted, carpetaVideo, inicio, fin)) {
+        cerr << "[ERROR] No se pudo generar el video. Verifica que existan archivos válidos en '"
+             << carpetaHighlighted << "'.\n";
+        return EXIT_FAILURE;
+    }
+
+    cout << "Video generado correctamente en '" << carpetaVideo << "'.\n";
+    return EXIT_SUCCESS;
+}
+
+int ejecutarEncolar(int argc, char* argv[])
+{
+    using namespace std;
+    if (argc < 6) { mostrarUso(); return EXIT_FAILURE; }
 
-    cout << "=== Aplicación de procesamiento de RM (NIfTI) ===\n\n";
+    const string dirImagenes   = argv[2];
+    const string dirMascaras   = argv[3];
+    const string carpetaSalida = argv[4];
+    const string dirCola       = argv[5];
 
-    // 1) Mostramos menú al usuario y leemos la opción
-    int opcion = mostrarMenu();
-    if (opcion < 1 || opcion > 11) {
-        cerr << "[ERROR] Opción inválida.\n";
+    OpcionesLote op;
+    string rutaResumen;   // no se usa al encolar
+    if (!leerOpciones(argc, argv, 6, op, rutaResumen)) { mostrarUso(); return EXIT_FAILURE; }
+
+    vector<CasoLote> casos = EmparejarCasos(dirImagenes, dirMascaras);
+    if (casos.empty()) {
+        cerr << "[ERROR] No se encontraron casos (imagen + máscara) en '" << dirImagenes
+             << "' y '" << dirMascaras << "'.\n";
         return EXIT_FAILURE;
     }
 
-    // 2) Rutas hardcodeadas (puedes cambiar según tus carpetas)
-    const string rutaNifti         = "/home/juanja/Desktop/vision/Task06_Lung/imagesTr/lung_001.nii.gz";
-    const string rutaMask          = "/home/juanja/Desktop/vision/Task06_Lung/labelsTr/lung_001.nii.gz";
-    const string carpetaSalidaBase = "Output/";
+    const int nuevas = EncolarCasos(casos, carpetaSalida, op, dirCola);
+    if (nuevas < 0) return EXIT_FAILURE;
+
+    cout << nuevas << " casos encolados en '" << dirCola << "' ("
+         << casos.size() - nuevas << " ya estaban en la cola).\n";
+    return EXIT_SUCCESS;
+}
+
+int ejecutarTrabajador(int argc, char* argv[])
+{
+    using namespace std;
+    if (argc < 3) { mostrarUso(); return EXIT_FAILURE; }
 
-    // 3) Si el usuario eligió la opción 11, generamos el video y salimos
-    if (opcion == 11)
+    const string dirCola = argv[2];
+    OpcionesTrabajador op;
+    for (int i = 3; i < argc; ++i)
     {
-        const string carpetaHighlighted = carpetaSalidaBase + "highlighted/";
-        const string carpetaVideo       = carpetaSalidaBase + "video/";
-
-        // ——— Contar cuántas imágenes hay en Output/highlighted/ ———
-        int N = 0;
-        if (fs::exists(carpetaHighlighted) && fs::is_directory(carpetaHighlighted)) {
-            for (auto const& entry : fs::directory_iterator(carpetaHighlighted)) {
-                if (!entry.is_regular_file()) continue;
-                string ext = entry.path().extension().string();
-                // Convertir ext a minúsculas
-                for (auto& c : ext) c = static_cast<char>(tolower(c));
-                if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" ||
-                    ext == ".bmp" || ext == ".tif" || ext == ".tiff")
-                {
-                    ++N;
-                }
-            }
-        }
+        const string arg = argv[i];
+        const bool hayValor = i + 1 < argc;
 
-        if (N == 0) {
-            cerr << "[ERROR] No se encontraron imágenes en '" << carpetaHighlighted << "'.\n";
+        if (arg == "--hilos" && hayValor) {
+            if (!leerEntero(argv[++i], op.numHilos)) { mostrarUso(); return EXIT_FAILURE; }
+        } else if (arg == "--lease-seg" && hayValor) {
+            if (!leerEntero(argv[++i], op.segundosLease) || op.segundosLease < 3) {
+                cerr << "[ERROR] --lease-seg debe ser un número de segundos (mínimo 3).\n";
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--sin-esperar") {
+            op.esperarEnCurso = false;
+        } else {
+            cerr << "[ERROR] Opción desconocida o sin valor: " << arg << "\n";
+            mostrarUso();
             return EXIT_FAILURE;
         }
+    }
 
-        // ——— Pedir al usuario los índices de inicio y fin ———
-        int inicio, fin;
-        cout << "Ingrese índice inicial (1–" << N << "): ";
-        cin >> inicio;
-        if (cin.fail() || inicio < 1 || inicio > N) {
-            cerr << "[ERROR] Índice inicial inválido. Debe estar entre 1 y " << N << ".\n";
-            return EXIT_FAILURE;
-        }
+    ResumenTrabajador resumen = EjecutarTrabajador(dirCola, op);
 
-        cout << "Ingrese índice final (" << inicio << "–" << N << "): ";
-        cin >> fin;
-        if (cin.fail() || fin < inicio || fin > N) {
-            cerr << "[ERROR] Índice final inválido. Debe estar entre " << inicio << " y " << N << ".\n";
-            return EXIT_FAILURE;
-        }
+    cout << "Trabajador terminado: " << resumen.procesados << " casos procesados, "
+         << resumen.reutilizados << " ya hechos, " << resumen.fallidos << " fallidos, "
+         << resumen.reclamados << " leases vencidos reclamados; "
+         << resumen.slices << " slices en " << resumen.segundos << " s.\n";
+
+    return resumen.fallidos == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int ejecutarServidor(int argc, char* argv[])
+{
+    using namespace std;
+    OpcionesServidor op;
+    for (int i = 2; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        const bool hayValor = i + 1 < argc;
+        bool ok = true;
+
+        if (arg == "--socket" && hayValor)             op.rutaSocket = argv[++i];
+        else if (arg == "--mb-volumenes" && hayValor)  ok = leerEntero(argv[++i], op.mbVolumenes) && op.mbVolumenes >= 0;
+        else if (arg == "--mb-frames" && hayValor)     ok = leerEntero(argv[++i], op.mbFrames) && op.mbFrames >= 0;
+        else if (arg == "--hilos" && hayValor)         ok = leerEntero(argv[++i], op.numHilos);
+        else ok = false;
 
-        // ——— Llamar a la función que genera el video con el rango [inicio, fin] ———
-        bool ok = GenerarVideoHighlighted(carpetaHighlighted, carpetaVideo, inicio, fin);
         if (!ok) {
-            cerr << "[ERROR] No se pudo generar el video. Verifica que existan archivos válidos en '"
-                 << carpetaHighlighted << "'.\n";
+            cerr << "[ERROR] Opción desconocida o valor inválido: " << arg << "\n";
+            mostrarUso();
             return EXIT_FAILURE;
         }
+    }
+    return EjecutarServidor(op) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-        cout << "Video generado correctamente en '" << carpetaVideo << "'.\n";
-        return EXIT_SUCCESS;
+int ejecutarConsulta(int argc, char* argv[])
+{
+    using namespace std;
+    string rutaSocket = kRutaSocketServidor;
+    int i = 2;
+    if (i + 1 < argc && string(argv[i]) == "--socket") {
+        rutaSocket = argv[i + 1];
+        i += 2;
     }
+    if (i >= argc) { mostrarUso(); return EXIT_FAILURE; }
 
-    // 4) Para opciones 1–10: procesamos todos los slices usando el filtro elegido
-    cout << "Leyendo volúmenes y procesando todos los slices...\n";
-    bool ok = ProcesarTodosSlices(rutaNifti, rutaMask, carpetaSalidaBase, opcion);
-    if (!ok) {
-        cerr << "[ERROR] Falló el procesamiento de slices.\n";
+    // Se reenvía tal cual; las rutas con espacios van entre comillas
+    string peticion;
+    for (; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        if (!peticion.empty()) peticion += " ";
+        peticion += (arg.find(' ') != string::npos) ? "\"" + arg + "\"" : arg;
+    }
+
+    string respuesta;
+    if (!ConsultarServidor(rutaSocket, peticion, respuesta)) {
+        cerr << "[ERROR] No se pudo contactar con el servidor en '" << rutaSocket << "'.\n";
         return EXIT_FAILURE;
     }
+    cout << respuesta << "\n";
+    return respuesta.rfind("OK", 0) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-    cout << "Proceso completado correctamente.\n";
-    return EXIT_SUCCESS;
+int ejecutarComando(int argc, char* argv[])
+{
+    const std::string comando = argv[1];
+    if (comando == "lote")  return ejecutarLote(argc, argv);
+    if (comando == "caso")  return ejecutarCaso(argc, argv);
+    if (comando == "video") return ejecutarVideo(argc, argv);
+    if (comando == "encolar")    return ejecutarEncolar(argc, argv);
+    if (comando == "trabajador") return ejecutarTrabajador(argc, argv);
+    if (comando == "servidor")   return ejecutarServidor(argc, argv);
+    if (comando == "consulta")   return ejecutarConsulta(argc, argv);
+
+    mostrarUso();
+    return EXIT_FAILURE;
 }
 
-// Muestra el menú y devuelve la opción elegida (1–11)
-int mostrarMenu()
+// Percentiles por tramo de la traza registrada
+void mostrarResumenTraza()
 {
     using namespace std;
-    cout << "Selecciona UN solo filtro a aplicar:\n";
-    cout << " 1) Thresholding\n";
-    cout << " 2) Contrast Stretching\n";
-    cout << " 3) Binarización por umbral de color\n";
-    cout << " 4) Operaciones lógicas (NOT, AND, OR, XOR)\n";
-    cout << " 5) Detección de Bordes\n";
-    cout << " 6) Manipulación de píxeles\n";
-    cout << " 7) Filtros de suavizado\n";
-    cout << " 8) Operaciones morfológicas\n";
-    cout << " 9) Segmentación Watershed\n";
-    cout << "10) Aplicar TODOS los filtros en secuencia\n";
-    cout << "11) Generar video con las imágenes en Output/highlighted/\n";
-    cout << "Opción (1–11): ";
-
-    int opc;
-    cin >> opc;
-    return opc;
+    const vector<ResumenTramo> resumen = ResumirTraza();
+    if (resumen.empty()) return;
+
+    cout << "\n" << left << setw(28) << "tramo" << right << setw(10) << "llamadas" << setw(12) << "total(ms)"
+         << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "max" << "\n";
+    for (const auto& r : resumen)
+    {
+        cout << left << setw(28) << r.nombre << right << setw(10) << r.llamadas
+             << fixed << setprecision(1) << setw(12) << r.msTotal << setprecision(3)
+             << setw(10) << r.p50 << setw(10) << r.p90 << setw(10) << r.p99 << setw(10) << r.max << "\n";
+    }
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+    if (const long long descartados = TramosDescartados())
+        cerr << "[WARNING] " << descartados << " tramos descartados (búfer de traza lleno): se conservan los últimos.\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        mostrarUso();
+        return EXIT_FAILURE;
+    }
+
+    // --traza ruta.json vale para cualquier comando: se quita de argv antes de despacharlo
+    std::string rutaTraza;
+    for (int i = 2; i + 1 < argc; ++i)
+    {
+        if (std::string(argv[i]) != "--traza") continue;
+        rutaTraza = argv[i + 1];
+        for (int j = i; j + 2 <= argc; ++j) argv[j] = argv[j + 2];
+        argc -= 2;
+        break;
+    }
+    if (!rutaTraza.empty()) IniciarTraza();
+
+    const int resultado = ejecutarComando(argc, argv);
+
+    if (!rutaTraza.empty())
+    {
+        DetenerTraza();
+        mostrarResumenTraza();
+        if (ExportarTrazaChrome(rutaTraza))
+            std::cout << "Traza en '" << rutaTraza << "' (chrome://tracing o ui.perfetto.dev).\n";
+    }
+    return resultado;
 }
@@ -0,0 +1,586 @@
+// Segmentacion3D.cpp
+#include "Segmentacion3D.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include "BloquesZ.h"             // para RecorrerBloquesZ y PlanosPorBloqueZ
+#include "Traza.h"
+
+// Distancia "infinita" de la transformada de distancia (al cuadrado, en mm²)
+static constexpr float kDistanciaInfinita = 1e20f;
+
+// Marcas del watershed, como en cv::watershed
+static constexpr int32_t kLineaDivisoria = -1;
+static constexpr int32_t kEnCola = -2;
+
+VolumenEtiquetas::VolumenEtiquetas(int nx, int ny, int nz, const double espaciado[3])
+    : nx(nx), ny(ny), nz(nz), datos(static_cast<size_t>(nx) * ny * nz)
+{
+    for (int d = 0; d < 3; ++d) this->espaciado[d] = espaciado[d];
+    memoria.Fijar(static_cast<long long>(datos.size() * sizeof(int32_t)));
+}
+
+// ----------------------------------------------------------
+// Estadísticas de las regiones
+// ----------------------------------------------------------
+
+// Suma de coordenadas y caja envolvente de una región, a medida que se le asignan vóxeles
+struct AcumuladorRegion
+{
+    uint64_t voxeles = 0;
+    uint64_t suma[3] = { 0, 0, 0 };
+    int minimo[3] = { INT_MAX, INT_MAX, INT_MAX };
+    int maximo[3] = { -1, -1, -1 };
+
+    void Anadir(int x, int y, int z)
+    {
+        const int c[3] = { x, y, z };
+        ++voxeles;
+        for (int d = 0; d < 3; ++d) {
+            suma[d] += static_cast<uint64_t>(c[d]);
+            minimo[d] = std::min(minimo[d], c[d]);
+            maximo[d] = std::max(maximo[d], c[d]);
+        }
+    }
+
+    void Unir(const AcumuladorRegion& otro)
+    {
+        voxeles += otro.voxeles;
+        for (int d = 0; d < 3; ++d) {
+            suma[d] += otro.suma[d];
+            minimo[d] = std::min(minimo[d], otro.minimo[d]);
+            maximo[d] = std::max(maximo[d], otro.maximo[d]);
+        }
+    }
+};
+
+// Estadísticas finales; acumulados[e − 1] es la región e
+static std::vector<ComponenteConexa> ResumirRegiones(const std::vector<AcumuladorRegion>& acumulados)
+{
+    std::vector<ComponenteConexa> regiones(acumulados.size());
+    for (size_t e = 0; e < acumulados.size(); ++e)
+    {
+        const AcumuladorRegion& a = acumulados[e];
+        ComponenteConexa& r = regiones[e];
+        r.etiqueta = static_cast<int>(e) + 1;
+        r.voxeles  = a.voxeles;
+        if (a.voxeles == 0) continue;
+        for (int d = 0; d < 3; ++d) {
+            r.centroide[d] = static_cast<double>(a.suma[d]) / static_cast<double>(a.voxeles);
+            r.minimo[d] = a.minimo[d];
+            r.maximo[d] = a.maximo[d];
+        }
+    }
+    return regiones;
+}
+
+// ----------------------------------------------------------
+// Componentes conexas
+// ----------------------------------------------------------
+
+// Vecinos (dx, dy, dz) que ya se han recorrido en orden x, y, z
+static std::vector<cv::Point3i> VecinosAnteriores(int conectividad)
+{
+    if (conectividad == 6) return { { -1, 0, 0 }, { 0, -1, 0 }, { 0, 0, -1 } };
+
+    std::vector<cv::Point3i> vecinos;
+    for (int dz = -1; dz <= 0; ++dz)
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dz == 0 && (dy > 0 || (dy == 0 && dx >= 0))) continue;
+                vecinos.emplace_back(dx, dy, dz);
+            }
+    return vecinos;     // 13
+}
+
+// Raíz de la clase de 'e', acortando el camino a la mitad
+static int32_t Raiz(std::vector<int32_t>& padre, int32_t e)
+{
+    while (padre[e] != e) {
+        padre[e] = padre[padre[e]];
+        e = padre[e];
+    }
+    return e;
+}
+
+// Une las clases de 'a' y 'b'. La raíz es siempre la menor: padre[e] <= e
+static int32_t UnirClases(std::vector<int32_t>& padre, int32_t a, int32_t b)
+{
+    a = Raiz(padre, a);
+    b = Raiz(padre, b);
+    if (a < b) { padre[b] = a; return a; }
+    padre[a] = b;
+    return b;
+}
+
+// Etiquetas provisionales de un bloque de planos: las locales van de 1 a padre.size() − 1
+// y en la tabla global ocupan [base + 1, base + padre.size() − 1]
+struct BloqueEtiquetas
+{
+    int32_t base = 0;
+    std::vector<int32_t> padre;
+    std::vector<AcumuladorRegion> acumulados;
+};
+
+VolumenEtiquetas ComponentesConexas3D(const Volumen8u& binaria, int conectividad,
+                                      std::vector<ComponenteConexa>* componentes)
+{
+    CV_Assert(conectividad == 6 || conectividad == 26);
+    const int nx = binaria.Nx(), ny = binaria.Ny(), nz = binaria.Nz();
+    VolumenEtiquetas etiquetas(nx, ny, nz, binaria.Espaciado());
+    if (componentes) componentes->clear();
+    if (binaria.Vacio()) return etiquetas;
+
+    TramoTraza tramo("componentesConexas3D");
+    const std::vector<cv::Point3i> vecinos = VecinosAnteriores(conectividad);
+    const int planosBloque = PlanosPorBloqueZ(nz);
+    std::vector<BloqueEtiquetas> bloques((nz + planosBloque - 1) / planosBloque);
+
+    // 1) Etiquetas provisionales y sus equivalencias dentro de cada bloque. Los vecinos
+    //    del plano anterior al bloque se dejan para el paso 2.
+    RecorrerBloquesZ(nz, "ccl3D_bloques", [&](int z0, int z1) {
+        BloqueEtiquetas& b = bloques[z0 / planosBloque];
+        b.padre.assign(1, 0);
+        for (int z = z0; z < z1; ++z)
+        {
+            const uchar* bin = binaria.Plano(z);
+            int32_t* lab = etiquetas.Plano(z);
+            for (int y = 0; y < ny; ++y)
+                for (int x = 0; x < nx; ++x)
+                {
+                    const size_t i = static_cast<size_t>(y) * nx + x;
+                    if (!bin[i]) continue;
+
+                    int32_t e = 0;
+                    for (const cv::Point3i& d : vecinos) {
+                        const int xx = x + d.x, yy = y + d.y, zz = z + d.z;
+                        if (xx < 0 || xx >= nx || yy < 0 || yy >= ny || zz < z0) continue;
+                        const int32_t n = etiquetas.Plano(zz)[static_cast<size_t>(yy) * nx + xx];
+                        if (n == 0 || n == e) continue;
+                        e = e ? UnirClases(b.padre, e, n) : n;
+                    }
+                    if (!e) {
+                        e = static_cast<int32_t>(b.padre.size());
+                        b.padre.push_back(e);
+                    }
+                    lab[i] = e;
+                }
+        }
+    });
+
+    // 2) Tabla global de equivalencias (bloques en orden) y uniones a través de cada frontera
+    int32_t total = 0;
+    for (BloqueEtiquetas& b : bloques) {
+        b.base = total;
+        total += static_cast<int32_t>(b.padre.size()) - 1;
+    }
+    std::vector<int32_t> padre(static_cast<size_t>(total) + 1, 0);
+    for (const BloqueEtiquetas& b : bloques)
+        for (size_t e = 1; e < b.padre.size(); ++e)
+            padre[b.base + e] = b.base + b.padre[e];
+
+    {
+        TramoTraza tramoFronteras("ccl3D_fronteras");
+        const int radio = (conectividad == 26) ? 1 : 0;
+        for (size_t k = 1; k < bloques.size(); ++k)
+        {
+            const int z = static_cast<int>(k) * planosBloque;
+            const int32_t* actual   = etiquetas.Plano(z);
+            const int32_t* anterior = etiquetas.Plano(z - 1);
+            const int32_t baseActual = bloques[k].base, baseAnterior = bloques[k - 1].base;
+            for (int y = 0; y < ny; ++y)
+                for (int x = 0; x < nx; ++x)
+                {
+                    const int32_t e = actual[static_cast<size_t>(y) * nx + x];
+                    if (!e) continue;
+                    for (int yy = std::max(0, y - radio); yy <= std::min(ny - 1, y + radio); ++yy)
+                        for (int xx = std::max(0, x - radio); xx <= std::min(nx - 1, x + radio); ++xx) {
+                            const int32_t n = anterior[static_cast<size_t>(yy) * nx + xx];
+                            if (n) UnirClases(padre, baseActual + e, baseAnterior + n);
+                        }
+                }
+        }
+    }
+
+    // 3) Aplanar: como padre[e] <= e, al llegar a e su padre ya tiene la etiqueta final.
+    //    Cada raíz es la provisional del primer vóxel de su componente en orden x, y, z.
+    int32_t numEtiquetas = 0;
+    for (int32_t e = 1; e <= total; ++e)
+        padre[e] = (padre[e] == e) ? ++numEtiquetas : padre[padre[e]];
+    etiquetas.FijarNumEtiquetas(numEtiquetas);
+
+    // 4) Etiqueta final de cada vóxel y estadísticas por etiqueta provisional del bloque
+    RecorrerBloquesZ(nz, "ccl3D_etiquetar", [&](int z0, int z1) {
+        BloqueEtiquetas& b = bloques[z0 / planosBloque];
+        if (componentes) b.acumulados.assign(b.padre.size(), AcumuladorRegion());
+        const int32_t* final = padre.data() + b.base;
+        for (int z = z0; z < z1; ++z)
+        {
+            int32_t* lab = etiquetas.Plano(z);
+            for (int y = 0; y < ny; ++y)
+                for (int x = 0; x < nx; ++x)
+                {
+                    int32_t& e = lab[static_cast<size_t>(y) * nx + x];
+                    if (!e) continue;
+                    if (componentes) b.acumulados[e].Anadir(x, y, z);
+                    e = final[e];
+                }
+        }
+    });
+
+    if (componentes)
+    {
+        std::vector<AcumuladorRegion> acumulados(numEtiquetas);
+        for (const BloqueEtiquetas& b : bloques)
+            for (size_t e = 1; e < b.acumulados.size(); ++e)
+                acumulados[padre[b.base + e] - 1].Unir(b.acumulados[e]);
+        *componentes = ResumirRegiones(acumulados);
+    }
+    return etiquetas;
+}
+
+// ----------------------------------------------------------
+// Watershed
+// ----------------------------------------------------------
+
+void Watershed3D(const Volumen8u& imagen, VolumenEtiquetas& marcadores, std::vector<ComponenteConexa>* regiones)
+{
+    CV_Assert(imagen.Nx() == marcadores.Nx() && imagen.Ny() == marcadores.Ny() && imagen.Nz() == marcadores.Nz());
+    const int nx = imagen.Nx(), ny = imagen.Ny(), nz = imagen.Nz();
+    const size_t voxelesPlano = imagen.VoxelesPlano();
+    if (regiones) regiones->clear();
+    if (imagen.Vacio()) return;
+
+    TramoTraza tramo("watershed3D");
+    const uchar* img = imagen.Datos();
+    int32_t* m = marcadores.Plano(0);
+    const ptrdiff_t desplazamiento[6] = { -1, 1, -static_cast<ptrdiff_t>(nx), nx,
+                                          -static_cast<ptrdiff_t>(voxelesPlano),
+                                          static_cast<ptrdiff_t>(voxelesPlano) };
+    // ¿Está dentro del volumen el vecino k de (x, y, z)?
+    auto dentro = [&](int k, int x, int y, int z) {
+        switch (k) {
+            case 0:  return x > 0;
+            case 1:  return x < nx - 1;
+            case 2:  return y > 0;
+            case 3:  return y < ny - 1;
+            case 4:  return z > 0;
+            default: return z < nz - 1;
+        }
+    };
+
+    std::vector<std::deque<size_t>> colas(256);
+    std::vector<AcumuladorRegion> acumulados;
+    int32_t maxEtiqueta = 0;
+    auto acumular = [&](int32_t e, int x, int y, int z) {
+        if (!regiones) return;
+        if (static_cast<size_t>(e) > acumulados.size()) acumulados.resize(e);
+        acumulados[e - 1].Anadir(x, y, z);
+    };
+
+    // 1) Los vóxeles por decidir junto a un marcador entran en la cola con la menor
+    //    diferencia de intensidad con sus vecinos marcados
+    int nivel = 256;
+    size_t i = 0;
+    for (int z = 0; z < nz; ++z)
+        for (int y = 0; y < ny; ++y)
+            for (int x = 0; x < nx; ++x, ++i)
+            {
+                if (m[i] < 0) m[i] = 0;
+                if (m[i] > 0) {
+                    maxEtiqueta = std::max(maxEtiqueta, m[i]);
+                    acumular(m[i], x, y, z);
+                    continue;
+                }
+                int prioridad = 256;
+                for (int k = 0; k < 6; ++k) {
+                    if (!dentro(k, x, y, z)) continue;
+                    const size_t j = i + desplazamiento[k];
+                    if (m[j] > 0) prioridad = std::min(prioridad, std::abs(img[i] - img[j]));
+                }
+                if (prioridad < 256) {
+                    colas[prioridad].push_back(i);
+                    m[i] = kEnCola;
+                    nivel = std::min(nivel, prioridad);
+                }
+            }
+
+    // 2) Inundación: cada vóxel que sale de la cola toma la etiqueta de sus vecinos
+    //    marcados (o −1 si hay dos distintas) y mete en la cola a sus vecinos por decidir
+    for (;;)
+    {
+        while (nivel < 256 && colas[nivel].empty()) ++nivel;
+        if (nivel == 256) break;
+        const size_t v = colas[nivel].front();
+        colas[nivel].pop_front();
+
+        const int z = static_cast<int>(v / voxelesPlano);
+        const int y = static_cast<int>((v % voxelesPlano) / nx);
+        const int x = static_cast<int>(v % nx);
+
+        int32_t etiqueta = 0;
+        for (int k = 0; k < 6; ++k) {
+            if (!dentro(k, x, y, z)) continue;
+            const int32_t n = m[v + desplazamiento[k]];
+            if (n <= 0) continue;
+            if (etiqueta == 0) etiqueta = n;
+            else if (n != etiqueta) etiqueta = kLineaDivisoria;
+        }
+        m[v] = etiqueta;
+        if (etiqueta == kLineaDivisoria) continue;
+        acumular(etiqueta, x, y, z);
+
+        for (int k = 0; k < 6; ++k) {
+            if (!dentro(k, x, y, z)) continue;
+            const size_t j = v + desplazamiento[k];
+            if (m[j] != 0) continue;
+            const int t = std::abs(img[v] - img[j]);
+            colas[t].push_back(j);
+            m[j] = kEnCola;
+            nivel = std::min(nivel, t);
+        }
+    }
+
+    marcadores.FijarNumEtiquetas(maxEtiqueta);
+    if (regiones) {
+        acumulados.resize(maxEtiqueta);
+        *regiones = ResumirRegiones(acumulados);
+    }
+}
+
+// ----------------------------------------------------------
+// Segmentación completa (filtro 9 en 3D)
+// ----------------------------------------------------------
+
+// Transformada de distancia euclídea exacta al cuadrado de una línea de n muestras
+// (Felzenszwalb y Huttenlocher): d[q] = min_p (paso2·(q − p)² + f[p]).
+// 'v' (n) y 's' (n + 1) son de trabajo: las parábolas de la envolvente y sus cortes.
+static void DistanciaCuadrada1D(const float* f, float* d, int n, double paso2, int* v, double* s)
+{
+    int k = 0;
+    v[0] = 0;
+    s[0] = -std::numeric_limits<double>::infinity();
+    s[1] = std::numeric_limits<double>::infinity();
+    for (int q = 1; q < n; ++q)
+    {
+        double corte;
+        for (;;) {
+            const int p = v[k];
+            corte = ((f[q] + paso2 * q * q) - (f[p] + paso2 * p * p)) / (2.0 * paso2 * (q - p));
+            if (corte > s[k]) break;
+            --k;
+        }
+        ++k;
+        v[k] = q;
+        s[k] = corte;
+        s[k + 1] = std::numeric_limits<double>::infinity();
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (s[k + 1] < q) ++k;
+        const double dq = q - v[k];
+        d[q] = static_cast<float>(paso2 * dq * dq + f[v[k]]);
+    }
+}
+
+// Distancia euclídea en mm de cada vóxel de objeto (≠0) al vóxel de fondo más cercano,
+// separable: x e y por bloques de planos, z por filas y con las columnas de cada fila juntas
+static std::vector<float> TransformadaDistancia3D(const Volumen8u& objeto)
+{
+    const int nx = objeto.Nx(), ny = objeto.Ny(), nz = objeto.Nz();
+    const size_t voxelesPlano = objeto.VoxelesPlano();
+    double paso2[3];
+    for (int d = 0; d < 3; ++d) {
+        const double s = objeto.Espaciado()[d];
+        paso2[d] = (s > 0) ? s * s : 1.0;
+    }
+    std::vector<float> dist(voxelesPlano * nz);
+
+    RecorrerBloquesZ(nz, "distancia3D_xy", [&](int z0, int z1) {
+        const int n = std::max(nx, ny);
+        std::vector<float> f(n), d(n);
+        std::vector<int> v(n);
+        std::vector<double> s(n + 1);
+        for (int z = z0; z < z1; ++z)
+        {
+            const uchar* o = objeto.Plano(z);
+            float* plano = dist.data() + z * voxelesPlano;
+            for (int y = 0; y < ny; ++y) {
+                for (int x = 0; x < nx; ++x) f[x] = o[static_cast<size_t>(y) * nx + x] ? kDistanciaInfinita : 0.0f;
+                DistanciaCuadrada1D(f.data(), plano + static_cast<size_t>(y) * nx, nx, paso2[0], v.data(), s.data());
+            }
+            for (int x = 0; x < nx; ++x) {
+                for (int y = 0; y < ny; ++y) f[y] = plano[static_cast<size_t>(y) * nx + x];
+                DistanciaCuadrada1D(f.data(), d.data(), ny, paso2[1], v.data(), s.data());
+                for (int y = 0; y < ny; ++y) plano[static_cast<size_t>(y) * nx + x] = d[y];
+            }
+        }
+    });
+
+    cv::parallel_for_(cv::Range(0, ny), [&](const cv::Range& r) {
+        TramoTraza tramoZ("distancia3D_z", r.start);
+        std::vector<float> columnas(static_cast<size_t>(nx) * nz), d(nz);
+        std::vector<int> v(nz);
+        std::vector<double> s(nz + 1);
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const size_t fila = static_cast<size_t>(y) * nx;
+            for (int z = 0; z < nz; ++z)
+                for (int x = 0; x < nx; ++x) columnas[static_cast<size_t>(x) * nz + z] = dist[z * voxelesPlano + fila + x];
+            for (int x = 0; x < nx; ++x) {
+                DistanciaCuadrada1D(&columnas[static_cast<size_t>(x) * nz], d.data(), nz, paso2[2], v.data(), s.data());
+                for (int z = 0; z < nz; ++z) dist[z * voxelesPlano + fila + x] = std::sqrt(d[z]);
+            }
+        }
+    });
+    return dist;
+}
+
+VolumenEtiquetas SegmentarWatershed3D(const Volumen8u& vol, std::vector<ComponenteConexa>* regiones)
+{
+    if (regiones) regiones->clear();
+    if (vol.Vacio()) return VolumenEtiquetas();
+
+    TramoTraza tramo("segmentarWatershed3D");
+    const int nx = vol.Nx(), ny = vol.Ny(), nz = vol.Nz();
+    const size_t voxelesPlano = vol.VoxelesPlano();
+
+    // 1-2) Suavizado y Otsu con el histograma de todo el volumen (un umbral para todos los slices)
+    Volumen8u binaria(nx, ny, nz, vol.Espaciado());
+    {
+        const Volumen8u suave = SuavizarGaussiano3D(vol);
+        const cv::Mat entrada(nz, static_cast<int>(voxelesPlano), CV_8U, const_cast<uchar*>(suave.Datos()));
+        cv::Mat salida(nz, static_cast<int>(voxelesPlano), CV_8U, binaria.Plano(0));
+        cv::threshold(entrada, salida, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    }
+
+    // 3) Apertura: las 2 iteraciones con la caja 3x3 del 2D son una caja de radio 2
+    const int ry2 = RadioEquivalente(vol, 1, 2), rz2 = RadioEquivalente(vol, 2, 2);
+    Volumen8u apertura = MorfologiaCaja3D(MorfologiaCaja3D(binaria, true, 2, ry2, rz2), false, 2, ry2, rz2);
+    binaria = Volumen8u();
+
+    // 4) Fondo seguro: dilatación de radio 3
+    const Volumen8u fondoSeguro = MorfologiaCaja3D(apertura, false, 3, RadioEquivalente(vol, 1, 3),
+                                                   RadioEquivalente(vol, 2, 3));
+
+    // 5) Primer plano seguro: a más de la mitad de la distancia máxima al fondo
+    Volumen8u primerPlano(nx, ny, nz, vol.Espaciado());
+    {
+        const std::vector<float> dist = TransformadaDistancia3D(apertura);
+        apertura = Volumen8u();
+        const float umbral = 0.5f * *std::max_element(dist.begin(), dist.end());
+        uchar* pp = primerPlano.Plano(0);
+        RecorrerBloquesZ(nz, "primerPlano3D", [&](int z0, int z1) {
+            for (size_t i = z0 * voxelesPlano; i < z1 * voxelesPlano; ++i)
+                pp[i] = (dist[i] > umbral) ? 255 : 0;
+        });
+    }
+
+    // 6) Marcadores: componentes del primer plano + 1 (el fondo es la región 1) y 0 en
+    //    la zona por decidir (fondo seguro sin primer plano seguro)
+    VolumenEtiquetas marcadores = ComponentesConexas3D(primerPlano, 26);
+    {
+        const uchar* fondo = fondoSeguro.Datos();
+        const uchar* pp = primerPlano.Plano(0);
+        int32_t* m = marcadores.Plano(0);
+        RecorrerBloquesZ(nz, "marcadores3D", [&](int z0, int z1) {
+            for (size_t i = z0 * voxelesPlano; i < z1 * voxelesPlano; ++i)
+                m[i] = (fondo[i] && !pp[i]) ? 0 : m[i] + 1;
+        });
+    }
+    // 7) Watershed sobre el volumen sin suavizar, como el 2D sobre el slice
+    Watershed3D(vol, marcadores, regiones);
+    return marcadores;
+}
+
+// ----------------------------------------------------------
+// Salida
+// ----------------------------------------------------------
+
+cv::Vec3b ColorEtiqueta(int etiqueta)
+{
+    // Mezcla de enteros (hash): colores sin relación entre etiquetas consecutivas,
+    // con cada canal en [64, 255] para no confundirlos con el negro de las líneas
+    uint32_t h = static_cast<uint32_t>(etiqueta) * 0x9E3779B1u;
+    h ^= h >> 16;
+    h *= 0x45D9F3Bu;
+    h ^= h >> 16;
+    return cv::Vec3b(static_cast<uchar>(64 + (h & 0xBF)),
+                     static_cast<uchar>(64 + ((h >> 8) & 0xBF)),
+                     static_cast<uchar>(64 + ((h >> 16) & 0xBF)));
+}
+
+cv::Mat ColorearEtiquetas(const cv::Mat& etiquetas)
+{
+    CV_Assert(etiquetas.type() == CV_32S);
+    cv::Mat salida(etiquetas.size(), CV_8UC3);
+    for (int y = 0; y < etiquetas.rows; ++y)
+    {
+        const int32_t* e = etiquetas.ptr<int32_t>(y);
+        cv::Vec3b* out = salida.ptr<cv::Vec3b>(y);
+        int32_t anterior = 0;
+        cv::Vec3b color(0, 0, 0);
+        for (int x = 0; x < etiquetas.cols; ++x) {
+            if (e[x] != anterior) {
+                anterior = e[x];
+                color = (anterior > 0) ? ColorEtiqueta(anterior) : cv::Vec3b(0, 0, 0);
+            }
+            out[x] = color;
+        }
+    }
+    return salida;
+}
+
+bool GuardarComponentesCsv(const std::vector<ComponenteConexa>& componentes, const double espaciado[3],
+                           const std::string& ruta)
+{
+    namespace fs = std::filesystem;
+    const fs::path rutaFinal{ ruta };
+    const fs::path rutaTmp = rutaFinal.string() + ".tmp";
+
+    {
+        std::ofstream out(rutaTmp);
+        if (!out) {
+            std::cerr << "[ERROR] No se pudo escribir '" << rutaTmp.string() << "'.\n";
+            return false;
+        }
+
+        out << "etiqueta,voxeles,volumen_mm3,centroide_x_mm,centroide_y_mm,centroide_z_mm,"
+               "min_x,min_y,min_z,max_x,max_y,max_z\n";
+
+        const double volumenVoxel = espaciado[0] * espaciado[1] * espaciado[2];
+        char buf[256];
+        for (const auto& c : componentes)
+        {
+            if (c.voxeles == 0) continue;
+            std::snprintf(buf, sizeof(buf), "%d,%llu,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%d,%d,%d\n",
+                          c.etiqueta, static_cast<unsigned long long>(c.voxeles),
+                          static_cast<double>(c.voxeles) * volumenVoxel,
+                          c.centroide[0] * espaciado[0], c.centroide[1] * espaciado[1],
+                          c.centroide[2] * espaciado[2],
+                          c.minimo[0], c.minimo[1], c.minimo[2], c.maximo[0], c.maximo[1], c.maximo[2]);
+            out << buf;
+        }
+        if (!out) {
+            std::cerr << "[ERROR] Falló la escritura de '" << rutaTmp.string() << "'.\n";
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(rutaTmp, rutaFinal, ec);
+    if (ec) {
+        std::cerr << "[ERROR] No se pudo renombrar '" << rutaTmp.string() << "': " << ec.message() << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+// Segmentacion3D.h
+#ifndef SEGMENTACION3D_H
+#define SEGMENTACION3D_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "Filtros3D.h"            // para Volumen8u
+#include "Memoria.h"              // para MemoriaContada
+
+// CSV con las regiones del watershed 3D, en la carpeta base (ver Manifiesto::archivoComponentes)
+constexpr const char* kNombreComponentes3D = "componentes3d.csv";
+
+/**
+ * Volumen de etiquetas int32 con el layout de Volumen8u. Como en cv::watershed,
+ * 0 es "sin etiqueta" y −1 la línea divisoria entre regiones.
+ */
+class VolumenEtiquetas
+{
+public:
+    VolumenEtiquetas() = default;
+    VolumenEtiquetas(int nx, int ny, int nz, const double espaciado[3]);     // todo a 0
+
+    int Nx() const { return nx; }
+    int Ny() const { return ny; }
+    int Nz() const { return nz; }
+    const double* Espaciado() const { return espaciado; }
+    bool Vacio() const { return datos.empty(); }
+    size_t VoxelesPlano() const { return static_cast<size_t>(nx) * ny; }
+
+    // Etiquetas en uso: 1..NumEtiquetas()
+    int NumEtiquetas() const { return numEtiquetas; }
+    void FijarNumEtiquetas(int n) { numEtiquetas = n; }
+
+    const int32_t* Datos() const { return datos.data(); }
+    int32_t* Plano(int z) { return datos.data() + z * VoxelesPlano(); }
+    const int32_t* Plano(int z) const { return datos.data() + z * VoxelesPlano(); }
+
+    // Plano axial z como cv::Mat CV_32SC1 que comparte memoria con el volumen
+    cv::Mat PlanoAxial(int z) { return cv::Mat(ny, nx, CV_32S, Plano(z)); }
+
+private:
+    int nx = 0, ny = 0, nz = 0;
+    double espaciado[3] = { 1.0, 1.0, 1.0 };
+    int numEtiquetas = 0;
+    std::vector<int32_t> datos;
+    MemoriaContada memoria{ CategoriaMemoria::Volumenes };
+};
+
+/**
+ * Estadísticas de una componente o región, acumuladas en la misma pasada que la etiqueta.
+ */
+struct ComponenteConexa
+{
+    int etiqueta = 0;
+    uint64_t voxeles = 0;
+    double centroide[3] = { 0.0, 0.0, 0.0 };   // en vóxeles (x, y, z)
+    int minimo[3] = { 0, 0, 0 };               // caja envolvente, inclusiva, en vóxeles
+    int maximo[3] = { 0, 0, 0 };
+};
+
+/**
+ * Componentes conexas 3D de un volumen binario (distinto de 0 es objeto) con union-find
+ * por bloques de planos:
+ *  1) cada bloque (en paralelo) etiqueta sus vóxeles con etiquetas provisionales y une
+ *     las que se tocan dentro del bloque;
+ *  2) se unen las etiquetas a un lado y otro de cada frontera entre bloques (un plano
+ *     por frontera, secuencial);
+ *  3) la tabla de equivalencias se aplana en una pasada y cada bloque (en paralelo)
+ *     reescribe sus vóxeles con la etiqueta final y acumula las estadísticas.
+ * Las etiquetas (1..N) siguen el orden x, y, z del primer vóxel de cada componente:
+ * no dependen del número de hilos.
+ *
+ * @param conectividad 6 (caras) o 26 (caras, aristas y vértices; la 8 del 2D).
+ * @param componentes  Si no es nulo, recibe las estadísticas (índice = etiqueta − 1).
+ */
+VolumenEtiquetas ComponentesConexas3D(const Volumen8u& binaria, int conectividad = 26,
+                                      std::vector<ComponenteConexa>* componentes = nullptr);
+
+/**
+ * Watershed 3D por marcadores, como cv::watershed: en 'marcadores', >0 es marcador y 0
+ * por decidir. Inunda desde los marcadores con vecindad 6 y una cola de 256 niveles (la
+ * diferencia de intensidad con el vóxel desde el que se llega); los vóxeles en los que
+ * se tocan dos regiones quedan a −1. La inundación es secuencial.
+ *
+ * @param regiones Si no es nulo, estadísticas de cada región (índice = etiqueta − 1),
+ *                 acumuladas al asignar cada vóxel.
+ */
+void Watershed3D(const Volumen8u& imagen, VolumenEtiquetas& marcadores,
+                 std::vector<ComponenteConexa>* regiones = nullptr);
+
+/**
+ * Versión volumétrica del filtro 9 (aplicarOtraTecnica): suavizado, Otsu sobre todo el
+ * volumen, apertura, fondo seguro, primer plano seguro con la transformada de distancia
+ * euclídea 3D (en mm), marcadores con ComponentesConexas3D y Watershed3D. Una estructura
+ * que cruza slices lleva la misma etiqueta en todos ellos; la región 1 es el fondo.
+ */
+VolumenEtiquetas SegmentarWatershed3D(const Volumen8u& vol, std::vector<ComponenteConexa>* regiones = nullptr);
+
+/**
+ * Color fijo de una etiqueta (>0): el mismo en todos los slices y frames del video.
+ */
+cv::Vec3b ColorEtiqueta(int etiqueta);
+
+/**
+ * Plano de etiquetas CV_32S coloreado con ColorEtiqueta; 0 y −1 en negro, como el filtro 9.
+ */
+cv::Mat ColorearEtiquetas(const cv::Mat& etiquetas);
+
+/**
+ * Escribe las regiones como CSV (etiqueta, vóxeles, volumen en mm³, centroide en mm y
+ * caja envolvente en vóxeles) en un temporal que después se renombra a 'ruta'.
+ */
+bool GuardarComponentesCsv(const std::vector<ComponenteConexa>& componentes, const double espaciado[3],
+                           const std::string& ruta);
+
+#endif // SEGMENTACION3D_H
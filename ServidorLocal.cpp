@@ -0,0 +1,648 @@
+// ServidorLocal.cpp
+#include "ServidorLocal.h"
+#include "Utils.h"                // para LeerVolumenNiftiNativo, ProcesarTodosSlices y ProcesarPlanoVolumen
+#include "CacheResultados.h"     // para ResultadosVigentes
+#include "Memoria.h"              // para MemoriaContada y LeerMemoria
+#include <sys/mman.h>             // para shm_open y mmap
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Reloj = std::chrono::steady_clock;
+
+double MsDesde(Reloj::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Reloj::now() - t0).count();
+}
+
+/**
+ * Caché LRU con límite de memoria. Cada entrada declara sus bytes; al insertar
+ * se descartan las menos usadas hasta volver al límite (la recién insertada
+ * siempre se queda). Los valores son shared_ptr: una entrada descartada sigue
+ * viva mientras alguna petición la esté usando.
+ * No es thread-safe: la protege el mutex del servidor.
+ */
+template <typename Valor>
+class CacheLru
+{
+public:
+    explicit CacheLru(long long limiteBytes) : limite(limiteBytes) {}
+
+    std::shared_ptr<Valor> Buscar(const std::string& clave)
+    {
+        auto it = indice.find(clave);
+        if (it == indice.end()) {
+            ++fallos;
+            return nullptr;
+        }
+        orden.splice(orden.begin(), orden, it->second);   // pasa a ser la más reciente
+        ++aciertos;
+        return it->second->valor;
+    }
+
+    void Insertar(const std::string& clave, std::shared_ptr<Valor> valor, long long bytes)
+    {
+        Quitar(clave);
+        orden.push_front({ clave, std::move(valor), bytes });
+        indice[clave] = orden.begin();
+        bytesUsados += bytes;
+
+        while (bytesUsados > limite && orden.size() > 1) {
+            ++descartes;
+            Quitar(orden.back().clave);
+        }
+    }
+
+    void Quitar(const std::string& clave)
+    {
+        auto it = indice.find(clave);
+        if (it == indice.end()) return;
+        bytesUsados -= it->second->bytes;
+        orden.erase(it->second);
+        indice.erase(it);
+    }
+
+    void Vaciar()
+    {
+        orden.clear();
+        indice.clear();
+        bytesUsados = 0;
+    }
+
+    std::string Json() const
+    {
+        std::ostringstream out;
+        out << "{\"entradas\":" << orden.size()
+            << ",\"mb\":" << bytesUsados / (1024.0 * 1024.0)
+            << ",\"mbLimite\":" << limite / (1024.0 * 1024.0)
+            << ",\"aciertos\":" << aciertos
+            << ",\"fallos\":" << fallos
+            << ",\"descartes\":" << descartes << "}";
+        return out.str();
+    }
+
+private:
+    struct Entrada
+    {
+        std::string clave;
+        std::shared_ptr<Valor> valor;
+        long long bytes;
+    };
+
+    std::list<Entrada> orden;                    // de la más reciente a la más antigua
+    std::unordered_map<std::string, typename std::list<Entrada>::iterator> indice;
+    long long limite;
+    long long bytesUsados = 0;
+    long long aciertos = 0, fallos = 0, descartes = 0;
+};
+
+/**
+ * Slice highlighted en un segmento de memoria compartida POSIX. El servidor no
+ * lo mantiene mapeado: el segmento vive hasta que se destruye la entrada
+ * (shm_unlink), y los clientes que ya lo mapearon conservan sus páginas.
+ */
+class FrameCompartido
+{
+public:
+    static std::shared_ptr<FrameCompartido> Crear(const cv::Mat& bgr, const std::string& nombre)
+    {
+        if (bgr.empty() || bgr.depth() != CV_8U) return nullptr;
+
+        const size_t bytesFila = static_cast<size_t>(bgr.cols) * bgr.elemSize();
+        const size_t bytes     = bytesFila * bgr.rows;
+
+        const int fd = shm_open(nombre.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            std::cerr << "[ERROR] shm_open '" << nombre << "': " << std::strerror(errno) << "\n";
+            return nullptr;
+        }
+        void* datos = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(bytes)) == 0)
+            datos = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (datos == MAP_FAILED) {
+            std::cerr << "[ERROR] Reservando " << bytes << " bytes en '" << nombre << "': "
+                      << std::strerror(errno) << "\n";
+            shm_unlink(nombre.c_str());
+            return nullptr;
+        }
+
+        // Filas contiguas, sin relleno
+        for (int y = 0; y < bgr.rows; ++y)
+            std::memcpy(static_cast<uchar*>(datos) + y * bytesFila, bgr.ptr(y), bytesFila);
+        munmap(datos, bytes);
+
+        auto frame = std::shared_ptr<FrameCompartido>(new FrameCompartido());
+        frame->nombre  = nombre;
+        frame->ancho   = bgr.cols;
+        frame->alto    = bgr.rows;
+        frame->canales = bgr.channels();
+        frame->bytes   = bytes;
+        frame->memoria.Fijar(static_cast<long long>(bytes));
+        return frame;
+    }
+
+    ~FrameCompartido() { shm_unlink(nombre.c_str()); }
+
+    std::string Respuesta() const
+    {
+        std::ostringstream out;
+        out << nombre << " " << ancho << " " << alto << " " << canales << " " << bytes;
+        return out.str();
+    }
+
+    std::string nombre;
+    int ancho = 0, alto = 0, canales = 0;
+    size_t bytes = 0;
+
+private:
+    FrameCompartido() = default;
+    MemoriaContada memoria{ CategoriaMemoria::Frames };   // el segmento, mientras esté en la caché
+};
+
+// Prefijo de los segmentos de este proceso: "/rmproc.<pid>.<n>"
+std::string PrefijoShm(pid_t pid) { return "/rmproc." + std::to_string(pid) + "."; }
+
+// Borra los segmentos que dejó un servidor anterior que no terminó bien (Linux: /dev/shm)
+void LimpiarSegmentosHuerfanos()
+{
+    std::error_code ec;
+    for (const auto& entrada : fs::directory_iterator("/dev/shm", ec))
+    {
+        const std::string nombre = entrada.path().filename().string();
+        if (nombre.rfind("rmproc.", 0) != 0) continue;
+        const size_t fin = nombre.find('.', 7);
+        if (fin == std::string::npos) continue;
+
+        const pid_t pid = static_cast<pid_t>(std::atol(nombre.substr(7, fin - 7).c_str()));
+        if (pid > 0 && kill(pid, 0) != 0 && errno == ESRCH)
+            shm_unlink(("/" + nombre).c_str());
+    }
+}
+
+// Identifica el contenido de un archivo sin leerlo: ruta absoluta + tamaño + fecha
+bool ClaveArchivo(const std::string& ruta, std::string& clave)
+{
+    std::error_code ec;
+    const auto tam = fs::file_size(ruta, ec);
+    if (ec) return false;
+    const auto mtime = fs::last_write_time(ruta, ec);
+    if (ec) return false;
+    clave = fs::absolute(ruta, ec).string() + "|" + std::to_string(tam) + "|"
+          + std::to_string(static_cast<long long>(mtime.time_since_epoch().count()));
+    return true;
+}
+
+// Separa una línea en argumentos (espacios; "entre comillas" para rutas con espacios)
+std::vector<std::string> Separar(const std::string& linea)
+{
+    std::vector<std::string> args;
+    std::string actual;
+    bool enComillas = false, hayArg = false;
+    for (char c : linea)
+    {
+        if (c == '"') {
+            enComillas = !enComillas;
+            hayArg = true;
+        } else if (!enComillas && (c == ' ' || c == '\t' || c == '\r')) {
+            if (hayArg) args.push_back(actual);
+            actual.clear();
+            hayArg = false;
+        } else {
+            actual += c;
+            hayArg = true;
+        }
+    }
+    if (hayArg) args.push_back(actual);
+    return args;
+}
+
+bool LeerEntero(const std::string& texto, int& valor)
+{
+    try {
+        size_t usados = 0;
+        valor = std::stoi(texto, &usados);
+        return usados == texto.size();
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+std::string ErrorFiltroInvalido()
+{
+    return "ERROR filtro inválido (1–" + std::to_string(kNumFiltros) + ")";
+}
+
+bool LeerOrientacion(const std::string& texto, Orientacion& orientacion)
+{
+    orientacion = OrientacionDesdeNombre(texto);
+    return texto == NombreOrientacion(orientacion);
+}
+
+bool EnviarLinea(int fd, const std::string& linea)
+{
+    const std::string datos = linea + "\n";
+    size_t enviados = 0;
+    while (enviados < datos.size())
+    {
+        const ssize_t n = send(fd, datos.data() + enviados, datos.size() - enviados, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        enviados += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Lee hasta el siguiente '\n' (sin incluirlo); 'pendiente' guarda lo que sobra
+bool RecibirLinea(int fd, std::string& pendiente, std::string& linea)
+{
+    char buffer[4096];
+    while (true)
+    {
+        const size_t pos = pendiente.find('\n');
+        if (pos != std::string::npos) {
+            linea = pendiente.substr(0, pos);
+            pendiente.erase(0, pos + 1);
+            return true;
+        }
+        const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        pendiente.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+bool DireccionSocket(const std::string& ruta, sockaddr_un& dir)
+{
+    std::memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    if (ruta.empty() || ruta.size() >= sizeof(dir.sun_path)) {
+        std::cerr << "[ERROR] Ruta de socket inválida (máximo " << sizeof(dir.sun_path) - 1
+                  << " caracteres): '" << ruta << "'\n";
+        return false;
+    }
+    std::memcpy(dir.sun_path, ruta.c_str(), ruta.size());
+    return true;
+}
+
+class Servidor
+{
+public:
+    explicit Servidor(const OpcionesServidor& opciones)
+        : opciones(opciones),
+          volumenes(static_cast<long long>(std::max(0, opciones.mbVolumenes)) << 20),
+          frames(static_cast<long long>(std::max(0, opciones.mbFrames)) << 20),
+          prefijoShm(PrefijoShm(getpid()))
+    {}
+
+    ~Servidor()
+    {
+        // Los destructores de FrameCompartido hacen shm_unlink
+        frames.Vaciar();
+        volumenes.Vaciar();
+    }
+
+    bool Ejecutar();
+
+private:
+    void AtenderConexion(int fd);
+    std::string Responder(const std::vector<std::string>& args);
+    std::string Procesar(const std::vector<std::string>& args);
+    std::string Slice(const std::vector<std::string>& args);
+    std::string Stats();
+
+    // Volumen de la caché (o leído ahora); varias peticiones del mismo archivo esperan a una sola lectura
+    VolumenNifti Volumen(const std::string& ruta, const char* descripcion, std::string& clave);
+
+    const OpcionesServidor opciones;
+
+    std::mutex mtxCache;
+    CacheLru<std::shared_future<VolumenNifti>> volumenes;
+    CacheLru<FrameCompartido> frames;
+    const std::string prefijoShm;
+    std::atomic<unsigned long long> contadorShm{ 0 };
+
+    std::mutex mtxProcesar;               // PROCESAR ya usa todos los hilos: de uno en uno
+    std::atomic<long long> peticiones{ 0 };
+
+    int fdSocket = -1;
+    std::atomic<bool> salir{ false };
+    std::mutex mtxConexiones;
+    std::condition_variable cvConexiones;
+    std::set<int> conexiones;             // abiertas (cada una con su hilo)
+};
+
+VolumenNifti Servidor::Volumen(const std::string& ruta, const char* descripcion, std::string& clave)
+{
+    if (!ClaveArchivo(ruta, clave)) return VolumenNifti();
+
+    std::shared_ptr<std::shared_future<VolumenNifti>> lectura;
+    std::promise<VolumenNifti> promesa;
+    bool leer = false;
+    {
+        std::lock_guard<std::mutex> lock(mtxCache);
+        lectura = volumenes.Buscar(clave);
+        if (!lectura) {
+            lectura = std::make_shared<std::shared_future<VolumenNifti>>(promesa.get_future().share());
+            volumenes.Insertar(clave, lectura, 0);       // el tamaño se conoce al terminar de leer
+            leer = true;
+        }
+    }
+    if (!leer) return lectura->get();
+
+    // Si la lectura lanza, quienes esperan reciben la misma excepción (no broken_promise)
+    // y la entrada sale de la caché para que la próxima petición lo vuelva a intentar
+    VolumenNifti vol;
+    try {
+        vol = LeerVolumenNiftiNativo(ruta, descripcion);
+    }
+    catch (...) {
+        promesa.set_exception(std::current_exception());
+        {
+            std::lock_guard<std::mutex> lock(mtxCache);
+            volumenes.Quitar(clave);
+        }
+        throw;
+    }
+    promesa.set_value(vol);
+
+    std::lock_guard<std::mutex> lock(mtxCache);
+    if (!vol) {
+        volumenes.Quitar(clave);
+        return vol;
+    }
+    volumenes.Insertar(clave, lectura, vol.Bytes());
+    return vol;
+}
+
+std::string Servidor::Procesar(const std::vector<std::string>& args)
+{
+    if (args.size() < 5 || args.size() > 6)
+        return "ERROR uso: PROCESAR <imagen> <mascara> <carpetaSalida> <filtro> [orientacion]";
+
+    const auto t0 = Reloj::now();
+    const std::string& rutaNifti = args[1];
+    const std::string& rutaMask  = args[2];
+    std::string carpetaSalidaBase = args[3];
+    if (carpetaSalidaBase.empty()) return "ERROR carpeta de salida vacía";
+    if (carpetaSalidaBase.back() != '/') carpetaSalidaBase += '/';
+
+    int filtro = 0;
+    if (!LeerEntero(args[4], filtro) || filtro < 1 || filtro > kNumFiltros) return ErrorFiltroInvalido();
+
+    // Mismas opciones que 'RMProcessorCli caso' (con estadísticas, sin video)
+    std::vector<cv::Mat> highlighted;
+    OpcionesProcesado op;
+    if (args.size() == 6 && !LeerOrientacion(args[5], op.orientacion)) return "ERROR orientación desconocida";
+    op.numHilos = opciones.numHilos;
+    op.recolectarEstadisticas = true;
+
+    std::lock_guard<std::mutex> lockProcesar(mtxProcesar);
+
+    ManifiestoResultados m;
+    if (ResultadosVigentes(rutaNifti, rutaMask, carpetaSalidaBase, filtro, op, &m)) {
+        std::ostringstream out;
+        out << "OK " << m.NumSlices() << " " << MsDesde(t0) << " vigente";
+        return out.str();
+    }
+
+    std::string claveImg, claveMask;
+    op.imagenPrecargada  = Volumen(rutaNifti, "imagen", claveImg);
+    op.mascaraPrecargada = Volumen(rutaMask, "máscara", claveMask);
+    if (!op.imagenPrecargada || !op.mascaraPrecargada) return "ERROR no se pudieron leer los volúmenes";
+
+    op.framesHighlighted = &highlighted;
+    if (!ProcesarTodosSlices(rutaNifti, rutaMask, carpetaSalidaBase, filtro, op))
+        return "ERROR falló el procesamiento (ver la salida del servidor)";
+
+    // Los slices recién calculados quedan en la caché para las peticiones SLICE
+    // (sólo los que caben: los primeros no deben descartarse por los últimos)
+    const std::string prefijoClave = claveImg + "#" + claveMask + "#" + std::to_string(filtro) + "#"
+                                   + NombreOrientacion(op.orientacion) + "#";
+    long long bytesLimite = static_cast<long long>(std::max(0, opciones.mbFrames)) << 20;
+    for (size_t i = 0; i < highlighted.size(); ++i)
+    {
+        const long long bytes = static_cast<long long>(highlighted[i].total() * highlighted[i].elemSize());
+        if (bytes <= 0 || bytes > bytesLimite) break;
+        bytesLimite -= bytes;
+
+        auto frame = FrameCompartido::Crear(highlighted[i], prefijoShm + std::to_string(contadorShm++));
+        if (!frame) break;
+        std::lock_guard<std::mutex> lock(mtxCache);
+        frames.Insertar(prefijoClave + std::to_string(i), frame, static_cast<long long>(frame->bytes));
+    }
+
+    std::ostringstream out;
+    out << "OK " << highlighted.size() << " " << MsDesde(t0) << " procesado";
+    return out.str();
+}
+
+std::string Servidor::Slice(const std::vector<std::string>& args)
+{
+    if (args.size() != 6)
+        return "ERROR uso: SLICE <imagen> <mascara> <filtro> <orientacion> <indice>";
+
+    const auto t0 = Reloj::now();
+    int filtro = 0, indice = 0;
+    Orientacion orientacion;
+    if (!LeerEntero(args[3], filtro) || filtro < 1 || filtro > kNumFiltros) return ErrorFiltroInvalido();
+    if (!LeerOrientacion(args[4], orientacion)) return "ERROR orientación desconocida";
+    if (!LeerEntero(args[5], indice) || indice < 0) return "ERROR índice inválido (0-based)";
+
+    std::string claveImg, claveMask;
+    if (!ClaveArchivo(args[1], claveImg) || !ClaveArchivo(args[2], claveMask))
+        return "ERROR no existen la imagen o la máscara";
+    const std::string clave = claveImg + "#" + claveMask + "#" + std::to_string(filtro) + "#"
+                            + NombreOrientacion(orientacion) + "#" + std::to_string(indice);
+
+    std::shared_ptr<FrameCompartido> frame;
+    {
+        std::lock_guard<std::mutex> lock(mtxCache);
+        frame = frames.Buscar(clave);
+    }
+    const bool acierto = static_cast<bool>(frame);
+
+    if (!frame)
+    {
+        VolumenNifti img  = Volumen(args[1], "imagen", claveImg);
+        VolumenNifti mask = Volumen(args[2], "máscara", claveMask);
+        if (!img || !mask) return "ERROR no se pudieron leer los volúmenes";
+
+        cv::Mat highlighted;
+        try {
+            highlighted = ProcesarPlanoVolumen(img, mask, orientacion, indice, filtro);
+        }
+        catch (const cv::Exception& e) {
+            return std::string("ERROR ") + e.what();
+        }
+        if (highlighted.empty()) return "ERROR plano fuera de rango o tamaños distintos";
+
+        frame = FrameCompartido::Crear(highlighted, prefijoShm + std::to_string(contadorShm++));
+        if (!frame) return "ERROR no se pudo crear la memoria compartida";
+
+        std::lock_guard<std::mutex> lock(mtxCache);
+        frames.Insertar(clave, frame, static_cast<long long>(frame->bytes));
+    }
+
+    std::ostringstream out;
+    out << "OK " << frame->Respuesta() << " " << MsDesde(t0) << (acierto ? " acierto" : " fallo");
+    return out.str();
+}
+
+std::string Servidor::Stats()
+{
+    std::lock_guard<std::mutex> lock(mtxCache);
+    std::ostringstream out;
+    out << "OK {\"peticiones\":" << peticiones.load()
+        << ",\"volumenes\":" << volumenes.Json()
+        << ",\"frames\":" << frames.Json();
+
+    // Memoria contada de todo el proceso (cachés y procesamientos en curso), en bytes
+    const EstadoMemoria memoria = LeerMemoria();
+    out << ",\"memoria\":{\"vivos\":" << memoria.vivosTotal << ",\"pico\":" << memoria.picoTotal;
+    for (int c = 0; c < kNumCategoriasMemoria; ++c)
+        out << ",\"" << NombreCategoriaMemoria(static_cast<CategoriaMemoria>(c)) << "\":[" << memoria.vivos[c]
+            << "," << memoria.picos[c] << "]";
+    out << "}}";
+    return out.str();
+}
+
+std::string Servidor::Responder(const std::vector<std::string>& args)
+{
+    ++peticiones;
+    const std::string& comando = args[0];
+    if (comando == "PROCESAR") return Procesar(args);
+    if (comando == "SLICE")    return Slice(args);
+    if (comando == "STATS")    return Stats();
+    if (comando == "SALIR") {
+        salir = true;
+        shutdown(fdSocket, SHUT_RDWR);        // despierta al accept
+        return "OK";
+    }
+    return "ERROR comando desconocido: " + comando;
+}
+
+void Servidor::AtenderConexion(int fd)
+{
+    std::string pendiente, linea;
+    while (!salir && RecibirLinea(fd, pendiente, linea))
+    {
+        const auto args = Separar(linea);
+        if (args.empty()) continue;
+
+        std::string respuesta;
+        try {
+            respuesta = Responder(args);
+        }
+        catch (const std::exception& e) {
+            respuesta = std::string("ERROR ") + e.what();
+        }
+        if (!EnviarLinea(fd, respuesta)) break;
+    }
+
+    std::unique_lock<std::mutex> lock(mtxConexiones);
+    conexiones.erase(fd);
+    close(fd);
+    std::notify_all_at_thread_exit(cvConexiones, std::move(lock));
+}
+
+bool Servidor::Ejecutar()
+{
+    sockaddr_un dir;
+    if (!DireccionSocket(opciones.rutaSocket, dir)) return false;
+
+    // Si ya hay un servidor escuchando en esa ruta, no se le quita el socket
+    std::string respuesta;
+    if (ConsultarServidor(opciones.rutaSocket, "STATS", respuesta)) {
+        std::cerr << "[ERROR] Ya hay un servidor en '" << opciones.rutaSocket << "'.\n";
+        return false;
+    }
+    unlink(opciones.rutaSocket.c_str());
+    LimpiarSegmentosHuerfanos();
+
+    fdSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fdSocket < 0 ||
+        bind(fdSocket, reinterpret_cast<sockaddr*>(&dir), sizeof(dir)) != 0 ||
+        listen(fdSocket, 64) != 0)
+    {
+        std::cerr << "[ERROR] No se pudo abrir el socket '" << opciones.rutaSocket << "': "
+                  << std::strerror(errno) << "\n";
+        if (fdSocket >= 0) close(fdSocket);
+        return false;
+    }
+    chmod(opciones.rutaSocket.c_str(), 0600);    // sólo el usuario del servidor
+
+    std::cout << "[INFO] Servidor escuchando en '" << opciones.rutaSocket << "' (caché: "
+              << opciones.mbVolumenes << " MB de volúmenes, " << opciones.mbFrames << " MB de slices).\n";
+
+    // Un hilo por conexión (desacoplado: el servidor puede vivir días y atender miles)
+    while (!salir)
+    {
+        const int fd = accept(fdSocket, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;                                   // shutdown por SALIR (o error del socket)
+        }
+        std::lock_guard<std::mutex> lock(mtxConexiones);
+        conexiones.insert(fd);
+        std::thread(&Servidor::AtenderConexion, this, fd).detach();
+    }
+
+    // Dejar de leer de las conexiones abiertas (las peticiones en curso terminan
+    // y responden) y esperar a que acaben sus hilos
+    {
+        std::unique_lock<std::mutex> lock(mtxConexiones);
+        for (int fd : conexiones) shutdown(fd, SHUT_RD);
+        cvConexiones.wait(lock, [this] { return conexiones.empty(); });
+    }
+
+    close(fdSocket);
+    unlink(opciones.rutaSocket.c_str());
+    std::cout << "[INFO] Servidor detenido.\n";
+    return true;
+}
+
+} // namespace
+
+bool EjecutarServidor(const OpcionesServidor& opciones)
+{
+    Servidor servidor(opciones);
+    return servidor.Ejecutar();
+}
+
+bool ConsultarServidor(const std::string& rutaSocket, const std::string& peticion, std::string& respuesta)
+{
+    sockaddr_un dir;
+    if (!DireccionSocket(rutaSocket, dir)) return false;
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    bool ok = connect(fd, reinterpret_cast<sockaddr*>(&dir), sizeof(dir)) == 0;
+
+    std::string pendiente;
+    ok = ok && EnviarLinea(fd, peticion) && RecibirLinea(fd, pendiente, respuesta);
+    close(fd);
+    return ok;
+}
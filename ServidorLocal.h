@@ -0,0 +1,56 @@
+// ServidorLocal.h
+#ifndef SERVIDORLOCAL_H
+#define SERVIDORLOCAL_H
+
+#include <string>
+
+// Socket por defecto del servidor local
+constexpr const char* kRutaSocketServidor = "/tmp/rmprocessor.sock";
+
+/**
+ * Servidor de larga duración (daemon) sobre un socket Unix local. Mantiene en
+ * memoria los volúmenes leídos y los slices highlighted ya calculados, de modo
+ * que los visores y los scripts de QA no vuelven a leer ni a filtrar nada en
+ * peticiones repetidas o de acceso aleatorio.
+ *
+ * Protocolo: una línea por petición y una línea por respuesta ("OK ..." o
+ * "ERROR <motivo>"). Los argumentos se separan por espacios; las rutas con
+ * espacios van entre comillas dobles.
+ *
+ *   PROCESAR <imagen> <mascara> <carpetaSalida> <filtro> [orientacion]
+ *       -> OK <numSlices> <ms> procesado|vigente
+ *   SLICE <imagen> <mascara> <filtro> <orientacion> <indice>
+ *       -> OK <shm> <ancho> <alto> <canales> <bytes> <ms> acierto|fallo
+ *   STATS
+ *       -> OK {json con aciertos, fallos y memoria de cada caché, y la memoria
+ *          contada del proceso: bytes vivos y pico, y [vivos, pico] por categoría}
+ *   SALIR
+ *       -> OK (el servidor termina)
+ *
+ * SLICE devuelve la imagen highlighted (BGR, 8 bits, filas contiguas) en un
+ * segmento de memoria compartida POSIX: el cliente lo abre con shm_open(<shm>,
+ * O_RDONLY) y mmap. El segmento es la propia entrada de la caché; se borra
+ * (shm_unlink) cuando la caché la descarta, así que el cliente debe abrirlo en
+ * cuanto recibe la respuesta (una vez mapeado, el mapeo sigue siendo válido).
+ */
+struct OpcionesServidor
+{
+    std::string rutaSocket = kRutaSocketServidor;
+    int mbVolumenes = 4096;       // memoria máxima de volúmenes en caché
+    int mbFrames    = 1024;       // memoria máxima de slices highlighted en caché
+    int numHilos    = 0;          // hilos de PROCESAR (0 = todos los núcleos)
+};
+
+/**
+ * Atiende peticiones (una conexión por hilo) hasta recibir SALIR.
+ * @return false si no se pudo abrir el socket.
+ */
+bool EjecutarServidor(const OpcionesServidor& opciones);
+
+/**
+ * Cliente mínimo: envía una petición al servidor y devuelve la línea de respuesta.
+ * @return false si no se pudo conectar.
+ */
+bool ConsultarServidor(const std::string& rutaSocket, const std::string& peticion, std::string& respuesta);
+
+#endif // SERVIDORLOCAL_H
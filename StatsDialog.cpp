@@ -0,0 +1,293 @@
+// StatsDialog.cpp
+#include "StatsDialog.h"
+#include <QLabel>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QPainter>
+#include <QPen>
+#include <QFont>
+#include <algorithm>
+#include <cmath>
+
+// Texto con las estadísticas de una serie (vacío si no tiene datos)
+static QString TextoEstadisticas(const QString& titulo, const EstadisticasIntensidad& e)
+{
+    if (e.n == 0) return titulo + ": sin datos\n";
+    return QString("%1 (%2 vóxeles)\n"
+                   "  Media: %3   Mediana: %4   Moda: %5\n"
+                   "  Varianza: %6   Desviación estándar: %7\n"
+                   "  Mín: %8   Q1: %9   Q3: %10   Máx: %11\n")
+        .arg(titulo)
+        .arg(static_cast<unsigned long long>(e.n))
+        .arg(e.media, 0, 'f', 2)
+        .arg(e.mediana, 0, 'f', 2)
+        .arg(e.moda, 0, 'g', 6)
+        .arg(e.varianza, 0, 'f', 2)
+        .arg(e.desviacion, 0, 'f', 2)
+        .arg(e.minimo, 0, 'g', 6)
+        .arg(e.q1, 0, 'f', 1)
+        .arg(e.q3, 0, 'f', 1)
+        .arg(e.maximo, 0, 'g', 6);
+}
+
+// Series total/dentro/fuera de un EstadisticasRoi (las vacías se omiten al dibujar)
+static std::vector<SerieBoxplot> SeriesRoi(const EstadisticasRoi& roi)
+{
+    return {
+        { "Total",          roi.total  },
+        { "Dentro máscara", roi.dentro },
+        { "Fuera máscara",  roi.fuera  },
+    };
+}
+
+// ---------------------------------------------------------------------------
+// BoxplotWidget
+// ---------------------------------------------------------------------------
+
+BoxplotWidget::BoxplotWidget(const std::vector<SerieBoxplot>& todas, QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(400, 350);
+
+    bool primero = true;
+    for (const auto& s : todas)
+    {
+        if (s.stats.n == 0) continue;
+        series.push_back(s);
+        ejeMin = primero ? s.stats.minimo : std::min(ejeMin, s.stats.minimo);
+        ejeMax = primero ? s.stats.maximo : std::max(ejeMax, s.stats.maximo);
+        primero = false;
+    }
+    // Datos de 8 bits: eje fijo 0-255 como el boxplot original
+    if (primero || (ejeMin >= 0.0 && ejeMax <= 255.0)) {
+        ejeMin = 0.0;
+        ejeMax = 255.0;
+    }
+    if (ejeMax <= ejeMin) ejeMax = ejeMin + 1.0;
+}
+
+void BoxplotWidget::paintEvent(QPaintEvent * /*event*/)
+{
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.fillRect(rect(), QColor(Qt::white));
+
+    // Márgenes para título, eje y nombres de las series
+    const int margenIzq = 70, margenDer = 20, margenSup = 40, margenInf = 30;
+    const double x0 = margenIzq;
+    const double x1 = width() - margenDer;
+    const double yTop = margenSup;
+    const double yBot = height() - margenInf;
+
+    // Intensidad -> coordenada Y del widget
+    auto Y = [&](double v) { return yBot - (v - ejeMin) / (ejeMax - ejeMin) * (yBot - yTop); };
+
+    p.setPen(QColor(Qt::black));
+    p.drawText(QRect(0, 5, width(), margenSup - 10), Qt::AlignHCenter, "Boxplot de valores de píxel");
+
+    // Eje Y con 6 marcas
+    p.drawLine(QPointF(x0, yTop), QPointF(x0, yBot));
+    for (int k = 0; k <= 5; ++k) {
+        double v = ejeMin + (ejeMax - ejeMin) * k / 5.0;
+        p.drawLine(QPointF(x0 - 5, Y(v)), QPointF(x0, Y(v)));
+        p.drawText(QPointF(5, Y(v) + 4), QString::number(std::lround(v)));
+    }
+    p.drawText(QPointF(5, yTop - 10),
+               QString("Intensidad (%1-%2)").arg(std::lround(ejeMin)).arg(std::lround(ejeMax)));
+
+    if (series.empty()) return;
+
+    const double anchoSerie = (x1 - x0) / static_cast<double>(series.size());
+    for (size_t i = 0; i < series.size(); ++i)
+    {
+        const EstadisticasIntensidad& s = series[i].stats;
+        const double xc = x0 + anchoSerie * (i + 0.5);
+        const double anchoCaja = anchoSerie * 0.4;
+        const double anchoBigote = anchoCaja * 0.5;
+
+        // Bigotes
+        p.setPen(QPen(QColor(Qt::black), 1));
+        p.drawLine(QPointF(xc, Y(s.bigoteInferior)), QPointF(xc, Y(s.q1)));
+        p.drawLine(QPointF(xc, Y(s.q3)), QPointF(xc, Y(s.bigoteSuperior)));
+        p.drawLine(QPointF(xc - anchoBigote / 2, Y(s.bigoteInferior)),
+                   QPointF(xc + anchoBigote / 2, Y(s.bigoteInferior)));
+        p.drawLine(QPointF(xc - anchoBigote / 2, Y(s.bigoteSuperior)),
+                   QPointF(xc + anchoBigote / 2, Y(s.bigoteSuperior)));
+
+        // Caja Q1-Q3
+        p.setBrush(QColor(Qt::white));
+        p.drawRect(QRectF(QPointF(xc - anchoCaja / 2, Y(s.q3)),
+                          QPointF(xc + anchoCaja / 2, Y(s.q1))));
+
+        // Mediana
+        p.setPen(QPen(QColor(255, 127, 14), 2));
+        p.drawLine(QPointF(xc - anchoCaja / 2, Y(s.mediana)),
+                   QPointF(xc + anchoCaja / 2, Y(s.mediana)));
+
+        // Atípicos: un círculo por valor distinto
+        p.setPen(QPen(QColor(Qt::black), 1));
+        p.setBrush(QBrush());
+        for (double v : s.atipicos)
+            p.drawEllipse(QPointF(xc, Y(v)), 3, 3);
+
+        p.drawText(QRect(static_cast<int>(xc - anchoSerie / 2), static_cast<int>(yBot + 5),
+                         static_cast<int>(anchoSerie), margenInf - 5),
+                   Qt::AlignHCenter, series[i].nombre);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// PerfilZWidget
+// ---------------------------------------------------------------------------
+
+PerfilZWidget::PerfilZWidget(const std::vector<PerfilSliceZ>& perfil, QWidget *parent)
+    : QWidget(parent),
+      perfil(perfil)
+{
+    setMinimumSize(400, 350);
+}
+
+void PerfilZWidget::paintEvent(QPaintEvent * /*event*/)
+{
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.fillRect(rect(), QColor(Qt::white));
+
+    const int margenIzq = 60, margenDer = 70, margenSup = 40, margenInf = 30;
+    const double x0 = margenIzq;
+    const double x1 = width() - margenDer;
+    const double yTop = margenSup;
+    const double yBot = height() - margenInf;
+
+    p.setPen(QColor(Qt::black));
+    p.drawText(QRect(0, 5, width(), margenSup - 10), Qt::AlignHCenter, "Perfil a lo largo de Z");
+    p.drawLine(QPointF(x0, yBot), QPointF(x1, yBot));
+    p.drawLine(QPointF(x0, yTop), QPointF(x0, yBot));
+    p.drawLine(QPointF(x1, yTop), QPointF(x1, yBot));
+
+    if (perfil.size() < 2) return;
+
+    // Rangos de cada eje
+    double intMin = perfil[0].media, intMax = perfil[0].media, areaMax = 0.0;
+    for (const auto& s : perfil)
+    {
+        intMin = std::min(intMin, s.media);
+        intMax = std::max(intMax, s.media);
+        if (s.voxelesMascara > 0) {
+            intMin = std::min(intMin, s.mediaDentro);
+            intMax = std::max(intMax, s.mediaDentro);
+        }
+        areaMax = std::max(areaMax, s.areaMascaraMm2);
+    }
+    if (intMax <= intMin) intMax = intMin + 1.0;
+    if (areaMax <= 0.0) areaMax = 1.0;
+
+    const double zMax = static_cast<double>(perfil.size() - 1);
+    auto X     = [&](double z) { return x0 + z / zMax * (x1 - x0); };
+    auto YInt  = [&](double v) { return yBot - (v - intMin) / (intMax - intMin) * (yBot - yTop); };
+    auto YArea = [&](double a) { return yBot - a / areaMax * (yBot - yTop); };
+
+    // Etiquetas de los ejes
+    p.drawText(QPointF(5, YInt(intMax) + 4), QString::number(std::lround(intMax)));
+    p.drawText(QPointF(5, YInt(intMin) + 4), QString::number(std::lround(intMin)));
+    p.drawText(QPointF(x1 + 5, YArea(areaMax) + 4), QString::number(std::lround(areaMax)) + " mm²");
+    p.drawText(QPointF(x1 + 5, YArea(0) + 4), "0");
+    p.drawText(QPointF(x0, yBot + 20), "z = 0");
+    p.drawText(QPointF(x1 - 50, yBot + 20), "z = " + QString::number(static_cast<int>(zMax)));
+
+    const QColor colMedia(31, 119, 180), colDentro(214, 39, 40), colArea(44, 160, 44);
+    for (size_t z = 1; z < perfil.size(); ++z)
+    {
+        const PerfilSliceZ& a = perfil[z - 1];
+        const PerfilSliceZ& b = perfil[z];
+
+        p.setPen(QPen(colMedia, 1.5));
+        p.drawLine(QPointF(X(z - 1), YInt(a.media)), QPointF(X(z), YInt(b.media)));
+
+        if (a.voxelesMascara > 0 && b.voxelesMascara > 0) {
+            p.setPen(QPen(colDentro, 1.5));
+            p.drawLine(QPointF(X(z - 1), YInt(a.mediaDentro)), QPointF(X(z), YInt(b.mediaDentro)));
+        }
+
+        p.setPen(QPen(colArea, 1.5, Qt::DashLine));
+        p.drawLine(QPointF(X(z - 1), YArea(a.areaMascaraMm2)), QPointF(X(z), YArea(b.areaMascaraMm2)));
+    }
+
+    // Leyenda
+    p.setPen(colMedia);
+    p.drawText(QPointF(x0 + 10, yTop + 15), "Media del slice");
+    p.setPen(colDentro);
+    p.drawText(QPointF(x0 + 10, yTop + 30), "Media dentro de la máscara");
+    p.setPen(colArea);
+    p.drawText(QPointF(x0 + 10, yTop + 45), "Área de la máscara (eje derecho)");
+}
+
+// ---------------------------------------------------------------------------
+// StatsDialog
+// ---------------------------------------------------------------------------
+
+StatsDialog::StatsDialog(const EstadisticasRoi& slice,
+                         const EstadisticasVolumen* volumen,
+                         const QString& descripcion,
+                         double msCalculo,
+                         QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Estadísticas de la imagen");
+
+    lblDescripcion = new QLabel(descripcion + QString("  (calculado en %1 ms)").arg(msCalculo, 0, 'f', 2));
+    lblDescripcion->setWordWrap(true);
+
+    tabs = new QTabWidget();
+
+    // --- Pestaña del slice actual ---
+    QWidget *tabSlice = new QWidget();
+    QVBoxLayout *vSlice = new QVBoxLayout(tabSlice);
+    vSlice->addWidget(new QLabel(TextoEstadisticas("Slice", slice.total)
+                                 + TextoEstadisticas("Dentro de la máscara", slice.dentro)
+                                 + TextoEstadisticas("Fuera de la máscara", slice.fuera)));
+    vSlice->addWidget(new BoxplotWidget(SeriesRoi(slice)), 1);
+    tabs->addTab(tabSlice, "Slice");
+
+    // --- Pestañas del volumen completo ---
+    if (volumen)
+    {
+        QWidget *tabVol = new QWidget();
+        QVBoxLayout *vVol = new QVBoxLayout(tabVol);
+        QString cabecera = QString("Volumen %1 x %2 x %3, espaciado %4 x %5 x %6 mm\n"
+                                   "Volumen de la máscara: %7 mm³ (%8 ml, %9 vóxeles)\n\n")
+            .arg(volumen->nx).arg(volumen->ny).arg(volumen->nz)
+            .arg(volumen->spacing[0], 0, 'f', 3)
+            .arg(volumen->spacing[1], 0, 'f', 3)
+            .arg(volumen->spacing[2], 0, 'f', 3)
+            .arg(volumen->volumenMascaraMm3, 0, 'f', 1)
+            .arg(volumen->volumenMascaraMm3 / 1000.0, 0, 'f', 2)
+            .arg(static_cast<unsigned long long>(volumen->roi.dentro.n));
+        vVol->addWidget(new QLabel(cabecera
+                                   + TextoEstadisticas("Volumen", volumen->roi.total)
+                                   + TextoEstadisticas("Dentro de la máscara", volumen->roi.dentro)
+                                   + TextoEstadisticas("Fuera de la máscara", volumen->roi.fuera)
+                                   + QString("\nReducción en paralelo: %1 ms").arg(volumen->msCalculo, 0, 'f', 1)));
+        vVol->addWidget(new BoxplotWidget(SeriesRoi(volumen->roi)), 1);
+        tabs->addTab(tabVol, "Volumen");
+
+        tabs->addTab(new PerfilZWidget(volumen->perfilZ), "Perfil Z");
+    }
+
+    btnCerrar = new QPushButton("Cerrar");
+    connect(btnCerrar, &QPushButton::clicked, this, &StatsDialog::accept);
+
+    QHBoxLayout *hButtons = new QHBoxLayout();
+    hButtons->addStretch();
+    hButtons->addWidget(btnCerrar);
+
+    QVBoxLayout *vMain = new QVBoxLayout(this);
+    vMain->addWidget(lblDescripcion);
+    vMain->addWidget(tabs, 1);
+    vMain->addLayout(hButtons);
+
+    setLayout(vMain);
+    resize(700, 750);
+}
@@ -0,0 +1,86 @@
+// StatsDialog.h
+#ifndef STATSDIALOG_H
+#define STATSDIALOG_H
+
+#include <QDialog>
+#include <QString>
+#include <QWidget>
+#include <vector>
+#include "Estadisticas.h"
+
+class QLabel;
+class QPushButton;
+class QTabWidget;
+
+// Una caja del boxplot
+struct SerieBoxplot
+{
+    QString nombre;
+    EstadisticasIntensidad stats;
+};
+
+/**
+ * Boxplots verticales (estilo matplotlib) dibujados con QPainter, uno por serie,
+ * a partir de estadísticas ya calculadas. El eje Y va de 0 a 255 si todos los
+ * datos caben (imágenes de 8 bits) y si no se ajusta al mínimo/máximo.
+ * Las series sin datos (n = 0) no se dibujan.
+ */
+class BoxplotWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit BoxplotWidget(const std::vector<SerieBoxplot>& series, QWidget *parent = nullptr);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    std::vector<SerieBoxplot> series;
+    double ejeMin = 0.0, ejeMax = 255.0;
+};
+
+/**
+ * Perfiles a lo largo de Z: media de intensidad del slice, media dentro de la
+ * máscara (eje izquierdo) y área de la máscara en mm² (eje derecho).
+ */
+class PerfilZWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PerfilZWidget(const std::vector<PerfilSliceZ>& perfil, QWidget *parent = nullptr);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    std::vector<PerfilSliceZ> perfil;
+};
+
+/**
+ * Ventana de estadísticas: el slice actual (total, dentro y fuera de la máscara)
+ * y, si se da, el volumen completo con el volumen de la máscara y los perfiles en Z.
+ * Sustituye al antiguo image_stats.py.
+ */
+class StatsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param volumen Puede ser nullptr (sólo se muestra la pestaña del slice).
+     */
+    StatsDialog(const EstadisticasRoi& slice,
+                const EstadisticasVolumen* volumen,
+                const QString& descripcion,
+                double msCalculo,
+                QWidget *parent = nullptr);
+
+private:
+    QLabel      *lblDescripcion;
+    QTabWidget  *tabs;
+    QPushButton *btnCerrar;
+};
+
+#endif // STATSDIALOG_H
@@ -0,0 +1,180 @@
+// Suavizado.cpp
+#include "Suavizado.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/core/utility.hpp>  // para cv::parallel_for_
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "Traza.h"
+
+// Filas mínimas por franja: cada franja vuelve a llenar 2·radio+1 filas de histogramas
+static constexpr int kFilasMinFranja = 32;
+
+// Histogramas de dos niveles: 16 grupos (4 bits altos) de 16 valores (4 bits bajos)
+static constexpr int kGrupos = 16;
+
+// ----------------------------------------------------------
+// Mediana de coste constante
+// ----------------------------------------------------------
+
+// Histogramas de cada columna de la imagen con borde: los 2·radio+1 píxeles de la
+// columna que caen en la ventana de la fila actual
+struct HistogramasColumna
+{
+    explicit HistogramasColumna(int ancho)
+        : fino(static_cast<size_t>(ancho) * 256), grueso(static_cast<size_t>(ancho) * kGrupos) {}
+
+    void Anadir(const uchar* fila, int ancho)
+    {
+        for (int x = 0; x < ancho; ++x) {
+            ++fino[static_cast<size_t>(x) * 256 + fila[x]];
+            ++grueso[static_cast<size_t>(x) * kGrupos + (fila[x] >> 4)];
+        }
+    }
+
+    void Quitar(const uchar* fila, int ancho)
+    {
+        for (int x = 0; x < ancho; ++x) {
+            --fino[static_cast<size_t>(x) * 256 + fila[x]];
+            --grueso[static_cast<size_t>(x) * kGrupos + (fila[x] >> 4)];
+        }
+    }
+
+    const uint16_t* Fino(int x, int grupo) const { return fino.data() + static_cast<size_t>(x) * 256 + grupo * kGrupos; }
+    const uint16_t* Grueso(int x) const { return grueso.data() + static_cast<size_t>(x) * kGrupos; }
+
+    std::vector<uint16_t> fino, grueso;
+};
+
+// Una fila de salida: el histograma grueso de la ventana se desplaza columna a columna y
+// el fino sólo se pone al día, cuando hace falta, en el grupo que contiene la mediana
+static void MedianaFila(const HistogramasColumna& columnas, int radio, int mitad, int cols, uchar* out)
+{
+    const int lado = 2 * radio + 1;
+    uint16_t grueso[kGrupos] = {};
+    uint16_t fino[kGrupos][kGrupos];
+    int actualizado[kGrupos];
+    std::fill(actualizado, actualizado + kGrupos, INT_MIN / 2);
+
+    for (int c = 0; c < lado; ++c) {
+        const uint16_t* g = columnas.Grueso(c);
+        for (int k = 0; k < kGrupos; ++k) grueso[k] += g[k];
+    }
+
+    for (int x = 0; x < cols; ++x)
+    {
+        if (x > 0) {
+            const uint16_t* entra = columnas.Grueso(x + 2 * radio);
+            const uint16_t* sale  = columnas.Grueso(x - 1);
+            for (int k = 0; k < kGrupos; ++k) grueso[k] += entra[k] - sale[k];
+        }
+
+        int acumulado = 0, grupo = 0;
+        while (acumulado + grueso[grupo] <= mitad) acumulado += grueso[grupo++];
+
+        uint16_t* f = fino[grupo];
+        if (x - actualizado[grupo] > lado) {
+            // Demasiado atrasado: se suma de nuevo la ventana entera
+            std::fill(f, f + kGrupos, 0);
+            for (int c = x; c < x + lado; ++c) {
+                const uint16_t* h = columnas.Fino(c, grupo);
+                for (int k = 0; k < kGrupos; ++k) f[k] += h[k];
+            }
+        } else {
+            for (int j = actualizado[grupo] + 1; j <= x; ++j) {
+                const uint16_t* entra = columnas.Fino(j + 2 * radio, grupo);
+                const uint16_t* sale  = columnas.Fino(j - 1, grupo);
+                for (int k = 0; k < kGrupos; ++k) f[k] += entra[k] - sale[k];
+            }
+        }
+        actualizado[grupo] = x;
+
+        int valor = 0;
+        while (acumulado + f[valor] <= mitad) acumulado += f[valor++];
+        out[x] = static_cast<uchar>(grupo * kGrupos + valor);
+    }
+}
+
+cv::Mat MedianaHistograma(const cv::Mat& src, int radio)
+{
+    CV_Assert(src.type() == CV_8UC1 && radio >= 0 && radio < 128);
+    if (radio == 0 || src.empty()) return src.clone();
+
+    cv::Mat ext;
+    cv::copyMakeBorder(src, ext, radio, radio, radio, radio, cv::BORDER_REPLICATE);
+    cv::Mat dst(src.size(), CV_8U);
+
+    const int filas = src.rows, cols = src.cols, ancho = ext.cols;
+    const int lado = 2 * radio + 1;
+    const int mitad = (lado * lado) / 2;
+    const int hilos = std::max(1, cv::getNumThreads());
+    const int filasFranja = std::max(kFilasMinFranja, (filas + hilos - 1) / hilos);
+    const int numFranjas = (filas + filasFranja - 1) / filasFranja;
+
+    cv::parallel_for_(cv::Range(0, numFranjas), [&](const cv::Range& r) {
+        HistogramasColumna columnas(ancho);
+        for (int franja = r.start; franja < r.end; ++franja)
+        {
+            TramoTraza tramo("medianaFranja", franja);
+            const int y0 = franja * filasFranja;
+            const int y1 = std::min(filas, y0 + filasFranja);
+
+            // La fila de salida y usa las filas y .. y + 2·radio de la imagen con borde
+            std::fill(columnas.fino.begin(), columnas.fino.end(), 0);
+            std::fill(columnas.grueso.begin(), columnas.grueso.end(), 0);
+            for (int k = 0; k < lado; ++k) columnas.Anadir(ext.ptr<uchar>(y0 + k), ancho);
+
+            for (int y = y0; y < y1; ++y) {
+                if (y > y0) {
+                    columnas.Quitar(ext.ptr<uchar>(y - 1), ancho);
+                    columnas.Anadir(ext.ptr<uchar>(y + 2 * radio), ancho);
+                }
+                MedianaFila(columnas, radio, mitad, cols, dst.ptr<uchar>(y));
+            }
+        }
+    }, numFranjas);
+    return dst;
+}
+
+// ----------------------------------------------------------
+// Filtro guiado
+// ----------------------------------------------------------
+
+cv::Mat FiltroGuiadoRapido(const cv::Mat& src, int radio, double eps, int submuestreo)
+{
+    CV_Assert(src.type() == CV_8UC1 && radio >= 1 && eps > 0 && submuestreo >= 1);
+    if (src.empty()) return src.clone();
+
+    cv::Mat guia;
+    src.convertTo(guia, CV_32F, 1.0 / 255.0);
+
+    // Coeficientes a y b de q = a·I + b sobre la guía reducida
+    cv::Mat reducida = guia;
+    if (submuestreo > 1) {
+        const cv::Size tamReducido(std::max(1, src.cols / submuestreo), std::max(1, src.rows / submuestreo));
+        cv::resize(guia, reducida, tamReducido, 0, 0, cv::INTER_AREA);
+    }
+    const int r = std::max(1, radio / submuestreo);
+    const cv::Size caja(2 * r + 1, 2 * r + 1);
+
+    cv::Mat media, mediaCuadrado, varianza, a, b;
+    cv::boxFilter(reducida, media, CV_32F, caja, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+    cv::boxFilter(reducida.mul(reducida), mediaCuadrado, CV_32F, caja, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+    varianza = mediaCuadrado - media.mul(media);
+    cv::divide(varianza, varianza + eps, a);
+    b = media - a.mul(media);
+
+    // Cada píxel usa la media de los coeficientes de todas las ventanas que lo contienen
+    cv::boxFilter(a, a, CV_32F, caja, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+    cv::boxFilter(b, b, CV_32F, caja, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+    if (submuestreo > 1) {
+        cv::resize(a, a, src.size(), 0, 0, cv::INTER_LINEAR);
+        cv::resize(b, b, src.size(), 0, 0, cv::INTER_LINEAR);
+    }
+
+    cv::Mat dst;
+    cv::Mat q = a.mul(guia) + b;
+    q.convertTo(dst, CV_8U, 255.0);
+    return dst;
+}
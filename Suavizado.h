@@ -0,0 +1,33 @@
+// Suavizado.h
+#ifndef SUAVIZADO_H
+#define SUAVIZADO_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Mediana de una ventana (2·radio+1)² con histogramas por columna (Perreault y Hébert,
+ * "Median Filtering in Constant Time"): al avanzar una fila, cada columna suma el píxel
+ * que entra y resta el que sale; al avanzar un píxel, el histograma de la ventana suma
+ * la columna que entra y resta la que sale. Con histogramas de dos niveles (16 grupos
+ * de 16 valores) sólo se recorren los 16 grupos y los 16 valores del grupo de la
+ * mediana, así que el coste por píxel no depende del radio.
+ *
+ * El borde se replica, como en cv::medianBlur. Las filas se reparten en franjas en
+ * paralelo; cada franja tiene sus propios histogramas de columna.
+ *
+ * @param src CV_8UC1.
+ */
+cv::Mat MedianaHistograma(const cv::Mat& src, int radio);
+
+/**
+ * Filtro guiado (He, Sun y Tang) con la propia imagen como guía: suaviza las zonas
+ * planas y conserva los bordes cuya varianza local pasa de 'eps' (en intensidades
+ * normalizadas a [0, 1]), como un bilateral pero sólo con medias de caja, de coste
+ * independiente del radio. Los coeficientes se calculan sobre la imagen reducida
+ * 'submuestreo' veces y se amplían con interpolación bilineal ("Fast Guided Filter").
+ *
+ * @param src CV_8UC1.
+ */
+cv::Mat FiltroGuiadoRapido(const cv::Mat& src, int radio, double eps, int submuestreo = 1);
+
+#endif // SUAVIZADO_H
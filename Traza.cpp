@@ -0,0 +1,260 @@
+// Traza.cpp
+#include "Traza.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+namespace detalle {
+std::atomic<bool> trazaActiva{ false };
+}
+
+namespace {
+
+struct Evento
+{
+    const char* nombre;
+    long long inicioNs;
+    long long finNs;              // en los contadores, el valor
+    int arg;
+    bool contador;
+};
+
+// Búfer circular de un hilo. Sólo escribe su dueño; el resto lo lee con el registro bloqueado.
+struct BufferHilo
+{
+    std::vector<Evento> eventos;                  // capacidad potencia de 2
+    size_t mascara = 0;
+    std::atomic<unsigned long long> escritos{ 0 };
+    std::atomic<unsigned> generacion{ 0 };        // traza a la que pertenecen los eventos
+    std::atomic<bool> conDueno{ true };           // false cuando el hilo termina
+    int tid = 0;
+};
+
+std::mutex mtxRegistro;
+std::vector<std::unique_ptr<BufferHilo>> buffers;   // los de hilos terminados se borran al iniciar otra traza
+size_t capacidadPorHilo = size_t(1) << 16;
+long long origenNs = 0;
+int siguienteTid = 1;
+std::atomic<unsigned> generacionActual{ 0 };
+
+// Al terminar el hilo, su búfer queda sin dueño (los eventos siguen ahí hasta la próxima traza)
+struct DuenoBuffer
+{
+    BufferHilo* buffer = nullptr;
+    ~DuenoBuffer() { if (buffer) buffer->conDueno = false; }
+};
+thread_local DuenoBuffer dueno;
+
+// Primer tramo del hilo en esta traza: crea o vacía su búfer (una vez por hilo y traza)
+BufferHilo* PrepararBufferHilo(unsigned generacion)
+{
+    std::lock_guard<std::mutex> lock(mtxRegistro);
+    if (!dueno.buffer)
+    {
+        buffers.push_back(std::make_unique<BufferHilo>());
+        dueno.buffer = buffers.back().get();
+        dueno.buffer->tid = siguienteTid++;
+    }
+    BufferHilo* b = dueno.buffer;
+    if (b->eventos.size() != capacidadPorHilo) {
+        b->eventos.assign(capacidadPorHilo, Evento{});
+        b->mascara = capacidadPorHilo - 1;
+    }
+    b->escritos.store(0, std::memory_order_relaxed);
+    b->generacion.store(generacion, std::memory_order_relaxed);
+    return b;
+}
+
+// Llama a f(buffer, evento) con los eventos conservados de la traza actual (registro bloqueado)
+template <class F>
+void RecorrerEventos(F&& f)
+{
+    const unsigned generacion = generacionActual.load();
+    for (const auto& b : buffers)
+    {
+        if (b->generacion.load() != generacion) continue;
+        const unsigned long long escritos = b->escritos.load(std::memory_order_acquire);
+        const unsigned long long capacidad = b->eventos.size();
+        const unsigned long long desde = escritos > capacidad ? escritos - capacidad : 0;
+        for (unsigned long long k = desde; k < escritos; ++k) f(*b, b->eventos[k & b->mascara]);
+    }
+}
+
+void RegistrarEvento(const Evento& e)
+{
+    const unsigned generacion = generacionActual.load(std::memory_order_acquire);
+    BufferHilo* b = dueno.buffer;
+    if (!b || b->generacion.load(std::memory_order_relaxed) != generacion)
+        b = PrepararBufferHilo(generacion);
+
+    const unsigned long long n = b->escritos.load(std::memory_order_relaxed);
+    b->eventos[n & b->mascara] = e;
+    b->escritos.store(n + 1, std::memory_order_release);
+}
+
+double Percentil(const std::vector<double>& ordenados, double p)
+{
+    // Rango más cercano: el menor valor con al menos p·n valores <= él
+    const size_t n = ordenados.size();
+    size_t k = static_cast<size_t>(std::ceil(p * static_cast<double>(n)));
+    k = std::min(std::max<size_t>(k, 1), n);
+    return ordenados[k - 1];
+}
+
+} // namespace
+
+namespace detalle {
+
+long long AhoraNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RegistrarTramo(const char* nombre, long long inicioNs, long long finNs, int arg)
+{
+    RegistrarEvento(Evento{ nombre, inicioNs, finNs, arg, false });
+}
+
+} // namespace detalle
+
+void RegistrarContadorTraza(const char* nombre, long long valor)
+{
+    if (!TrazaActiva()) return;
+    RegistrarEvento(Evento{ nombre, detalle::AhoraNs(), valor, -1, true });
+}
+
+void IniciarTraza(size_t eventosPorHilo)
+{
+    std::lock_guard<std::mutex> lock(mtxRegistro);
+    buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                 [](const auto& b) { return !b->conDueno.load(); }),
+                  buffers.end());
+
+    size_t capacidad = 1;
+    while (capacidad < std::max<size_t>(eventosPorHilo, 16)) capacidad <<= 1;
+    capacidadPorHilo = capacidad;
+    origenNs = detalle::AhoraNs();
+
+    generacionActual.fetch_add(1, std::memory_order_release);
+    detalle::trazaActiva.store(true);
+}
+
+void DetenerTraza()
+{
+    detalle::trazaActiva.store(false);
+}
+
+std::vector<ResumenTramo> ResumirTraza()
+{
+    std::map<std::string, std::vector<double>> duraciones;
+    {
+        std::lock_guard<std::mutex> lock(mtxRegistro);
+        RecorrerEventos([&](const BufferHilo&, const Evento& e) {
+            if (!e.contador) duraciones[e.nombre].push_back((e.finNs - e.inicioNs) / 1e6);
+        });
+    }
+
+    std::vector<ResumenTramo> resumen;
+    resumen.reserve(duraciones.size());
+    for (auto& [nombre, ms] : duraciones)
+    {
+        std::sort(ms.begin(), ms.end());
+        ResumenTramo r;
+        r.nombre   = nombre;
+        r.llamadas = static_cast<long long>(ms.size());
+        for (double v : ms) r.msTotal += v;
+        r.p50 = Percentil(ms, 0.50);
+        r.p90 = Percentil(ms, 0.90);
+        r.p99 = Percentil(ms, 0.99);
+        r.max = ms.back();
+        resumen.push_back(std::move(r));
+    }
+    std::sort(resumen.begin(), resumen.end(),
+              [](const ResumenTramo& a, const ResumenTramo& b) { return a.msTotal > b.msTotal; });
+    return resumen;
+}
+
+long long TramosDescartados()
+{
+    std::lock_guard<std::mutex> lock(mtxRegistro);
+    const unsigned generacion = generacionActual.load();
+    long long descartados = 0;
+    for (const auto& b : buffers)
+    {
+        if (b->generacion.load() != generacion) continue;
+        const unsigned long long escritos = b->escritos.load();
+        if (escritos > b->eventos.size()) descartados += static_cast<long long>(escritos - b->eventos.size());
+    }
+    return descartados;
+}
+
+bool ExportarTrazaChrome(const std::string& ruta)
+{
+    const fs::path rutaFinal{ ruta };
+    const fs::path rutaTmp = rutaFinal.string() + ".tmp";
+    std::error_code ec;
+    if (rutaFinal.has_parent_path()) fs::create_directories(rutaFinal.parent_path(), ec);
+
+    {
+        std::ofstream out(rutaTmp, std::ios::trunc);
+        if (!out) {
+            std::cerr << "[ERROR] No se pudo escribir la traza en '" << rutaTmp.string() << "'.\n";
+            return false;
+        }
+
+        // Tiempos en microsegundos desde IniciarTraza, como espera el formato de Chrome
+        std::lock_guard<std::mutex> lock(mtxRegistro);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool primero = true;
+        char linea[256];
+        for (const auto& b : buffers)
+        {
+            if (b->generacion.load() != generacionActual.load()) continue;
+            std::snprintf(linea, sizeof(linea),
+                          "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"hilo %d\"}}",
+                          primero ? "" : ",\n", b->tid, b->tid);
+            out << linea;
+            primero = false;
+        }
+        RecorrerEventos([&](const BufferHilo& b, const Evento& e) {
+            const double ts  = (e.inicioNs - origenNs) / 1e3;
+            if (e.contador) {
+                std::snprintf(linea, sizeof(linea),
+                              "%s{\"ph\":\"C\",\"name\":\"%s\",\"pid\":1,\"ts\":%.3f,\"args\":{\"MB\":%.3f}}",
+                              primero ? "" : ",\n", e.nombre, ts, e.finNs / (1024.0 * 1024.0));
+                out << linea;
+                primero = false;
+                return;
+            }
+            const double dur = (e.finNs - e.inicioNs) / 1e3;
+            int n = std::snprintf(linea, sizeof(linea),
+                                  "%s{\"ph\":\"X\",\"cat\":\"rm\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                                  primero ? "" : ",\n", e.nombre, b.tid, ts, dur);
+            if (e.arg >= 0 && n > 0 && n < static_cast<int>(sizeof(linea)))
+                std::snprintf(linea + n, sizeof(linea) - n, ",\"args\":{\"slice\":%d}", e.arg);
+            out << linea << "}";
+            primero = false;
+        });
+        out << "\n]}\n";
+        if (!out) {
+            std::cerr << "[ERROR] Falló la escritura de la traza en '" << rutaTmp.string() << "'.\n";
+            return false;
+        }
+    }
+
+    fs::rename(rutaTmp, rutaFinal, ec);
+    if (ec) {
+        std::cerr << "[ERROR] No se pudo mover la traza a '" << ruta << "': " << ec.message() << "\n";
+        return false;
+    }
+    return true;
+}
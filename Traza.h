@@ -0,0 +1,108 @@
+// Traza.h
+#ifndef TRAZA_H
+#define TRAZA_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * Traza de tramos (ámbitos con nombre) del pipeline, para ver en qué se va el
+ * tiempo de una ejecución: se exporta en el formato JSON de Chrome / Perfetto
+ * (chrome://tracing, ui.perfetto.dev) y se resume en percentiles por tramo.
+ *
+ * Cada hilo escribe sus tramos en su propio búfer circular, sin locks: si una
+ * ejecución genera más tramos que la capacidad, se conservan los más recientes.
+ * Con la traza desactivada, un TramoTraza sólo lee un atómico.
+ *
+ * ResumirTraza y ExportarTrazaChrome deben llamarse cuando ya no hay tramos en
+ * curso (p. ej. al volver de ProcesarTodosSlices, con sus hilos ya terminados).
+ */
+
+/**
+ * Descarta la traza anterior y empieza a registrar.
+ * @param eventosPorHilo Capacidad del búfer circular de cada hilo.
+ */
+void IniciarTraza(size_t eventosPorHilo = size_t(1) << 16);
+
+/**
+ * Deja de registrar; lo registrado sigue disponible para resumir o exportar.
+ */
+void DetenerTraza();
+
+namespace detalle {
+extern std::atomic<bool> trazaActiva;
+void RegistrarTramo(const char* nombre, long long inicioNs, long long finNs, int arg);
+long long AhoraNs();
+}
+
+inline bool TrazaActiva()
+{
+    return detalle::trazaActiva.load(std::memory_order_relaxed);
+}
+
+/**
+ * Registra su ámbito como un tramo de la traza (si está activa).
+ * 'nombre' debe ser un literal: se guarda el puntero, no una copia.
+ * 'arg' (opcional, >= 0) acompaña al tramo; en los slices es el índice del plano.
+ */
+class TramoTraza
+{
+public:
+    explicit TramoTraza(const char* nombre, int arg = -1)
+        : nombre(TrazaActiva() ? nombre : nullptr), arg(arg)
+    {
+        if (this->nombre) inicioNs = detalle::AhoraNs();
+    }
+
+    ~TramoTraza()
+    {
+        if (nombre) detalle::RegistrarTramo(nombre, inicioNs, detalle::AhoraNs(), arg);
+    }
+
+    TramoTraza(const TramoTraza&) = delete;
+    TramoTraza& operator=(const TramoTraza&) = delete;
+
+private:
+    const char* nombre;
+    int arg;
+    long long inicioNs = 0;
+};
+
+/**
+ * Registra el valor de un contador en este instante (si la traza está activa);
+ * Chrome lo dibuja como una serie en el tiempo. No entra en ResumirTraza.
+ * 'nombre' debe ser un literal, como en TramoTraza.
+ */
+void RegistrarContadorTraza(const char* nombre, long long valor);
+
+/**
+ * Percentiles de duración de un tramo (en ms) en la traza registrada.
+ */
+struct ResumenTramo
+{
+    std::string nombre;
+    long long llamadas = 0;
+    double msTotal = 0.0;             // sumado entre hilos
+    double p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+};
+
+/**
+ * Un resumen por nombre de tramo, ordenados por msTotal de mayor a menor.
+ */
+std::vector<ResumenTramo> ResumirTraza();
+
+/**
+ * Tramos que se perdieron porque algún búfer circular se llenó (0 = traza completa).
+ */
+long long TramosDescartados();
+
+/**
+ * Escribe la traza registrada como JSON de Chrome (eventos "X", un tid por hilo;
+ * los contadores, como eventos "C" en MB).
+ * @return false si no se pudo escribir el archivo.
+ */
+bool ExportarTrazaChrome(const std::string& ruta);
+
+#endif // TRAZA_H
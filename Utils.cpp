@@ -4,10 +4,41 @@
 #include <opencv2/core.hpp>       // para cv::Mat
 #include <opencv2/imgcodecs.hpp>  // para cv::imwrite
 #include "Filtros.h"              // para ITKImage2DtoCVMat, ITKMask2BinCVMat, ProcesarYGuardarSlice
+#include "Manifiesto.h"
+#include "VideoMJPG.h"           // para CodificarVideoMJPG
+#include "CacheResultados.h"     // para CalcularHuella y ClaveResultados
+#include "ArenaMat.h"             // para ArenaMat y CopiarFueraDeArena
+#include "Perfil.h"               // para MedirEtapa, PerfilEnHilo y TramoTraza
+#include "Memoria.h"              // para SumarMemoria, LeerMemoria y MuestrearMemoriaEnTraza
+#include "MascaraCompacta.h"      // para VolumenMascaraCompacta
+#include "Filtros3D.h"            // para el modo 3D (AplicarFiltro3D, AperturaCierre3D)
+#include "Segmentacion3D.h"       // para el filtro 9 en modo 3D (SegmentarWatershed3D)
 #include <opencv2/opencv.hpp>
 #include <filesystem>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Crea carpetaVideo (si no existe) y devuelve la ruta de "highlighted_video.avi"
+static bool PrepararRutaVideo(const std::string& carpetaVideo, std::string& salidaVideo)
+{
+    fs::path pathV = carpetaVideo;
+    try {
+        fs::create_directories(pathV);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[ERROR] No se pudo crear carpeta '" << carpetaVideo
+                  << "': " << e.what() << "\n";
+        return false;
+    }
+    salidaVideo = (pathV / "highlighted_video.avi").string();
+    return true;
+}
 
 bool GenerarVideoHighlighted(
     const std::string& carpetaHighlighted,
@@ -16,8 +47,6 @@ bool GenerarVideoHighlighted(
     int fin
 )
 {
-    namespace fs = std::filesystem;
-
     // 1) Verificar que carpetaHighlighted exista y sea directorio
     fs::path pathH = carpetaHighlighted;
     if (!fs::exists(pathH) || !fs::is_directory(pathH)) {
@@ -25,27 +54,20 @@ bool GenerarVideoHighlighted(
         return false;
     }
 
-    // 2) Recorrer todos los archivos dentro de carpetaHighlighted y guardar rutas de imágenes
-    std::vector<fs::path> listaImagenes;
-    for (auto const& entry : fs::directory_iterator(pathH)) {
-        if (!entry.is_regular_file()) continue;
-        std::string ext = entry.path().extension().string();
-        // Convertimos la extensión a minúsculas
-        for (auto& c : ext) c = static_cast<char>(tolower(c));
-        if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" ||
-            ext == ".bmp" || ext == ".tif" || ext == ".tiff")
-        {
-            listaImagenes.push_back(entry.path());
-        }
-    }
-
-    if (listaImagenes.empty()) {
-        std::cerr << "[ERROR] No se encontraron imágenes en '" << carpetaHighlighted << "'.\n";
+    // 2) Leer el manifiesto de la ejecución (está en la carpeta padre de highlighted/)
+    fs::path pathBase = pathH.has_filename() ? pathH.parent_path() : pathH.parent_path().parent_path();
+    ManifiestoResultados manifiesto;
+    if (!LeerManifiesto(pathBase.string(), manifiesto) || manifiesto.NumSlices() == 0) {
+        std::cerr << "[ERROR] No hay manifiesto de resultados en '" << pathBase.string() << "'.\n";
         return false;
     }
 
-    // 3) Ordenar alfabéticamente (para asegurar la secuencia correcta de slices)
-    std::sort(listaImagenes.begin(), listaImagenes.end());
+    // 3) Las rutas salen del manifiesto, ya en el orden de los slices
+    std::vector<fs::path> listaImagenes;
+    listaImagenes.reserve(manifiesto.archivos.size());
+    for (const auto& nombre : manifiesto.archivos) {
+        listaImagenes.push_back(pathH / nombre);
+    }
 
     // 4) Validar rangos (revisados ya en main, pero por seguridad):
     int total = static_cast<int>(listaImagenes.size());
@@ -55,114 +77,392 @@ bool GenerarVideoHighlighted(
         return false;
     }
 
-    // 5) Leer la imagen en la posición 'inicio' para obtener dimensiones (asumimos todas iguales)
-    cv::Mat primera = cv::imread(listaImagenes[inicio - 1].string());
-    if (primera.empty()) {
-        std::cerr << "[ERROR] No se pudo leer la imagen: "
-                  << listaImagenes[inicio - 1] << "\n";
+    // 5) Crear carpetaVideo y construir la ruta del AVI
+    std::string salidaVideo;
+    if (!PrepararRutaVideo(carpetaVideo, salidaVideo)) return false;
+
+    // 6) Leer (decodificar PNG) y codificar MJPG en paralelo; se escriben en orden
+    const int fps = 10;
+    bool ok = CodificarVideoMJPG(
+        fin - inicio + 1,
+        [&](int k) {
+            const fs::path& ruta = listaImagenes[inicio - 1 + k];
+            cv::Mat frame;
+            {
+                MedirEtapa medir(Etapa::Lectura);
+                frame = cv::imread(ruta.string());
+            }
+            if (frame.empty()) {
+                std::cerr << "[WARNING] Saltando imagen no leída: " << ruta << "\n";
+            }
+            return frame;
+        },
+        salidaVideo,
+        fps
+    );
+    if (!ok) {
+        std::cerr << "[ERROR] No se pudo generar el video en: " << salidaVideo << "\n";
         return false;
     }
-    int altura = primera.rows;
-    int ancho  = primera.cols;
 
-    // 6) Crear carpetaVideo si no existe
-    fs::path pathV = carpetaVideo;
-    try {
-        fs::create_directories(pathV);
-    }
-    catch (const std::exception& e) {
-        std::cerr << "[ERROR] No se pudo crear carpeta '" << carpetaVideo
-                  << "': " << e.what() << "\n";
+    std::cout << "[INFO] Video guardado en: " << salidaVideo << "\n";
+    return true;
+}
+
+bool GenerarVideoDesdeFrames(
+    const std::vector<cv::Mat>& frames,
+    const std::string& carpetaVideo,
+    int inicio,
+    int fin
+)
+{
+    int total = static_cast<int>(frames.size());
+    if (inicio < 1 || fin < inicio || fin > total) {
+        std::cerr << "[ERROR] Rangos inválidos: inicio=" << inicio << ", fin=" << fin
+                  << ". Debe ser 1 ≤ inicio ≤ fin ≤ " << total << ".\n";
         return false;
     }
 
-    // 7) Configurar VideoWriter
-    std::string salidaVideo = (pathV / "highlighted_video.avi").string();
-    int fps = 10;
-    cv::VideoWriter writer;
-    writer.open(salidaVideo,
-                cv::VideoWriter::fourcc('M','J','P','G'),
-                fps,
-                cv::Size(ancho, altura),
-                true  // true = color
+    std::string salidaVideo;
+    if (!PrepararRutaVideo(carpetaVideo, salidaVideo)) return false;
+
+    // Los frames ya están decodificados: sólo se codifica JPEG (en paralelo)
+    const int fps = 10;
+    bool ok = CodificarVideoMJPG(
+        fin - inicio + 1,
+        [&](int k) { return frames[inicio - 1 + k]; },
+        salidaVideo,
+        fps
     );
-    if (!writer.isOpened()) {
-        std::cerr << "[ERROR] No se pudo abrir VideoWriter en: " << salidaVideo << "\n";
+    if (!ok) {
+        std::cerr << "[ERROR] No se pudo generar el video en: " << salidaVideo << "\n";
         return false;
     }
 
-    // 8) Recorrer las imágenes desde (inicio-1) hasta (fin-1) y escribirlas como fotogramas
-    for (int idx = inicio - 1; idx <= fin - 1; ++idx) {
-        cv::Mat frame = cv::imread(listaImagenes[idx].string());
-        if (frame.empty()) {
-            std::cerr << "[WARNING] Saltando imagen no leída: " << listaImagenes[idx] << "\n";
-            continue;
-        }
-        // Si difiere de tamaño, redimensionar
-        if (frame.rows != altura || frame.cols != ancho) {
-            cv::resize(frame, frame, cv::Size(ancho, altura));
-        }
-        writer.write(frame);
+    std::cout << "[INFO] Video guardado en: " << salidaVideo << "\n";
+    return true;
+}
+
+// Lee sólo la cabecera del NIfTI; nullptr si no se pudo
+static itk::NiftiImageIO::Pointer LeerCabeceraNifti(const std::string& rutaNifti)
+{
+    auto niftiIO = itk::NiftiImageIO::New();
+    niftiIO->SetFileName(rutaNifti);
+    try
+    {
+        niftiIO->ReadImageInformation();
     }
+    catch (itk::ExceptionObject& err)
+    {
+        std::cerr << "[ERROR] Leyendo cabecera NIfTI '" << rutaNifti << "': " << err << "\n";
+        return nullptr;
+    }
+    if (niftiIO->GetNumberOfDimensions() < 3) return nullptr;
+    return niftiIO;
+}
 
-    // 9) Liberar recursos (cierra el archivo AVI)
-    writer.release();
+// Tipo en el que se procesa cada tipo de componente del NIfTI
+static TipoPixelVolumen TipoParaComponente(itk::ImageIOBase::IOComponentEnum componente)
+{
+    switch (componente) {
+        case itk::ImageIOBase::UCHAR:  return TipoPixelVolumen::UInt8;
+        case itk::ImageIOBase::CHAR:
+        case itk::ImageIOBase::SHORT:  return TipoPixelVolumen::Int16;
+        case itk::ImageIOBase::USHORT: return TipoPixelVolumen::UInt16;
+        default:                       return TipoPixelVolumen::Float32;
+    }
+}
 
-    std::cout << "[INFO] Video guardado en: " << salidaVideo << "\n";
-    return true;
+static size_t BytesPixel(TipoPixelVolumen tipo)
+{
+    switch (tipo) {
+        case TipoPixelVolumen::UInt8:   return 1;
+        case TipoPixelVolumen::Int16:
+        case TipoPixelVolumen::UInt16:  return 2;
+        case TipoPixelVolumen::Float32:
+        default:                        return 4;
+    }
+}
+
+const char* NombreTipoPixelVolumen(TipoPixelVolumen tipo)
+{
+    switch (tipo) {
+        case TipoPixelVolumen::UInt8:   return "uint8";
+        case TipoPixelVolumen::UInt16:  return "uint16";
+        case TipoPixelVolumen::Float32: return "float32";
+        case TipoPixelVolumen::Int16:
+        default:                        return "int16";
+    }
 }
 
+int VolumenNifti::TipoCv() const
+{
+    switch (tipo) {
+        case TipoPixelVolumen::UInt8:   return CV_8U;
+        case TipoPixelVolumen::UInt16:  return CV_16U;
+        case TipoPixelVolumen::Float32: return CV_32F;
+        case TipoPixelVolumen::Int16:
+        default:                        return CV_16S;
+    }
+}
 
-bool ProcesarTodosSlices(
-    const std::string& rutaNifti,
-    const std::string& rutaMask,
-    const std::string& carpetaSalidaBase,
-    int filterOption
-)
+long long VolumenNifti::Bytes() const
 {
-    // Tipos de reader 3D de ITK
-    using ReaderType3D = itk::ImageFileReader<ImageType3D>;
+    return static_cast<long long>(nx) * ny * nz * static_cast<long long>(BytesPixel(tipo));
+}
 
-    // --- 1) Leer volumen de imagen ---
-    ReaderType3D::Pointer readerImg = ReaderType3D::New();
-    auto niftiIOImg = itk::NiftiImageIO::New();
-    readerImg->SetImageIO(niftiIOImg);
-    readerImg->SetFileName(rutaNifti);
+// Lee el NIfTI como itk::Image<T, 3> con el ImageIO dado (si T es el tipo del archivo,
+// ITK no hace pasada de conversión)
+template <class T>
+static typename itk::Image<T, Dimension3D>::Pointer LeerImagenNifti(
+    const std::string& rutaNifti, itk::ImageIOBase* imageIO, const char* descripcion)
+{
+    using ImagenT = itk::Image<T, Dimension3D>;
+    using ReaderT = itk::ImageFileReader<ImagenT>;
+    typename ReaderT::Pointer reader = ReaderT::New();
+    reader->SetImageIO(imageIO);
+    reader->SetFileName(rutaNifti);
 
+    MedirEtapa medir(Etapa::Lectura);
     try
     {
-        readerImg->Update();
+        reader->Update();
     }
     catch (itk::ExceptionObject& err)
     {
-        std::cerr << "[ERROR] Leyendo NIfTI imagen '" << rutaNifti << "': "
+        std::cerr << "[ERROR] Leyendo NIfTI " << descripcion << " '" << rutaNifti << "': "
                   << err << "\n";
+        return nullptr;
+    }
+
+    // El buffer se descuenta cuando ITK destruye la imagen (la suelte quien la suelte: caché, precarga...)
+    typename ImagenT::Pointer imagen = reader->GetOutput();
+    const long long bytes = static_cast<long long>(imagen->GetPixelContainer()->Size() * sizeof(T));
+    SumarMemoria(CategoriaMemoria::Volumenes, bytes);
+    imagen->AddObserver(itk::DeleteEvent(), [bytes](const itk::EventObject&) {
+        SumarMemoria(CategoriaMemoria::Volumenes, -bytes);
+    });
+    return imagen;
+}
+
+template <class T>
+static bool LeerVolumenComo(const std::string& rutaNifti, itk::ImageIOBase* imageIO,
+                            const char* descripcion, VolumenNifti& vol)
+{
+    auto imagen = LeerImagenNifti<T>(rutaNifti, imageIO, descripcion);
+    if (!imagen) return false;
+
+    auto size3D  = imagen->GetLargestPossibleRegion().GetSize();
+    auto spacing = imagen->GetSpacing();
+    vol.imagen = imagen.GetPointer();
+    vol.datos  = imagen->GetBufferPointer();
+    vol.nx = static_cast<int>(size3D[0]);
+    vol.ny = static_cast<int>(size3D[1]);
+    vol.nz = static_cast<int>(size3D[2]);
+    for (int d = 0; d < 3; ++d) vol.espaciado[d] = spacing[d];
+    return true;
+}
+
+VolumenNifti LeerVolumenNiftiNativo(const std::string& rutaNifti, const char* descripcion)
+{
+    VolumenNifti vol;
+    auto niftiIO = LeerCabeceraNifti(rutaNifti);
+    if (!niftiIO) return vol;
+
+    vol.tipo = TipoParaComponente(niftiIO->GetComponentType());
+    bool ok = false;
+    switch (vol.tipo) {
+        case TipoPixelVolumen::UInt8:   ok = LeerVolumenComo<unsigned char>(rutaNifti, niftiIO, descripcion, vol);  break;
+        case TipoPixelVolumen::Int16:   ok = LeerVolumenComo<short>(rutaNifti, niftiIO, descripcion, vol);          break;
+        case TipoPixelVolumen::UInt16:  ok = LeerVolumenComo<unsigned short>(rutaNifti, niftiIO, descripcion, vol); break;
+        case TipoPixelVolumen::Float32: ok = LeerVolumenComo<float>(rutaNifti, niftiIO, descripcion, vol);          break;
+    }
+    return ok ? vol : VolumenNifti();
+}
+
+bool CalcularEstadisticasNifti(
+    const VolumenNifti& imagen,
+    const VolumenNifti* mascara,
+    EstadisticasVolumen& resultado,
+    int numHilos
+)
+{
+    if (!imagen) return false;
+
+    if (mascara && !mascara->MismoTamano(imagen))
+    {
+        std::cerr << "[ERROR] La máscara (" << mascara->nx << "x" << mascara->ny << "x" << mascara->nz
+                  << ") no tiene el tamaño de la imagen (" << imagen.nx << "x" << imagen.ny << "x"
+                  << imagen.nz << ").\n";
         return false;
     }
-    auto image3D = readerImg->GetOutput();
 
-    // --- 2) Leer volumen de máscara ---
-    using ReaderTypeMask3D = itk::ImageFileReader<ImageType3D>;
-    ReaderTypeMask3D::Pointer readerMask = ReaderTypeMask3D::New();
-    auto niftiIOMask = itk::NiftiImageIO::New();
-    readerMask->SetImageIO(niftiIOMask);
-    readerMask->SetFileName(rutaMask);
+    resultado = CalcularEstadisticasVolumen(
+        imagen.datos, imagen.TipoCv(),
+        mascara ? mascara->datos : nullptr, mascara ? mascara->TipoCv() : CV_8U,
+        imagen.nx, imagen.ny, imagen.nz,
+        imagen.espaciado,
+        numHilos
+    );
+    return true;
+}
 
-    try
+// Tamaño de los slices de salida: en coronal/sagital las filas son z y se
+// reescalan para respetar el espaciado físico
+static cv::Size TamSalidaPlanos(const VolumenNifti& imagen, const VolumenOrtogonal& vol, Orientacion orientacion)
+{
+    const double* spacing = imagen.espaciado;
+    double escalaFilas = 1.0;
+    if (orientacion == Orientacion::Coronal && spacing[0] > 0)
+        escalaFilas = spacing[2] / spacing[0];
+    else if (orientacion == Orientacion::Sagital && spacing[1] > 0)
+        escalaFilas = spacing[2] / spacing[1];
+
+    cv::Size tam = vol.TamPlano(orientacion);
+    if (std::abs(escalaFilas - 1.0) > 1e-3) {
+        tam.height = std::max(1, static_cast<int>(std::lround(tam.height * escalaFilas)));
+    }
+    return tam;
+}
+
+// Plano de imagen (en su tipo nativo) a 8 bits y etiquetas de la máscara (CV_8U), al tamaño
+// de salida, con la máscara binaria que sale de las etiquetas
+static void PlanoA8Bits(const cv::Mat& plano, const cv::Mat& etiquetas, const cv::Size& tamSalida,
+                        cv::Mat& matSlice, cv::Mat& matMask, cv::Mat& matEtiquetas)
+{
+    matSlice     = Normalizar16a8(plano);
+    matEtiquetas = etiquetas;
+    if (matSlice.size() != tamSalida)
     {
-        readerMask->Update();
+        cv::resize(matSlice,     matSlice,     tamSalida, 0, 0, cv::INTER_LINEAR);
+        cv::resize(matEtiquetas, matEtiquetas, tamSalida, 0, 0, cv::INTER_NEAREST);
     }
-    catch (itk::ExceptionObject& err)
+    matMask = BinarizarMascara(matEtiquetas);
+}
+
+// Máscara 0/255 y etiquetas de un plano compacto, al tamaño de salida. Si el plano sólo
+// tiene la etiqueta 1 (el caso binario), la máscara se expande directamente de los bits
+// o tramos y no se sacan etiquetas: ProcesarSlice pone entonces 1 en toda la ROI, que es
+// lo mismo, sin el plano de etiquetas ni su binarizado
+static void MascaraSalida(const PlanoMascaraCompacto& planoMascara, const cv::Size& tamSalida,
+                          cv::Mat& matMask, cv::Mat& matEtiquetas)
+{
+    const std::bitset<256>& presentes = planoMascara.EtiquetasPresentes();
+    if (presentes.none() || (presentes.count() == 1 && presentes.test(1)))
     {
-        std::cerr << "[ERROR] Leyendo NIfTI máscara '" << rutaMask << "': "
-                  << err << "\n";
+        matMask = planoMascara.Expandir();
+        matEtiquetas.release();
+        if (matMask.size() != tamSalida) cv::resize(matMask, matMask, tamSalida, 0, 0, cv::INTER_NEAREST);
+        return;
+    }
+    matEtiquetas = planoMascara.ExpandirEtiquetas();
+    if (matEtiquetas.size() != tamSalida)
+        cv::resize(matEtiquetas, matEtiquetas, tamSalida, 0, 0, cv::INTER_NEAREST);
+    matMask = BinarizarMascara(matEtiquetas);
+}
+
+// Plano 'indice' de un volumen del modo 3D (resultado del filtro o máscara refinada), al tamaño de salida
+static cv::Mat PlanoSalida3D(const VolumenOrtogonal& vol, Orientacion orientacion, int indice,
+                             const cv::Size& tamSalida, int interpolacion)
+{
+    cv::Mat plano = vol.ExtraerPlano(orientacion, indice);
+    if (plano.size() != tamSalida) cv::resize(plano, plano, tamSalida, 0, 0, interpolacion);
+    return plano;
+}
+
+cv::Mat ProcesarPlanoVolumen(
+    const VolumenNifti& imagen,
+    const VolumenNifti& mascara,
+    Orientacion orientacion,
+    int plano,
+    int filterOption
+)
+{
+    if (!imagen || !mascara || !imagen.MismoTamano(mascara)) return cv::Mat();
+
+    VolumenOrtogonal volImg(imagen.datos, imagen.TipoCv(), imagen.nx, imagen.ny, imagen.nz);
+    VolumenOrtogonal volMask(mascara.datos, mascara.TipoCv(), mascara.nx, mascara.ny, mascara.nz);
+    if (plano < 0 || plano >= volImg.NumPlanos(orientacion)) return cv::Mat();
+
+    // Un solo plano: sin PrepararOrientacion (la transposición sagital no compensa)
+    cv::Mat matSlice, matMask, matEtiquetas;
+    PlanoA8Bits(volImg.ExtraerPlano(orientacion, plano),
+                EtiquetasMascara(volMask.ExtraerPlano(orientacion, plano)),
+                TamSalidaPlanos(imagen, volImg, orientacion), matSlice, matMask, matEtiquetas);
+    return ProcesarSlice(matSlice, matMask, filterOption, nullptr, nullptr, &matEtiquetas);
+}
+
+bool ProcesarTodosSlices(
+    const std::string& rutaNifti,
+    const std::string& rutaMask,
+    const std::string& carpetaSalidaBase,
+    int filterOption,
+    const OpcionesProcesado& opciones
+)
+{
+    const Orientacion orientacion = opciones.orientacion;
+
+    // Los cv::Mat de la ejecución se cuentan por categoría (con o sin arenas)
+    InstalarAsignadorMat();
+
+    using Reloj = std::chrono::steady_clock;
+    auto msDesde = [](Reloj::time_point t0) {
+        return std::chrono::duration<double, std::milli>(Reloj::now() - t0).count();
+    };
+    const auto t0 = Reloj::now();
+
+    // Huellas de las entradas para la clave de los resultados (si los archivos no
+    // cambiaron, se reutilizan las del manifiesto anterior sin volver a leerlos)
+    ManifiestoResultados anterior;
+    LeerManifiesto(carpetaSalidaBase, anterior);
+    HuellaArchivo huellaImg, huellaMask;
+    bool huellasOk;
+    {
+        MedirEtapa medir(Etapa::Lectura);
+        huellasOk = CalcularHuella(rutaNifti, huellaImg, &anterior.huellaImagen) &&
+                    CalcularHuella(rutaMask, huellaMask, &anterior.huellaMascara);
+    }
+    if (!huellasOk)
+    {
+        std::cerr << "[ERROR] No se pudieron leer '" << rutaNifti << "' y '" << rutaMask << "'.\n";
         return false;
     }
-    auto mask3D = readerMask->GetOutput();
 
-    // --- 3) Obtener región y tamaño en Z ---
-    auto region3D = image3D->GetLargestPossibleRegion();
-    auto size3D   = region3D.GetSize(); // size3D[2] = número de slices en Z
+    // Un manifiesto anterior deja de ser válido en cuanto empieza otra ejecución
+    BorrarManifiesto(carpetaSalidaBase);
+    if (opciones.framesHighlighted) {
+        opciones.framesHighlighted->clear();
+    }
+
+    // --- 1) y 2) Leer volúmenes de imagen y máscara (salvo que ya vengan precargados) ---
+    VolumenNifti image3D = opciones.imagenPrecargada;
+    if (!image3D) image3D = LeerVolumenNiftiNativo(rutaNifti, "imagen");
+    if (!image3D) return false;
+    VolumenNifti mask3D = opciones.mascaraPrecargada;
+    if (!mask3D) mask3D = LeerVolumenNiftiNativo(rutaMask, "máscara");
+    if (!mask3D) return false;
+
+    ManifiestoResultados manifiesto;
+    manifiesto.rutaImagen  = rutaNifti;
+    manifiesto.rutaMascara = rutaMask;
+    manifiesto.filtro      = filterOption;
+    manifiesto.orientacion = NombreOrientacion(orientacion);
+    manifiesto.modo3D      = opciones.modo3D;
+    manifiesto.radioFiltro = opciones.radioFiltro;
+    manifiesto.huellaImagen  = huellaImg;
+    manifiesto.huellaMascara = huellaMask;
+    manifiesto.clave = ClaveResultados(huellaImg, huellaMask, filterOption, opciones);
+    manifiesto.msLectura   = msDesde(t0);
+    const auto tProcesado  = Reloj::now();
+
+    // --- 3) Obtener tamaño del volumen y comprobar que la máscara coincide ---
+    if (!image3D.MismoTamano(mask3D))
+    {
+        std::cerr << "[ERROR] La máscara (" << mask3D.nx << "x" << mask3D.ny << "x" << mask3D.nz
+                  << ") no tiene el tamaño de la imagen (" << image3D.nx << "x" << image3D.ny
+                  << "x" << image3D.nz << ").\n";
+        return false;
+    }
 
     // --- 4) Crear carpetas de salida: original, mask, highlighted ---
     fs::path outDirBase{ carpetaSalidaBase };
@@ -183,72 +483,321 @@ bool ProcesarTodosSlices(
         return false;
     }
 
-    // --- 5) Recorrer cada slice en Z ---
-    for (unsigned int z = 0; z < size3D[2]; ++z)
+    // --- 5) Vistas ortogonales sobre los buffers ITK (contiguos, x más rápido, tipo nativo) ---
+    // La máscara se empaqueta una sola vez por plano (bits o tramos, ver MascaraCompacta.h) y
+    // el volumen nativo se suelta aquí (salvo que lo retenga quien lo precargó)
+    VolumenOrtogonal volImg(image3D.datos, image3D.TipoCv(), image3D.nx, image3D.ny, image3D.nz);
+    std::unique_ptr<VolumenMascaraCompacta> mascaraCompacta;
     {
-        // ----- 5.1) Extraer slice de la imagen 3D -----
-        using ExtractFilterTypeImg = itk::ExtractImageFilter<ImageType3D, ImageType2D>;
-        ExtractFilterTypeImg::Pointer extractorImg = ExtractFilterTypeImg::New();
-        extractorImg->SetInput(image3D);
-
-        ImageType3D::RegionType desiredRegionImg = region3D;
-        ImageType3D::IndexType startImg = desiredRegionImg.GetIndex();
-        ImageType3D::SizeType sizeImg = desiredRegionImg.GetSize();
+        MedirEtapa medir(Etapa::Extraccion);
+        volImg.PrepararOrientacion(orientacion);
+        VolumenOrtogonal volMask(mask3D.datos, mask3D.TipoCv(), mask3D.nx, mask3D.ny, mask3D.nz);
+        mascaraCompacta = std::make_unique<VolumenMascaraCompacta>(volMask, orientacion);
+    }
+    std::cout << "[INFO] Máscara compacta: " << mascaraCompacta->Bytes() / 1024 << " KB ("
+              << mascaraCompacta->PlanosEnTramos() << " de " << mascaraCompacta->NumPlanos()
+              << " planos en tramos, " << mascaraCompacta->Etiquetas().count() << " etiquetas).\n";
+
+    // --- 5b) Modo 3D: la máscara se refina y el filtro (5, 7, 8, 9 ó 13) se aplica al volumen entero;
+    //         cada hilo saca después sus planos de estos volúmenes como de la imagen ---
+    Volumen8u procesado3D, mascaraRefinada3D;
+    VolumenEtiquetas etiquetas3D;
+    std::unique_ptr<VolumenOrtogonal> volProcesado3D, volMascara3D, volEtiquetas3D;
+    Orientacion orientacionProcesado3D = orientacion;     // de la que se sacan los planos de volProcesado3D
+    if (opciones.modo3D)
+    {
+        const auto t3D = Reloj::now();
+        {
+            MedirEtapa medir(Etapa::Filtro);
+            mascaraRefinada3D = AperturaCierre3D(BinarizarVolumen(
+                mask3D.datos, mask3D.TipoCv(), mask3D.nx, mask3D.ny, mask3D.nz, image3D.espaciado));
+            volMascara3D = std::make_unique<VolumenOrtogonal>(
+                mascaraRefinada3D.Datos(), CV_8U, image3D.nx, image3D.ny, image3D.nz);
+            volMascara3D->PrepararOrientacion(orientacion);
+
+            if (Filtro3DDisponible(filterOption)) {
+                Volumen8u volumen8 = NormalizarVolumenA8(image3D.datos, image3D.TipoCv(), image3D.nx,
+                                                         image3D.ny, image3D.nz, image3D.espaciado);
+                // El CLAHE ecualiza los slices de salida: en coronal o sagital se aplica al
+                // volumen reorientado, cuyos planos axiales son ya esos slices
+                if (Filtro3DPorOrientacion(filterOption) && orientacion != Orientacion::Axial) {
+                    volumen8 = ReorientarVolumen(volumen8, orientacion);
+                    orientacionProcesado3D = Orientacion::Axial;
+                }
+                procesado3D = AplicarFiltro3D(volumen8, filterOption);
+                volProcesado3D = std::make_unique<VolumenOrtogonal>(
+                    procesado3D.Datos(), CV_8U, procesado3D.Nx(), procesado3D.Ny(), procesado3D.Nz());
+                volProcesado3D->PrepararOrientacion(orientacionProcesado3D);
+            } else if (filterOption == 9) {
+                // Watershed volumétrico: las etiquetas (y sus colores) se mantienen de un slice al siguiente
+                std::vector<ComponenteConexa> regiones;
+                etiquetas3D = SegmentarWatershed3D(NormalizarVolumenA8(image3D.datos, image3D.TipoCv(), image3D.nx,
+                                                                       image3D.ny, image3D.nz, image3D.espaciado),
+                                                   &regiones);
+                volEtiquetas3D = std::make_unique<VolumenOrtogonal>(
+                    etiquetas3D.Datos(), CV_32S, image3D.nx, image3D.ny, image3D.nz);
+                volEtiquetas3D->PrepararOrientacion(orientacion);
+                if (!GuardarComponentesCsv(regiones, image3D.espaciado, (outDirBase / kNombreComponentes3D).string()))
+                    return false;
+                manifiesto.archivoComponentes = kNombreComponentes3D;
+                std::cout << "[INFO] Modo 3D: " << etiquetas3D.NumEtiquetas() << " regiones (" << kNombreComponentes3D
+                          << ").\n";
+            }
+        }
+        const bool filtro3D = volProcesado3D || volEtiquetas3D;
+        std::cout << "[INFO] Modo 3D: máscara refinada" << (filtro3D ? " y filtro aplicados" : " aplicada")
+                  << " al volumen en " << static_cast<long long>(msDesde(t3D)) << " ms"
+                  << (filtro3D ? "" : " (el filtro no tiene versión 3D: se aplica por slice)") << ".\n";
+    }
+    mask3D = VolumenNifti();
+    MuestrearMemoriaEnTraza();
+
+    // --- 6) Rango de planos a procesar y tamaño de cada slice de salida ---
+    const int numPlanos = volImg.NumPlanos(orientacion);
+    const int planoIni  = std::max(0, opciones.planoInicio);
+    const int planoFin  = (opciones.planoFin < 0) ? numPlanos - 1
+                                                  : std::min(opciones.planoFin, numPlanos - 1);
+    if (planoIni > planoFin)
+    {
+        std::cerr << "[ERROR] Rango de planos vacío: [" << opciones.planoInicio << ", "
+                  << opciones.planoFin << "] con " << numPlanos << " planos.\n";
+        return false;
+    }
+    const int numSalida = planoFin - planoIni + 1;
 
-        startImg[2] = z;
-        sizeImg[2]  = 0;
-        desiredRegionImg.SetIndex(startImg);
-        desiredRegionImg.SetSize(sizeImg);
+    const cv::Size tamSalida = TamSalidaPlanos(image3D, volImg, orientacion);
+    manifiesto.ancho = tamSalida.width;
+    manifiesto.alto  = tamSalida.height;
 
-        extractorImg->SetExtractionRegion(desiredRegionImg);
-        extractorImg->SetDirectionCollapseToIdentity();
+    if (opciones.framesHighlighted) {
+        opciones.framesHighlighted->assign(numSalida, cv::Mat());
+    }
 
-        try
-        {
-            extractorImg->Update();
-        }
-        catch (itk::ExceptionObject& err)
+    int numHilos = opciones.numHilos > 0 ? opciones.numHilos
+                                         : static_cast<int>(std::thread::hardware_concurrency());
+    numHilos = std::max(1, std::min(numHilos, numSalida));
+
+    // --- 7) Video en streaming: se escribe a medida que salen los frames. Un hilo que va
+    //        más de 2 frames por hilo por delante del siguiente a escribir espera ---
+    const int videoIni = std::max(planoIni, opciones.videoInicio);
+    const int videoFin = (opciones.videoFin < 0) ? planoFin : std::min(opciones.videoFin, planoFin);
+    EscritorAviMjpg escritorVideo;
+    std::unique_ptr<ReordenadorFramesAvi> reordenador;
+    if (!opciones.rutaVideo.empty() && videoIni <= videoFin)
+    {
+        fs::path rutaVideo{ opciones.rutaVideo };
+        std::error_code ec;
+        if (rutaVideo.has_parent_path()) fs::create_directories(rutaVideo.parent_path(), ec);
+        if (!escritorVideo.Abrir(opciones.rutaVideo, tamSalida.width, tamSalida.height, opciones.fpsVideo))
         {
-            std::cerr << "[ERROR] Extrayendo slice Z=" << z << " de imagen: "
-                      << err << "\n";
-            continue; // pasa al siguiente slice
+            std::cerr << "[ERROR] No se pudo abrir el video en: " << opciones.rutaVideo << "\n";
+            return false;
         }
-        auto sliceImg2D = extractorImg->GetOutput();
-        cv::Mat matSlice = ITKImage2DtoCVMat(sliceImg2D);
+        reordenador = std::make_unique<ReordenadorFramesAvi>(escritorVideo, videoIni, 2 * numHilos);
+    }
+
+    // Resúmenes por slice (opcionales); área de un píxel del plano original en mm²
+    std::vector<ResumenSlice> resumenes;
+    if (opciones.recolectarEstadisticas) resumenes.resize(numSalida);
+    const double* spacing = image3D.espaciado;
+    double areaPixelMm2 = spacing[0] * spacing[1];
+    if (orientacion == Orientacion::Coronal)      areaPixelMm2 = spacing[0] * spacing[2];
+    else if (orientacion == Orientacion::Sagital) areaPixelMm2 = spacing[1] * spacing[2];
 
-        // ----- 5.2) Extraer slice de la máscara 3D -----
-        using ExtractFilterTypeMask = itk::ExtractImageFilter<ImageType3D, ImageType2D>;
-        ExtractFilterTypeMask::Pointer extractorMask2D = ExtractFilterTypeMask::New();
-        extractorMask2D->SetInput(mask3D);
+    // --- 8) Procesar los planos en paralelo (cada hilo toma el siguiente índice libre) ---
+    std::atomic<int> siguiente{ planoIni };
+    std::atomic<bool> huboError{ false };
 
-        ImageType3D::RegionType desiredRegionMask = region3D;
-        ImageType3D::IndexType startMask = desiredRegionMask.GetIndex();
-        ImageType3D::SizeType sizeMask = desiredRegionMask.GetSize();
+    // Los temporales de cada slice salen de una arena por hilo que se reinicia entre
+    // slices: en régimen estable el filtrado no pide memoria al heap
+    std::mutex mtxContadores;
+    ContadoresArena contadoresArena;
 
-        startMask[2] = z;
-        sizeMask[2]  = 0;
-        desiredRegionMask.SetIndex(startMask);
-        desiredRegionMask.SetSize(sizeMask);
+    // Los hilos de trabajo miden en el perfil del hilo que llama (si lo hay)
+    PerfilEtapas* perfil = PerfilActivo();
 
-        extractorMask2D->SetExtractionRegion(desiredRegionMask);
-        extractorMask2D->SetDirectionCollapseToIdentity();
+    auto trabajador = [&]() {
+        PerfilEnHilo perfilHilo(perfil);
+        std::unique_ptr<ArenaMat> arena;
+        if (opciones.usarArena) arena = std::make_unique<ArenaMat>();
 
-        try
+        for (int i = siguiente++; i <= planoFin; i = siguiente++)
         {
-            extractorMask2D->Update();
+            if (arena) arena->Reiniciar();      // los Mat del slice anterior ya se destruyeron
+            TramoTraza tramoSlice("slice", i);
+            cv::Mat highlighted;
+            try
+            {
+                // ----- 8.1) Extraer plano de imagen y máscara y convertir a 8 bits -----
+                const PlanoMascaraCompacto& planoMascara = mascaraCompacta->Plano(i);
+                cv::Mat plano;
+                {
+                    MedirEtapa medir(Etapa::Extraccion);
+                    plano = volImg.ExtraerPlano(orientacion, i);
+                }
+                cv::Mat matSlice, matMask, matEtiquetas;
+                PlanosFiltrados3D filtrados3D;
+                {
+                    MedirEtapa medir(Etapa::Conversion);
+                    matSlice = Normalizar16a8(plano);
+                    if (matSlice.size() != tamSalida) cv::resize(matSlice, matSlice, tamSalida, 0, 0, cv::INTER_LINEAR);
+                    MascaraSalida(planoMascara, tamSalida, matMask, matEtiquetas);
+                    if (volMascara3D) {
+                        filtrados3D.maskRefinada = PlanoSalida3D(*volMascara3D, orientacion, i, tamSalida,
+                                                                 cv::INTER_NEAREST);
+                    }
+                    if (volProcesado3D) {
+                        filtrados3D.processed = PlanoSalida3D(*volProcesado3D, orientacionProcesado3D, i, tamSalida,
+                                                              cv::INTER_LINEAR);
+                    }
+                    if (volEtiquetas3D) {
+                        filtrados3D.processed = ColorearEtiquetas(PlanoSalida3D(*volEtiquetas3D, orientacion, i,
+                                                                                tamSalida, cv::INTER_NEAREST));
+                    }
+                }
+
+                // ----- 8.2) Procesar Y GUARDAR, aplicando solo el filtro elegido (filterOption) -----
+                cv::Mat processed;
+                AreasEtiquetas areas{};
+                highlighted = ProcesarYGuardarSlice(matSlice, matMask, dirOrig, dirMaskOut, dirHigh,
+                                                    static_cast<unsigned int>(i), filterOption,
+                                                    opciones.recolectarEstadisticas ? &processed : nullptr,
+                                                    &matEtiquetas,
+                                                    opciones.recolectarEstadisticas ? &areas : nullptr,
+                                                    opciones.modo3D ? &filtrados3D : nullptr,
+                                                    opciones.radioFiltro);
+
+                // ----- 8.3) Resumen del slice con los datos que ya están en caché -----
+                if (opciones.recolectarEstadisticas) {
+                    ResumenSlice& r = resumenes[i - planoIni];
+                    r = ResumirSlice(i, plano, planoMascara.Bits(), matSlice, processed, areaPixelMm2);
+
+                    // Áreas por etiqueta contadas al componer, sobre el slice de salida
+                    const double areaPixelSalidaMm2 = areaPixelMm2 * static_cast<double>(plano.total())
+                                                    / static_cast<double>(matSlice.total());
+                    for (int e = 1; e < 256; ++e)
+                        if (areas[e] > 0) r.areasEtiquetasMm2.emplace_back(e, areas[e] * areaPixelSalidaMm2);
+                }
+
+                if (opciones.framesHighlighted) {
+                    (*opciones.framesHighlighted)[i - planoIni] =
+                        arena ? CopiarFueraDeArena(highlighted, CategoriaMemoria::Frames) : highlighted;
+                }
+            }
+            catch (const cv::Exception& e)
+            {
+                std::cerr << "[ERROR] Procesando plano " << i << ": " << e.what() << "\n";
+                huboError = true;
+            }
+            catch (const std::exception& e)   // bad_alloc, filesystem_error... no deben salir del hilo
+            {
+                std::cerr << "[ERROR] Procesando plano " << i << ": " << e.what() << "\n";
+                huboError = true;
+            }
+            catch (...)
+            {
+                std::cerr << "[ERROR] Procesando plano " << i << ": excepción desconocida\n";
+                huboError = true;
+            }
+
+            // ----- 8.4) Codificar JPEG en este hilo y entregar al reordenador -----
+            // El índice se entrega siempre (vacío si falló), si no el video se quedaría esperándolo
+            if (reordenador && i >= videoIni && i <= videoFin)
+            {
+                std::vector<uchar> jpeg;
+                try
+                {
+                    if (!highlighted.empty() && !CodificarFrameJpeg(highlighted, jpeg)) jpeg.clear();
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "[ERROR] Codificando el frame " << i << ": " << e.what() << "\n";
+                    jpeg.clear();
+                    huboError = true;
+                }
+                reordenador->Entregar(i, std::move(jpeg));
+            }
+            MuestrearMemoriaEnTraza();
         }
-        catch (itk::ExceptionObject& err)
-        {
-            std::cerr << "[ERROR] Extrayendo slice Z=" << z << " de máscara: "
-                      << err << "\n";
-            continue;
+
+        if (arena) {
+            std::lock_guard<std::mutex> lock(mtxContadores);
+            contadoresArena += arena->Contadores();
+        }
+    };
+
+    std::vector<std::thread> hilos;
+    for (int h = 1; h < numHilos; ++h) hilos.emplace_back(trabajador);
+    trabajador();
+    for (auto& hilo : hilos) hilo.join();
+
+    if (reordenador)
+    {
+        const bool videoOk = reordenador->Ok() && escritorVideo.Cerrar();
+        if (!videoOk) {
+            std::cerr << "[ERROR] Falló la escritura del video: " << opciones.rutaVideo << "\n";
+            huboError = true;
+        } else {
+            manifiesto.rutaVideo = opciones.rutaVideo;
+            std::cout << "[INFO] Video guardado en: " << opciones.rutaVideo << "\n";
         }
-        auto sliceMask2D = extractorMask2D->GetOutput();
-        cv::Mat matMask = ITKMask2BinCVMat(sliceMask2D);
+    }
+    if (huboError) return false;
 
-        // ----- 5.3) Procesar Y GUARDAR, aplicando solo el filtro elegido (filterOption) -----
-        ProcesarYGuardarSlice(matSlice, matMask, dirOrig, dirMaskOut, dirHigh, z, filterOption);
+    for (int i = planoIni; i <= planoFin; ++i)
+    {
+        manifiesto.indices.push_back(i);
+        manifiesto.archivos.push_back(NombreArchivoSlice(static_cast<unsigned int>(i)));
     }
 
-    return true;
+    if (opciones.recolectarEstadisticas)
+    {
+        if (!GuardarResumenSlicesCsv(resumenes, (outDirBase / kNombreEstadisticasSlices).string()))
+            return false;
+        manifiesto.archivoEstadisticas = kNombreEstadisticasSlices;
+    }
+
+    if (opciones.usarArena)
+    {
+        manifiesto.asignacionesMat   = contadoresArena.asignaciones;
+        manifiesto.reservasHeapArena = contadoresArena.reservasHeap;
+        std::cout << "[INFO] Temporales cv::Mat: " << contadoresArena.asignaciones << " desde arenas ("
+                  << contadoresArena.bytes / (1024 * 1024) << " MB), " << contadoresArena.reservasHeap
+                  << " bloques pedidos al heap, " << contadoresArena.bloquesRetenidos << " retenidos.\n";
+    }
+
+    const EstadoMemoria memoria = LeerMemoria();
+    manifiesto.picoMemoria = memoria.picoTotal;
+    for (int c = 0; c < kNumCategoriasMemoria; ++c) manifiesto.picosMemoria[c] = memoria.picos[c];
+    std::cout << "[INFO] Pico de memoria: " << DescribirMemoria(memoria, true) << "\n";
+    MuestrearMemoriaEnTraza();
+
+    // --- 9) Escribir el manifiesto (marca la ejecución como completa) ---
+    manifiesto.msProcesado = msDesde(tProcesado);
+    manifiesto.msTotal     = msDesde(t0);
+    return GuardarManifiesto(manifiesto, carpetaSalidaBase);
+}
+
+int ContarPlanosNifti(const std::string& rutaNifti, Orientacion orientacion)
+{
+    auto niftiIO = LeerCabeceraNifti(rutaNifti);
+    if (!niftiIO) return 0;
+
+    switch (orientacion) {
+        case Orientacion::Coronal: return static_cast<int>(niftiIO->GetDimensions(1));
+        case Orientacion::Sagital: return static_cast<int>(niftiIO->GetDimensions(0));
+        case Orientacion::Axial:
+        default:                   return static_cast<int>(niftiIO->GetDimensions(2));
+    }
+}
+
+long long BytesVolumenNifti(const std::string& rutaNifti)
+{
+    auto niftiIO = LeerCabeceraNifti(rutaNifti);
+    if (!niftiIO) return 0;
+
+    long long voxeles = 1;
+    for (unsigned int d = 0; d < Dimension3D; ++d)
+        voxeles *= static_cast<long long>(niftiIO->GetDimensions(d));
+    return voxeles * static_cast<long long>(BytesPixel(TipoParaComponente(niftiIO->GetComponentType())));
 }
@@ -3,41 +3,182 @@
 #define UTILS_H
 
 #include <string>
+#include <vector>
 #include <filesystem>             // para std::filesystem::path
-#include <itkImage.h>             // para definir ImageType3D
+#include <itkImage.h>             // para itk::ImageBase en VolumenNifti
 #include <itkImageFileReader.h>
 #include <itkNiftiImageIO.h>
 #include <itkExtractImageFilter.h>
 #include "Filtros.h"              // para ITKImage2DtoCVMat, ITKMask2BinCVMat y ProcesarYGuardarSlice
+#include "Volumen.h"              // para Orientacion y VolumenOrtogonal
+#include "Manifiesto.h"           // para ManifiestoResultados
+#include "Estadisticas.h"         // para EstadisticasVolumen
 
 namespace fs = std::filesystem;
 
-// Tipos 3D de ITK (imagen y máscara)
+// Dimensión de los volúmenes NIfTI
 constexpr unsigned int Dimension3D = 3;
-using PixelType3D = short;
-using ImageType3D = itk::Image<PixelType3D, Dimension3D>;
 
 /**
- * Lee un volumen NIfTI (imagen y máscara), extrae cada slice en Z,
- * lo convierte a cv::Mat, aplica el filtro elegido y guarda resultados en carpetas.
+ * Tipos de píxel en los que se procesa un volumen sin convertirlo.
+ */
+enum class TipoPixelVolumen { UInt8, Int16, UInt16, Float32 };
+
+/**
+ * "uint8", "int16", "uint16" o "float32".
+ */
+const char* NombreTipoPixelVolumen(TipoPixelVolumen tipo);
+
+/**
+ * Volumen NIfTI leído en su tipo de píxel nativo. 'imagen' es la itk::Image<T, 3>
+ * del tipo y mantiene vivo el buffer al que apunta 'datos'; copiar la estructura
+ * sólo comparte la imagen.
+ */
+struct VolumenNifti
+{
+    TipoPixelVolumen tipo = TipoPixelVolumen::Int16;
+    itk::ImageBase<Dimension3D>::Pointer imagen;
+    const void* datos = nullptr;                  // buffer contiguo, x más rápido
+    int nx = 0, ny = 0, nz = 0;
+    double espaciado[3] = { 1.0, 1.0, 1.0 };      // mm (x, y, z)
+
+    explicit operator bool() const { return datos != nullptr; }
+
+    // Profundidad de OpenCV de los píxeles (CV_8U, CV_16S, CV_16U o CV_32F)
+    int TipoCv() const;
+    long long Bytes() const;
+    bool MismoTamano(const VolumenNifti& otro) const { return nx == otro.nx && ny == otro.ny && nz == otro.nz; }
+};
+
+/**
+ * Lee un volumen NIfTI en su tipo nativo si es uint8, int16, uint16 o float32, sin
+ * pasada de conversión. Los demás tipos se leen en el más cercano que los
+ * representa: int8 como int16 y los enteros de 32/64 bits y double como float32.
+ * Mientras la imagen viva, su buffer se cuenta en CategoriaMemoria::Volumenes.
+ * @param descripcion Para el mensaje de error ("imagen", "máscara"...).
+ * @return Vacío (false) si no se pudo leer.
+ */
+VolumenNifti LeerVolumenNiftiNativo(const std::string& rutaNifti, const char* descripcion);
+
+/**
+ * Estadísticas del volumen original completo, en su tipo nativo, y dentro/fuera
+ * de la máscara, con el volumen de la máscara en mm³ según el espaciado del NIfTI
+ * y los perfiles por slice a lo largo de Z.
+ *
+ * @param mascara Puede ser nullptr; si no, debe tener el tamaño de la imagen.
+ * @param numHilos Hilos para la reducción (0 = todos los núcleos).
+ * @return false si no hay imagen o los tamaños no coinciden.
+ */
+bool CalcularEstadisticasNifti(
+    const VolumenNifti& imagen,
+    const VolumenNifti* mascara,
+    EstadisticasVolumen& resultado,
+    int numHilos = 0
+);
+
+/**
+ * Opciones de una ejecución de ProcesarTodosSlices.
+ */
+struct OpcionesProcesado
+{
+    // Orientación de los planos a procesar
+    Orientacion orientacion = Orientacion::Axial;
+
+    // Si no es nulo, recibe en orden cada imagen highlighted (BGR) ya en memoria,
+    // para generar el video sin volver a leer los PNG de disco.
+    std::vector<cv::Mat>* framesHighlighted = nullptr;
+
+    // Rango de planos a procesar (0-based, inclusivo); planoFin = -1 llega hasta el último
+    int planoInicio = 0;
+    int planoFin    = -1;
+
+    // Hilos que procesan planos a la vez (0 = todos los núcleos)
+    int numHilos = 0;
+
+    // Si no está vacío, el video highlighted (MJPG) se escribe aquí mientras se procesa.
+    // Incluye los planos [videoInicio, videoFin] dentro del rango procesado (-1 = hasta el final).
+    std::string rutaVideo;
+    int    videoInicio = 0;
+    int    videoFin    = -1;
+    double fpsVideo    = 10.0;
+
+    // Si es true, cada hilo resume su slice mientras lo procesa (histogramas de original y
+    // procesado, área de la máscara, media/desviación en la ROI) y al final se escribe
+    // kNombreEstadisticasSlices en la carpeta base, referenciado desde el manifiesto.
+    bool recolectarEstadisticas = false;
+
+    // Volúmenes ya leídos de rutaNifti / rutaMask (p. ej. precargados por ProcesarLote
+    // mientras se procesaba el caso anterior). Si están vacíos, se leen en ProcesarTodosSlices.
+    VolumenNifti imagenPrecargada;
+    VolumenNifti mascaraPrecargada;
+
+    // Si es true, cada hilo sirve los cv::Mat temporales de sus slices desde una
+    // ArenaMat (ver ArenaMat.h) y el manifiesto guarda los contadores de asignación.
+    bool usarArena = true;
+
+    // Si es true, la máscara se refina en 3D y los filtros 5, 7 y 8 se aplican al volumen
+    // entero antes de sacar los slices (ver Filtros3D.h); el resto sigue siendo 2D.
+    bool modo3D = false;
+
+    // Radio de los filtros 11 y 12 (1–kRadioFiltroMaximo); 0 = el de cada filtro
+    int radioFiltro = 0;
+};
+
+/**
+ * Lee un volumen NIfTI (imagen y máscara, cada uno en su tipo nativo), extrae cada
+ * plano en la orientación pedida (axial por defecto), lo pasa a 8 bits, aplica el filtro elegido
+ * y guarda resultados en carpetas. Los planos se procesan en paralelo y, si se
+ * pide, el video se genera en la misma pasada (con un búfer de reordenación
+ * para que los frames salgan en orden).
  *
  * @param rutaNifti         Ruta al archivo NIfTI de la imagen 3D.
  * @param rutaMask          Ruta al archivo NIfTI de la máscara 3D.
  * @param carpetaSalidaBase Carpeta base donde se crearán subcarpetas:
- *                          "original", "mask" y "highlighted".
- * @param filterOption      Entero (1–10) que indica qué filtro aplicar.
+ *                          "original", "mask" y "highlighted", además del
+ *                          manifiesto de la ejecución (manifest.json).
+ * @param filterOption      Entero (1–kNumFiltros) que indica qué filtro aplicar.
+ * @param opciones          Orientación (axial por defecto) y demás opciones.
  * @return true si todo salió bien; false en caso de error.
  */
 bool ProcesarTodosSlices(
     const std::string& rutaNifti,
     const std::string& rutaMask,
     const std::string& carpetaSalidaBase,
+    int filterOption,
+    const OpcionesProcesado& opciones = OpcionesProcesado()
+);
+
+/**
+ * Procesa un solo plano de volúmenes ya en memoria, igual que ProcesarTodosSlices
+ * (mismo paso a 8 bits, reescalado y filtro) pero sin escribir nada en disco.
+ * @return La imagen highlighted (BGR); vacía si el plano no existe o los tamaños no coinciden.
+ */
+cv::Mat ProcesarPlanoVolumen(
+    const VolumenNifti& imagen,
+    const VolumenNifti& mascara,
+    Orientacion orientacion,
+    int plano,
     int filterOption
 );
 
+/**
+ * Número de planos del volumen NIfTI en la orientación dada, leyendo sólo la cabecera.
+ * @return 0 si no se pudo leer.
+ */
+int ContarPlanosNifti(const std::string& rutaNifti, Orientacion orientacion);
+
+/**
+ * Memoria que ocupa el volumen NIfTI una vez leído con LeerVolumenNiftiNativo, leyendo sólo
+ * la cabecera (para repartir un presupuesto de memoria antes de leerlo).
+ * @return 0 si no se pudo leer.
+ */
+long long BytesVolumenNifti(const std::string& rutaNifti);
+
 /**
  * Genera un video (AVI) usando sólo las imágenes cuyos índices estén
- * entre 'inicio' y 'fin' (1-based) encontradas en 'carpetaHighlighted'.
+ * entre 'inicio' y 'fin' (1-based) de 'carpetaHighlighted'. La lista y el
+ * orden de las imágenes se toman del manifiesto de la carpeta padre.
+ * La lectura de los PNG y la codificación MJPG se hacen en paralelo.
  *
  * @param carpetaHighlighted Carpeta donde están las imágenes “highlighted” (slices).
  * @param carpetaVideo       Carpeta destino donde guardaremos "highlighted_video.avi".
@@ -52,4 +193,21 @@ bool GenerarVideoHighlighted(
     int fin
 );
 
+/**
+ * Igual que GenerarVideoHighlighted, pero con frames que ya están en memoria
+ * (p. ej. los devueltos en OpcionesProcesado::framesHighlighted): no se lee
+ * ni decodifica ningún PNG, sólo se codifica MJPG en paralelo.
+ *
+ * @param frames       Frames highlighted (BGR) en orden de slice.
+ * @param carpetaVideo Carpeta destino donde guardaremos "highlighted_video.avi".
+ * @param inicio       Índice (1-based) del primer frame a incluir.
+ * @param fin          Índice (1-based) del último frame a incluir.
+ */
+bool GenerarVideoDesdeFrames(
+    const std::vector<cv::Mat>& frames,
+    const std::string& carpetaVideo,
+    int inicio,
+    int fin
+);
+
 #endif // UTILS_H
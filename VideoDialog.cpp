@@ -7,9 +7,11 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QIntValidator>
+#include <QCheckBox>
 
-VideoDialog::VideoDialog(int maxIndex, QWidget *parent)
+VideoDialog::VideoDialog(int maxIndex, QWidget *parent, bool permitirLimitar)
     : QDialog(parent),
+      chkLimitar(nullptr),
       maxSlices(maxIndex)
 {
     setWindowTitle("Generar video (índices)");
@@ -47,6 +49,12 @@ VideoDialog::VideoDialog(int maxIndex, QWidget *parent)
     form->addRow("Índice final (" + QString::number(spinStart->value()) + "–" 
                  + QString::number(maxSlices) + "):", spinEnd);
 
+    // Opcional: procesar sólo los slices del rango (video durante el procesamiento)
+    if (permitirLimitar) {
+        chkLimitar = new QCheckBox("Procesar sólo los slices de este rango");
+        form->addRow(chkLimitar);
+    }
+
     // Botones abajo
     QHBoxLayout *hButtons = new QHBoxLayout();
     hButtons->addStretch();
@@ -72,3 +80,8 @@ int VideoDialog::getEnd() const
 {
     return spinEnd->value();
 }
+
+bool VideoDialog::getLimitarProcesado() const
+{
+    return chkLimitar && chkLimitar->isChecked();
+}
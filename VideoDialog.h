@@ -7,20 +7,24 @@
 class QSpinBox;
 class QLabel;
 class QPushButton;
+class QCheckBox;
 
 class VideoDialog : public QDialog
 {
     Q_OBJECT
 
 public:
-    explicit VideoDialog(int maxIndex, QWidget *parent = nullptr);
+    // Con permitirLimitar = true se muestra la opción de procesar sólo el rango elegido
+    explicit VideoDialog(int maxIndex, QWidget *parent = nullptr, bool permitirLimitar = false);
     int getStart() const;
     int getEnd() const;
+    bool getLimitarProcesado() const;
 
 private:
     QSpinBox *spinStart;
     QSpinBox *spinEnd;
     QLabel   *lblTotal;
+    QCheckBox *chkLimitar;
     QPushButton *btnOk;
     QPushButton *btnCancel;
 
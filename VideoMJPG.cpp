@@ -0,0 +1,336 @@
+// VideoMJPG.cpp
+#include "VideoMJPG.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/core/utility.hpp>  // para cv::parallel_for_ y cv::getNumThreads
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include "Perfil.h"
+
+// ----------------------------------------------------------
+// Escritura little-endian de los campos RIFF
+// ----------------------------------------------------------
+static void EscribirU32(std::ofstream& out, uint32_t v)
+{
+    const char b[4] = {
+        static_cast<char>(v & 0xFF),         static_cast<char>((v >> 8) & 0xFF),
+        static_cast<char>((v >> 16) & 0xFF), static_cast<char>((v >> 24) & 0xFF)
+    };
+    out.write(b, 4);
+}
+
+static void EscribirU16(std::ofstream& out, uint16_t v)
+{
+    const char b[2] = { static_cast<char>(v & 0xFF), static_cast<char>((v >> 8) & 0xFF) };
+    out.write(b, 2);
+}
+
+static void EscribirFourcc(std::ofstream& out, const char* cc)
+{
+    out.write(cc, 4);
+}
+
+// Sobrescribe un uint32 en una posición ya escrita y vuelve al final
+static void ParchearU32(std::ofstream& out, std::streampos pos, uint32_t v)
+{
+    std::streampos actual = out.tellp();
+    out.seekp(pos);
+    EscribirU32(out, v);
+    out.seekp(actual);
+}
+
+static constexpr uint32_t kAvifHasIndex   = 0x10;
+static constexpr uint32_t kAviifKeyframe  = 0x10;
+static constexpr uint32_t kTamAvih        = 56;
+static constexpr uint32_t kTamStrh        = 56;
+static constexpr uint32_t kTamStrf        = 40;   // BITMAPINFOHEADER
+
+EscritorAviMjpg::~EscritorAviMjpg()
+{
+    if (archivo.is_open()) Cerrar();
+}
+
+bool EscritorAviMjpg::Abrir(const std::string& ruta, int anchoFrame, int altoFrame, double fps)
+{
+    if (archivo.is_open()) Cerrar();
+    if (anchoFrame <= 0 || altoFrame <= 0 || fps <= 0) return false;
+
+    archivo.open(ruta, std::ios::binary | std::ios::trunc);
+    if (!archivo.is_open()) return false;
+
+    ancho = anchoFrame;
+    alto  = altoFrame;
+    maxTamFrame = 0;
+    indice.clear();
+
+    const uint32_t tamStrl = 4 + (8 + kTamStrh) + (8 + kTamStrf);
+    const uint32_t tamHdrl = 4 + (8 + kTamAvih) + (8 + tamStrl);
+    const uint32_t escala  = 1000;
+    const uint32_t tasa    = static_cast<uint32_t>(std::lround(fps * escala));
+
+    // RIFF 'AVI '
+    EscribirFourcc(archivo, "RIFF");
+    posTamRiff = archivo.tellp();
+    EscribirU32(archivo, 0);
+    EscribirFourcc(archivo, "AVI ");
+
+    // LIST 'hdrl'
+    EscribirFourcc(archivo, "LIST");
+    EscribirU32(archivo, tamHdrl);
+    EscribirFourcc(archivo, "hdrl");
+
+    // 'avih' (MainAVIHeader)
+    EscribirFourcc(archivo, "avih");
+    EscribirU32(archivo, kTamAvih);
+    EscribirU32(archivo, static_cast<uint32_t>(std::lround(1e6 / fps))); // dwMicroSecPerFrame
+    EscribirU32(archivo, 0);                 // dwMaxBytesPerSec
+    EscribirU32(archivo, 0);                 // dwPaddingGranularity
+    EscribirU32(archivo, kAvifHasIndex);     // dwFlags
+    posTotalFramesAvih = archivo.tellp();
+    EscribirU32(archivo, 0);                 // dwTotalFrames (se corrige al cerrar)
+    EscribirU32(archivo, 0);                 // dwInitialFrames
+    EscribirU32(archivo, 1);                 // dwStreams
+    posBufferAvih = archivo.tellp();
+    EscribirU32(archivo, 0);                 // dwSuggestedBufferSize
+    EscribirU32(archivo, static_cast<uint32_t>(ancho));
+    EscribirU32(archivo, static_cast<uint32_t>(alto));
+    for (int i = 0; i < 4; ++i) EscribirU32(archivo, 0);  // dwReserved
+
+    // LIST 'strl'
+    EscribirFourcc(archivo, "LIST");
+    EscribirU32(archivo, tamStrl);
+    EscribirFourcc(archivo, "strl");
+
+    // 'strh' (AVIStreamHeader)
+    EscribirFourcc(archivo, "strh");
+    EscribirU32(archivo, kTamStrh);
+    EscribirFourcc(archivo, "vids");
+    EscribirFourcc(archivo, "MJPG");
+    EscribirU32(archivo, 0);                 // dwFlags
+    EscribirU16(archivo, 0);                 // wPriority
+    EscribirU16(archivo, 0);                 // wLanguage
+    EscribirU32(archivo, 0);                 // dwInitialFrames
+    EscribirU32(archivo, escala);            // dwScale
+    EscribirU32(archivo, tasa);              // dwRate (fps = dwRate / dwScale)
+    EscribirU32(archivo, 0);                 // dwStart
+    posLongitudStrh = archivo.tellp();
+    EscribirU32(archivo, 0);                 // dwLength (se corrige al cerrar)
+    posBufferStrh = archivo.tellp();
+    EscribirU32(archivo, 0);                 // dwSuggestedBufferSize
+    EscribirU32(archivo, 0xFFFFFFFFu);       // dwQuality (por defecto)
+    EscribirU32(archivo, 0);                 // dwSampleSize
+    EscribirU16(archivo, 0);                 // rcFrame.left
+    EscribirU16(archivo, 0);                 // rcFrame.top
+    EscribirU16(archivo, static_cast<uint16_t>(ancho));
+    EscribirU16(archivo, static_cast<uint16_t>(alto));
+
+    // 'strf' (BITMAPINFOHEADER)
+    EscribirFourcc(archivo, "strf");
+    EscribirU32(archivo, kTamStrf);
+    EscribirU32(archivo, kTamStrf);          // biSize
+    EscribirU32(archivo, static_cast<uint32_t>(ancho));
+    EscribirU32(archivo, static_cast<uint32_t>(alto));
+    EscribirU16(archivo, 1);                 // biPlanes
+    EscribirU16(archivo, 24);                // biBitCount
+    EscribirFourcc(archivo, "MJPG");         // biCompression
+    EscribirU32(archivo, static_cast<uint32_t>(ancho) * alto * 3);  // biSizeImage
+    for (int i = 0; i < 4; ++i) EscribirU32(archivo, 0);  // resolución y paleta
+
+    // LIST 'movi'
+    EscribirFourcc(archivo, "LIST");
+    posTamMovi = archivo.tellp();
+    EscribirU32(archivo, 0);
+    posFourccMovi = archivo.tellp();
+    EscribirFourcc(archivo, "movi");
+
+    return archivo.good();
+}
+
+bool EscritorAviMjpg::EscribirFrameJpeg(const std::vector<uchar>& jpeg)
+{
+    if (!archivo.is_open() || jpeg.empty()) return false;
+    MedirEtapa medir(Etapa::Escritura);
+
+    const uint64_t posChunk = static_cast<uint64_t>(archivo.tellp());
+    const uint64_t finPrevisto = posChunk + 8 + jpeg.size() + 1
+                               + 8 + 16ull * (indice.size() + 1);
+    if (finPrevisto > std::numeric_limits<uint32_t>::max()) {
+        std::cerr << "[ERROR] El video supera el límite de 4 GB de AVI.\n";
+        return false;
+    }
+
+    const uint32_t tam = static_cast<uint32_t>(jpeg.size());
+    EscribirFourcc(archivo, "00dc");
+    EscribirU32(archivo, tam);
+    archivo.write(reinterpret_cast<const char*>(jpeg.data()), tam);
+    if (tam & 1) archivo.put('\0');  // los chunks RIFF van alineados a 2 bytes
+
+    indice.push_back({ static_cast<uint32_t>(posChunk - static_cast<uint64_t>(posFourccMovi)), tam });
+    maxTamFrame = std::max(maxTamFrame, tam);
+    return archivo.good();
+}
+
+bool EscritorAviMjpg::Cerrar()
+{
+    if (!archivo.is_open()) return false;
+
+    // Índice 'idx1' (offsets relativos al FOURCC 'movi')
+    const std::streampos posIdx1 = archivo.tellp();
+    EscribirFourcc(archivo, "idx1");
+    EscribirU32(archivo, static_cast<uint32_t>(16 * indice.size()));
+    for (const auto& e : indice) {
+        EscribirFourcc(archivo, "00dc");
+        EscribirU32(archivo, kAviifKeyframe);
+        EscribirU32(archivo, e.offset);
+        EscribirU32(archivo, e.tam);
+    }
+    const std::streampos posFin = archivo.tellp();
+
+    const uint32_t numFrames = static_cast<uint32_t>(indice.size());
+    ParchearU32(archivo, posTamRiff,         static_cast<uint32_t>(posFin - posTamRiff - 4));
+    ParchearU32(archivo, posTamMovi,         static_cast<uint32_t>(posIdx1 - posFourccMovi));
+    ParchearU32(archivo, posTotalFramesAvih, numFrames);
+    ParchearU32(archivo, posLongitudStrh,    numFrames);
+    ParchearU32(archivo, posBufferAvih,      maxTamFrame);
+    ParchearU32(archivo, posBufferStrh,      maxTamFrame);
+
+    const bool ok = archivo.good();
+    archivo.close();
+    return ok;
+}
+
+ReordenadorFramesAvi::ReordenadorFramesAvi(EscritorAviMjpg& escritor, int primerIndice, int maxAdelanto)
+    : escritor(escritor), siguiente(primerIndice), maxAdelanto(maxAdelanto)
+{
+}
+
+void ReordenadorFramesAvi::Entregar(int indice, std::vector<uchar>&& jpeg)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    if (maxAdelanto > 0)
+        avanzo.wait(lock, [&] { return indice - siguiente < maxAdelanto; });
+
+    bytesPendientes += static_cast<long long>(jpeg.size());
+    pendientes.emplace(indice, std::move(jpeg));
+    maxPendientes = std::max(maxPendientes, pendientes.size());
+
+    // Vaciar todos los frames consecutivos disponibles desde 'siguiente'
+    const int cabeza = siguiente;
+    for (auto it = pendientes.find(siguiente); it != pendientes.end(); it = pendientes.find(siguiente))
+    {
+        if (!it->second.empty()) {
+            ok = escritor.EscribirFrameJpeg(it->second) && ok;
+        } else {
+            std::cerr << "[WARNING] Frame " << siguiente << " descartado del video.\n";
+        }
+        bytesPendientes -= static_cast<long long>(it->second.size());
+        pendientes.erase(it);
+        ++siguiente;
+    }
+    memoriaPendientes.Fijar(bytesPendientes);
+    if (siguiente != cabeza) avanzo.notify_all();
+}
+
+bool ReordenadorFramesAvi::Ok() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return ok && pendientes.empty();
+}
+
+size_t ReordenadorFramesAvi::MaxPendientes() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return maxPendientes;
+}
+
+bool CodificarFrameJpeg(const cv::Mat& frame, std::vector<uchar>& jpeg, int calidadJpeg)
+{
+    MedirEtapa medir(Etapa::Codificacion);
+    cv::Mat bgr;
+    if (frame.channels() == 1)
+        cv::cvtColor(frame, bgr, cv::COLOR_GRAY2BGR);
+    else
+        bgr = frame;
+
+    try {
+        return cv::imencode(".jpg", bgr, jpeg, { cv::IMWRITE_JPEG_QUALITY, calidadJpeg });
+    }
+    catch (const cv::Exception& e) {
+        std::cerr << "[ERROR] Codificando JPEG: " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool CodificarVideoMJPG(
+    int numFrames,
+    const std::function<cv::Mat(int)>& obtenerFrame,
+    const std::string& rutaSalida,
+    double fps,
+    int calidadJpeg
+)
+{
+    // 1) El primer frame válido fija el tamaño del video
+    int idxPrimero = 0;
+    cv::Mat primero;
+    for (; idxPrimero < numFrames; ++idxPrimero) {
+        primero = obtenerFrame(idxPrimero);
+        if (!primero.empty()) break;
+    }
+    if (primero.empty()) {
+        std::cerr << "[ERROR] No hay frames válidos para el video.\n";
+        return false;
+    }
+    const cv::Size tam(primero.cols, primero.rows);
+
+    EscritorAviMjpg escritor;
+    if (!escritor.Abrir(rutaSalida, tam.width, tam.height, fps)) {
+        std::cerr << "[ERROR] No se pudo abrir el video en: " << rutaSalida << "\n";
+        return false;
+    }
+
+    // 2) Por lotes: obtener + codificar en paralelo, escribir en orden.
+    //    Los hilos del pool de OpenCV miden en el perfil del hilo que llama.
+    PerfilEtapas* perfil = PerfilActivo();
+    const int lote = std::max(1, cv::getNumThreads()) * 2;
+    std::vector<std::vector<uchar>> jpegs(lote);
+    std::vector<char> valido(lote);
+    MemoriaContada memoriaLote{ CategoriaMemoria::ColaVideo };
+
+    for (int base = idxPrimero; base < numFrames; base += lote)
+    {
+        const int n = std::min(lote, numFrames - base);
+        std::fill(valido.begin(), valido.end(), 0);
+
+        cv::parallel_for_(cv::Range(0, n), [&](const cv::Range& r) {
+            PerfilEnHilo perfilHilo(perfil);
+            for (int k = r.start; k < r.end; ++k) {
+                const int idx = base + k;
+                cv::Mat frame = (idx == idxPrimero) ? primero : obtenerFrame(idx);
+                if (frame.empty()) continue;
+                if (frame.cols != tam.width || frame.rows != tam.height) {
+                    cv::resize(frame, frame, tam);
+                }
+                valido[k] = CodificarFrameJpeg(frame, jpegs[k], calidadJpeg) ? 1 : 0;
+            }
+        });
+        long long bytesLote = 0;
+        for (int k = 0; k < n; ++k) bytesLote += static_cast<long long>(jpegs[k].size());
+        memoriaLote.Fijar(bytesLote);
+
+        for (int k = 0; k < n; ++k) {
+            if (!valido[k]) {
+                std::cerr << "[WARNING] Saltando frame " << (base + k) << " (vacío o no codificado).\n";
+                continue;
+            }
+            if (!escritor.EscribirFrameJpeg(jpegs[k])) {
+                escritor.Cerrar();
+                return false;
+            }
+        }
+    }
+
+    // 3) Cierra el archivo (índice + cabeceras definitivas)
+    return escritor.Cerrar();
+}
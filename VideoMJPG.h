@@ -0,0 +1,130 @@
+// VideoMJPG.h
+#ifndef VIDEOMJPG_H
+#define VIDEOMJPG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "Memoria.h"              // para MemoriaContada
+
+/**
+ * Escritor de AVI (RIFF 1.0 + índice idx1) con un único stream de video MJPG.
+ * Recibe frames ya codificados en JPEG, así la codificación puede hacerse en
+ * paralelo fuera y aquí sólo se escriben en orden.
+ * No es thread-safe: un solo hilo debe llamar a EscribirFrameJpeg.
+ */
+class EscritorAviMjpg
+{
+public:
+    EscritorAviMjpg() = default;
+    ~EscritorAviMjpg();
+
+    EscritorAviMjpg(const EscritorAviMjpg&) = delete;
+    EscritorAviMjpg& operator=(const EscritorAviMjpg&) = delete;
+
+    /**
+     * Crea el archivo y escribe las cabeceras (se completan en Cerrar()).
+     * @return false si no se pudo abrir el archivo.
+     */
+    bool Abrir(const std::string& ruta, int ancho, int alto, double fps);
+
+    /**
+     * Añade un frame JPEG al final del stream.
+     * @return false si hubo error de escritura o se superaría el límite de 4 GB del AVI 1.0.
+     */
+    bool EscribirFrameJpeg(const std::vector<uchar>& jpeg);
+
+    /**
+     * Escribe el índice, corrige tamaños y número de frames, y cierra el archivo.
+     */
+    bool Cerrar();
+
+    bool EstaAbierto() const { return archivo.is_open(); }
+    int  NumFrames() const { return static_cast<int>(indice.size()); }
+    int  Ancho() const { return ancho; }
+    int  Alto() const { return alto; }
+
+private:
+    struct EntradaIndice { uint32_t offset; uint32_t tam; };
+
+    std::ofstream archivo;
+    int ancho = 0, alto = 0;
+    uint32_t maxTamFrame = 0;
+    std::vector<EntradaIndice> indice;
+
+    // Posiciones a corregir al cerrar
+    std::streampos posTamRiff, posTotalFramesAvih, posBufferAvih;
+    std::streampos posLongitudStrh, posBufferStrh, posTamMovi, posFourccMovi;
+};
+
+/**
+ * Búfer de reordenación para escribir en un EscritorAviMjpg frames que llegan
+ * desordenados desde varios hilos. Cada índice desde 'primerIndice' debe
+ * entregarse exactamente una vez (un JPEG vacío marca un frame descartado).
+ * Los frames que llegan adelantados esperan en memoria. Un slice lento en cabeza
+ * no frena a los demás hilos, así que el búfer se acota con 'maxAdelanto': quien
+ * entrega un índice que va 'maxAdelanto' o más por delante del siguiente a escribir
+ * espera a que avance la cabeza. Si los hilos toman los índices en orden no hay
+ * interbloqueo: el hilo con el siguiente índice nunca espera.
+ */
+class ReordenadorFramesAvi
+{
+public:
+    /**
+     * @param maxAdelanto Índices por delante del siguiente a escribir que se aceptan
+     *                    sin esperar (0 = sin límite); acota los pendientes a maxAdelanto - 1.
+     */
+    ReordenadorFramesAvi(EscritorAviMjpg& escritor, int primerIndice, int maxAdelanto = 0);
+
+    // Thread-safe. Espera si 'indice' va demasiado adelantado y luego escribe este
+    // frame y los siguientes que ya estén pendientes.
+    void Entregar(int indice, std::vector<uchar>&& jpeg);
+
+    bool   Ok() const;
+    size_t MaxPendientes() const;
+
+private:
+    EscritorAviMjpg& escritor;
+    mutable std::mutex mtx;
+    std::condition_variable avanzo;
+    int siguiente;
+    int maxAdelanto;
+    std::map<int, std::vector<uchar>> pendientes;
+    long long bytesPendientes = 0;
+    MemoriaContada memoriaPendientes{ CategoriaMemoria::ColaVideo };
+    size_t maxPendientes = 0;
+    bool ok = true;
+};
+
+/**
+ * Codifica 'numFrames' frames como video MJPG en 'rutaSalida'.
+ *
+ * 'obtenerFrame(i)' devuelve el frame i (BGR o gris, 8 bits); se llama en paralelo
+ * desde varios hilos (debe ser thread-safe), así que puede leer/decodificar de disco
+ * o devolver un cv::Mat que ya esté en memoria. La codificación JPEG también se
+ * hace en paralelo, por lotes, y los frames se escriben en orden.
+ * Frames vacíos se saltan; los de distinto tamaño se redimensionan al del primero.
+ *
+ * @return true si el video se escribió correctamente.
+ */
+bool CodificarVideoMJPG(
+    int numFrames,
+    const std::function<cv::Mat(int)>& obtenerFrame,
+    const std::string& rutaSalida,
+    double fps,
+    int calidadJpeg = 95
+);
+
+/**
+ * Codifica un frame (BGR o gris, 8 bits) a JPEG con la calidad dada.
+ * Los grises se pasan a BGR para que todos los frames del AVI sean iguales.
+ */
+bool CodificarFrameJpeg(const cv::Mat& frame, std::vector<uchar>& jpeg, int calidadJpeg = 95);
+
+#endif // VIDEOMJPG_H
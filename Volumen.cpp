@@ -0,0 +1,169 @@
+// Volumen.cpp
+#include "Volumen.h"
+#include <opencv2/core/utility.hpp>  // para cv::parallel_for_
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Lado del bloque (en elementos) para la transposición: 32x32 elementos = 1-4 KB por bloque
+// según el tipo, las 32 líneas de destino que toca un bloque caben holgadas en L1.
+static constexpr int kBloqueTransposicion = 32;
+
+const char* NombreOrientacion(Orientacion orientacion)
+{
+    switch (orientacion) {
+        case Orientacion::Coronal: return "coronal";
+        case Orientacion::Sagital: return "sagital";
+        case Orientacion::Axial:
+        default:                   return "axial";
+    }
+}
+
+Orientacion OrientacionDesdeNombre(const std::string& nombre)
+{
+    if (nombre == "coronal") return Orientacion::Coronal;
+    if (nombre == "sagital") return Orientacion::Sagital;
+    return Orientacion::Axial;
+}
+
+// Los píxeles sólo se copian: basta un entero sin signo del mismo tamaño que el elemento
+template <class T>
+static void TransponerSagital(const T* datos, T* dst, int nx, int ny, int nz)
+{
+    const size_t planoSag = static_cast<size_t>(nz) * ny;  // elementos por plano sagital
+    const int B = kBloqueTransposicion;
+
+    // Cada z escribe en filas distintas de cada plano sagital: sin conflictos entre hilos.
+    cv::parallel_for_(cv::Range(0, nz), [&](const cv::Range& r) {
+        for (int z = r.start; z < r.end; ++z) {
+            const T* planoAxial = datos + static_cast<size_t>(z) * nx * ny;
+            const size_t filaDst = static_cast<size_t>(nz - 1 - z) * ny;
+            for (int y0 = 0; y0 < ny; y0 += B) {
+                const int y1 = std::min(y0 + B, ny);
+                for (int x0 = 0; x0 < nx; x0 += B) {
+                    const int x1 = std::min(x0 + B, nx);
+                    for (int y = y0; y < y1; ++y) {
+                        const T* fila = planoAxial + static_cast<size_t>(y) * nx;
+                        for (int x = x0; x < x1; ++x) {
+                            dst[x * planoSag + filaDst + y] = fila[x];
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Plano sagital sin preparar: lectura con salto de nx (válido para cortes sueltos)
+template <class T>
+static void CopiarSagitalConSalto(const T* datos, cv::Mat& plano, int indice, int nx, int ny, int nz)
+{
+    const size_t planoAxial = static_cast<size_t>(nx) * ny;
+    for (int r = 0; r < nz; ++r) {
+        const T* src = datos + static_cast<size_t>(nz - 1 - r) * planoAxial + indice;
+        T* dst = plano.ptr<T>(r);
+        for (int y = 0; y < ny; ++y) {
+            dst[y] = src[static_cast<size_t>(y) * nx];
+        }
+    }
+}
+
+VolumenOrtogonal::VolumenOrtogonal(const void* datos, int tipoCv, int nx, int ny, int nz)
+    : datos(static_cast<const unsigned char*>(datos)), tipoCv(CV_MAT_DEPTH(tipoCv)),
+      bytesElemento(CV_ELEM_SIZE(CV_MAT_DEPTH(tipoCv))), nx(nx), ny(ny), nz(nz)
+{
+    CV_Assert(bytesElemento == 1 || bytesElemento == 2 || bytesElemento == 4);
+}
+
+int VolumenOrtogonal::NumPlanos(Orientacion orientacion) const
+{
+    switch (orientacion) {
+        case Orientacion::Coronal: return ny;
+        case Orientacion::Sagital: return nx;
+        case Orientacion::Axial:
+        default:                   return nz;
+    }
+}
+
+cv::Size VolumenOrtogonal::TamPlano(Orientacion orientacion) const
+{
+    // cv::Size(ancho, alto)
+    switch (orientacion) {
+        case Orientacion::Coronal: return cv::Size(nx, nz);
+        case Orientacion::Sagital: return cv::Size(ny, nz);
+        case Orientacion::Axial:
+        default:                   return cv::Size(nx, ny);
+    }
+}
+
+void VolumenOrtogonal::PrepararOrientacion(Orientacion orientacion)
+{
+    if (orientacion != Orientacion::Sagital || !transpuestaSagital.empty()) return;
+
+    const size_t elementos = static_cast<size_t>(nx) * ny * nz;
+    transpuestaSagital.resize(elementos * bytesElemento);
+    memoriaTranspuesta.Fijar(static_cast<long long>(transpuestaSagital.size()));
+    unsigned char* dst = transpuestaSagital.data();
+
+    switch (bytesElemento) {
+        case 1:
+            TransponerSagital(datos, dst, nx, ny, nz);
+            break;
+        case 2:
+            TransponerSagital(reinterpret_cast<const uint16_t*>(datos),
+                              reinterpret_cast<uint16_t*>(dst), nx, ny, nz);
+            break;
+        default:
+            TransponerSagital(reinterpret_cast<const uint32_t*>(datos),
+                              reinterpret_cast<uint32_t*>(dst), nx, ny, nz);
+            break;
+    }
+}
+
+cv::Mat VolumenOrtogonal::ExtraerPlano(Orientacion orientacion, int indice) const
+{
+    const size_t planoAxial = static_cast<size_t>(nx) * ny * bytesElemento;  // en bytes
+
+    switch (orientacion)
+    {
+        case Orientacion::Coronal:
+        {
+            // Fila r del plano = fila y=indice del slice z = nz-1-r (contigua en memoria)
+            cv::Mat plano(nz, nx, tipoCv);
+            const size_t bytesFila = static_cast<size_t>(nx) * bytesElemento;
+            for (int r = 0; r < nz; ++r) {
+                const unsigned char* src = datos + static_cast<size_t>(nz - 1 - r) * planoAxial
+                                                 + static_cast<size_t>(indice) * bytesFila;
+                std::memcpy(plano.ptr(r), src, bytesFila);
+            }
+            return plano;
+        }
+        case Orientacion::Sagital:
+        {
+            if (!transpuestaSagital.empty()) {
+                unsigned char* p = const_cast<unsigned char*>(transpuestaSagital.data())
+                                 + static_cast<size_t>(indice) * nz * ny * bytesElemento;
+                return cv::Mat(nz, ny, tipoCv, p);
+            }
+            cv::Mat plano(nz, ny, tipoCv);
+            switch (bytesElemento) {
+                case 1:
+                    CopiarSagitalConSalto(datos, plano, indice, nx, ny, nz);
+                    break;
+                case 2:
+                    CopiarSagitalConSalto(reinterpret_cast<const uint16_t*>(datos), plano, indice, nx, ny, nz);
+                    break;
+                default:
+                    CopiarSagitalConSalto(reinterpret_cast<const uint32_t*>(datos), plano, indice, nx, ny, nz);
+                    break;
+            }
+            return plano;
+        }
+        case Orientacion::Axial:
+        default:
+        {
+            unsigned char* p = const_cast<unsigned char*>(datos) + static_cast<size_t>(indice) * planoAxial;
+            return cv::Mat(ny, nx, tipoCv, p);
+        }
+    }
+}
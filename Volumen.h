@@ -0,0 +1,78 @@
+// Volumen.h
+#ifndef VOLUMEN_H
+#define VOLUMEN_H
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "Memoria.h"              // para MemoriaContada
+
+/**
+ * Orientación del plano de corte (índices ITK: x = columna, y = fila, z = slice).
+ *  - Axial:   plano z = cte  -> filas = y, columnas = x
+ *  - Coronal: plano y = cte  -> filas = z, columnas = x
+ *  - Sagital: plano x = cte  -> filas = z, columnas = y
+ * En coronal y sagital la fila 0 corresponde al z más alto (superior arriba).
+ */
+enum class Orientacion { Axial = 0, Coronal = 1, Sagital = 2 };
+
+/**
+ * Nombre legible de la orientación ("axial", "coronal", "sagital").
+ */
+const char* NombreOrientacion(Orientacion orientacion);
+
+/**
+ * Inversa de NombreOrientacion (p. ej. para el campo del manifiesto). Axial si no se reconoce.
+ */
+Orientacion OrientacionDesdeNombre(const std::string& nombre);
+
+/**
+ * Vista de un volumen 3D en su tipo de píxel nativo (buffer ITK contiguo, x más
+ * rápido; CV_8U, CV_16S, CV_16U o CV_32F) que permite sacar planos en las tres
+ * orientaciones.
+ *
+ * - Axial: el plano ya es contiguo, se devuelve un cv::Mat que apunta al buffer (sin copia).
+ * - Coronal: cada fila del plano es una fila contigua del volumen (memcpy por fila).
+ * - Sagital: es el peor caso (salto de nx elementos entre píxeles vecinos). Tras
+ *   PrepararOrientacion(Sagital) se guarda una copia transpuesta por bloques con
+ *   layout [x][z][y], de modo que cada plano sagital queda contiguo en memoria.
+ *
+ * El buffer original debe seguir vivo mientras se use la vista.
+ * ExtraerPlano es const y puede llamarse desde varios hilos a la vez.
+ */
+class VolumenOrtogonal
+{
+public:
+    /**
+     * @param tipoCv Profundidad de OpenCV de los elementos del buffer (un canal).
+     */
+    VolumenOrtogonal(const void* datos, int tipoCv, int nx, int ny, int nz);
+
+    int NumPlanos(Orientacion orientacion) const;
+    cv::Size TamPlano(Orientacion orientacion) const;
+
+    /**
+     * Prepara el layout para extraer muchos planos de la orientación dada.
+     * Sólo hace trabajo para Sagital (transposición por bloques, en paralelo).
+     */
+    void PrepararOrientacion(Orientacion orientacion);
+
+    /**
+     * Devuelve el plano 'indice' (0-based) como cv::Mat del tipo del volumen.
+     * Para Axial (y Sagital ya preparado) el Mat comparte memoria con el volumen:
+     * no debe modificarse.
+     */
+    cv::Mat ExtraerPlano(Orientacion orientacion, int indice) const;
+
+private:
+    const unsigned char* datos;
+    int tipoCv;
+    size_t bytesElemento;
+    int nx, ny, nz;
+
+    // Copia transpuesta [x][z invertido][y] para cortes sagitales (vacía si no se preparó)
+    std::vector<unsigned char> transpuestaSagital;
+    MemoriaContada memoriaTranspuesta{ CategoriaMemoria::Volumenes };
+};
+
+#endif // VOLUMEN_H
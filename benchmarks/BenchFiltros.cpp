@@ -0,0 +1,419 @@
+// BenchFiltros.cpp
+// Micro-benchmarks (Google Benchmark) de cada filtro y de las conversiones del
+// pipeline sobre planos sintéticos de 256², 512² y 1024². El rendimiento se
+// reporta en MPix/s; con --benchmark_out=archivo.json --benchmark_out_format=json
+// el resultado (con el commit en el contexto) se compara entre commits con
+// compare.py de Google Benchmark.
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <opencv2/core/utility.hpp>  // para cv::parallel_for_
+#include <opencv2/imgproc.hpp>       // para cv::createCLAHE
+#include "Filtros.h"
+#include "Filtros3D.h"
+#include "MascaraCompacta.h"
+#include "Segmentacion3D.h"
+#include "Suavizado.h"
+#include "ArenaMat.h"
+#include "DatosSinteticos.h"
+
+#ifndef RM_COMMIT
+#define RM_COMMIT "desconocido"
+#endif
+
+namespace {
+
+// Plano sintético (16 bits), su versión de 8 bits y la máscara binaria, por tamaño.
+// Para el overlay: la máscara como etiqueta única (0/1), repartida en 4 etiquetas
+// por franjas verticales, y unos bordes de Canny.
+struct Entrada
+{
+    cv::Mat plano16, mascara16;
+    cv::Mat slice8u, mascaraBin;
+    PlanoMascaraBits mascaraBits;
+    cv::Mat etiquetaUnica, etiquetasVarias, bordes;
+};
+
+const Entrada& EntradaDeTamano(int lado)
+{
+    static std::map<int, Entrada> entradas;     // los benchmarks corren en un solo hilo
+    auto it = entradas.find(lado);
+    if (it != entradas.end()) return it->second;
+
+    Entrada e;
+    GenerarPlanoSintetico(cv::Size(lado, lado), 0.5, 12345, e.plano16, e.mascara16);
+    e.slice8u    = Normalizar16a8(e.plano16);
+    e.mascaraBin = BinarizarMascara(e.mascara16);
+    e.mascaraBits = PlanoMascaraBits::Empaquetar(e.mascaraBin);
+
+    e.etiquetaUnica = e.mascaraBin / 255;
+    e.etiquetasVarias = e.etiquetaUnica.clone();
+    for (int y = 0; y < lado; ++y) {
+        uchar* fila = e.etiquetasVarias.ptr<uchar>(y);
+        for (int x = 0; x < lado; ++x)
+            if (fila[x]) fila[x] = static_cast<uchar>(1 + 4 * x / lado);
+    }
+    cv::Canny(e.slice8u, e.bordes, 50, 150);
+    return entradas.emplace(lado, std::move(e)).first->second;
+}
+
+// Imagen ITK 2D con el contenido de un plano CV_16S
+ImageType2D::Pointer PlanoAITK(const cv::Mat& plano16)
+{
+    ImageType2D::RegionType region;
+    ImageType2D::SizeType tam;
+    tam[0] = static_cast<ImageType2D::SizeValueType>(plano16.cols);
+    tam[1] = static_cast<ImageType2D::SizeValueType>(plano16.rows);
+    region.SetSize(tam);
+
+    auto imagen = ImageType2D::New();
+    imagen->SetRegions(region);
+    imagen->Allocate();
+    for (int y = 0; y < plano16.rows; ++y)
+        std::memcpy(imagen->GetBufferPointer() + static_cast<size_t>(y) * plano16.cols,
+                    plano16.ptr<short>(y), plano16.cols * sizeof(short));
+    return imagen;
+}
+
+void ContarPixeles(benchmark::State& state, int lado)
+{
+    const double pixeles = static_cast<double>(lado) * lado;
+    state.counters["MPix/s"] = benchmark::Counter(pixeles * state.iterations() / 1e6,
+                                                  benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(static_cast<int64_t>(pixeles) * state.iterations());
+}
+
+// Kernel sobre el slice de 8 bits (y la máscara). Como en ProcesarTodosSlices,
+// los temporales salen de una arena que se reinicia en cada iteración.
+void BenchSlice(benchmark::State& state, const std::function<cv::Mat(const Entrada&)>& kernel)
+{
+    const int lado = static_cast<int>(state.range(0));
+    const Entrada& e = EntradaDeTamano(lado);
+    ArenaMat arena;
+    for (auto _ : state)
+    {
+        arena.Reiniciar();
+        cv::Mat r = kernel(e);
+        benchmark::DoNotOptimize(r.data);
+    }
+    ContarPixeles(state, lado);
+}
+
+#define BENCH_SLICE(nombre, expresion)                                              \
+    void nombre(benchmark::State& state) {                                          \
+        BenchSlice(state, [](const Entrada& e) { return expresion; });             \
+    }                                                                               \
+    BENCHMARK(nombre)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond)
+
+// —————— Filtros 1–9 y 11–13 ——————
+BENCH_SLICE(BM_Thresholding,        aplicarThresholding(e.slice8u));
+BENCH_SLICE(BM_ContrastStretching,  aplicarContrastStretching(e.slice8u));
+BENCH_SLICE(BM_BinarizacionColor,   aplicarBinarizacionColor(e.slice8u));
+BENCH_SLICE(BM_OperacionLogicaNot,  aplicarOperacionLogica(e.slice8u, e.mascaraBin, 0));
+BENCH_SLICE(BM_OperacionLogicaAnd,  aplicarOperacionLogica(e.slice8u, e.mascaraBin, 1));
+BENCH_SLICE(BM_DeteccionBordes,     aplicarDeteccionBordes(e.slice8u));
+BENCH_SLICE(BM_ManipulacionPixeles, aplicarManipulacionPixeles(e.slice8u));
+BENCH_SLICE(BM_FiltroSuavizado,     aplicarFiltroSuavizado(e.slice8u));
+BENCH_SLICE(BM_OperacionesMorfo,    aplicarOperacionesMorfo(e.slice8u));
+BENCH_SLICE(BM_Watershed,           aplicarOtraTecnica(e.slice8u));
+BENCH_SLICE(BM_MedianaRapida,       aplicarMedianaRapida(e.slice8u));
+BENCH_SLICE(BM_SuavizadoBordes,     aplicarSuavizadoBordes(e.slice8u));
+BENCH_SLICE(BM_Clahe,               aplicarClahe(e.slice8u));
+
+// Referencia del filtro 13: el CLAHE de OpenCV con los mismos parámetros
+void BM_ClaheOpenCV(benchmark::State& state)
+{
+    const int lado = static_cast<int>(state.range(0));
+    const Entrada& e = EntradaDeTamano(lado);
+    cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(2.0, cv::Size(8, 8));
+    for (auto _ : state)
+    {
+        cv::Mat r;
+        clahe->apply(e.slice8u, r);
+        benchmark::DoNotOptimize(r.data);
+    }
+    ContarPixeles(state, lado);
+}
+BENCHMARK(BM_ClaheOpenCV)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// —————— Suavizado (Suavizado.h) por radio en 512²: el coste no debería crecer con él ——————
+void BM_MedianaHistogramaRadio(benchmark::State& state)
+{
+    const Entrada& e = EntradaDeTamano(512);
+    const int radio = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        cv::Mat r = MedianaHistograma(e.slice8u, radio);
+        benchmark::DoNotOptimize(r.data);
+    }
+    ContarPixeles(state, 512);
+}
+BENCHMARK(BM_MedianaHistogramaRadio)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+// Referencia: cv::medianBlur (ordenación con radio pequeño, histogramas con radio grande)
+void BM_MedianBlurRadio(benchmark::State& state)
+{
+    const Entrada& e = EntradaDeTamano(512);
+    const int radio = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        cv::Mat r;
+        cv::medianBlur(e.slice8u, r, 2 * radio + 1);
+        benchmark::DoNotOptimize(r.data);
+    }
+    ContarPixeles(state, 512);
+}
+BENCHMARK(BM_MedianBlurRadio)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+void BM_FiltroGuiadoRadio(benchmark::State& state)
+{
+    const Entrada& e = EntradaDeTamano(512);
+    const int radio = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        cv::Mat r = FiltroGuiadoRapido(e.slice8u, radio, 0.01, 4);
+        benchmark::DoNotOptimize(r.data);
+    }
+    ContarPixeles(state, 512);
+}
+BENCHMARK(BM_FiltroGuiadoRadio)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+// Referencia: bilateral de OpenCV con la misma ventana (coste proporcional a su área)
+void BM_BilateralRadio(benchmark::State& state)
+{
+    const Entrada& e = EntradaDeTamano(512);
+    const int radio = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        cv::Mat r;
+        cv::bilateralFilter(e.slice8u, r, 2 * radio + 1, 25.0, radio / 2.0);
+        benchmark::DoNotOptimize(r.data);
+    }
+    ContarPixeles(state, 512);
+}
+BENCHMARK(BM_BilateralRadio)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+// —————— Overlay de ProcesarYGuardarSlice (filtro 0 = sin filtro: sólo refinado de máscara + composición) ——————
+BENCH_SLICE(BM_Composicion,         ProcesarSlice(e.slice8u, e.mascaraBin, 0));
+
+// —————— Composición del overlay (una pasada con la LUT de la paleta), 1 etiqueta frente a 4 ——————
+BENCH_SLICE(BM_ComponerOverlay1Etiqueta,  ComponerOverlay(e.slice8u, e.etiquetaUnica, e.bordes));
+BENCH_SLICE(BM_ComponerOverlay4Etiquetas, ComponerOverlay(e.slice8u, e.etiquetasVarias, e.bordes));
+
+// —————— Slice completo: filtro 10 (todos en secuencia) + composición ——————
+BENCH_SLICE(BM_SliceTodosFiltros,   ProcesarSlice(e.slice8u, e.mascaraBin, 10));
+
+// —————— Conversiones a 8 bits ——————
+BENCH_SLICE(BM_Normalizar16a8,      Normalizar16a8(e.plano16));
+BENCH_SLICE(BM_BinarizarMascara,    BinarizarMascara(e.mascara16));
+
+// —————— Máscara empaquetada a bits (MascaraCompacta.h) ——————
+BENCH_SLICE(BM_ExpandirMascaraBits, e.mascaraBits.Expandir());
+
+void BM_EmpaquetarMascara(benchmark::State& state)
+{
+    const int lado = static_cast<int>(state.range(0));
+    const Entrada& e = EntradaDeTamano(lado);
+    for (auto _ : state)
+    {
+        PlanoMascaraBits bits = PlanoMascaraBits::Empaquetar(e.mascara16);
+        benchmark::DoNotOptimize(bits.Fila(0));
+    }
+    ContarPixeles(state, lado);
+}
+BENCHMARK(BM_EmpaquetarMascara)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// Área y caja envolvente: popcount/ctz sobre palabras frente a countNonZero/boundingRect de 8 bits
+void BM_AreaCajaMascaraBits(benchmark::State& state)
+{
+    const int lado = static_cast<int>(state.range(0));
+    const Entrada& e = EntradaDeTamano(lado);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(e.mascaraBits.Area());
+        benchmark::DoNotOptimize(e.mascaraBits.CajaEnvolvente());
+    }
+    ContarPixeles(state, lado);
+}
+BENCHMARK(BM_AreaCajaMascaraBits)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+void BM_AreaCajaMascara8u(benchmark::State& state)
+{
+    const int lado = static_cast<int>(state.range(0));
+    const Entrada& e = EntradaDeTamano(lado);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cv::countNonZero(e.mascaraBin));
+        benchmark::DoNotOptimize(cv::boundingRect(e.mascaraBin));
+    }
+    ContarPixeles(state, lado);
+}
+BENCHMARK(BM_AreaCajaMascara8u)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// —————— Modo 3D (Filtros3D.h) frente al bucle 2D por slices ——————
+// Volumen sintético de kPlanosVolumen planos con el espaciado típico de un TC de tórax
+// (cortes de 2.5 mm: el suavizado y la morfología tienen radio 1 en z)
+constexpr int kPlanosVolumen = 64;
+
+const Volumen8u& VolumenDeTamano(int lado)
+{
+    static std::map<int, Volumen8u> volumenes;
+    auto it = volumenes.find(lado);
+    if (it != volumenes.end()) return it->second;
+
+    const size_t voxelesPlano = static_cast<size_t>(lado) * lado;
+    std::vector<short> datos(voxelesPlano * kPlanosVolumen);
+    for (int z = 0; z < kPlanosVolumen; ++z) {
+        cv::Mat plano16, mascara16;
+        GenerarPlanoSintetico(cv::Size(lado, lado), static_cast<double>(z) / (kPlanosVolumen - 1),
+                              12345 + z, plano16, mascara16);
+        std::memcpy(datos.data() + z * voxelesPlano, plano16.ptr<short>(), voxelesPlano * sizeof(short));
+    }
+    const double espaciado[3] = { 0.7, 0.7, 2.5 };
+    return volumenes.emplace(lado, NormalizarVolumenA8(datos.data(), CV_16S, lado, lado, kPlanosVolumen,
+                                                       espaciado)).first->second;
+}
+
+void ContarVoxeles(benchmark::State& state, const Volumen8u& vol)
+{
+    const double voxeles = static_cast<double>(vol.VoxelesPlano()) * vol.Nz();
+    state.counters["MPix/s"] = benchmark::Counter(voxeles * state.iterations() / 1e6,
+                                                  benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(static_cast<int64_t>(voxeles) * state.iterations());
+}
+
+// Filtros con versión 3D x lado del plano
+void ArgumentosVolumen(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({ "filtro", "lado" });
+    for (int filtro : { 5, 7, 8, 13 })
+        for (int lado : { 256, 512 }) b->Args({ filtro, lado });
+}
+
+// Filtro 5, 7, 8 ó 13 sobre cada plano axial, en paralelo por planos como ProcesarTodosSlices
+void BM_Filtro2DPorSlices(benchmark::State& state)
+{
+    const int filtro = static_cast<int>(state.range(0));
+    const Volumen8u& vol = VolumenDeTamano(static_cast<int>(state.range(1)));
+    for (auto _ : state)
+    {
+        cv::parallel_for_(cv::Range(0, vol.Nz()), [&](const cv::Range& r) {
+            for (int z = r.start; z < r.end; ++z) {
+                const cv::Mat plano = vol.PlanoAxial(z);
+                cv::Mat res = (filtro == 5)  ? aplicarDeteccionBordes(plano)
+                            : (filtro == 7)  ? aplicarFiltroSuavizado(plano)
+                            : (filtro == 13) ? aplicarClahe(plano)
+                                             : aplicarOperacionesMorfo(plano);
+                benchmark::DoNotOptimize(res.data);
+            }
+        });
+    }
+    ContarVoxeles(state, vol);
+}
+BENCHMARK(BM_Filtro2DPorSlices)->Apply(ArgumentosVolumen)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_Filtro3D(benchmark::State& state)
+{
+    const int filtro = static_cast<int>(state.range(0));
+    const Volumen8u& vol = VolumenDeTamano(static_cast<int>(state.range(1)));
+    for (auto _ : state)
+    {
+        Volumen8u res = AplicarFiltro3D(vol, filtro);
+        benchmark::DoNotOptimize(res.Datos());
+    }
+    ContarVoxeles(state, vol);
+}
+BENCHMARK(BM_Filtro3D)->Apply(ArgumentosVolumen)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Filtro 9 (watershed) por slices frente al watershed 3D, y las componentes conexas solas
+void BM_Watershed2DPorSlices(benchmark::State& state)
+{
+    const Volumen8u& vol = VolumenDeTamano(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        cv::parallel_for_(cv::Range(0, vol.Nz()), [&](const cv::Range& r) {
+            for (int z = r.start; z < r.end; ++z) {
+                cv::Mat res = aplicarOtraTecnica(vol.PlanoAxial(z));
+                benchmark::DoNotOptimize(res.data);
+            }
+        });
+    }
+    ContarVoxeles(state, vol);
+}
+BENCHMARK(BM_Watershed2DPorSlices)->Arg(256)->Arg(512)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_Segmentacion3D(benchmark::State& state)
+{
+    const Volumen8u& vol = VolumenDeTamano(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        std::vector<ComponenteConexa> regiones;
+        VolumenEtiquetas res = SegmentarWatershed3D(vol, &regiones);
+        benchmark::DoNotOptimize(res.Datos());
+    }
+    ContarVoxeles(state, vol);
+}
+BENCHMARK(BM_Segmentacion3D)->Arg(256)->Arg(512)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Sobre los bordes 3D: muchas componentes pequeñas y alargadas que cruzan los bloques
+void BM_ComponentesConexas3D(benchmark::State& state)
+{
+    const Volumen8u& vol = VolumenDeTamano(static_cast<int>(state.range(0)));
+    const Volumen8u bordes = BordesCanny3D(vol);
+    for (auto _ : state)
+    {
+        std::vector<ComponenteConexa> componentes;
+        VolumenEtiquetas res = ComponentesConexas3D(bordes, 26, &componentes);
+        benchmark::DoNotOptimize(res.Datos());
+    }
+    ContarVoxeles(state, vol);
+}
+BENCHMARK(BM_ComponentesConexas3D)->Arg(256)->Arg(512)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Las conversiones desde ITK reciben la imagen 2D ya extraída (la extracción no se mide)
+void BM_ITKImage2DtoCVMat(benchmark::State& state)
+{
+    const int lado = static_cast<int>(state.range(0));
+    const ImageType2D::Pointer imagen = PlanoAITK(EntradaDeTamano(lado).plano16);
+    ArenaMat arena;
+    for (auto _ : state)
+    {
+        arena.Reiniciar();
+        cv::Mat r = ITKImage2DtoCVMat(imagen);
+        benchmark::DoNotOptimize(r.data);
+    }
+    ContarPixeles(state, lado);
+}
+BENCHMARK(BM_ITKImage2DtoCVMat)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+void BM_ITKMask2BinCVMat(benchmark::State& state)
+{
+    const int lado = static_cast<int>(state.range(0));
+    const ImageType2D::Pointer mascara = PlanoAITK(EntradaDeTamano(lado).mascara16);
+    ArenaMat arena;
+    for (auto _ : state)
+    {
+        arena.Reiniciar();
+        cv::Mat r = ITKMask2BinCVMat(mascara);
+        benchmark::DoNotOptimize(r.data);
+    }
+    ContarPixeles(state, lado);
+}
+BENCHMARK(BM_ITKMask2BinCVMat)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    // Para comparar resultados de distintos commits
+    benchmark::AddCustomContext("commit", RM_COMMIT);
+    benchmark::AddCustomContext("opencvHilos", std::to_string(cv::getNumThreads()));
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,527 @@
+// BenchInterfaz.cpp
+// Benchmark de la interfaz sin pantalla (plataforma "offscreen" de Qt): abre MainWindow
+// con un caso sintético y mide lo que el usuario percibe como velocidad de la herramienta:
+//  - para cada filtro, el tiempo desde que se elige en el combo hasta que se pinta el
+//    primer slice (procesando y, otra vez, con los resultados ya vigentes en Output/);
+//  - el slider recorrido a ritmos fijos: latencia de cada frame (desde que cambia el
+//    valor hasta que la vista filtrada se repinta) y actualizaciones perdidas.
+// Los QMessageBox que abre la ventana se cierran solos y su tiempo se descuenta.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <QApplication>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDir>
+#include <QEvent>
+#include <QEventLoop>
+#include <QGuiApplication>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPixmap>
+#include <QPushButton>
+#include <QSlider>
+#include <QTest>
+#include <QTimer>
+#include <opencv2/core.hpp>
+#include "MainWindow.h"
+#include "Manifiesto.h"
+#include "VolumenSintetico.h"
+
+#ifndef RM_COMMIT
+#define RM_COMMIT "desconocido"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Reloj = std::chrono::steady_clock;
+
+double MsDesde(Reloj::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Reloj::now() - t0).count();
+}
+
+struct OpcionesBenchInterfaz
+{
+    OpcionesVolumenSintetico volumen;
+    std::vector<int> filtros;                 // vacío = todos (1–kNumFiltros)
+    std::vector<int> ritmos{ 30, 60, 120 };   // cambios del slider por segundo
+    double segundos = 3.0;                    // duración de cada recorrido del slider
+    std::string carpeta = (fs::temp_directory_path() / "rm_bench_interfaz").string();
+    std::string rutaJson;                     // vacío = <carpeta>/bench_interfaz_<commit>.json
+};
+
+struct MedidaFiltro
+{
+    int filtro = 0;
+    int numSlices = 0;
+    double msPrimerSlice = 0.0;    // elegir filtro -> primer slice pintado (sin diálogos)
+    double msProcesado   = 0.0;    // msTotal del manifiesto (ProcesarTodosSlices)
+    double msDialogos    = 0.0;    // lo que estuvieron abiertos los QMessageBox (descontado)
+    double msReaplicar   = 0.0;    // mismo filtro otra vez: resultados vigentes, sin procesar
+};
+
+struct MedidaRecorrido
+{
+    int ritmo = 0;
+    int intervaloMs = 0;
+    double segundos = 0.0;
+    long long ticks = 0;               // cambios de valor hechos
+    long long ticksPerdidos = 0;       // los que el temporizador no pudo dar (bucle ocupado)
+    long long superpuestos = 0;        // cambios pedidos antes de pintarse el anterior
+    long long mostrados = 0;           // frames que llegaron a pintarse
+    double fpsMostrados = 0.0;
+    double p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;   // latencia hasta el repintado (ms)
+    double manejadorP50 = 0.0, manejadorMax = 0.0;       // onSliderValueChanged (ms)
+};
+
+double Percentil(std::vector<double> valores, double p)
+{
+    // Rango más cercano, como en ResumirTraza
+    if (valores.empty()) return 0.0;
+    std::sort(valores.begin(), valores.end());
+    size_t k = static_cast<size_t>(std::ceil(p * static_cast<double>(valores.size())));
+    k = std::min(std::max<size_t>(k, 1), valores.size());
+    return valores[k - 1];
+}
+
+qint64 ClavePixmap(const QLabel* vista)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    return vista->pixmap(Qt::ReturnByValue).cacheKey();
+#else
+    return vista->pixmap() ? vista->pixmap()->cacheKey() : 0;
+#endif
+}
+
+/**
+ * Cierra cada QMessageBox en cuanto se muestra (su exec() no bloquea el benchmark)
+ * y suma el tiempo que estuvo abierto. Los avisos y errores hacen fallar la medida.
+ */
+class CerradorDialogos : public QObject
+{
+public:
+    double msAbiertos = 0.0;
+    std::vector<std::string> errores;
+
+protected:
+    bool eventFilter(QObject* obj, QEvent* e) override
+    {
+        if (e->type() != QEvent::Show && e->type() != QEvent::Hide) return false;
+        auto* caja = qobject_cast<QMessageBox*>(obj);
+        if (!caja) return false;
+
+        if (e->type() == QEvent::Show) {
+            abierto = Reloj::now();
+            if (caja->icon() == QMessageBox::Critical || caja->icon() == QMessageBox::Warning)
+                errores.push_back(caja->text().toStdString());
+            QTimer::singleShot(0, caja, [caja] { caja->accept(); });
+        } else {
+            msAbiertos += MsDesde(abierto);
+        }
+        return false;
+    }
+
+private:
+    Reloj::time_point abierto;
+};
+
+/**
+ * Cuenta los repintados de la vista filtrada que muestran una imagen nueva (el
+ * momento en que Qt entrega el evento de pintado) y avisa de cada uno.
+ */
+class ObservadorPintado : public QObject
+{
+public:
+    explicit ObservadorPintado(QLabel* vista) : vista(vista) { vista->installEventFilter(this); }
+
+    long long pintadosNuevos = 0;
+    std::function<void()> alPintarNueva;
+
+    // Procesa eventos hasta que haya más de 'desde' repintados nuevos; false si vence el plazo
+    bool Esperar(long long desde, int plazoMs)
+    {
+        const auto t0 = Reloj::now();
+        while (pintadosNuevos <= desde)
+        {
+            if (MsDesde(t0) > plazoMs) return false;
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+        }
+        return true;
+    }
+
+protected:
+    bool eventFilter(QObject*, QEvent* e) override
+    {
+        if (e->type() == QEvent::Paint)
+        {
+            const qint64 clave = ClavePixmap(vista);
+            if (clave != 0 && clave != ultimaClave) {
+                ultimaClave = clave;
+                ++pintadosNuevos;
+                if (alPintarNueva) alPintarNueva();
+            }
+        }
+        return false;
+    }
+
+private:
+    QLabel* vista;
+    qint64 ultimaClave = 0;
+};
+
+void mostrarUso()
+{
+    std::cout << "Uso:\n"
+              << "  RMBenchInterfaz [opciones]\n"
+              << "\n"
+              << "Opciones:\n"
+              << "  --tam N             Ancho y alto de cada plano (por defecto 256)\n"
+              << "  --planos N          Planos en z (por defecto 48)\n"
+              << "  --tipo T            int16|uint8|uint16|float32 (por defecto int16)\n"
+              << "  --filtros A,B,...   Filtros a medir (por defecto 1–" << kNumFiltros << ")\n"
+              << "  --ritmos A,B,...    Cambios del slider por segundo (por defecto 30,60,120)\n"
+              << "  --segundos S        Duración de cada recorrido del slider (por defecto 3)\n"
+              << "  --carpeta ruta      Volúmenes y Output/ (por defecto <tmp>/rm_bench_interfaz)\n"
+              << "  --json ruta         Resultado (por defecto <carpeta>/bench_interfaz_<commit>.json)\n"
+              << "\n"
+              << "Corre sin pantalla (QT_QPA_PLATFORM=offscreen) salvo que QT_QPA_PLATFORM diga otra cosa.\n";
+}
+
+bool leerEntero(const std::string& texto, int& valor)
+{
+    try {
+        size_t usados = 0;
+        valor = std::stoi(texto, &usados);
+        return usados == texto.size();
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool leerLista(const std::string& texto, int minimo, int maximo, std::vector<int>& valores)
+{
+    valores.clear();
+    std::stringstream ss(texto);
+    std::string parte;
+    while (std::getline(ss, parte, ','))
+    {
+        int v = 0;
+        if (!leerEntero(parte, v) || v < minimo || v > maximo) return false;
+        valores.push_back(v);
+    }
+    return !valores.empty();
+}
+
+bool leerOpciones(int argc, char* argv[], OpcionesBenchInterfaz& op)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hayValor = i + 1 < argc;
+        if (arg == "--tam" && hayValor) {
+            int tam = 0;
+            if (!leerEntero(argv[++i], tam) || tam < 16) return false;
+            op.volumen.ancho = op.volumen.alto = tam;
+        } else if (arg == "--planos" && hayValor) {
+            // Con un solo plano el slider no tiene nada que recorrer
+            if (!leerEntero(argv[++i], op.volumen.planos) || op.volumen.planos < 2) return false;
+        } else if (arg == "--tipo" && hayValor) {
+            if (!LeerTipoPixel(argv[++i], op.volumen.tipo)) return false;
+        } else if (arg == "--filtros" && hayValor) {
+            if (!leerLista(argv[++i], 1, kNumFiltros, op.filtros)) return false;
+        } else if (arg == "--ritmos" && hayValor) {
+            if (!leerLista(argv[++i], 1, 1000, op.ritmos)) return false;
+        } else if (arg == "--segundos" && hayValor) {
+            try { op.segundos = std::stod(argv[++i]); }
+            catch (const std::exception&) { return false; }
+            if (op.segundos <= 0.0) return false;
+        } else if (arg == "--carpeta" && hayValor) {
+            op.carpeta = argv[++i];
+        } else if (arg == "--json" && hayValor) {
+            op.rutaJson = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Elige el filtro, pulsa "Aplicar filtro" y espera al primer slice pintado (dos veces:
+// procesando y con los resultados ya vigentes); false si algo falló
+bool MedirFiltro(MainWindow& ventana, CerradorDialogos& cerrador, ObservadorPintado& observador,
+                 int filtro, MedidaFiltro& m)
+{
+    auto* combo  = ventana.findChild<QComboBox*>("comboFilter");
+    auto* boton  = ventana.findChild<QPushButton*>("btnApplyFilter");
+    m.filtro = filtro;
+
+    for (int pasada = 0; pasada < 2; ++pasada)
+    {
+        const long long pintados = observador.pintadosNuevos;
+        const double msDialogos  = cerrador.msAbiertos;
+        const size_t errores     = cerrador.errores.size();
+
+        const auto t0 = Reloj::now();
+        combo->setCurrentIndex(filtro - 1);
+        QTest::mouseClick(boton, Qt::LeftButton);      // onApplyFilter corre aquí mismo
+        const bool pintado = observador.Esperar(pintados, 120000);
+        const double ms = MsDesde(t0);
+        const double dialogos = cerrador.msAbiertos - msDialogos;
+
+        if (cerrador.errores.size() != errores) {
+            std::cerr << "[ERROR] Filtro " << filtro << ": " << cerrador.errores.back() << "\n";
+            return false;
+        }
+        if (!pintado) {
+            std::cerr << "[ERROR] Filtro " << filtro << ": no se pintó ningún slice.\n";
+            return false;
+        }
+        if (pasada == 0) {
+            m.msPrimerSlice = ms - dialogos;
+            m.msDialogos    = dialogos;
+        } else {
+            m.msReaplicar   = ms - dialogos;
+        }
+    }
+
+    ManifiestoResultados manifiesto;
+    if (LeerManifiesto("Output/", manifiesto)) {
+        m.numSlices   = manifiesto.NumSlices();
+        m.msProcesado = manifiesto.msTotal;
+    }
+    return true;
+}
+
+// Mueve el slider un paso cada 1000/ritmo ms durante 'segundos' (vuelve al principio al llegar al final)
+MedidaRecorrido RecorrerSlider(QSlider* slider, ObservadorPintado& observador, int ritmo, double segundos)
+{
+    MedidaRecorrido m;
+    m.ritmo = ritmo;
+    m.intervaloMs = std::max(1, static_cast<int>(std::lround(1000.0 / ritmo)));
+
+    std::vector<double> latencias, manejador;
+    bool pendiente = false;
+    Reloj::time_point tPeticion;
+    observador.alPintarNueva = [&] {
+        if (!pendiente) return;
+        latencias.push_back(MsDesde(tPeticion));
+        pendiente = false;
+    };
+
+    const int n = slider->maximum() - slider->minimum() + 1;
+    QTimer temporizador;
+    temporizador.setTimerType(Qt::PreciseTimer);
+    temporizador.setInterval(m.intervaloMs);
+    QObject::connect(&temporizador, &QTimer::timeout, [&] {
+        ++m.ticks;
+        if (pendiente) ++m.superpuestos;
+        const int valor = slider->minimum() + (slider->value() - slider->minimum() + 1) % n;
+        pendiente = true;
+        tPeticion = Reloj::now();
+        slider->setValue(valor);                       // onSliderValueChanged corre aquí mismo
+        manejador.push_back(MsDesde(tPeticion));
+    });
+
+    QEventLoop bucle;
+    const auto t0 = Reloj::now();
+    temporizador.start();
+    QTimer::singleShot(static_cast<int>(segundos * 1000.0), &bucle, &QEventLoop::quit);
+    bucle.exec();
+    temporizador.stop();
+    m.segundos = MsDesde(t0) / 1000.0;
+
+    // El último cambio todavía puede estar por pintarse: no cuenta como perdido
+    if (pendiente) observador.Esperar(observador.pintadosNuevos, 1000);
+    observador.alPintarNueva = nullptr;
+
+    const long long esperados = std::llround(m.segundos * 1000.0 / m.intervaloMs);
+    m.ticksPerdidos = std::max(0LL, esperados - m.ticks);
+    m.mostrados     = static_cast<long long>(latencias.size());
+    m.fpsMostrados  = m.segundos > 0 ? m.mostrados / m.segundos : 0.0;
+    m.p50 = Percentil(latencias, 0.50);
+    m.p90 = Percentil(latencias, 0.90);
+    m.p99 = Percentil(latencias, 0.99);
+    m.max = Percentil(latencias, 1.0);
+    m.manejadorP50 = Percentil(manejador, 0.50);
+    m.manejadorMax = Percentil(manejador, 1.0);
+    return m;
+}
+
+bool GuardarJson(const OpcionesBenchInterfaz& op, const std::vector<MedidaFiltro>& filtros,
+                 const std::vector<MedidaRecorrido>& recorridos, const std::string& ruta)
+{
+    try
+    {
+        const fs::path rutaFinal{ ruta };
+        const fs::path rutaTmp = rutaFinal.string() + ".tmp";
+        {
+            cv::FileStorage out(rutaTmp.string(), cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+            if (!out.isOpened()) {
+                std::cerr << "[ERROR] No se pudo escribir el resultado en '" << rutaTmp.string() << "'.\n";
+                return false;
+            }
+            out << "commit"     << std::string(RM_COMMIT);
+            out << "plataforma" << QGuiApplication::platformName().toStdString();
+            out << "ancho"      << op.volumen.ancho;
+            out << "alto"       << op.volumen.alto;
+            out << "planos"     << op.volumen.planos;
+            out << "tipo"       << std::string(NombreTipoPixel(op.volumen.tipo));
+
+            out << "filtros" << "[";
+            for (const auto& m : filtros)
+            {
+                out << "{";
+                out << "filtro"        << m.filtro;
+                out << "numSlices"     << m.numSlices;
+                out << "msPrimerSlice" << m.msPrimerSlice;
+                out << "msProcesado"   << m.msProcesado;
+                out << "msDialogos"    << m.msDialogos;
+                out << "msReaplicar"   << m.msReaplicar;
+                out << "}";
+            }
+            out << "]";
+
+            out << "slider" << "[";
+            for (const auto& m : recorridos)
+            {
+                out << "{";
+                out << "ritmo"         << m.ritmo;
+                out << "intervaloMs"   << m.intervaloMs;
+                out << "segundos"      << m.segundos;
+                out << "cambios"       << static_cast<double>(m.ticks);
+                out << "ticksPerdidos" << static_cast<double>(m.ticksPerdidos);
+                out << "superpuestos"  << static_cast<double>(m.superpuestos);
+                out << "mostrados"     << static_cast<double>(m.mostrados);
+                out << "fpsMostrados"  << m.fpsMostrados;
+                out << "latenciaMs" << "{" << "p50" << m.p50 << "p90" << m.p90
+                    << "p99" << m.p99 << "max" << m.max << "}";
+                out << "manejadorMs" << "{" << "p50" << m.manejadorP50 << "max" << m.manejadorMax << "}";
+                out << "}";
+            }
+            out << "]";
+        }
+        fs::rename(rutaTmp, rutaFinal);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[ERROR] Guardando resultado: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // Sin pantalla salvo que se pida otra plataforma (p. ej. QT_QPA_PLATFORM=xcb para verlo)
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);      // quita de argv las opciones propias de Qt
+
+    OpcionesBenchInterfaz op;
+    op.volumen.ancho = op.volumen.alto = 256;
+    op.volumen.planos = 48;
+    if (!leerOpciones(argc, argv, op)) {
+        mostrarUso();
+        return EXIT_FAILURE;
+    }
+    if (op.filtros.empty()) for (int f = 1; f <= kNumFiltros; ++f) op.filtros.push_back(f);
+    if (op.rutaJson.empty())
+        op.rutaJson = (fs::path(op.carpeta) / ("bench_interfaz_" + std::string(RM_COMMIT) + ".json")).string();
+    op.rutaJson = fs::absolute(op.rutaJson).string();
+
+    // --- 1) Volumen sintético (se reutiliza si ya existe con las mismas opciones) ---
+    std::string rutaImagen, rutaMascara;
+    if (!GenerarVolumenSintetico(op.volumen, (fs::path(op.carpeta) / "volumenes").string(),
+                                 rutaImagen, rutaMascara))
+        return EXIT_FAILURE;
+    rutaImagen  = fs::absolute(rutaImagen).string();
+    rutaMascara = fs::absolute(rutaMascara).string();
+
+    // La ventana escribe en Output/ relativo al directorio actual: uno limpio para el benchmark
+    const fs::path trabajo = fs::absolute(fs::path(op.carpeta) / "interfaz");
+    std::error_code ec;
+    fs::remove_all(trabajo, ec);
+    fs::create_directories(trabajo, ec);
+    if (ec || !QDir::setCurrent(QString::fromStdString(trabajo.string()))) {
+        std::cerr << "[ERROR] No se pudo usar la carpeta '" << trabajo.string() << "'.\n";
+        return EXIT_FAILURE;
+    }
+
+    // --- 2) Ventana con el caso cargado, como la vería el usuario ---
+    MainWindow ventana;
+    ventana.establecerEntradas(QString::fromStdString(rutaImagen), QString::fromStdString(rutaMascara));
+    ventana.show();
+    if (!QTest::qWaitForWindowExposed(&ventana)) {
+        std::cerr << "[ERROR] La ventana no llegó a mostrarse.\n";
+        return EXIT_FAILURE;
+    }
+
+    auto* vista  = ventana.findChild<QLabel*>("lblFilteredView");
+    auto* slider = ventana.findChild<QSlider*>("sliderSlice");
+    auto* video  = ventana.findChild<QCheckBox*>("chkVideoAlProcesar");
+    if (!vista || !slider || !video || !ventana.findChild<QComboBox*>("comboFilter") ||
+        !ventana.findChild<QPushButton*>("btnApplyFilter"))
+    {
+        std::cerr << "[ERROR] MainWindow no tiene los widgets esperados (objectName).\n";
+        return EXIT_FAILURE;
+    }
+    video->setChecked(false);          // el diálogo de rango del video no se mide aquí
+
+    CerradorDialogos cerrador;
+    app.installEventFilter(&cerrador);
+    ObservadorPintado observador(vista);
+
+    // --- 3) Cada filtro: elegirlo -> primer slice pintado ---
+    std::cout << "Plataforma Qt: " << QGuiApplication::platformName().toStdString() << "\n\n"
+              << std::setw(7) << "filtro" << std::setw(16) << "primer slice" << std::setw(13) << "procesado"
+              << std::setw(12) << "diálogos" << std::setw(13) << "reaplicar" << "   (ms)\n";
+    std::vector<MedidaFiltro> filtros;
+    for (int filtro : op.filtros)
+    {
+        MedidaFiltro m;
+        if (!MedirFiltro(ventana, cerrador, observador, filtro, m)) return EXIT_FAILURE;
+        filtros.push_back(m);
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(7) << m.filtro << std::setw(16) << m.msPrimerSlice << std::setw(13) << m.msProcesado
+                  << std::setw(12) << m.msDialogos << std::setw(13) << m.msReaplicar << "\n";
+    }
+
+    // --- 4) Slider a ritmos fijos sobre los resultados del último filtro ---
+    if (slider->maximum() <= slider->minimum()) {
+        std::cerr << "[ERROR] El slider no tiene slices que recorrer.\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "\n" << std::setw(7) << "ritmo" << std::setw(10) << "mostrados" << std::setw(8) << "fps"
+              << std::setw(9) << "p50" << std::setw(9) << "p90" << std::setw(9) << "p99" << std::setw(9) << "máx"
+              << std::setw(12) << "manejador" << std::setw(10) << "perdidos" << "   (latencia en ms)\n";
+    std::vector<MedidaRecorrido> recorridos;
+    for (int ritmo : op.ritmos)
+    {
+        const MedidaRecorrido m = RecorrerSlider(slider, observador, ritmo, op.segundos);
+        recorridos.push_back(m);
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(7) << m.ritmo << std::setw(10) << m.mostrados << std::setw(8) << m.fpsMostrados
+                  << std::setprecision(2)
+                  << std::setw(9) << m.p50 << std::setw(9) << m.p90 << std::setw(9) << m.p99 << std::setw(9) << m.max
+                  << std::setw(12) << m.manejadorP50 << std::setw(10) << (m.ticksPerdidos + m.superpuestos) << "\n";
+    }
+    std::cout << "\nLatencia: del cambio de valor al repintado de la vista filtrada. Perdidos: cambios que "
+                 "el temporizador no pudo dar más los que se pidieron antes de pintarse el anterior.\n";
+
+    if (!GuardarJson(op, filtros, recorridos, op.rutaJson)) return EXIT_FAILURE;
+    std::cout << "[INFO] Resultado guardado en: " << op.rutaJson << "\n";
+    return EXIT_SUCCESS;
+}
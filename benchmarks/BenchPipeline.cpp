@@ -0,0 +1,344 @@
+// BenchPipeline.cpp
+// Benchmark de extremo a extremo: genera (o reutiliza) un volumen NIfTI sintético,
+// ejecuta ProcesarTodosSlices y GenerarVideoHighlighted con distintos números de
+// hilos y reparte el tiempo entre lectura, extracción, conversión, filtro,
+// composición, codificación y escritura. La curva de escalado (aceleración y
+// eficiencia respecto al primer número de hilos) se muestra y se guarda en JSON.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>   // para cv::setNumThreads
+#include "Utils.h"
+#include "Perfil.h"
+#include "Memoria.h"
+#include "VolumenSintetico.h"
+
+#ifndef RM_COMMIT
+#define RM_COMMIT "desconocido"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct OpcionesBench
+{
+    OpcionesVolumenSintetico volumen;
+    int filtro = 7;
+    Orientacion orientacion = Orientacion::Axial;
+    bool modo3D = false;                // OpcionesProcesado::modo3D
+    std::vector<int> hilos;             // vacío = 1, 2, 4... hasta todos los núcleos
+    int repeticiones = 3;
+    bool video = true;
+    std::string carpeta = (fs::temp_directory_path() / "rm_bench_pipeline").string();
+    std::string rutaJson;               // vacío = <carpeta>/bench_pipeline_<commit>.json
+};
+
+// Una pasada: reloj, tiempo por etapa (sumado entre hilos) y pico de memoria
+struct Medida
+{
+    double msReloj = 0.0;
+    double ms[kNumEtapas] = {};
+    EstadoMemoria memoria;
+
+    void TomarDe(const PerfilEtapas& perfil)
+    {
+        for (int e = 0; e < kNumEtapas; ++e) ms[e] = perfil.Ms(static_cast<Etapa>(e));
+        memoria = LeerMemoria();
+    }
+};
+
+struct ResultadoHilos
+{
+    int hilos = 0;
+    Medida procesado;                   // ProcesarTodosSlices (la repetición mediana)
+    Medida video;                       // GenerarVideoHighlighted de esa misma repetición
+    double aceleracion = 1.0;
+    double eficiencia  = 1.0;
+};
+
+void mostrarUso()
+{
+    std::cout << "Uso:\n"
+              << "  RMBenchPipeline [opciones]\n"
+              << "\n"
+              << "Opciones:\n"
+              << "  --tam N             Ancho y alto de cada plano (por defecto 512)\n"
+              << "  --planos N          Planos en z (por defecto 128)\n"
+              << "  --tipo T            int16|uint8|uint16|float32 (por defecto int16)\n"
+              << "  --gz                Volúmenes .nii.gz en vez de .nii\n"
+              << "  --filtro N          Filtro 1–" << kNumFiltros << " (por defecto 7)\n"
+              << "  --orientacion O     axial|coronal|sagital (por defecto axial)\n"
+              << "  --3d                Modo 3D: máscara y filtros 5, 7, 8, 9 y 13 sobre el volumen\n"
+              << "  --hilos A,B,...     Hilos a probar (por defecto 1, 2, 4... hasta todos los núcleos)\n"
+              << "  --repeticiones N    Pasadas por número de hilos; se usa la mediana (por defecto 3)\n"
+              << "  --sin-video         No medir GenerarVideoHighlighted\n"
+              << "  --carpeta ruta      Volúmenes y resultados (por defecto <tmp>/rm_bench_pipeline)\n"
+              << "  --json ruta         Resultado (por defecto <carpeta>/bench_pipeline_<commit>.json)\n";
+}
+
+bool leerEntero(const std::string& texto, int& valor)
+{
+    try {
+        size_t usados = 0;
+        valor = std::stoi(texto, &usados);
+        return usados == texto.size();
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool leerListaHilos(const std::string& texto, std::vector<int>& hilos)
+{
+    hilos.clear();
+    std::stringstream ss(texto);
+    std::string parte;
+    while (std::getline(ss, parte, ','))
+    {
+        int h = 0;
+        if (!leerEntero(parte, h) || h < 1) return false;
+        hilos.push_back(h);
+    }
+    return !hilos.empty();
+}
+
+bool leerOpciones(int argc, char* argv[], OpcionesBench& op)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hayValor = i + 1 < argc;
+        if (arg == "--tam" && hayValor) {
+            int tam = 0;
+            if (!leerEntero(argv[++i], tam) || tam < 16) return false;
+            op.volumen.ancho = op.volumen.alto = tam;
+        } else if (arg == "--planos" && hayValor) {
+            if (!leerEntero(argv[++i], op.volumen.planos) || op.volumen.planos < 1) return false;
+        } else if (arg == "--tipo" && hayValor) {
+            if (!LeerTipoPixel(argv[++i], op.volumen.tipo)) return false;
+        } else if (arg == "--gz") {
+            op.volumen.comprimir = true;
+        } else if (arg == "--filtro" && hayValor) {
+            if (!leerEntero(argv[++i], op.filtro) || op.filtro < 1 || op.filtro > kNumFiltros) return false;
+        } else if (arg == "--orientacion" && hayValor) {
+            const std::string nombre = argv[++i];
+            op.orientacion = OrientacionDesdeNombre(nombre);
+            if (nombre != NombreOrientacion(op.orientacion)) return false;
+        } else if (arg == "--hilos" && hayValor) {
+            if (!leerListaHilos(argv[++i], op.hilos)) return false;
+        } else if (arg == "--repeticiones" && hayValor) {
+            if (!leerEntero(argv[++i], op.repeticiones) || op.repeticiones < 1) return false;
+        } else if (arg == "--3d") {
+            op.modo3D = true;
+        } else if (arg == "--sin-video") {
+            op.video = false;
+        } else if (arg == "--carpeta" && hayValor) {
+            op.carpeta = argv[++i];
+        } else if (arg == "--json" && hayValor) {
+            op.rutaJson = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<int> HilosPorDefecto()
+{
+    const int nucleos = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> hilos;
+    for (int h = 1; h < nucleos; h *= 2) hilos.push_back(h);
+    hilos.push_back(nucleos);
+    return hilos;
+}
+
+// Una pasada completa con 'hilos' hilos; false si el pipeline falló
+bool Pasada(const OpcionesBench& op, const std::string& rutaImagen, const std::string& rutaMascara,
+            int hilos, Medida& procesado, Medida& video)
+{
+    using Reloj = std::chrono::steady_clock;
+    const fs::path salida = fs::path(op.carpeta) / "salida";
+    std::error_code ec;
+    fs::remove_all(salida, ec);          // fuera de la medida: cada pasada escribe desde cero
+
+    OpcionesProcesado opciones;
+    opciones.orientacion = op.orientacion;
+    opciones.numHilos    = hilos;
+    opciones.modo3D      = op.modo3D;
+
+    PerfilEtapas perfil;
+    ReiniciarPicosMemoria();
+    {
+        PerfilEnHilo perfilHilo(&perfil);
+        const auto t0 = Reloj::now();
+        if (!ProcesarTodosSlices(rutaImagen, rutaMascara, salida.string() + "/", op.filtro, opciones))
+            return false;
+        procesado.msReloj = std::chrono::duration<double, std::milli>(Reloj::now() - t0).count();
+    }
+    procesado.TomarDe(perfil);
+
+    if (!op.video) return true;
+
+    const int numSlices = ContarPlanosNifti(rutaImagen, op.orientacion);
+    perfil.Reiniciar();
+    ReiniciarPicosMemoria();
+    {
+        PerfilEnHilo perfilHilo(&perfil);
+        const auto t0 = Reloj::now();
+        if (!GenerarVideoHighlighted((salida / "highlighted").string(), (salida / "video").string(),
+                                     1, numSlices))
+            return false;
+        video.msReloj = std::chrono::duration<double, std::milli>(Reloj::now() - t0).count();
+    }
+    video.TomarDe(perfil);
+    return true;
+}
+
+void ImprimirFila(const char* fase, int hilos, const Medida& m, double aceleracion, double eficiencia)
+{
+    std::cout << std::setw(6) << hilos << std::setw(7) << fase
+              << std::setw(11) << std::fixed << std::setprecision(1) << m.msReloj;
+    for (int e = 0; e < kNumEtapas; ++e) std::cout << std::setw(13) << m.ms[e];
+    std::cout << std::setw(8) << std::setprecision(2) << aceleracion
+              << std::setw(8) << std::setprecision(2) << eficiencia
+              << std::setw(10) << std::setprecision(1) << m.memoria.picoTotal / (1024.0 * 1024.0) << "\n";
+}
+
+void EscribirMedida(cv::FileStorage& out, const char* nombre, const Medida& m)
+{
+    out << nombre << "{";
+    out << "msReloj" << m.msReloj;
+    out << "msEtapas" << "{";
+    for (int e = 0; e < kNumEtapas; ++e) out << NombreEtapa(static_cast<Etapa>(e)) << m.ms[e];
+    out << "}";
+    out << "picoMemoria" << static_cast<double>(m.memoria.picoTotal);
+    out << "picosMemoria" << "{";
+    for (int c = 0; c < kNumCategoriasMemoria; ++c)
+        out << NombreCategoriaMemoria(static_cast<CategoriaMemoria>(c)) << static_cast<double>(m.memoria.picos[c]);
+    out << "}";
+    out << "}";
+}
+
+bool GuardarJson(const OpcionesBench& op, const std::vector<ResultadoHilos>& resultados, const std::string& ruta)
+{
+    try
+    {
+        const fs::path rutaFinal{ ruta };
+        const fs::path rutaTmp = rutaFinal.string() + ".tmp";
+        {
+            cv::FileStorage out(rutaTmp.string(), cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+            if (!out.isOpened()) {
+                std::cerr << "[ERROR] No se pudo escribir el resultado en '" << rutaTmp.string() << "'.\n";
+                return false;
+            }
+            out << "commit"       << std::string(RM_COMMIT);
+            out << "nucleos"      << static_cast<int>(std::thread::hardware_concurrency());
+            out << "ancho"        << op.volumen.ancho;
+            out << "alto"         << op.volumen.alto;
+            out << "planos"       << op.volumen.planos;
+            out << "tipo"         << std::string(NombreTipoPixel(op.volumen.tipo));
+            out << "comprimido"   << static_cast<int>(op.volumen.comprimir);
+            out << "filtro"       << op.filtro;
+            out << "orientacion"  << std::string(NombreOrientacion(op.orientacion));
+            out << "modo3D"       << static_cast<int>(op.modo3D);
+            out << "repeticiones" << op.repeticiones;
+
+            out << "resultados" << "[";
+            for (const auto& r : resultados)
+            {
+                out << "{";
+                out << "hilos"       << r.hilos;
+                out << "aceleracion" << r.aceleracion;
+                out << "eficiencia"  << r.eficiencia;
+                EscribirMedida(out, "procesado", r.procesado);
+                if (op.video) EscribirMedida(out, "video", r.video);
+                out << "}";
+            }
+            out << "]";
+        }
+        fs::rename(rutaTmp, rutaFinal);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[ERROR] Guardando resultado: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    OpcionesBench op;
+    if (!leerOpciones(argc, argv, op)) {
+        mostrarUso();
+        return EXIT_FAILURE;
+    }
+    if (op.hilos.empty()) op.hilos = HilosPorDefecto();
+    if (op.rutaJson.empty())
+        op.rutaJson = (fs::path(op.carpeta) / ("bench_pipeline_" + std::string(RM_COMMIT) + ".json")).string();
+
+    // --- 1) Volumen sintético (se reutiliza si ya existe con las mismas opciones) ---
+    std::string rutaImagen, rutaMascara;
+    if (!GenerarVolumenSintetico(op.volumen, (fs::path(op.carpeta) / "volumenes").string(),
+                                 rutaImagen, rutaMascara))
+        return EXIT_FAILURE;
+
+    // --- 2) Barrido de hilos; para cada número se queda la pasada de reloj mediano ---
+    std::cout << "\n" << std::setw(6) << "hilos" << std::setw(7) << "fase" << std::setw(11) << "reloj(ms)";
+    for (int e = 0; e < kNumEtapas; ++e) std::cout << std::setw(13) << NombreEtapa(static_cast<Etapa>(e));
+    std::cout << std::setw(8) << "acel." << std::setw(8) << "efic." << std::setw(10) << "pico(MB)" << "\n";
+
+    std::vector<ResultadoHilos> resultados;
+    for (int hilos : op.hilos)
+    {
+        // El pool de OpenCV (transposición sagital, video) usa los mismos hilos que el pipeline
+        cv::setNumThreads(hilos);
+
+        std::vector<std::pair<Medida, Medida>> pasadas(op.repeticiones);
+        for (auto& pasada : pasadas)
+        {
+            if (!Pasada(op, rutaImagen, rutaMascara, hilos, pasada.first, pasada.second)) {
+                std::cerr << "[ERROR] Falló la pasada con " << hilos << " hilos.\n";
+                return EXIT_FAILURE;
+            }
+        }
+        std::sort(pasadas.begin(), pasadas.end(), [](const auto& a, const auto& b) {
+            return a.first.msReloj + a.second.msReloj < b.first.msReloj + b.second.msReloj;
+        });
+
+        ResultadoHilos r;
+        r.hilos     = hilos;
+        r.procesado = pasadas[pasadas.size() / 2].first;
+        r.video     = pasadas[pasadas.size() / 2].second;
+        if (!resultados.empty())
+        {
+            const ResultadoHilos& base = resultados.front();
+            const double msBase = base.procesado.msReloj + base.video.msReloj;
+            const double ms     = r.procesado.msReloj + r.video.msReloj;
+            r.aceleracion = ms > 0 ? msBase / ms : 0.0;
+            r.eficiencia  = r.aceleracion * base.hilos / hilos;
+        }
+        resultados.push_back(r);
+
+        ImprimirFila("proc", hilos, r.procesado, r.aceleracion, r.eficiencia);
+        if (op.video) ImprimirFila("video", hilos, r.video, r.aceleracion, r.eficiencia);
+    }
+    std::cout << "\nTiempos por etapa sumados entre hilos; aceleración y eficiencia sobre el reloj "
+                 "total (procesado + video) respecto a " << resultados.front().hilos << " hilo(s); "
+                 "pico de memoria contada (Memoria.h) en cada fase.\n";
+
+    if (!GuardarJson(op, resultados, op.rutaJson)) return EXIT_FAILURE;
+    std::cout << "[INFO] Resultado guardado en: " << op.rutaJson << "\n";
+    return EXIT_SUCCESS;
+}
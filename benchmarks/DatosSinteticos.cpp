@@ -0,0 +1,58 @@
+// DatosSinteticos.cpp
+#include "DatosSinteticos.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+void GenerarPlanoSintetico(cv::Size tam, double z, uint64_t semilla, cv::Mat& plano16, cv::Mat& mascara16)
+{
+    const double w = tam.width, h = tam.height;
+    const double escala = std::min(w, h) / 512.0;       // los tamaños están pensados para 512²
+    cv::RNG rng(semilla);
+    auto punto = [](double x, double y) { return cv::Point(cvRound(x), cvRound(y)); };
+    auto ejes  = [](double a, double b) { return cv::Size(std::max(1, cvRound(a)), std::max(1, cvRound(b))); };
+
+    // --- Aire, cuerpo y columna ---
+    plano16.create(tam, CV_16S);
+    plano16.setTo(cv::Scalar(-1000));
+    cv::ellipse(plano16, punto(w * 0.5, h * 0.5), ejes(w * 0.45, h * 0.36), 0, 0, 360, cv::Scalar(40), cv::FILLED);
+    cv::circle(plano16, punto(w * 0.5, h * 0.77), std::max(2, cvRound(w * 0.05)), cv::Scalar(700), cv::FILLED);
+
+    // --- Pulmones: más grandes en el centro del volumen ---
+    const double factor = std::max(0.25, std::sin(3.14159265358979 * std::clamp(z, 0.0, 1.0)));
+    const cv::Point centros[2] = { punto(w * 0.32, h * 0.47), punto(w * 0.68, h * 0.47) };
+    const cv::Size ejesPulmon = ejes(w * 0.13 * factor, h * 0.22 * factor);
+    for (const auto& c : centros)
+        cv::ellipse(plano16, c, ejesPulmon, 0, 0, 360, cv::Scalar(-850), cv::FILLED);
+
+    // --- Vasos: puntos brillantes dentro de los pulmones ---
+    for (int k = 0; k < 60; ++k)
+    {
+        const cv::Point& c = centros[k % 2];
+        const double ang = rng.uniform(0.0, 2 * 3.14159265358979);
+        const double r   = std::sqrt(rng.uniform(0.0, 1.0)) * 0.9;
+        const cv::Point p(c.x + cvRound(std::cos(ang) * r * ejesPulmon.width),
+                          c.y + cvRound(std::sin(ang) * r * ejesPulmon.height));
+        cv::circle(plano16, p, std::max(1, cvRound(rng.uniform(1.0, 4.0) * escala)),
+                   cv::Scalar(rng.uniform(-100, 120)), cv::FILLED);
+    }
+
+    // --- Máscara: lesiones en la parte media del volumen ---
+    mascara16 = cv::Mat::zeros(tam, CV_16S);
+    const int numLesiones = (z < 0.3 || z > 0.7) ? 0 : 1 + rng.uniform(0, 3);
+    for (int k = 0; k < numLesiones; ++k)
+    {
+        const cv::Point& c = centros[k % 2];
+        const cv::Point p(c.x + cvRound(rng.uniform(-0.5, 0.5) * ejesPulmon.width),
+                          c.y + cvRound(rng.uniform(-0.5, 0.5) * ejesPulmon.height));
+        const cv::Size e = ejes(rng.uniform(0.02, 0.05) * w, rng.uniform(0.02, 0.05) * w);
+        const double angulo = rng.uniform(0.0, 180.0);
+        cv::ellipse(mascara16, p, e, angulo, 0, 360, cv::Scalar(1), cv::FILLED);
+        cv::ellipse(plano16,   p, e, angulo, 0, 360, cv::Scalar(rng.uniform(20, 60)), cv::FILLED);
+    }
+
+    // --- Ruido del escáner ---
+    cv::Mat ruido(tam, CV_16S);
+    rng.fill(ruido, cv::RNG::NORMAL, 0, 20);
+    cv::add(plano16, ruido, plano16);
+}
@@ -0,0 +1,21 @@
+// DatosSinteticos.h
+#ifndef DATOSSINTETICOS_H
+#define DATOSSINTETICOS_H
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+/**
+ * Plano sintético con aspecto de TC de tórax (unidades Hounsfield, CV_16S):
+ * aire fuera del cuerpo, tejido blando, dos pulmones con vasos, columna y
+ * ruido. La máscara (CV_16S, 0/1) marca unas cuantas lesiones dentro de los
+ * pulmones, como las etiquetas del dataset de pulmón del MSD.
+ *
+ * @param tam     Tamaño del plano (ancho x alto).
+ * @param z       Posición relativa en el volumen (0–1): los pulmones crecen hacia
+ *                el centro y las lesiones sólo aparecen en la parte media.
+ * @param semilla Misma semilla y mismos parámetros dan el mismo plano.
+ */
+void GenerarPlanoSintetico(cv::Size tam, double z, uint64_t semilla, cv::Mat& plano16, cv::Mat& mascara16);
+
+#endif // DATOSSINTETICOS_H
@@ -0,0 +1,193 @@
+// VolumenSintetico.cpp
+#include "VolumenSintetico.h"
+#include "DatosSinteticos.h"
+#include <itkImage.h>
+#include <itkImageFileWriter.h>
+#include <itkNiftiImageIO.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Paso de HU (CV_16S) al tipo guardado: destino = HU * alfa + beta (con saturación)
+void EscalaDeTipo(TipoPixelSintetico tipo, double& alfa, double& beta)
+{
+    alfa = 1.0;
+    beta = 0.0;
+    if (tipo == TipoPixelSintetico::UInt16) {
+        beta = 1024.0;
+    } else if (tipo == TipoPixelSintetico::UInt8) {
+        alfa = 255.0 / 2000.0;
+        beta = 127.5;
+    }
+}
+
+template <class TPixel>
+typename itk::Image<TPixel, 3>::Pointer NuevoVolumen(const OpcionesVolumenSintetico& op)
+{
+    using Imagen = itk::Image<TPixel, 3>;
+    typename Imagen::SizeType tam;
+    tam[0] = static_cast<typename Imagen::SizeValueType>(op.ancho);
+    tam[1] = static_cast<typename Imagen::SizeValueType>(op.alto);
+    tam[2] = static_cast<typename Imagen::SizeValueType>(op.planos);
+    typename Imagen::SpacingType espaciado;
+    for (unsigned int d = 0; d < 3; ++d) espaciado[d] = op.espaciado[d];
+
+    auto volumen = Imagen::New();
+    volumen->SetRegions(tam);
+    volumen->SetSpacing(espaciado);
+    volumen->Allocate();
+    return volumen;
+}
+
+template <class TImagen>
+bool EscribirNifti(const TImagen* volumen, const std::string& ruta, bool comprimir, const char* descripcion)
+{
+    auto escritor = itk::ImageFileWriter<TImagen>::New();
+    escritor->SetImageIO(itk::NiftiImageIO::New());
+    escritor->SetFileName(ruta);
+    escritor->SetInput(volumen);
+    escritor->SetUseCompression(comprimir);
+    try
+    {
+        escritor->Update();
+    }
+    catch (itk::ExceptionObject& err)
+    {
+        std::cerr << "[ERROR] Escribiendo NIfTI " << descripcion << " '" << ruta << "': " << err << "\n";
+        return false;
+    }
+    return true;
+}
+
+template <class TPixel>
+bool GenerarYEscribir(const OpcionesVolumenSintetico& op, const std::string& rutaImagen,
+                      const std::string& rutaMascara)
+{
+    auto imagen  = NuevoVolumen<TPixel>(op);
+    auto mascara = NuevoVolumen<unsigned char>(op);
+    double alfa, beta;
+    EscalaDeTipo(op.tipo, alfa, beta);
+
+    // Cada plano z se genera y se convierte directamente en los buffers de ITK
+    const size_t voxelesPlano = static_cast<size_t>(op.ancho) * op.alto;
+    std::atomic<int> siguiente{ 0 };
+    auto trabajador = [&]() {
+        for (int z = siguiente++; z < op.planos; z = siguiente++)
+        {
+            cv::Mat plano16, mascara16;
+            const double zRel = op.planos > 1 ? static_cast<double>(z) / (op.planos - 1) : 0.5;
+            GenerarPlanoSintetico(cv::Size(op.ancho, op.alto), zRel, op.semilla + static_cast<uint64_t>(z),
+                                  plano16, mascara16);
+
+            cv::Mat destinoImg(op.alto, op.ancho, cv::DataType<TPixel>::type,
+                               imagen->GetBufferPointer() + z * voxelesPlano);
+            cv::Mat destinoMask(op.alto, op.ancho, CV_8U, mascara->GetBufferPointer() + z * voxelesPlano);
+            plano16.convertTo(destinoImg, destinoImg.type(), alfa, beta);
+            mascara16.convertTo(destinoMask, CV_8U);
+        }
+    };
+
+    const int numHilos = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), op.planos));
+    std::vector<std::thread> hilos;
+    for (int h = 1; h < numHilos; ++h) hilos.emplace_back(trabajador);
+    trabajador();
+    for (auto& hilo : hilos) hilo.join();
+
+    return EscribirNifti(imagen.GetPointer(), rutaImagen, op.comprimir, "imagen") &&
+           EscribirNifti(mascara.GetPointer(), rutaMascara, op.comprimir, "máscara");
+}
+
+// Se escribe con otro nombre (misma extensión, que decide la compresión) y se renombra
+// al final: un volumen a medio escribir nunca se confunde con uno ya generado
+std::string RutaTemporal(const std::string& ruta)
+{
+    const fs::path p{ ruta };
+    return (p.parent_path() / (".tmp_" + p.filename().string())).string();
+}
+
+} // namespace
+
+const char* NombreTipoPixel(TipoPixelSintetico tipo)
+{
+    switch (tipo) {
+        case TipoPixelSintetico::UInt8:   return "uint8";
+        case TipoPixelSintetico::UInt16:  return "uint16";
+        case TipoPixelSintetico::Float32: return "float32";
+        case TipoPixelSintetico::Int16:
+        default:                          return "int16";
+    }
+}
+
+bool LeerTipoPixel(const std::string& nombre, TipoPixelSintetico& tipo)
+{
+    for (auto t : { TipoPixelSintetico::Int16, TipoPixelSintetico::UInt8,
+                    TipoPixelSintetico::UInt16, TipoPixelSintetico::Float32 })
+    {
+        if (nombre == NombreTipoPixel(t)) { tipo = t; return true; }
+    }
+    return false;
+}
+
+bool GenerarVolumenSintetico(
+    const OpcionesVolumenSintetico& opciones,
+    const std::string& carpeta,
+    std::string& rutaImagen,
+    std::string& rutaMascara
+)
+{
+    if (opciones.ancho <= 0 || opciones.alto <= 0 || opciones.planos <= 0) {
+        std::cerr << "[ERROR] Tamaño de volumen sintético inválido.\n";
+        return false;
+    }
+
+    std::error_code ec;
+    fs::create_directories(carpeta, ec);
+    if (ec) {
+        std::cerr << "[ERROR] No se pudo crear carpeta '" << carpeta << "': " << ec.message() << "\n";
+        return false;
+    }
+
+    // El nombre identifica el volumen: si ya existe (mismas opciones) se reutiliza
+    const std::string base = "sintetico_" + std::to_string(opciones.ancho) + "x" + std::to_string(opciones.alto)
+                           + "x" + std::to_string(opciones.planos) + "_" + NombreTipoPixel(opciones.tipo)
+                           + "_s" + std::to_string(opciones.semilla);
+    const std::string extension = opciones.comprimir ? ".nii.gz" : ".nii";
+    rutaImagen  = (fs::path(carpeta) / (base + extension)).string();
+    rutaMascara = (fs::path(carpeta) / (base + "_mascara" + extension)).string();
+
+    if (fs::exists(rutaImagen, ec) && fs::exists(rutaMascara, ec)) {
+        std::cout << "[INFO] Reutilizando volumen sintético: " << rutaImagen << "\n";
+        return true;
+    }
+
+    const std::string tmpImagen  = RutaTemporal(rutaImagen);
+    const std::string tmpMascara = RutaTemporal(rutaMascara);
+    bool ok = false;
+    switch (opciones.tipo) {
+        case TipoPixelSintetico::UInt8:   ok = GenerarYEscribir<unsigned char>(opciones, tmpImagen, tmpMascara);  break;
+        case TipoPixelSintetico::UInt16:  ok = GenerarYEscribir<unsigned short>(opciones, tmpImagen, tmpMascara); break;
+        case TipoPixelSintetico::Float32: ok = GenerarYEscribir<float>(opciones, tmpImagen, tmpMascara);          break;
+        case TipoPixelSintetico::Int16:
+        default:                          ok = GenerarYEscribir<short>(opciones, tmpImagen, tmpMascara);          break;
+    }
+    if (ok) {
+        fs::rename(tmpMascara, rutaMascara, ec);
+        if (!ec) fs::rename(tmpImagen, rutaImagen, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::cerr << "[ERROR] No se pudo generar el volumen sintético en '" << carpeta << "'.\n";
+        fs::remove(tmpImagen, ec);
+        fs::remove(tmpMascara, ec);
+        return false;
+    }
+    std::cout << "[INFO] Volumen sintético generado: " << rutaImagen << "\n";
+    return true;
+}
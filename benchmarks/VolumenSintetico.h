@@ -0,0 +1,53 @@
+// VolumenSintetico.h
+#ifndef VOLUMENSINTETICO_H
+#define VOLUMENSINTETICO_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Tipo de píxel con el que se guarda la imagen sintética (la máscara siempre es uint8,
+ * como en labelsTr). El pipeline procesa cada volumen en su tipo nativo.
+ */
+enum class TipoPixelSintetico { Int16, UInt8, UInt16, Float32 };
+
+const char* NombreTipoPixel(TipoPixelSintetico tipo);
+
+/**
+ * "int16", "uint8", "uint16" o "float32".
+ * @return false si el nombre no es ninguno de ellos.
+ */
+bool LeerTipoPixel(const std::string& nombre, TipoPixelSintetico& tipo);
+
+struct OpcionesVolumenSintetico
+{
+    int ancho  = 512;
+    int alto   = 512;
+    int planos = 128;
+    TipoPixelSintetico tipo = TipoPixelSintetico::Int16;
+    bool comprimir = false;                       // .nii.gz en vez de .nii
+    double espaciado[3] = { 0.7, 0.7, 2.5 };      // mm (x, y, z), típico de TC de tórax
+    uint64_t semilla = 12345;
+};
+
+/**
+ * Escribe en 'carpeta' una imagen y una máscara NIfTI sintéticas con los planos de
+ * GenerarPlanoSintetico a lo largo de z. Los planos se generan en paralelo; si
+ * ya existen unos con las mismas opciones, se reutilizan.
+ *
+ * Valores de la imagen según el tipo: int16 y float32 en unidades Hounsfield,
+ * uint16 desplazado +1024 (como los TC sin rescale intercept) y uint8 con la
+ * ventana [-1000, 1000] HU.
+ *
+ * @param rutaImagen  Salida: ruta del volumen de imagen escrito.
+ * @param rutaMascara Salida: ruta del volumen de máscara escrito.
+ * @return false si no se pudo crear la carpeta o escribir algún volumen.
+ */
+bool GenerarVolumenSintetico(
+    const OpcionesVolumenSintetico& opciones,
+    const std::string& carpeta,
+    std::string& rutaImagen,
+    std::string& rutaMascara
+);
+
+#endif // VOLUMENSINTETICO_H
@@ -7,6 +7,9 @@ int main(int argc, char *argv[])
     QApplication app(argc, argv);
 
     MainWindow w;
+    // RMProcessorQt [imagen.nii.gz mascara.nii.gz]: entradas ya cargadas al abrir
+    const QStringList args = app.arguments();
+    if (args.size() >= 3) w.establecerEntradas(args.at(1), args.at(2));
     w.show();
 
     return app.exec();